@@ -0,0 +1,123 @@
+// AckPacing.cpp
+// see AckPacing.h
+
+#include "AckPacing.h"
+#include "AtCommand.h"
+#include "Latency.h"
+
+#include <string.h>
+
+bool ackPacing = false;
+unsigned int ackTimeoutMs = 50;  // the fixed InterstitialDelay it replaces
+
+AckStats ackStats;
+
+// send times of the commands not answered yet, oldest first; past
+// AckWindow outstanding the rest are counted but not timed
+const byte AckWindow = 8;
+static unsigned long sentAt[AckWindow];
+static byte oldest = 0;
+static byte pending = 0;         // unanswered, in time
+static byte late = 0;            // unanswered, timed out
+static unsigned long waitStart;  // last send or answer (ms)
+
+// the last command sent, when it was a key report, for a resend
+static char lastKey[AtKeyboardCodeLen + 1];
+static bool lastWasKey = false;
+static byte retries = 0;
+
+void ackInit(){
+  ackStats = AckStats();
+  oldest = 0;
+  pending = 0;
+  late = 0;
+  waitStart = halMillis();
+  lastWasKey = false;
+  retries = 0;
+}
+
+//=====SEND=============================SEND========================
+static void send(const char *command){
+  unsigned long start = halMicros();
+  halPrintln(command);
+  latencyRecord(LAT_WRITE, halMicros() - start);
+  ackStats.sent++;
+  if (!ackPacing) return;
+  if (pending < AckWindow) sentAt[(oldest + pending) % AckWindow] = halMicros();
+  if (pending < 255) pending++;
+  waitStart = halMillis();
+}
+
+void atSend(const char *command){
+  lastWasKey = false;
+  send(command);
+}
+
+void atSendKey(const char *command){
+  strncpy(lastKey, command, AtKeyboardCodeLen);
+  lastKey[AtKeyboardCodeLen] = 0;
+  lastWasKey = true;
+  retries = 0;
+  send(command);
+}
+
+//=====ANSWERS==========================ANSWERS=====================
+// true when the link has been answering in time and this answer comes
+// when the oldest command out would be answered: then it is that one's,
+// and the timed out commands' answers were lost rather than late
+static bool isOnTime(){
+  unsigned long timed = ackStats.acks + ackStats.errors - 1 - ackStats.late;
+  if (!pending || pending > AckWindow || !timed) return false;
+  return halMicros() - sentAt[oldest] <= 2 * (ackStats.ackMicros / timed);
+}
+
+static void answered(bool ok){
+  if (ok) ackStats.acks++;
+  else ackStats.errors++;
+  if (late && isOnTime()) {
+    ackStats.lost += late;
+    late = 0;
+  }
+  if (late) {
+    late--;
+    ackStats.late++;
+    return;
+  }
+  if (!pending) return;  // not ours, a stray line
+  if (pending <= AckWindow) {
+    unsigned long took = halMicros() - sentAt[oldest];
+    ackStats.ackMicros += took;
+    latencyRecord(LAT_ACK, took);
+    if (took > ackStats.maxAckMicros) ackStats.maxAckMicros = took;
+  }
+  oldest = (oldest + 1) % AckWindow;
+  pending--;
+  waitStart = halMillis();
+  // an ERROR for the last thing sent, if a key report, is sent again
+  if (!ok && !pending && lastWasKey && retries < AckRetries) {
+    retries++;
+    ackStats.retries++;
+    send(lastKey);
+  }
+}
+
+void ackService(){
+  char line[8];
+  while (halReadLine(line, sizeof(line))) {
+    if (!ackPacing) continue;
+    if (!strcmp(line, "OK")) answered(true);
+    else if (!strcmp(line, "ERROR")) answered(false);
+  }
+}
+
+bool ackWaiting(){
+  ackService();
+  if (!pending) return false;
+  if (halMillis() - waitStart < ackTimeoutMs) return true;
+  ackStats.timeouts++;
+  if (late + pending > 255) late = 255;
+  else late += pending;
+  pending = 0;
+  oldest = 0;
+  return false;
+}
@@ -0,0 +1,51 @@
+// AckPacing.h
+// The Bluefruit answers every AT command with a line, OK or ERROR.  All
+// commands go out through atSend() here, which keeps count of the ones
+// not answered yet, so with ackPacing the output queue sends the next
+// report as soon as the module has taken the last one instead of after a
+// fixed InterstitialDelay, and still goes on after ackTimeoutMs if an
+// answer never comes.
+//
+// The module answers in order, so each answer is for the oldest command
+// outstanding.  After a timeout that is a timed out one, late, unless the
+// answer comes as soon as the link has been answering the commands since:
+// then the missing answers were dropped or garbled on the way, and are not
+// waited for, which would slow every command after them to the timeout.
+// A key report that gets an ERROR is sent again (up to AckRetries times)
+// when nothing has gone out after it; a report is the state of the keys,
+// so sending it twice does no harm.
+
+#ifndef ACK_PACING_H
+#define ACK_PACING_H
+
+#include "ChorderHal.h"
+
+// false sends at the fixed pace of InterstitialDelay and reads no answers
+extern bool ackPacing;
+extern unsigned int ackTimeoutMs;  // go on without an answer after this
+const byte AckRetries = 2;         // resends of one key report
+
+void ackInit();
+void atSend(const char *command);     // any AT command
+void atSendKey(const char *command);  // AT+BLEKEYBOARDCODE, may be resent
+void ackService();                    // read what the module has answered
+// true while ackPacing and a command is still unanswered, short of
+// ackTimeoutMs since the last send or answer
+bool ackWaiting();
+
+struct AckStats {
+  unsigned long sent;          // commands sent, resends included
+  unsigned long acks;          // OK answers
+  unsigned long errors;        // ERROR answers
+  unsigned long retries;       // key reports sent again after an ERROR
+  unsigned long timeouts;      // times it went on without an answer
+  unsigned long late;          // answers after their timeout, when later
+                               // commands were already out: reordering
+  unsigned long lost;          // answers never had after a timeout, found
+                               // out from the next one coming in time
+  unsigned long ackMicros;     // total send to answer, over in-time answers
+  unsigned long maxAckMicros;
+};
+extern AckStats ackStats;
+
+#endif
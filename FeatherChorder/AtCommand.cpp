@@ -0,0 +1,100 @@
+// AtCommand.cpp
+// see AtCommand.h
+
+#include "AtCommand.h"
+
+#include <string.h>
+
+const char hexDigits[16] PROGMEM = {
+  '0', '1', '2', '3', '4', '5', '6', '7',
+  '8', '9', 'a', 'b', 'c', 'd', 'e', 'f'
+};
+
+static const char keyboardCodePrefix[] PROGMEM = "AT+BLEKEYBOARDCODE=";
+const byte keyboardCodePrefixLen = sizeof(keyboardCodePrefix) - 1;
+
+//=====KEYBOARD CODE====================KEYBOARD CODE===============
+// Format for Bluefruit Feather is MOD-00-KEY, each always 2 hex digits
+// as firmware greater than 0.6.7 wants the leading zero.
+byte atKeyboardCode(char *buf, byte modKey, byte rawKey){
+  memcpy_P(buf, keyboardCodePrefix, keyboardCodePrefixLen);
+  char *p = buf + keyboardCodePrefixLen;
+  p[0] = pgm_read_byte(&hexDigits[modKey >> 4]);
+  p[1] = pgm_read_byte(&hexDigits[modKey & 0x0F]);
+  p[2] = '-';
+  p[3] = '0';
+  p[4] = '0';
+  p[5] = '-';
+  p[6] = pgm_read_byte(&hexDigits[rawKey >> 4]);
+  p[7] = pgm_read_byte(&hexDigits[rawKey & 0x0F]);
+  p[8] = 0;
+  return AtKeyboardCodeLen;
+}
+
+byte atKeyboardRelease(char *buf){
+  memcpy_P(buf, keyboardCodePrefix, keyboardCodePrefixLen);
+  memcpy_P(buf + keyboardCodePrefixLen, PSTR("00-00"), 6);
+  return AtKeyboardReleaseLen;
+}
+
+//=====MOUSE MOVE=======================MOUSE MOVE==================
+static const char mouseMovePrefix[] PROGMEM = "AT+BleHidMouseMove=";
+
+// -128 to 127 at p, returns the end
+static char *decimal(char *p, int8_t value){
+  byte n = value < 0 ? -value : value;
+  if (value < 0) *p++ = '-';
+  if (n >= 100) *p++ = '0' + n / 100;
+  if (n >= 10) *p++ = '0' + n / 10 % 10;
+  *p++ = '0' + n % 10;
+  return p;
+}
+
+byte atMouseMove(char *buf, int8_t x, int8_t y, int8_t wheel){
+  memcpy_P(buf, mouseMovePrefix, sizeof(mouseMovePrefix) - 1);
+  char *p = decimal(buf + sizeof(mouseMovePrefix) - 1, x);
+  *p++ = ',';
+  p = decimal(p, y);
+  if (wheel) {
+    *p++ = ',';
+    p = decimal(p, wheel);
+  }
+  *p = 0;
+  return p - buf;
+}
+
+//=====BATTERY LEVEL====================BATTERY LEVEL===============
+static const char batteryLevelPrefix[] PROGMEM = "AT+BLEBATTVAL=";
+
+byte atBatteryLevel(char *buf, byte percent){
+  memcpy_P(buf, batteryLevelPrefix, sizeof(batteryLevelPrefix) - 1);
+  char *p = decimal(buf + sizeof(batteryLevelPrefix) - 1, percent > 100 ? 100 : percent);
+  *p = 0;
+  return p - buf;
+}
+
+//=====COMMAND WITH TEXT================COMMAND WITH TEXT===========
+size_t atCommandWithText(char *buf, const char *flashPrefix, const char *text){
+  size_t prefixLen = strlen_P(flashPrefix);
+  size_t room = AtCommandSize - 1 - prefixLen;
+  size_t used = strlen(text);
+  if (used > room) used = room;
+  memcpy_P(buf, flashPrefix, prefixLen);
+  memcpy(buf + prefixLen, text, used);
+  buf[prefixLen + used] = 0;
+  return used;
+}
+
+size_t atCommandWithTextP(char *buf, const char *flashPrefix, const char *flashText){
+  size_t prefixLen = strlen_P(flashPrefix);
+  size_t room = AtCommandSize - 1 - prefixLen;
+  memcpy_P(buf, flashPrefix, prefixLen);
+  char *p = buf + prefixLen;
+  size_t used = 0;
+  char c;
+  while (used < room && (c = pgm_read_byte(flashText + used))) {
+    p[used++] = c;
+  }
+  p[used] = 0;
+  return used;
+}
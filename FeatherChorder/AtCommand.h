@@ -0,0 +1,43 @@
+// AtCommand.h
+// Formats the Bluefruit AT commands the chorder sends into a caller
+// supplied buffer (normally on the stack), so a keystroke costs no heap
+// and goes out in a single halPrintln().
+
+#ifndef AT_COMMAND_H
+#define AT_COMMAND_H
+
+#include "ChorderHal.h"
+
+// '0' - '9' then 'a' - 'f', in PROGMEM; Trace.cpp logs with it too
+extern const char hexDigits[16];
+
+// room for the longest command we build, terminating 0 included
+const byte AtCommandSize = 64;
+
+// "AT+BLEKEYBOARDCODE=MM-00-KK", modifier and key as 2 digit hex.
+// buf needs AtKeyboardCodeLen + 1 chars, returns AtKeyboardCodeLen.
+const byte AtKeyboardCodeLen = 27;
+byte atKeyboardCode(char *buf, byte modKey, byte rawKey);
+// "AT+BLEKEYBOARDCODE=00-00", every key up.  buf needs
+// AtKeyboardReleaseLen + 1 chars, returns AtKeyboardReleaseLen.
+const byte AtKeyboardReleaseLen = 24;
+byte atKeyboardRelease(char *buf);
+
+// "AT+BleHidMouseMove=X,Y" in decimal, with ",WHEEL" when the wheel
+// moves too.  buf needs AtMouseMoveSize chars, returns the length.
+const byte AtMouseMoveSize = 34;  // three -128s
+byte atMouseMove(char *buf, int8_t x, int8_t y, int8_t wheel);
+
+// "AT+BLEBATTVAL=N", the Battery Service level, 0 - 100 in decimal.
+// buf needs AtBatteryLevelSize chars, returns the length.
+const byte AtBatteryLevelSize = 18;
+byte atBatteryLevel(char *buf, byte percent);
+
+// 'flashPrefix' (in PROGMEM, PSTR("AT+...=")) followed by as much of
+// 'text' as fits in AtCommandSize.  Returns how many chars of 'text' were
+// used, so long text can be sent over several commands.
+size_t atCommandWithText(char *buf, const char *flashPrefix, const char *text);
+// the same for text in PROGMEM
+size_t atCommandWithTextP(char *buf, const char *flashPrefix, const char *flashText);
+
+#endif
@@ -0,0 +1,90 @@
+// Battery.cpp
+// see Battery.h
+
+#include "Battery.h"
+#include "AckPacing.h"
+#include "OutputBackend.h"
+#include "OutputQueue.h"
+
+unsigned long batterySampleMs = 60000;
+byte batteryLowPercent = 10;
+unsigned long batteryLowIdleMs = 1000;
+
+BatteryStats batteryStats;
+
+// a resting LiPo at 0, 5 ... 100%, as (mV - 3000) / 10
+static const byte lipo_curve[] PROGMEM = {
+   27,  61,  69,  71,  73,  75,  77,  79,  80,  82,  84,
+   85,  87,  91,  95,  98, 102, 108, 111, 115, 120
+};
+const byte CurveSteps = sizeof(lipo_curve) - 1;
+const byte CurveStepPercent = 100 / CurveSteps;
+static_assert(CurveSteps * CurveStepPercent == 100, "a curve point every few percent up to 100");
+
+// the filter, in mV * 16
+const byte FilterShift = 4;
+static long filtered = 0;
+static unsigned long lastSampleMs = 0;
+
+//=====CONVERSION=======================CONVERSION==================
+// the divider halves the battery, the ADC is 10 bits of 3.3v
+unsigned int batteryMillivolts(int raw){
+  return (unsigned long)raw * 2 * 3300 / 1024;
+}
+
+byte batteryPercent(unsigned int millivolts){
+  unsigned int step = millivolts < 3000 ? 0 : (millivolts - 3000) / 10;
+  if (step < pgm_read_byte(&lipo_curve[0])) return 0;
+  for (byte i = 0; i < CurveSteps; i++) {
+    unsigned int low = pgm_read_byte(&lipo_curve[i]) * 10 + 3000;
+    unsigned int high = pgm_read_byte(&lipo_curve[i + 1]) * 10 + 3000;
+    if (millivolts < high)
+      return i * CurveStepPercent + (millivolts - low) * CurveStepPercent / (high - low);
+  }
+  return 100;
+}
+
+//=====SAMPLE===========================SAMPLE======================
+void batteryInit(){
+  batteryStats = BatteryStats();
+  batteryStats.percent = BatteryUnknown;
+  batteryStats.published = BatteryUnknown;
+  filtered = 0;
+  batterySample();
+}
+
+void batterySample(){
+  lastSampleMs = halMillis();
+  batteryStats.samples++;
+  long reading = (long)batteryMillivolts(halReadBattery()) << FilterShift;
+  if (reading < (long)BatteryMinMillivolts << FilterShift) {
+    filtered = 0;  // no battery
+    batteryStats.millivolts = 0;
+    batteryStats.percent = BatteryUnknown;
+    batteryStats.isLow = false;
+    return;
+  }
+  // the first reading starts the filter, later ones move it a quarter
+  filtered = filtered ? filtered + (reading - filtered) / 4 : reading;
+  batteryStats.millivolts = filtered >> FilterShift;
+  byte percent = batteryPercent(batteryStats.millivolts);
+  batteryStats.percent = percent;
+  if (percent <= batteryLowPercent && !batteryStats.isLow) {
+    batteryStats.isLow = true;
+    halLogP(PSTR("battery low"));
+  } else if (percent > batteryLowPercent + BatteryLowHysteresis) {
+    batteryStats.isLow = false;
+  }
+}
+
+void batteryService(){
+  if (halMillis() - lastSampleMs >= batterySampleMs) batterySample();
+}
+
+void batteryPublish(){
+  byte percent = batteryStats.percent;
+  if (percent == BatteryUnknown || percent == batteryStats.published) return;
+  if (!outputBackend->battery || outputQueueDepth() || ackWaiting()) return;
+  batteryStats.published = percent;
+  outputBackend->battery(percent);
+}
@@ -0,0 +1,57 @@
+// Battery.h
+// The LiPo, watched in the background.  batteryService() runs from quiet
+// passes, asleep too, and reads VBATPIN once a batterySampleMs; readings
+// go through a fixed-point low-pass filter (a quarter of each new one)
+// and a LiPo discharge curve to a percent.  A change of percent goes to
+// the module's Battery Service (AT+BLEBATTVAL) from the next quiet pass
+// awake, as sending wakes the board, so hosts show it the way they show
+// any BLE keyboard's.  Nothing is typed; BAT_LVL still types the voltage
+// on request.
+//
+// At batteryLowPercent or under the battery is low until it is back over
+// it by BatteryLowHysteresis: the board then goes to sleep after
+// batteryLowIdleMs rather than idleSleepMs, and asleep it looks at the
+// switches every BatteryLowSleeps halSleep()s rather than every one.
+//
+// A reading under BatteryMinMillivolts is no battery (or no divider, as
+// on the host unless hostSetBattery() says otherwise); nothing is
+// published and the policy is off.
+
+#ifndef BATTERY_H
+#define BATTERY_H
+
+#include "ChorderHal.h"
+
+extern unsigned long batterySampleMs;   // time between readings
+extern byte batteryLowPercent;
+extern unsigned long batteryLowIdleMs;  // quiet time before sleeping when low
+const byte BatteryLowHysteresis = 5;    // percent
+const byte BatteryLowSleeps = 2;        // halSleep()s a pass asleep when low
+const unsigned int BatteryMinMillivolts = 2500;
+const byte BatteryUnknown = 0xFF;
+
+struct BatteryStats {
+  unsigned int millivolts;  // filtered, 0 with no battery
+  byte percent;             // BatteryUnknown with no battery
+  byte published;           // the last sent to the host, BatteryUnknown none
+  bool isLow;
+  unsigned long samples;
+};
+extern BatteryStats batteryStats;
+
+// a raw VBATPIN reading (half the battery, 10 bits of 3.3v) in mV
+unsigned int batteryMillivolts(int raw);
+// what is left at 'millivolts', resting, from the LiPo curve
+byte batteryPercent(unsigned int millivolts);
+
+// the first reading, at boot
+void batteryInit();
+// a reading now, into the filter
+void batterySample();
+// a reading when one is due, from quiet passes
+void batteryService();
+// the percent to the host when it changed, from quiet passes awake (the
+// output queue empty)
+void batteryPublish();
+
+#endif
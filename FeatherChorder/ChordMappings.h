@@ -3,17 +3,43 @@
 // Mappings moved here so they can be changed without risk
 // of modifying the rest of the code.
 // - Greg
+//
+// Generated from ChordChart.txt by tools/keymap_compiler, change the
+// chart and run it (cmake --build build --target keymap) rather than
+// editing this file.
 
 typedef uint8_t keymap_t;
 
+// Keymaps live in flash (PROGMEM) and are only read through
+// keymapLookup() in Keymap.cpp, so they cost no SRAM.
+//
+// A layer is either dense, 128 keymap_t indexed by the chord, or sparse,
+// a list of the chords that do something, sorted by chord, for layers that
+// are mostly ENUMKEY__.  Chords not in a sparse list are ENUMKEY__.
+struct keymap_entry_t {
+  uint8_t chord;
+  keymap_t key;
+};
+
+struct keymap_layer_t {
+  const keymap_t *dense;          // 128 entries, or 0 for a sparse layer
+  const keymap_entry_t *sparse;   // sorted by chord
+  uint8_t sparseCount;
+};
+
+// for the static_asserts below: chords 1 - 127, each once, in order
+constexpr bool keymapSparseOk(const keymap_entry_t *e, unsigned n, int last = 0){
+  return n == 0 || (e->chord > last && e->chord < 128 && keymapSparseOk(e + 1, n - 1, e->chord));
+}
+
 
 /**********************************************************
  *  order is  Far Thumb, Center Thumb, Near Thumb button  *
  *  Index Finger, Middle Finger, Ring Finger, Pinky       *
  *  FCN IMRP                                              *
  **********************************************************/
-const keymap_t keymap_default[128] = {
-  ENUMKEY__,                        // --- ----  0x00 no keys pressed
+const keymap_t keymap_default[] PROGMEM = {
+  ENUMKEY__,                        // --- ----  0x00   no keys pressed
   ENUMKEY_W,                        // --- ---P  0x01
   ENUMKEY_Y,                        // --- --R-  0x02
   ENUMKEY_U,                        // --- --RP  0x03
@@ -32,7 +58,6 @@ const keymap_t keymap_default[128] = {
   ENUMKEY_T,                        // --- IMRP  0x0F
 
   MODE_NUM,                         // --N ----  0x10
-
   MODE_FUNC,                        // --N ---P  0x11
   ENUMKEY_esc,                      // --N --R-  0x12
   ENUMKEY_smcol,                    // --N --RP  0x13
@@ -41,11 +66,11 @@ const keymap_t keymap_default[128] = {
   ENUMKEY_dot,                      // --N -MR-  0x16
   MOD_LALT,                         // --N -MRP  0x17
 
-  RAW_LGUI,                        // --N I---  0x18
+  RAW_LGUI,                         // --N I---  0x18
   ENUMKEY_ins,                      // --N I--P  0x19
   MOD_LGUI,                         // --N I-R-  0x1A
   MOD_LCTRL,                        // --N I-RP  0x1B
-  LATCH,                       // --N IM--  0x1C
+  LATCH,                            // --N IM--  0x1C
   MACRO_opencurly,                  // --N IM-P  0x1D
   ENUMKEY_ping,                     // --N IMR-  0x1E
   MODE_NUMLCK,                      // --N IMRP  0x1F
@@ -106,38 +131,38 @@ const keymap_t keymap_default[128] = {
 
   ENUMKEY_break,                    // F-N ----  0x50
   MACRO_SHIFTDN,                    // F-N ---P  0x51
-  ENUMKEY__,                        // F-N --R-  0x52
-  ENUMKEY__,                        // F-N --RP  0x53
-  ENUMKEY__,                        // F-N -M--  0x54
-  ENUMKEY__,                        // F-N -M-P  0x55
-  ENUMKEY__,                        // F-N -MR-  0x56
-  ENUMKEY__,                        // F-N -MRP  0x57
-
-  ENUMKEY__,                        // F-N I---  0x58
-  ENUMKEY__,                        // F-N I--P  0x59
-  ENUMKEY__,                        // F-N I-R-  0x5A
-  ENUMKEY__,                        // F-N I-RP  0x5B
-  ENUMKEY__,                        // F-N IM--  0x5C
-  ENUMKEY__,                        // F-N IM-P  0x5D
-  ENUMKEY__,                        // F-N IMR-  0x5E
-  ENUMKEY__,                        // F-N IMRP  0x5F
+  WORD_about,                       // F-N --R-  0x52
+  WORD_and,                         // F-N --RP  0x53
+  WORD_for,                         // F-N -M--  0x54
+  WORD_from,                        // F-N -M-P  0x55
+  WORD_have,                        // F-N -MR-  0x56
+  WORD_that,                        // F-N -MRP  0x57
+
+  WORD_the,                         // F-N I---  0x58
+  WORD_their,                       // F-N I--P  0x59
+  WORD_there,                       // F-N I-R-  0x5A
+  WORD_this,                        // F-N I-RP  0x5B
+  WORD_which,                       // F-N IM--  0x5C
+  WORD_with,                        // F-N IM-P  0x5D
+  WORD_would,                       // F-N IMR-  0x5E
+  WORD_you,                         // F-N IMRP  0x5F
 
   MOD_RSHIFT,                       // FC- ----  0x60
   ENUMKEY_KPenter,                  // FC- ---P  0x61
   ENUMKEY_KP6,                      // FC- --R-  0x62
-  MEDIA_volup, // was ENUMKEY_KP2,  //  FC- --RP  0x63
-  MEDIA_stop, // was ENUMKEY_KP5,   // FC- -M--  0x64
+  MEDIA_volup,                      // FC- --RP  0x63   was ENUMKEY_KP2
+  MEDIA_stop,                       // FC- -M--  0x64   was ENUMKEY_KP5
   ENUMKEY_KPast,                    // FC- -M-P  0x65
-  MEDIA_playpause,  // was ENUMKEY_KPcomma,   // FC- -MR-  0x66
-  MEDIA_next, // was ENUMKEY_KP3,             // FC- -MRP  0x67
+  MEDIA_playpause,                  // FC- -MR-  0x66   was ENUMKEY_KPcomma
+  MEDIA_next,                       // FC- -MRP  0x67   was ENUMKEY_KP3
 
   ENUMKEY_KP4,                      // FC- I---  0x68
-  MEDIA_previous, // was ENUMKEY_KP1,         // FC- I--P  0x69
+  MEDIA_previous,                   // FC- I--P  0x69   was ENUMKEY_KP1
   ENUMKEY_KPminus,                  // FC- I-R-  0x6A
   ENUMKEY_KP7,                      // FC- I-RP  0x6B
-  MEDIA_voldn, // was ENUMKEY_KP8,            // FC- IM--  0x6C
+  MEDIA_voldn,                      // FC- IM--  0x6C   was ENUMKEY_KP8
   ENUMKEY_KPslash,                  // FC- IM-P  0x6D
-  MEDIA_previous, // was ENUMKEY_KP9,         // FC- IMR-  0x6E
+  MEDIA_previous,                   // FC- IMR-  0x6E   was ENUMKEY_KP9
   ENUMKEY_KP0,                      // FC- IMRP  0x6F
 
   MODE_RESET,                       // FCN ----  0x70
@@ -158,12 +183,14 @@ const keymap_t keymap_default[128] = {
   ENUMKEY__,                        // FCN IMR-  0x7E
   ENUMKEY__                         // FCN IMRP  0x7F
 };
+static_assert(sizeof(keymap_default) == 128 * sizeof(keymap_t),
+              "keymap_default needs a key for each of the 128 chords");
 
 /**************************************
  * number/symbols mode                *
  **************************************/
-const keymap_t keymap_numsym[128] = {
-  ENUMKEY__,                        // --- ----  0x00
+const keymap_t keymap_numsym[] PROGMEM = {
+  ENUMKEY__,                        // --- ----  0x00   no keys pressed
   ENUMKEY_5,                        // --- ---P  0x01
   ENUMKEY_4,                        // --- --R-  0x02
   MACRO_quotes,                     // --- --RP  0x03   "" and a back arrow
@@ -194,7 +221,7 @@ const keymap_t keymap_numsym[128] = {
   ENUMKEY_ins,                      // --N I--P  0x19
   MOD_LGUI,                         // --N I-R-  0x1A
   MOD_LCTRL,                        // --N I-RP  0x1B
-  LATCH,                        // --N IM--  0x1C
+  LATCH,                            // --N IM--  0x1C
   ENUMKEY__,                        // --N IM-P  0x1D
   ENUMKEY_ping,                     // --N IMR-  0x1E
   MODE_RESET,                       // --N IMRP  0x1F
@@ -209,9 +236,9 @@ const keymap_t keymap_numsym[128] = {
   ENUMKEY_lbr,                      // -C- -MRP  0x27
 
   ENUMKEY_6,                        // -C- I---  0x28
-  MACRO_ampersand,                  // -C- I--P  0x29       &
-  MACRO_parens,                     // -C- I-R-  0x2A       () and a back arrow
-  MACRO_question,                   // -C- I-RP  0x2B       ?
+  MACRO_ampersand,                  // -C- I--P  0x29   &
+  MACRO_parens,                     // -C- I-R-  0x2A   () and a back arrow
+  MACRO_question,                   // -C- I-RP  0x2B   ?
   MACRO_asterisk,                   // -C- IM--  0x2C
   ENUMKEY_lbr,                      // -C- IM-P  0x2D
   MACRO_plus,                       // -C- IMR-  0x2E
@@ -307,154 +334,119 @@ const keymap_t keymap_numsym[128] = {
   ENUMKEY__,                        // FCN IMR-  0x7E
   ENUMKEY__                         // FCN IMRP  0x7F
 };
+static_assert(sizeof(keymap_numsym) == 128 * sizeof(keymap_t),
+              "keymap_numsym needs a key for each of the 128 chords");
 
 /**************************************
  * function key mode                  *
+ * sparse, only the chords in use     *
  **************************************/
-const keymap_t keymap_function[128] = {
-  ENUMKEY__,                        // --- ----  0x00
-  ENUMKEY_F5,                       // --- ---P  0x01
-  ENUMKEY_F4,                       // --- --R-  0x02
-  MEDIA_volup,                      // --- --RP  0x03
-  ENUMKEY_F3,                       // --- -M--  0x04
-  ENUMKEY__,                        // --- -M-P  0x05
-  MACRO_TEST,                       // --- -MR-  0x06
-  MEDIA_stop,                       // --- -MRP  0x07
-
-  ENUMKEY_F2,                       // --- I---  0x08
-  MEDIA_previous,                   // --- I--P  0x09
-  ENUMKEY__,                        // --- I-R-  0x0A
-  ENUMKEY__,                        // --- I-RP  0x0B
-  MEDIA_voldn,                      // --- IM--  0x0C
-  ENUMKEY__,                        // --- IM-P  0x0D
-  BAT_LVL,                          // --- IMR-  0x0E
-  ENUMKEY__,                        // --- IMRP  0x0F
-
-  ENUMKEY__,                        // --N ----  0x10
-  MODE_RESET,                       // --N ---P  0x11
-  ENUMKEY__,                        // --N --R-  0x12
-  ENUMKEY__,                        // --N --RP  0x13
-  ENUMKEY__,                        // --N -M--  0x14
-  ENUMKEY__,                        // --N -M-P  0x15
-  ENUMKEY__,                        // --N -MR-  0x16
-  MOD_LALT,                         // --N -MRP  0x17
+constexpr keymap_entry_t keymap_function[] PROGMEM = {
+  { 0x01, ENUMKEY_F5 },             // --- ---P  0x01
+  { 0x02, ENUMKEY_F4 },             // --- --R-  0x02
+  { 0x03, MEDIA_volup },            // --- --RP  0x03
+  { 0x04, ENUMKEY_F3 },             // --- -M--  0x04
+  { 0x06, MACRO_TEST },             // --- -MR-  0x06
+  { 0x07, MEDIA_stop },             // --- -MRP  0x07
+
+  { 0x08, ENUMKEY_F2 },             // --- I---  0x08
+  { 0x09, MEDIA_previous },         // --- I--P  0x09
+  { 0x0A, USAGE_DUMP },             // --- I-R-  0x0A
+  { 0x0B, RECORD_BINDING },         // --- I-RP  0x0B
+  { 0x0C, MEDIA_voldn },            // --- IM--  0x0C
+  { 0x0D, LATENCY_REPORT },         // --- IM-P  0x0D
+  { 0x0E, BAT_LVL },                // --- IMR-  0x0E
+  { 0x0F, TRACE_DUMP },             // --- IMRP  0x0F
+
+  { 0x10, MODE_POINTER },           // --N ----  0x10
+  { 0x11, MODE_RESET },             // --N ---P  0x11
+  { 0x17, MOD_LALT },               // --N -MRP  0x17
+
+  { 0x1A, MOD_LGUI },               // --N I-R-  0x1A
+  { 0x1B, MOD_LCTRL },              // --N I-RP  0x1B
+  { 0x1C, LATCH },                  // --N IM--  0x1C
+
+  { 0x20, ENUMKEY_F1 },             // -C- ----  0x20
+  { 0x21, ENUMKEY_F9 },             // -C- ---P  0x21
+  { 0x22, ENUMKEY_F8 },             // -C- --R-  0x22
+  { 0x23, ENUMKEY_F12 },            // -C- --RP  0x23
+  { 0x24, ENUMKEY_F7 },             // -C- -M--  0x24
+  { 0x26, ENUMKEY_F11 },            // -C- -MR-  0x26
+
+  { 0x28, ENUMKEY_F6 },             // -C- I---  0x28
+  { 0x2C, ENUMKEY_F10 },            // -C- IM--  0x2C
+
+  { 0x30, MULTI_NumShift },         // -CN ----  0x30
+  { 0x34, ANDROID_dpadcenter },     // -CN -M--  0x34
+  { 0x36, ANDROID_home },           // -CN -MR-  0x36
+  { 0x37, MOD_RALT },               // -CN -MRP  0x37
+
+  { 0x39, ANDROID_back },           // -CN I--P  0x39
+  { 0x3A, MOD_RGUI },               // -CN I-R-  0x3A
+  { 0x3B, MOD_RCTRL },              // -CN I-RP  0x3B
+  { 0x3C, ANDROID_menu },           // -CN IM--  0x3C
+  { 0x3E, ANDROID_search },         // -CN IMR-  0x3E
+
+  { 0x40, MOD_LSHIFT },             // F-- ----  0x40
+  { 0x46, MEDIA_playpause },        // F-- -MR-  0x46
+  { 0x47, MEDIA_next },             // F-- -MRP  0x47
+
+  { 0x48, MEDIA_previous },         // F-- I---  0x48
+
+  { 0x60, MOD_RSHIFT },             // FC- ----  0x60
+
+  { 0x70, MODE_RESET }              // FCN ----  0x70
+};
+static_assert(sizeof(keymap_function) / sizeof(keymap_function[0]) < 128 && keymapSparseOk(keymap_function, sizeof(keymap_function) / sizeof(keymap_function[0])),
+              "keymap_function wants chords 1 - 127, each once, sorted");
 
-  ENUMKEY__,                        // --N I---  0x18
-  ENUMKEY__,                        // --N I--P  0x19
-  MOD_LGUI,                         // --N I-R-  0x1A
-  MOD_LCTRL,                        // --N I-RP  0x1B
-  LATCH,                        // --N IM--  0x1C
-  ENUMKEY__,                        // --N IM-P  0x1D
-  ENUMKEY__,                        // --N IMR-  0x1E
-  ENUMKEY__,                        // --N IMRP  0x1F
-
-  ENUMKEY_F1,                       // -C- ----  0x20
-  ENUMKEY_F9,                       // -C- ---P  0x21
-  ENUMKEY_F8,                       // -C- --R-  0x22
-  ENUMKEY_F12,                      // -C- --RP  0x23
-  ENUMKEY_F7,                       // -C- -M--  0x24
-  ENUMKEY__,                        // -C- -M-P  0x25
-  ENUMKEY_F11,                      // -C- -MR-  0x26
-  ENUMKEY__,                        // -C- -MRP  0x27
-
-  ENUMKEY_F6,                       // -C- I---  0x28
-  ENUMKEY__,                        // -C- I--P  0x29
-  ENUMKEY__,                        // -C- I-R-  0x2A
-  ENUMKEY__,                        // -C- I-RP  0x2B
-  ENUMKEY_F10,                      // -C- IM--  0x2C
-  ENUMKEY__,                        // -C- IM-P  0x2D
-  ENUMKEY__,                        // -C- IMR-  0x2E
-  ENUMKEY__,                        // -C- IMRP  0x2F
+/**************************************
+ * pointer (mouse) mode               *
+ * sparse, only the chords in use     *
+ **************************************/
+constexpr keymap_entry_t keymap_pointer[] PROGMEM = {
+  { 0x01, POINTER_right },          // --- ---P  0x01
+  { 0x02, POINTER_down },           // --- --R-  0x02
+  { 0x03, POINTER_downright },      // --- --RP  0x03
+  { 0x04, POINTER_up },             // --- -M--  0x04
+  { 0x05, POINTER_upright },        // --- -M-P  0x05
 
-  MULTI_NumShift,                   // -CN ----  0x30
-  ENUMKEY__,                        // -CN ---P  0x31
-  ENUMKEY__,                        // -CN --R-  0x32
-  ENUMKEY__,                        // -CN --RP  0x33
-  ANDROID_dpadcenter,               // -CN -M--  0x34
-  ENUMKEY__,                        // -CN -M-P  0x35
-  ANDROID_home,                     // -CN -MR-  0x36
-  MOD_RALT,                         // -CN -MRP  0x37
+  { 0x08, POINTER_left },           // --- I---  0x08
+  { 0x0A, POINTER_downleft },       // --- I-R-  0x0A
+  { 0x0C, POINTER_upleft },         // --- IM--  0x0C
 
-  ENUMKEY__,                        // -CN I---  0x38
-  ANDROID_back,                     // -CN I--P  0x39
-  MOD_RGUI,                         // -CN I-R-  0x3A
-  MOD_RCTRL,                        // -CN I-RP  0x3B
-  ANDROID_menu,                     // -CN IM--  0x3C
-  ENUMKEY__,                        // -CN IM-P  0x3D
-  ANDROID_search,                   // -CN IMR-  0x3E
-  ENUMKEY__,                        // -CN IMRP  0x3F
+  { 0x10, POINTER_lclick },         // --N ----  0x10
+  { 0x12, ENUMKEY_esc },            // --N --R-  0x12
+  { 0x14, ENUMKEY_enter },          // --N -M--  0x14
 
-  MOD_LSHIFT,                       // F-- ----  0x40
-  ENUMKEY__,                        // F-- ---P  0x41
-  ENUMKEY__,                        // F-- --R-  0x42
-  ENUMKEY__,                        // F-- --RP  0x43
-  ENUMKEY__,                        // F-- -M--  0x44
-  ENUMKEY__,                        // F-- -M-P  0x45
-  MEDIA_playpause,                  // F-- -MR-  0x46
-  MEDIA_next,                        // F-- -MRP  0x47
-
-  MEDIA_previous,                   // F-- I---  0x48
-  ENUMKEY__,                        // F-- I--P  0x49
-  ENUMKEY__,                        // F-- I-R-  0x4A
-  ENUMKEY__,                        // F-- I-RP  0x4B
-  ENUMKEY__,                        // F-- IM--  0x4C
-  ENUMKEY__,                        // F-- IM-P  0x4D
-  ENUMKEY__,                        // F-- IMR-  0x4E
-  ENUMKEY__,                        // F-- IMRP  0x4F
-
-  ENUMKEY__,                        // F-N ----  0x50
-  ENUMKEY__,                        // F-N ---P  0x51
-  ENUMKEY__,                        // F-N --R-  0x52
-  ENUMKEY__,                        // F-N --RP  0x53
-  ENUMKEY__,                        // F-N -M--  0x54
-  ENUMKEY__,                        // F-N -M-P  0x55
-  ENUMKEY__,                        // F-N -MR-  0x56
-  ENUMKEY__,                        // F-N -MRP  0x57
+  { 0x20, POINTER_rclick },         // -C- ----  0x20
+  { 0x22, POINTER_scrolldown },     // -C- --R-  0x22
+  { 0x24, POINTER_scrollup },       // -C- -M--  0x24
 
-  ENUMKEY__,                        // F-N I---  0x58
-  ENUMKEY__,                        // F-N I--P  0x59
-  ENUMKEY__,                        // F-N I-R-  0x5A
-  ENUMKEY__,                        // F-N I-RP  0x5B
-  ENUMKEY__,                        // F-N IM--  0x5C
-  ENUMKEY__,                        // F-N IM-P  0x5D
-  ENUMKEY__,                        // F-N IMR-  0x5E
-  ENUMKEY__,                        // F-N IMRP  0x5F
+  { 0x30, POINTER_mclick },         // -CN ----  0x30
 
-  MOD_RSHIFT,                       // FC- ----  0x60
-  ENUMKEY__,                        // FC- ---P  0x61
-  ENUMKEY__,                        // FC- --R-  0x62
-  ENUMKEY__,                        // FC- --RP  0x63
-  ENUMKEY__,                        // FC- -M--  0x64
-  ENUMKEY__,                        // FC- -M-P  0x65
-  ENUMKEY__,                        // FC- -MR-  0x66
-  ENUMKEY__,                        // FC- -MRP  0x67
-
-  ENUMKEY__,                        // FC- I---  0x68
-  ENUMKEY__,                        // FC- I--P  0x69
-  ENUMKEY__,                        // FC- I-R-  0x6A
-  ENUMKEY__,                        // FC- I-RP  0x6B
-  ENUMKEY__,                        // FC- IM--  0x6C
-  ENUMKEY__,                        // FC- IM-P  0x6D
-  ENUMKEY__,                        // FC- IMR-  0x6E
-  ENUMKEY__,                        // FC- IMRP  0x6F
+  { 0x40, POINTER_drag },           // F-- ----  0x40
 
-  MODE_RESET,                       // FCN ----  0x70
-  ENUMKEY__,                        // FCN ---P  0x71
-  ENUMKEY__,                        // FCN --R-  0x72
-  ENUMKEY__,                        // FCN --RP  0x73
-  ENUMKEY__,                        // FCN -M--  0x74
-  ENUMKEY__,                        // FCN -M-P  0x75
-  ENUMKEY__,                        // FCN -MR-  0x76
-  ENUMKEY__,                        // FCN -MRP  0x77
+  { 0x60, MODE_POINTER },           // FC- ----  0x60
 
-  ENUMKEY__,                        // FCN I---  0x78
-  ENUMKEY__,                        // FCN I--P  0x79
-  ENUMKEY__,                        // FCN I-R-  0x7A
-  ENUMKEY__,                        // FCN I-RP  0x7B
-  ENUMKEY__,                        // FCN IM--  0x7C
-  ENUMKEY__,                        // FCN IM-P  0x7D
-  ENUMKEY__,                        // FCN IMR-  0x7E
-  ENUMKEY__                         // FCN IMRP  0x7F
+  { 0x70, MODE_RESET }              // FCN ----  0x70
+};
+static_assert(sizeof(keymap_pointer) / sizeof(keymap_pointer[0]) < 128 && keymapSparseOk(keymap_pointer, sizeof(keymap_pointer) / sizeof(keymap_pointer[0])),
+              "keymap_pointer wants chords 1 - 127, each once, sorted");
+
+/**************************************
+ * layers, in the order of Mode in    *
+ * Chorder.cpp                        *
+ **************************************/
+const keymap_layer_t keymap_layers[] PROGMEM = {
+  { keymap_default, 0, 0 },                   // ALPHA
+  { keymap_numsym, 0, 0 },                    // NUMSYM
+  { 0, keymap_function,
+    sizeof(keymap_function) / sizeof(keymap_function[0]) },  // FUNCTION
+  { 0, keymap_pointer,
+    sizeof(keymap_pointer) / sizeof(keymap_pointer[0]) }  // POINTER
 };
+static_assert(sizeof(keymap_layers) / sizeof(keymap_layers[0]) == 4,
+              "a layer for each Mode in Chorder.cpp");
 
 // end ChordMappings.h
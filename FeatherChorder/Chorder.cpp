@@ -0,0 +1,794 @@
+// Chorder.cpp
+// Board independent chorder logic, split out from FeatherChorder.ino.
+// Everything here reaches the hardware through ChorderHal.h only.
+
+#include "Chorder.h"
+#include "AckPacing.h"
+#include "Battery.h"
+#include "Debounce.h"
+#include "Dictionary.h"
+#include "HidReport.h"
+#include "Keymap.h"
+#include "KeymapOverlay.h"
+#include "Macro.h"
+#include "OutputBackend.h"
+#include "OutputQueue.h"
+#include "KeyCodes.h"
+#include "KeyTables.h"
+#include "Latency.h"
+#include "Pointer.h"
+#include "Trace.h"
+#include "Usage.h"
+
+//==================================================
+// ctb
+// A few timing constants
+const int HalfSec = 500;  // for a half second delay
+
+// It seems it can happen that there are times when sending 3 raw
+// keys in a macro, the keys can arrive in the wrong order.  So this was added
+// 2025-02-23 to see if it prevents that.  Adjust as needed.
+// A long name for a short thing. The time between raw key sends in a macro  .
+const int InterstitialDelay = 50; // for a 5/100 sec. delay (4/100 was not enough)
+
+// note - key debounce timing constants are not in this section.
+
+//====END=CONSTANTS=====================END=CONSTANTS=============
+
+// used by processReading()
+// ctb
+enum State {
+  PRESSING,
+  RELEASING,
+  HOLDING,    // chord sent on hold, waiting for a release
+  REPEATING,  // key down sent for a held chord, its key up goes on release
+};
+
+State state = RELEASING;
+byte lastKeyState = 0;
+
+// used by processReading() and checkHold()
+unsigned int holdDwellMs = 0;        // 0 sends chords on release
+unsigned long chordChangeTime = 0;   // the chord being pressed last changed
+bool chordIsPrefix = false;          // a bigger chord starts with it
+
+// used by checkHold(), processReading() and sendRawKey()
+unsigned int repeatHoldMs = 0;       // 0 sends every chord as a tap
+byte repeatLayers = 0;               // 1 << Mode, every plain key repeats
+bool chordIsRepeat = false;          // the chord being pressed repeats
+bool isRepeatHeld = false;           // key down sent, its key up still to go
+
+// used by processReading() and chordOf()
+bool rolloverChords = false;
+byte rolloverHeldSwitches = 0x00;
+byte consumedSwitches = 0;           // still down from the chord sent last
+
+// used by sendKey()
+// ctb
+// also the layer number for keymapLookup(), see keymap_layers
+enum Mode {
+  ALPHA,
+  NUMSYM,
+  FUNCTION,
+  POINTER   // the mouse, see Pointer.h
+};
+
+bool isNumsymLocked = false;
+bool isPointerLocked = false;
+keymap_t latchMods = 0x00;  // currently latched modKeys
+keymap_t modKeys = 0x00;  // current modifyers ( L/Rshift,L/Ralt, L/Rctrl, L/Rgui )
+
+Mode mode = ALPHA;
+
+// used by sendKey() and recordKey(), see KeymapOverlay.h
+enum RecordStep {
+  RECORD_OFF,
+  RECORD_TARGET,  // the next chord is the one to change
+  RECORD_CODE     // and the one after gives its code
+};
+
+RecordStep recordStep = RECORD_OFF;
+byte recordLayer = 0;
+byte recordChord = 0;
+
+// used by processREADING and loop
+byte previousStableReading = 0;
+byte currentStableReading = 0;
+
+ScanStats scanStats;
+
+// used by idle() and scan()
+unsigned long idleSleepMs = 5000;  // quiet time before sleeping, 0 never
+SleepStats sleepStats;
+bool isAsleep = false;
+bool isWaitingForKey = false;      // woke, no key sent yet
+unsigned long lastActiveTime = 0;  // the last pass that had work to do
+unsigned long lastWakeTime = 0;
+unsigned long sentAtWake = 0;
+
+// used by chorderInit() and reportWritten()
+BootStats bootStats;
+
+// used by scan(), processReading() and sendChord(), for Latency.h
+unsigned long rawEdgeMicros = 0;     // the switches started to change
+bool isRawEdgePending = false;       // and haven't been debounced yet
+unsigned long stableEdgeMicros = 0;  // the raw change behind the last stable one
+unsigned long chordStartMicros = 0;  // the chord being pressed began
+unsigned long chordEdgeMicros = 0;   // the change that completed the chord sent
+bool isReportPending = false;        // and its first report hasn't gone yet
+unsigned long debounceDelay = 10;  // the debounce time in ms (1 - 15); increase if the output flickers
+//=====RESET=====================RESET==========================
+void reset(){
+	isRepeatHeld = false;  // the key up below clears a held key too
+	mode = ALPHA;
+	latchMods=0x00;
+	modKeys = 0x00;
+	isNumsymLocked = false;
+	isPointerLocked = false;
+	recordStep = RECORD_OFF;  // and give up a recording
+	outputClear();  // drop whatever is left of a macro
+	pointerStop();  // and let go of a drag
+	sendRawKeyUp();
+}
+//=====LATENCY==========================LATENCY=====================
+// sendKey() for a chord that is complete, timed for Latency.h
+static void sendChord(byte chord){
+	unsigned long start = halMicros();
+	latencyRecord(LAT_CHORD, start - chordStartMicros);
+	chordEdgeMicros = stableEdgeMicros;
+	isReportPending = true;
+	sendKey(chord);
+	latencyRecord(LAT_DISPATCH, halMicros() - start);
+}
+
+// the first report or text to go out after sendChord() ends its total,
+// and the first after power-up the boot
+static void reportWritten(){
+	if (!bootStats.firstKeyMs) bootStats.firstKeyMs = halMillis() | 1;  // not 0 at power-up
+	if (!isReportPending) return;
+	isReportPending = false;
+	latencyRecord(LAT_TOTAL, halMicros() - chordEdgeMicros);
+}
+
+//=====SEND KEY====================SEND KEY========================
+// the mode and modifiers once a key is sent: ALPHA unless a layer is
+// locked, the latched modifiers
+static void baseMode(){
+  modKeys = latchMods; //sets modKeys to any currently latched mods, or 0x00 if none
+  mode = ALPHA;
+	// Reset the modKeys and mode based on
+	if (isNumsymLocked){
+    mode = NUMSYM;
+  }
+  if (isPointerLocked){
+    mode = POINTER;
+  }
+}
+
+// a chord while RECORD_BINDING waits for one; false when it is to be
+// sent as usual, the mode keys (so the chord can be in any layer) and
+// the resets
+static bool recordKey(byte chord, keymap_t theKey){
+  if ((theKey > DIV_Modes && theKey <= MULTI_NumShift) || theKey == MODE_POINTER) return false;
+  if (recordStep == RECORD_TARGET) {
+    if (theKey == RECORD_BINDING) {
+      recordStep = RECORD_OFF;  // pressed again, nothing to change
+      halLogP(PSTR("overlay off"));
+    } else {
+      recordStep = RECORD_CODE;
+      recordLayer = mode;
+      recordChord = chord;
+    }
+  } else {
+    keymap_t chartCode = keymapChartLookup(recordLayer, recordChord);
+    if (theKey == RECORD_BINDING) theKey = chartCode;  // back to the chart
+    recordStep = RECORD_OFF;
+    if (overlayBind(recordLayer, recordChord, theKey, chartCode)) {
+      char line[20] = "overlay";
+      *logHex(logHex(logHex(line + 7, recordLayer), recordChord), theKey) = 0;
+      halLog(line);
+    } else {
+      halLogP(PSTR("overlay full"));
+    }
+  }
+  baseMode();
+  return true;
+}
+
+// used by processReading()
+// ctb
+void sendKey(byte keyState){
+  keymap_t theKey;  
+  // Determine the key based on the current mode's keymap
+  theKey = keymapLookup(mode, keyState);
+  traceRecord(TRACE_CHORD, keyState, theKey);
+  if (recordStep && recordKey(keyState, theKey)) return;
+  usageCount(mode, keyState, theKey);
+  dispatchKey(theKey);
+}
+
+//=====DISPATCH KEY================DISPATCH KEY====================
+// the codes between DIV_Modes and DIV_Combo that aren't media keys, and
+// raw codes past the dictionary; false when the modifiers and mode are to
+// stay as they are
+static bool dispatchCommand(keymap_t theKey){
+  switch (theKey)  {
+		// Handle mode switching - return immediately after the mode has changed
+		// Handle basic mode switching
+  case LATCH:
+		if ( latchMods == 0x00 ) {  // latch was not set, so set it  current modKeys 
+			latchMods = modKeys;
+		} else {
+      latchMods = 0x00;   // latch was set, so clear it.   
+		}
+		return true;
+  case MODE_NUM:
+    if (mode == NUMSYM) {
+      mode = ALPHA;
+    } else {
+      mode = NUMSYM;
+    }
+    return false;
+  case MODE_FUNC:
+    if (mode == FUNCTION) {
+      mode = ALPHA;
+    } else {
+      mode = FUNCTION;
+    }
+    return false;
+  case MODE_RESET:
+		reset();
+    return false;
+  case MODE_MRESET:
+		reset();
+    usageFlush();   // what is counted since the last flush
+    halPowerOff();  // turn off 3.3v regulator enable.
+    return false;
+		// something with a battery only		
+	case BAT_LVL:
+		// get and send the battedy level, then
+		// do a mode_reset
+    gAsBattLvl();
+		reset();
+    return false;
+	case TRACE_DUMP:
+		traceDump();
+		reset();
+		return false;
+	case USAGE_DUMP:
+		usageDump();
+		reset();
+		return false;
+	case LATENCY_REPORT: {
+		// the histograms to the serial port, p50/p90 typed out
+		char summary[LatencySummarySize];
+		latencyReport();
+		latencySummary(summary);
+		sendString(summary);
+		reset();
+		return false;
+	}
+	case MODE_FRESET:
+    sendFactoryReset();
+    return false;
+		// back to common code
+		// Handle mode locks
+  case MODE_NUMLCK:
+    if (isNumsymLocked){
+      isNumsymLocked = false;
+      mode = ALPHA;
+    } else {
+      isNumsymLocked = true;
+      mode = NUMSYM;
+    }
+    return false;
+  case MODE_POINTER:
+    if (isPointerLocked){
+      isPointerLocked = false;
+      pointerStop();
+      mode = ALPHA;
+    } else {
+      isPointerLocked = true;
+      mode = POINTER;
+    }
+    return false;
+  case RECORD_BINDING:
+    recordStep = RECORD_TARGET;
+    halLogP(PSTR("overlay record"));
+    return true;
+		// Handle special keys
+  case MULTI_NumShift:
+    if (mode == NUMSYM) {
+      mode = ALPHA;
+    } else {
+      mode = NUMSYM;
+    }
+    modKeys = modKeys ^ 0x02;
+    return false;
+  case MULTI_CtlAlt:
+    modKeys = modKeys ^ 0x01;
+    modKeys = modKeys ^ 0x04;
+    return false;
+  default:
+    // raw codes above the dictionary, RAW_LGUI and the like
+    sendRawKey(modKeys, theKey);
+    return true;
+  }
+}
+
+// What a key code does, by its range in KeyCodes.h: the ranges that are
+// data (KeyTables.h, MacroTable.h, the dictionary) are a compare and a
+// table read, plain keys go first as they are most of the typing, and
+// only the codes that change state are left to the switch.
+void dispatchKey(keymap_t theKey){
+  if (theKey < DIV_Mods) {
+    sendRawKey(modKeys, theKey);
+  } else if ((byte)(theKey - MOD_LCTRL) < sizeof(modifier_bits)) {
+    // Handle modifier keys toggling
+    modKeys ^= pgm_read_byte(&modifier_bits[theKey - MOD_LCTRL]);
+    return;
+  } else if (theKey >= DIV_Word && theKey < DictionaryCodeEnd) {
+    typeWord(theKey - DIV_Word, modKeys, latchMods);
+  } else if (theKey >= DIV_Macro && theKey < MacroCodeEnd) {
+    // Macros, see MacroTable.h
+    runMacro(theKey - DIV_Macro, modKeys, latchMods);
+  } else if (theKey >= DIV_Combo && theKey < DIV_Macro) {
+    const uint8_t *combo = key_combos[theKey - DIV_Combo];
+    sendRawKey(pgm_read_byte(&combo[0]), pgm_read_byte(&combo[1]));
+  } else if (theKey >= DIV_Pointer && theKey < DIV_OverlayMacro) {
+    // the moves went while the chord was held, see pointerHeld()
+    pointerKey(theKey);
+  } else if (theKey >= DIV_OverlayMacro && theKey < DIV_Combo) {
+    overlayMacro(theKey - DIV_OverlayMacro);
+  } else if (theKey >= MEDIA_playpause && theKey <= MEDIA_voldn) {
+    const char *control;
+    memcpy_P(&control, &media_controls[theKey - MEDIA_playpause], sizeof(control));
+    queueControlKeyP(control);
+  } else if (!dispatchCommand(theKey)) {
+    // mode changes and the like are done, they keep the modifiers
+    return;
+  }
+  baseMode();
+}
+
+//======SEND RAW KEY====================SEND RAW KEY================
+// ctb
+// used in sendKey()
+//
+// new sendRawKey to make sure all is working as expected
+// before trying to impliment seporate watching for key down and key up
+// to allow host side key repeat
+//
+// key down then key up, through the output queue so that it goes out
+// in order with the rest of a macro; see OutputQueue.h.  For a chord
+// held to repeat the key up waits for its release, see endRepeat().
+// 
+
+
+void sendRawKey(char modKey, char rawKey){
+	queueKeyDown(modKey, rawKey);
+	if (isRepeatHeld) return;
+	queueKeyUp();
+}
+
+//======SEND RAW KEY DOWN===============SEND RAW KEY DOWN============
+// through the output backend (OutputBackend.h), BLE unless setup()
+// picked another
+// used by the output queue, sends immediately
+//
+
+void sendRawKeyDn(char modKey, char rawKey){
+	outputBackend->keyDown(modKey, rawKey);
+	traceRecord(TRACE_DOWN, modKey, rawKey);
+	reportWritten();
+}
+
+//======SEND RAW KEY UP==============SEND RAW KEY UP==================
+// used by the output queue, reset() and sendString(), sends immediately
+//
+void sendRawKeyUp(){
+	outputBackend->keyUp();
+	traceRecord(TRACE_UP);
+}  
+//======SEND TEXT===================SEND TEXT=========================
+// text to the backend in one go, or a key at a time for backends that
+// only send reports; characters with no key are left out
+//
+static void sendText(const char *text, bool isFlash){
+	traceRecord(TRACE_TEXT);
+	reportWritten();
+	if (outputBackend->text) {
+		outputBackend->text(text, isFlash);
+	} else {
+		char c;
+		byte modKey, rawKey;
+		while ((c = isFlash ? pgm_read_byte(text) : *text)) {
+			text++;
+			if (!hidFromAscii(c, &modKey, &rawKey)) continue;
+			outputBackend->keyDown(modKey, rawKey);
+			outputBackend->keyUp();
+		}
+	}
+  sendRawKeyUp(); // just in case as there have been some odd key repeats happening.
+}
+
+//======SEND STRING============SEND STRING==========================
+// Currently this is only for testing, it was temporarily added to MRESET
+//
+void sendString(const char *StringOut){
+	outputFlush();  // anything queued goes first
+	sendText(StringOut, false);
+}  
+
+//======SEND STRING FROM FLASH======SEND STRING FROM FLASH============
+// used by the output queue for macro text, sends immediately
+//
+void sendStringP(const char *flashText){
+	sendText(flashText, true);
+}
+
+//======SEND WORD===================SEND WORD=========================
+// used by the output queue for dictionary words, the whole word in one
+// command; sends immediately
+//
+void sendWord(byte index, byte wordCase){
+	char word[DictionaryWordSize];
+	if (!dictionaryWord(index, word, wordCase)) return;
+	sendText(word, false);
+}
+
+//======SEND MOUSE KEY=====SEND MOUSE KEY===========================
+// the buttons now down, "0" for none; only where the backend has a
+// mouse.  Used by the output queue, sends immediately: a click is this
+// and "0" queued after it, see Pointer.h
+// 
+void sendMouseKey(const char *MouseKey){
+	if (!outputBackend->mouseButton) return;
+	outputBackend->mouseButton(MouseKey);
+	traceRecord(TRACE_TEXT);
+	reportWritten();
+}
+
+// at most size - 1 chars of flashText into buf, 0 terminated
+static void copyFlash(char *buf, const char *flashText, byte size){
+	byte n = 0;
+	while (n < size - 1 && (buf[n] = pgm_read_byte(flashText + n))) n++;
+	buf[n] = 0;
+}
+
+// the same for buttons in PROGMEM, as Pointer.cpp holds them
+void sendMouseKeyP(const char *flashButtons){
+	char buttons[MouseButtonsSize];
+	copyFlash(buttons, flashButtons, sizeof(buttons));
+	sendMouseKey(buttons);
+}
+//======SEND CONTROL KEY============SEND CONTROL KEY==================
+// used by the output queue, sends immediately
+//
+void sendControlKey(const char *cntrlName){
+  // note: for Volume +/- and the few other keys that take a time to hold, simply add it into the string
+  // for example:
+  //    sendControlKey("VOLUME+,500")
+  // will send Volume up and hold it for half a second
+	outputBackend->control(cntrlName);
+	traceRecord(TRACE_TEXT);
+	reportWritten();
+}
+//======SEND CONTROL KEY FROM FLASH===SEND CONTROL KEY FROM FLASH====
+// the same for a name in PROGMEM, as media_controls holds them; it is
+// copied out only while it goes
+//
+static_assert(sizeof(media_previous) <= ControlNameSize, "the longest media_controls name fits");
+
+void sendControlKeyP(const char *flashName){
+	char cntrlName[ControlNameSize];
+	copyFlash(cntrlName, flashName, sizeof(cntrlName));
+	sendControlKey(cntrlName);
+}
+//======GET AND SEND BATTERY LEVEL==================================
+// a fresh reading from halReadBattery(), VBATPIN on the BLE feather,
+// typed as " Kbd Batt: 3.87volts. " in one go; in mV so no float
+// code is pulled in; the text is kept in flash till then
+static const char battLvlText[] PROGMEM = " Kbd Batt: 0.00volts. ";
+
+void gAsBattLvl() {   
+	unsigned int mv = batteryMillivolts(halReadBattery());
+	unsigned int hundredths = (mv + 5) / 10;
+	char text[sizeof(battLvlText)];
+	memcpy_P(text, battLvlText, sizeof(text));
+	text[11] += hundredths / 100 % 10;
+	text[13] += hundredths / 10 % 10;
+	text[14] += hundredths % 10;
+	sendString(text);
+	batterySample();  // and the level the host shows, on the next quiet pass
+}
+//=====ROLLOVER=========================ROLLOVER====================
+// the part of a reading that makes up the chord being pressed: with
+// rolloverChords, not the fingers still down from the chord sent last,
+// other than rolloverHeldSwitches
+static byte chordOf(byte reading){
+	return reading & ~(consumedSwitches & ~rolloverHeldSwitches);
+}
+
+// a chord went out; with rolloverChords the fingers still down were
+// part of it and don't count toward the next one
+static void chordSent(){
+	if (rolloverChords) consumedSwitches = currentStableReading;
+}
+
+//=====HOLD=============================HOLD========================
+// true when some chord with more fingers than 'chord' is bound to
+// something in the current layer
+static bool hasBiggerChord(byte chord){
+	byte others = ~chord & 0x7F;
+	for (byte extra = others; extra; extra = (extra - 1) & others) {
+		if (keymapLookup(mode, chord | extra) != ENUMKEY__) return true;
+	}
+	return false;
+}
+
+// true when 'chord' is bound to a plain key that repeats, one in
+// repeat_keys (KeyTables.h) or any in a layer in repeatLayers
+static bool isRepeatKey(byte chord){
+	keymap_t theKey = keymapLookup(mode, chord);
+	if (theKey == ENUMKEY__ || theKey >= DIV_Mods) return false;
+	if (repeatLayers & (1 << mode)) return true;
+	for (byte i = 0; i < sizeof(repeat_keys); i++) {
+		if (pgm_read_byte(&repeat_keys[i]) == theKey) return true;
+	}
+	return false;
+}
+
+// the chord being pressed got another finger (or lost one on its way
+// to a release), start its dwell over
+static void chordChanged(){
+	chordIsRepeat = repeatHoldMs && isRepeatKey(chordOf(currentStableReading));
+	if (!holdDwellMs && !chordIsRepeat) return;
+	chordChangeTime = halMillis();
+	chordIsPrefix = holdDwellMs && hasBiggerChord(chordOf(currentStableReading));
+}
+
+// a repeating chord held still for repeatHoldMs: its key goes down now
+// and stays down, for the host's own autorepeat, until endRepeat()
+static void startRepeat(){
+	state = REPEATING;
+	isRepeatHeld = true;
+	sendChord(chordOf(currentStableReading));
+	chordSent();
+}
+
+static void endRepeat(){
+	if (!isRepeatHeld) return;
+	isRepeatHeld = false;
+	queueKeyUp();
+}
+
+// with holdDwellMs set, send the chord being pressed once it has held
+// still that long, or straight away when no bigger chord starts with
+// it; not while another finger is still on its way down.  With
+// rolloverChords the next chord can start before this one is lifted.
+static void checkHold(byte keyState){
+	if (keyState & ~currentStableReading) return;
+	unsigned long held = halMillis() - chordChangeTime;
+	if (chordIsRepeat) {
+		// a tap if it is lifted before then, whatever holdDwellMs says
+		if (held >= repeatHoldMs) startRepeat();
+		return;
+	}
+	if (chordIsPrefix && held < holdDwellMs) return;
+	state = rolloverChords ? RELEASING : HOLDING;
+	sendChord(chordOf(currentStableReading));
+	chordSent();
+}
+
+//=====PROCESS READING==================PROCESS READING===============
+// ctb
+// used in loop()
+//
+// check if was pressing chord and now releasing, change to releasing,
+//                                                 then send the key
+//         if chord was not pressing and now is, change to pressing
+//         if chord was sent on hold and now releasing, change to releasing
+// a finger still down from the chord sent last (see chordOf()) lifting
+// is neither
+//
+void processReading(){
+	byte lifted = previousStableReading & ~currentStableReading & ~consumedSwitches;
+	switch (state) {
+	case PRESSING:
+		if (lifted) {
+			state = RELEASING;
+			sendChord(chordOf(previousStableReading));
+			chordSent();
+		} else {
+			chordChanged();
+		}
+		break;
+		
+	case RELEASING:
+		if (currentStableReading & ~previousStableReading) {
+			state = PRESSING;
+			chordStartMicros = stableEdgeMicros;
+			chordChanged();
+		}
+		break;
+
+	case HOLDING:
+		if (lifted) {
+			state = RELEASING;
+		}
+		break;
+
+	case REPEATING:
+		// any change lets the key go; with rolloverChords another finger
+		// starts the next chord, otherwise it waits for a lift
+		if (currentStableReading == previousStableReading) break;
+		endRepeat();
+		if (!(currentStableReading & ~previousStableReading)) {
+			state = RELEASING;
+		} else if (rolloverChords) {
+			state = PRESSING;
+			chordStartMicros = stableEdgeMicros;
+			chordChanged();
+		} else {
+			state = HOLDING;
+		}
+		break;
+	}
+	consumedSwitches &= currentStableReading;
+}
+
+
+//=====POINTER==========================POINTER=====================
+// in the POINTER layer the code of the chord being pressed, which moves
+// the pointer until a finger lifts
+static keymap_t heldPointerKey(){
+	if (mode != POINTER || state == RELEASING) return ENUMKEY__;
+	return keymapLookup(mode, chordOf(currentStableReading));
+}
+
+//=====INIT=============================INIT========================
+// back to the power-on state, the globals above start out this way
+// on the board; host tests call this between cases.
+void chorderInit(){
+	state = RELEASING;
+	lastKeyState = 0;
+	chordChangeTime = 0;
+	chordIsPrefix = false;
+	chordIsRepeat = false;
+	isRepeatHeld = false;
+	consumedSwitches = 0;
+	previousStableReading = 0;
+	currentStableReading = 0;
+	debounceInit();
+	traceInit();
+	latencyInit();
+	isRawEdgePending = false;
+	isReportPending = false;
+	mode = ALPHA;
+	latchMods = 0x00;
+	modKeys = 0x00;
+	isNumsymLocked = false;
+	isPointerLocked = false;
+	recordStep = RECORD_OFF;
+	outputClear();
+	outputStats = OutputStats();
+	outputSelect(&bleBackend);
+	ackInit();
+	scanStats = ScanStats();
+	sleepStats = SleepStats();
+	isAsleep = false;
+	isWaitingForKey = false;
+	lastActiveTime = halMillis();
+	lastWakeTime = lastActiveTime;
+	bootStats.readyMs = halMillis();
+	bootStats.firstKeyMs = 0;
+	usageInit();
+	overlayInit();
+	pointerInit();
+	batteryInit();
+}
+
+//========LOOP=========================LOOP==================
+// ctb
+// used in loop()
+// a quiet pass with no switch down and no chord in progress; once that
+// has gone on for idleSleepMs sleep, and keep sleeping each pass after
+// (sooner and longer on a low battery, see Battery.h)
+static void idle() {
+  usageService();  // a due flush goes out while nothing else is
+  batteryService();
+  if (!isAsleep) batteryPublish();
+  if (!idleSleepMs) return;
+  unsigned long now = halMillis();
+  bool isLow = batteryStats.isLow;
+  unsigned long sleepAfter = isLow && batteryLowIdleMs < idleSleepMs ? batteryLowIdleMs : idleSleepMs;
+  if (!isAsleep) {
+    if (now - lastActiveTime < sleepAfter) return;
+    isAsleep = true;
+    sleepStats.sleeps++;
+    sleepStats.awakeMs += now - lastWakeTime;
+  }
+  for (byte i = 0; i < (isLow ? BatteryLowSleeps : 1); i++) halSleep();
+  sleepStats.asleepMs += halMillis() - now;
+}
+
+// a pass with work to do, waking up if it was asleep
+static void active() {
+  lastActiveTime = halMillis();
+  if (isAsleep) {
+    isAsleep = false;
+    isWaitingForKey = true;
+    lastWakeTime = lastActiveTime;
+    sentAtWake = outputStats.sent;
+  }
+}
+
+// one scan; the switches are read in a single call and when nothing has
+// changed, nothing is bouncing and nothing is waiting to go out (or for
+// the module to answer) the pass ends there, so most passes cost little
+// more than the read
+static void scan() {
+  byte keyState = halReadSwitches();
+
+  bool isDwelling = (holdDwellMs || chordIsRepeat) && state == PRESSING;
+  if (debounceIsQuiet(keyState) && !outputQueueDepth() && !isDwelling && !ackWaiting() &&
+      !pointerBusy()) {
+    scanStats.idleScans++;
+    isRawEdgePending = false;  // a bounce that came to nothing
+    if (!keyState && state == RELEASING) idle();
+    return;
+  }
+  active();
+	
+  if (lastKeyState != keyState) {
+    scanStats.changes++;
+    traceRecord(TRACE_RAW, keyState);
+    if (!isRawEdgePending) {
+      rawEdgeMicros = halMicros();
+      isRawEdgePending = true;
+    }
+  }
+  currentStableReading = debounce(keyState);
+	
+  if (previousStableReading != currentStableReading) {
+    unsigned long now = halMicros();
+    stableEdgeMicros = isRawEdgePending ? rawEdgeMicros : now;
+    latencyRecord(LAT_DEBOUNCE, now - stableEdgeMicros);
+    isRawEdgePending = keyState != currentStableReading;
+    traceRecord(TRACE_STABLE, currentStableReading);
+    processReading();
+    pointerHeld(heldPointerKey());
+    previousStableReading = currentStableReading;
+  }
+  if ((holdDwellMs || chordIsRepeat) && state == PRESSING) checkHold(keyState);
+	
+  lastKeyState = keyState;
+
+  // send what is due from the output queue, macros go out a key at a
+  // time over several passes while the scan keeps running
+  outputService();
+  pointerService();  // after the keys, motion only goes with none queued
+
+  if (isWaitingForKey && outputStats.sent != sentAtWake) {
+    unsigned long wakeToKey = halMillis() - lastWakeTime;
+    isWaitingForKey = false;
+    sleepStats.wakes++;
+    sleepStats.wakeToKeyMs += wakeToKey;
+    if (wakeToKey > sleepStats.maxWakeToKeyMs) sleepStats.maxWakeToKeyMs = wakeToKey;
+  }
+}
+
+void chorderLoop() {
+  if (scanStats.scans++ % ScanCostEvery) {
+    scan();
+    return;
+  }
+  unsigned long start = halMicros();
+  scan();
+  if (isAsleep) return;  // not a scan cost
+  unsigned long cost = halMicros() - start;
+  scanStats.costSamples++;
+  scanStats.costMicros += cost;
+  if (cost > scanStats.maxCostMicros) scanStats.maxCostMicros = cost;
+}
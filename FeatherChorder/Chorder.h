@@ -0,0 +1,105 @@
+// Chorder.h
+// The board independent part of FeatherChorder: switch scan, debounce,
+// the chord state machine and key sending.  Split out from
+// FeatherChorder.ino so it can also be built and measured on a PC,
+// see ChorderHal.h for what a board has to provide.
+
+#ifndef CHORDER_H
+#define CHORDER_H
+
+#include "ChorderHal.h"
+
+// A few timing constants
+extern const int HalfSec;            // for a half second delay
+extern const int InterstitialDelay;  // time between raw key sends in a macro
+
+extern unsigned long debounceDelay;  // the debounce time in ms (1 - 15), see Debounce.h
+
+// 0 sends a chord when its first finger lifts.  Otherwise a chord is sent
+// while still held, once it has stayed the same for holdDwellMs (or at
+// once if no bigger chord starts with it), and lifting only ends it.
+extern unsigned int holdDwellMs;
+
+// Hold to repeat: a chord bound to a key that repeats, held still for
+// repeatHoldMs, sends its key down then and the key up only when a
+// finger moves, so the host's own autorepeat runs while it is held;
+// lifted sooner it is a tap as before.  The keys that repeat are those
+// in repeat_keys (KeyTables.h: arrows, backspace, delete, space ...)
+// and every plain key of a layer whose 1 << Mode bit is in
+// repeatLayers.  0, the default, sends every chord as a tap; 250 is a
+// good start when turning it on.  reset() lets go of a held key.
+extern unsigned int repeatHoldMs;
+extern byte repeatLayers;
+
+// Rollover: the fingers still down from the chord sent last don't count
+// toward the next chord, so the next one can be pressed before they are
+// lifted, and lifting them sends nothing.  Switches in
+// rolloverHeldSwitches (keyState bits) still count while held, for a
+// thumb held down like a shift across several chords.
+extern bool rolloverChords;
+extern byte rolloverHeldSwitches;
+
+// Scan counters, for comparing scan backends.  scans over elapsed time is
+// the scan rate, costMicros / costSamples the time one chorderLoop() pass
+// takes; one pass in ScanCostEvery is timed so the timing stays cheap.
+struct ScanStats {
+  unsigned long scans;        // chorderLoop() passes
+  unsigned long changes;      // passes where the switches read differently
+  unsigned long idleScans;    // passes with nothing to do past the read
+  unsigned long costSamples;
+  unsigned long costMicros;
+  unsigned long maxCostMicros;
+};
+extern ScanStats scanStats;
+const unsigned int ScanCostEvery = 256;
+
+// Idle sleep: after idleSleepMs (0 = never) with no switch down, no chord
+// in progress and nothing left to send, each scan puts the board to sleep
+// with halSleep() until a switch is found down again.
+extern unsigned long idleSleepMs;
+
+// to tune idleSleepMs; awakeMs covers up to the last time it went to sleep,
+// wakeToKey is from the scan that found a switch after sleeping to the
+// first key sent
+struct SleepStats {
+  unsigned long sleeps;       // times it went to sleep
+  unsigned long asleepMs;
+  unsigned long awakeMs;
+  unsigned long wakes;        // wakes that went on to send a key
+  unsigned long wakeToKeyMs;  // total over those
+  unsigned long maxWakeToKeyMs;
+};
+extern SleepStats sleepStats;
+
+// boot to first key, for the fast boot in setup(): both from power-up
+// (halMillis()), readyMs when chorderInit() ran at the end of setup(),
+// firstKeyMs when the first report or text went out after it
+struct BootStats {
+  unsigned long readyMs;
+  unsigned long firstKeyMs;  // 0 until then
+};
+extern BootStats bootStats;
+
+void chorderInit();   // back to power-on state, used by setup() and host tests
+void chorderLoop();   // one scan of the switches, called from loop()
+
+void processReading();
+void sendKey(byte keyState);
+void dispatchKey(byte theKey);  // sendKey() after the keymap lookup
+void reset();
+
+void sendRawKey(char modKey, char rawKey);
+void sendRawKeyDn(char modKey, char rawKey);
+void sendRawKeyUp();
+void sendString(const char *StringOut);
+void sendStringP(const char *flashText);
+void sendWord(byte index, byte wordCase);
+void sendMouseKey(const char *MouseKey);
+void sendMouseKeyP(const char *flashButtons);  // copied out to MouseButtonsSize
+const byte MouseButtonsSize = 4;               // "LRM" and its 0
+void sendControlKey(const char *cntrlName);
+void sendControlKeyP(const char *flashName);  // copied out to ControlNameSize
+const byte ControlNameSize = 16;
+void gAsBattLvl();
+
+#endif
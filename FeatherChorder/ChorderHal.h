@@ -0,0 +1,55 @@
+// ChorderHal.h
+// Hardware abstraction for the chorder core (Chorder.cpp).
+// The core only reaches the switches, the clock and the Bluefruit through
+// the calls below, so the same scan/debounce/chord/send code builds for the
+// Feather (implemented in FeatherChorder.ino) and natively on Linux
+// (implemented in host/HostHal.cpp) for tests and benchmarks.
+
+#ifndef CHORDER_HAL_H
+#define CHORDER_HAL_H
+
+#include <Arduino.h>
+
+// number of chording switches, index 0 is the Pinky, 6 the Far Thumb
+const byte NumSwitches = 7;
+
+//=====PINS=============================PINS========================
+// all switches in one read, bit n set when switch n is closed
+// (bit 0 the Pinky), called once per scan so it wants to be cheap
+byte halReadSwitches();
+
+//=====CLOCK============================CLOCK=======================
+unsigned long halMillis();
+unsigned long halMicros();
+void halDelay(unsigned long ms);
+// sleep until something wakes the board, at most a few tens of ms; the
+// caller looks at the switches again and decides whether to go back
+void halSleep();
+
+//=====TRANSPORT========================TRANSPORT===================
+// one complete AT command for the Bluefruit module, line ending added here
+void halPrintln(const char *text);
+// the next whole line the module has answered (OK, ERROR ...), without
+// its line ending and cut to 'size'; false at once if there isn't one
+bool halReadLine(char *line, byte size);
+
+//=====EEPROM===========================EEPROM======================
+// the 32u4's 1 KB EEPROM, erased cells read 0xFF.  A write of the value
+// a cell already holds is skipped, as it wears the cell for nothing;
+// one that isn't takes about 3.4 ms on the board.
+const unsigned int HalEepromSize = 1024;
+byte halEepromRead(unsigned int addr);
+void halEepromWrite(unsigned int addr, byte value);
+
+//=====LOG==============================LOG=========================
+// one line of diagnostics (see Trace.h) for whoever is listening on the
+// USB serial port; not the Bluefruit
+void halLog(const char *line);
+void halLogP(const char *flashLine);  // a line in PROGMEM
+
+//=====BOARD============================BOARD=======================
+int halReadBattery();     // raw analog reading of VBATPIN
+void halPowerOff();       // drop the 3.3v regulator enable
+void sendFactoryReset();  // clear the BT known hosts table
+
+#endif
@@ -0,0 +1,92 @@
+// Debounce.cpp
+// see Debounce.h
+
+#include "Debounce.h"
+#include "Chorder.h"
+
+const byte AllSwitches = (1 << NumSwitches) - 1;
+
+// counters go up to 15 ms
+const byte CountBits = 4;
+const byte MaxCount = (1 << CountBits) - 1;
+
+byte eagerSwitches = AllSwitches;
+
+// count[i] holds bit i of every switch's count: the ms its reading has
+// held since it last changed, stopping at the debounce time
+static byte count[CountBits];
+static byte settled = AllSwitches;  // switches whose count has got there
+static byte lastRaw = 0;
+static byte stable = 0;
+static unsigned long lastTick = 0;
+
+// debounceDelay as a count
+static byte limit(){
+  if (debounceDelay < 1) return 1;
+  if (debounceDelay > MaxCount) return MaxCount;
+  return debounceDelay;
+}
+
+//=====COUNTERS=========================COUNTERS====================
+// switches whose count is n
+static byte countIs(byte n){
+  byte match = AllSwitches;
+  for (byte i = 0; i < CountBits; i++) {
+    match &= (n >> i) & 1 ? count[i] : ~count[i];
+  }
+  return match;
+}
+
+static void countSet(byte switches, byte n){
+  for (byte i = 0; i < CountBits; i++) {
+    if ((n >> i) & 1) count[i] |= switches;
+    else count[i] &= ~switches;
+  }
+}
+
+// add one to the count of 'switches'
+static void countStep(byte switches){
+  byte carry = switches;
+  for (byte i = 0; i < CountBits; i++) {
+    byte was = count[i];
+    count[i] = was ^ carry;
+    carry &= was;
+  }
+}
+
+//=====DEBOUNCE=========================DEBOUNCE====================
+void debounceInit(){
+  countSet(AllSwitches, limit());
+  settled = AllSwitches;
+  lastRaw = 0;
+  stable = 0;
+  lastTick = halMillis();
+}
+
+byte debounce(byte raw){
+  // first the time since the last call, which belongs to the last reading
+  byte n = limit();
+  unsigned long now = halMillis();
+  unsigned long ticks = now - lastTick;
+  lastTick = now;
+  while (ticks-- && settled != AllSwitches) {
+    countStep(AllSwitches & ~settled);
+    settled = countIs(n);
+  }
+  // a reading that has held long enough counts for every switch
+  stable ^= (lastRaw ^ stable) & settled;
+
+  byte edge = raw ^ lastRaw;
+  if (edge) {
+    // a clean edge on an eager switch counts straight away
+    stable ^= edge & eagerSwitches & settled;
+    countSet(edge, 0);
+    settled &= ~edge;
+    lastRaw = raw;
+  }
+  return stable;
+}
+
+bool debounceIsQuiet(byte raw){
+  return raw == lastRaw && raw == stable && settled == AllSwitches;
+}
@@ -0,0 +1,27 @@
+// Debounce.h
+// Per switch debounce for all seven switches at once.  Each switch has
+// its own counter (kept as vertical counters, one byte per counter bit),
+// so a bounce on one switch no longer holds back the others.
+//
+// A switch changes state when its reading has held for debounceDelay ms.
+// An eager switch also takes an edge at once when it has been quiet for
+// debounceDelay ms before it, and only the bounce after that is filtered
+// out; a finger landing or lifting on a settled switch is seen the same
+// scan instead of debounceDelay later.
+
+#ifndef DEBOUNCE_H
+#define DEBOUNCE_H
+
+#include "ChorderHal.h"
+
+// bit n set: switch n is eager, as keyState (bit 0 the Pinky)
+extern byte eagerSwitches;
+
+void debounceInit();
+// feed this scan's raw reading, returns the debounced keyState
+byte debounce(byte rawKeyState);
+// true when 'rawKeyState' is what debounce() already returns and no
+// switch is still settling, so calling debounce() would change nothing
+bool debounceIsQuiet(byte rawKeyState);
+
+#endif
@@ -0,0 +1,65 @@
+// Dictionary.cpp
+// see Dictionary.h
+
+#include "Dictionary.h"
+#include "Chorder.h"
+#include "KeyCodes.h"
+#include "Macro.h"
+#include "OutputQueue.h"
+#include "WordTable.h"
+
+const byte dictionaryWordCount = DIV_WordLast - DIV_Word;
+
+const byte ShiftMods = 0x22;  // left and right shift
+
+//=====LOOKUP===========================LOOKUP======================
+// walks the front coded list up to 'index'; the whole list is a few
+// hundred bytes of flash at most.  A byte below ' ' starts an entry.
+byte dictionaryWord(byte index, char *buf, byte wordCase){
+  if (index >= dictionaryWordCount) return 0;
+  const char *p = dictionary_words;
+  byte len = 0;
+  char c = pgm_read_byte(p++);
+  for (byte i = 0; i <= index; i++) {
+    len = c - 1;
+    while ((byte)(c = pgm_read_byte(p++)) >= ' ') {
+      if (len < DictionaryWordSize - 1) buf[len++] = c;
+    }
+  }
+  buf[len] = 0;
+  for (byte i = 0; i < len; i++) {
+    if (wordCase == WORD_UPPER || (wordCase == WORD_CAPITAL && i == 0)) {
+      if (buf[i] >= 'a' && buf[i] <= 'z') buf[i] -= 'a' - 'A';
+    }
+  }
+  return len;
+}
+
+//=====TYPE WORD========================TYPE WORD===================
+static byte keyFor(char c){
+  if (c >= 'a' && c <= 'z') return ENUMKEY_A + (c - 'a');
+  if (c == ' ') return ENUMKEY_spc;
+  if (c == '\'') return ENUMKEY_ping;
+  return ENUMKEY__;
+}
+
+void typeWord(byte index, byte modKeys, byte latchMods){
+  if (index >= dictionaryWordCount) return;
+
+  if (!((modKeys | latchMods) & ~ShiftMods)) {
+    byte wordCase = WORD_LOWER;
+    if (latchMods & ShiftMods) wordCase = WORD_UPPER;
+    else if (modKeys & ShiftMods) wordCase = WORD_CAPITAL;
+    queueWord(index, wordCase);
+    return;
+  }
+
+  // ctrl, alt or gui: a key at a time like the bigram macros
+  char word[DictionaryWordSize];
+  byte len = dictionaryWord(index, word);
+  for (byte i = 0; i < len; i++) {
+    if (i) queueGap();
+    queueKeyDown(i ? latchMods : modKeys, keyFor(word[i]));
+    queueKeyUp();
+  }
+}
@@ -0,0 +1,37 @@
+// Dictionary.h
+// Chords bound to whole words and phrases (WordTable.h).  A word goes
+// out as a single AT+BleKeyboard string instead of a key at a time with
+// InterstitialDelay between, and follows the bigram macros for
+// modifiers: shift, or caps from a latched shift, on the first letter,
+// latched modifiers on the rest.  Other modifiers can't be put in a
+// string, so then the word is typed a key at a time.
+
+#ifndef DICTIONARY_H
+#define DICTIONARY_H
+
+#include "ChorderHal.h"
+
+// key codes from DIV_Word up to here are words
+const byte DictionaryCodeEnd = 0xE0;
+
+// longest word or phrase, terminating 0 included
+const byte DictionaryWordSize = 48;
+
+extern const byte dictionaryWordCount;
+
+// how a word is capitalised when sent as a string
+enum WordCase {
+  WORD_LOWER,
+  WORD_CAPITAL,  // first letter
+  WORD_UPPER
+};
+
+// copy word 'index' to buf (DictionaryWordSize chars) in 'wordCase',
+// returns its length, 0 for an unknown index
+byte dictionaryWord(byte index, char *buf, byte wordCase = WORD_LOWER);
+
+// queue word 'index' with the given current and latched modifiers;
+// unknown numbers do nothing
+void typeWord(byte index, byte modKeys, byte latchMods);
+
+#endif
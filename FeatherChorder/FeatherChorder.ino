@@ -19,7 +19,9 @@
  *   set to false, moved this setting from BluefruitConfig.h
  * - Added Battery Voltage macro that returns the current voltage of the LiPo by
  *   printing that as keyboard output. (Not to serial console)
- * - Have not impimented key repeat yet.
+ * - Key repeat: a held backspace, delete, space, tab, enter or arrow (repeat_keys
+ *   in KeyTables.h) goes down after repeatHoldMs and up on release, the host
+ *   does the repeating.  Off (0) unless repeatHoldMs is set.
  * - Added printed comment to device when doing a factory reset.
  * - Added 4 macros for the 4 unassigned chords in the default keyset
  * - Changed caps lock to be handled on the host rather than by the keyboard
@@ -34,12 +36,30 @@
  * - Corrected latch mod so it no longer sends the after it is toggled off with
  *   the latched mods.
  * - Corrected the way the shiftdn macro worked.  
+ * - Pointer mode: FUNCTION then --N ---- locks the POINTER layer, where held
+ *   chords move the mouse and scroll, faster the longer they are held, and
+ *   the thumbs click and drag (Pointer.h).  FC- ---- goes back to typing.
+ * - Keymap overlay: chords rebound in EEPROM win over the chart without a
+ *   reflash (KeymapOverlay.h).  FUNCTION then --- I-RP, the chord to change,
+ *   then the chord whose key it should type.
+ * - Battery Service: the LiPo is read once a minute in the background and
+ *   the level goes to the host over BLE, nothing typed; a low battery
+ *   sleeps sooner and scans less asleep (Battery.h).  BAT_LVL still types
+ *   the voltage, now in one command and without float code.
+ * - With ACK_PACING an answer the module dropped or garbled no longer slows
+ *   every report after it to the answer timeout (AckPacing.h).
+ * - USB_WHEN_CABLED follows the cable while running, not just at boot, and
+ *   the board no longer powers down (dropping the USB keyboard) while
+ *   typing over it.
  *   
  *   Last mucked with on: 2025/03/26
  */
 
 #include <Arduino.h>
 #include <SPI.h>
+#include <EEPROM.h>
+#include <avr/sleep.h>
+#include <avr/wdt.h>
 
 // slight change to below to match adafruit example GPD 2025-02-09
 // #if not defined (_VARIANT_ARDUINO_DUE_X_)
@@ -57,8 +77,13 @@
 #endif
 
 
-#include "KeyCodes.h"
-#include "ChordMappings.h"
+#include "AckPacing.h"
+#include "Battery.h"
+#include "Chorder.h"
+#include "KeymapOverlay.h"
+#include "Latency.h"
+#include "SwitchPorts.h"
+#include "UsbHid.h"
 
 /*=============================================================
 	APPLICATION SETTINGS
@@ -89,14 +114,26 @@
 	MINIMUM_FIRMWARE_VERSION  Minimum firmware version to have some new features
 	VERBOSE_MODE	      If set to 'true' enables debug output, 'false'
 	attempts to suppresses most serial output.
+	SCAN_PORTS          1 reads all switches from the PIND and PINF
+	registers in one go (32u4 only, see SwitchPorts.h), 0 uses a
+	digitalRead() per switch as before.
+	ACK_PACING          1 sends each key report once the module has
+	answered OK to the last (see AckPacing.h), 0 keeps the fixed
+	InterstitialDelay between macro keys.
+	USB_WHEN_CABLED     1 types over the USB cable instead of BLE while
+	a computer has enumerated the board, looked at every pass of loop()
+	(see UsbHid.h), 0 always uses BLE.
 	-----------------------------------------------------------------------*/
 #define FACTORYRESET_ENABLE         0
 #define MINIMUM_FIRMWARE_VERSION    "0.6.6"
 #define VERBOSE_MODE                   true
+#define SCAN_PORTS                  1
+#define ACK_PACING                  1
+#define USB_WHEN_CABLED             1
 
 #define DEVICENAME       "FeatherChorder+"
 //=============================================================
-#define VBATPIN A9  // used by gAsBattLvl()
+#define VBATPIN A9  // used by halReadBattery(), see Battery.h
 //=============================================================
 
 // Create the bluefruit object, either software serial...uncomment these lines
@@ -126,6 +163,33 @@ void error(const __FlashStringHelper*err) {
   while (1); 
 }
 //=============================================================
+// setup() read backs, so a module that is already set up skips the
+// reconfigure and reset
+
+// AT+GAPDEVNAME with no argument answers the current name, then OK
+bool isDeviceNamed() {
+  ble.println(F("AT+GAPDEVNAME"));
+  ble.readline();
+  bool isSame = strcmp(ble.buffer, DEVICENAME) == 0;
+  ble.waitForOK();
+  return isSame;
+}
+
+// the HID service (or on old firmware the keyboard) answers 1 when on
+bool isHidEnabled(bool isNewFirmware) {
+  int32_t isOn = 0;
+  bool isAnswered = isNewFirmware
+    ? ble.sendCommandWithIntReply(F("AT+BleHIDEn"), &isOn)
+    : ble.sendCommandWithIntReply(F("AT+BleKeyboardEn"), &isOn);
+  return isAnswered && isOn == 1;
+}
+
+// the Battery Service (Battery.h) the same way, firmware 0.7.0 and up
+bool isBatteryEnabled() {
+  int32_t isOn = 0;
+  return ble.sendCommandWithIntReply(F("AT+BLEBATTEN"), &isOn) && isOn == 1;
+}
+//=============================================================
 class Button {
   byte _pin;  // The button's I/O pin, as an Arduino pin number.
 	
@@ -148,6 +212,7 @@ const int EnPin =  5;
 
 
 // Pin numbers for the chording keyboard switches, using the Arduino numbering.
+// With SCAN_PORTS these must match the port bits in SwitchPorts.h.
 static const Button switch_pins[7] = {
   Button(6),  // Pinky
   Button(A5),  // Ring
@@ -158,20 +223,120 @@ static const Button switch_pins[7] = {
   Button(A0),  // Far Thumb
 };
 
-//==================================================
-// ctb
-// A few timing constants
-const int HalfSec = 500;  // for a half second delay
+//=====HAL==============================HAL==========================
+// board side of ChorderHal.h, the chorder core in Chorder.cpp reaches
+// the switches, clock and Bluefruit only through these.
+byte halReadSwitches(){
+#if SCAN_PORTS && defined(__AVR_ATmega32U4__)
+  // switch_pins[] still sets up the pullups, the pins are read here
+  return switchesFromPorts(PIND, PINF);
+#else
+  byte keyState = 0, mask = 1;
+  for (byte i = 0; i < NumSwitches; i++) {
+    if (switch_pins[i].isDown()) keyState |= mask;
+    mask <<= 1;
+  }
+  return keyState;
+#endif
+}
+
+// millis() stops while powered down, halSleep() keeps count here
+unsigned long sleptMillis = 0;
+
+unsigned long halMillis(){
+  return millis() + sleptMillis;
+}
+
+unsigned long halMicros(){
+  return micros() + sleptMillis * 1000;
+}
+
+// Only PORTB has pin change interrupts on the 32u4 and the switches are
+// on PORTD and PORTF, so the watchdog wakes us about every 16 ms to look
+// at them instead.  Powering down drops the USB link, the serial one with
+// VERBOSE_MODE and the keyboard while typing over usbBackend, so then
+// just the CPU stops and timer 0 wakes it each ms.
+ISR(WDT_vect){
+}
+
+void halSleep(){
+#if VERBOSE_MODE
+  set_sleep_mode(SLEEP_MODE_IDLE);
+  sleep_mode();
+#else
+  if (outputBackend == &usbBackend) {
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    sleep_mode();
+    return;
+  }
+  noInterrupts();
+  wdt_reset();
+  WDTCSR = _BV(WDCE) | _BV(WDE);
+  WDTCSR = _BV(WDIE);  // interrupt, no reset, shortest period
+  set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+  sleep_enable();
+  interrupts();
+  sleep_cpu();
+  sleep_disable();
+  wdt_disable();
+  sleptMillis += 16;
+#endif
+}
+
+void halDelay(unsigned long ms){
+  delay(ms);
+}
+
+void halPrintln(const char *text){
+  ble.println(text);
+}
 
-// It seems it can happen that there are times when sending 3 raw
-// keys in a macro, the keys can arrive in the wrong order.  So this was added
-// 2025-02-23 to see if it prevents that.  Adjust as needed.
-// A long name for a short thing. The time between raw key sends in a macro  .
-const int InterstitialDelay = 50; // for a 5/100 sec. delay (4/100 was not enough)
+// the module's answers, gathered a char at a time as they come in
+bool halReadLine(char *line, byte size){
+  static char buf[16];
+  static byte used = 0;
+  while (ble.available()) {
+    int c = ble.read();
+    if (c == '\r') continue;
+    if (c != '\n') {
+      if (used < sizeof(buf) - 1) buf[used++] = c;
+      continue;
+    }
+    if (!used) continue;
+    buf[used] = 0;
+    used = 0;
+    strncpy(line, buf, size - 1);
+    line[size - 1] = 0;
+    return true;
+  }
+  return false;
+}
+
+byte halEepromRead(unsigned int addr){
+  return EEPROM.read(addr);
+}
 
-// note - key debounce timing constants are not in this section.
+// update() reads first and only writes a cell that changes
+void halEepromWrite(unsigned int addr, byte value){
+  EEPROM.update(addr, value);
+}
 
-//====END=CONSTANTS=====================END=CONSTANTS=============
+// the USB serial port, if a terminal has it open
+void halLog(const char *line){
+  if (Serial) Serial.println(line);
+}
+
+void halLogP(const char *flashLine){
+  if (Serial) Serial.println((const __FlashStringHelper *)flashLine);
+}
+
+int halReadBattery(){
+  return analogRead(VBATPIN);
+}
+
+void halPowerOff(){
+  digitalWrite(EnPin, LOW);  // turn off 3.3v regulator enable.
+}
 
 //=====SETUP============================SETUP====================
 // board specific messages
@@ -181,7 +346,8 @@ void setup(void)
 	pinMode(EnPin, OUTPUT);      // Make pin an output,
 	digitalWrite(EnPin, HIGH);  // and activate pullup.
 	// while (!Serial);  // Required for Flora & Micro (and usb output)
-  delay(HalfSec);
+  // only the serial monitor needs time to attach
+  if ( VERBOSE_MODE ) delay(HalfSec);
 	
   if ( VERBOSE_MODE ) Serial.begin(115200);
   if ( VERBOSE_MODE ) Serial.println(F("Adafruit Bluefruit HID Chorder"));
@@ -213,17 +379,26 @@ void setup(void)
   /* Print Bluefruit information */
   if ( VERBOSE_MODE )  ble.info();
 	
-  /* Change the device name to make it easier to find */
-  if ( VERBOSE_MODE ) Serial.println(F("Setting device name to " DEVICENAME ": "));
-  if (! ble.sendCommandCheckOK(F( "AT+GAPDEVNAME="DEVICENAME )) ) {
-    error(F("Could not set device name?"));
+  /* The module keeps its name and services over a power cycle, so only
+     set them, and pay for the reset, when the read back differs */
+  bool isNamed = isDeviceNamed();
+  bool isNewFirmware = ble.isVersionAtLeast(MINIMUM_FIRMWARE_VERSION);
+  bool isHid = isHidEnabled(isNewFirmware);
+  bool hasBatteryService = ble.isVersionAtLeast("0.7.0");
+  bool isBattery = !hasBatteryService || isBatteryEnabled();
+  if ( !isNamed ) {
+    if ( VERBOSE_MODE ) Serial.println(F("Setting device name to " DEVICENAME ": "));
+    if (! ble.sendCommandCheckOK(F( "AT+GAPDEVNAME="DEVICENAME )) ) {
+      error(F("Could not set device name?"));
+    }
   }
 	
 	// GPD 2025-02-09 replaced this section with section from latest hid keyboiard example
 	
   /* Enable HID Service */
-  if ( VERBOSE_MODE ) Serial.println(F("Enable HID Service (including Keyboard): "));
-  if ( ble.isVersionAtLeast(MINIMUM_FIRMWARE_VERSION) )
+  if ( !isHid ) {
+    if ( VERBOSE_MODE ) Serial.println(F("Enable HID Service (including Keyboard): "));
+    if ( isNewFirmware )
 		{
 			if ( !ble.sendCommandCheckOK(F( "AT+BleHIDEn=On" ))) {
 				error(F("Could not enable Keyboard"));
@@ -234,401 +409,61 @@ void setup(void)
 				error(F("Could not enable Keyboard"));
 			}
 		}
+  }
 	
-  /* Add or remove service requires a reset */
-  if ( VERBOSE_MODE ) Serial.println(F("Performing a SW reset (service changes require a reset): "));
-  if (! ble.reset() ) {
-    error(F("Couldn't reset??"));
+  /* Battery Service, the level hosts show for the keyboard */
+  if ( !isBattery ) {
+    if ( VERBOSE_MODE ) Serial.println(F("Enable Battery Service: "));
+    if (! ble.sendCommandCheckOK(F( "AT+BLEBATTEN=1" )) ) {
+      error(F("Could not enable Battery Service"));
+    }
   }
 	
+  /* Add or remove service requires a reset */
+  if ( !isNamed || !isHid || !isBattery ) {
+    if ( VERBOSE_MODE ) Serial.println(F("Performing a SW reset (service changes require a reset): "));
+    if (! ble.reset() ) {
+      error(F("Couldn't reset??"));
+    }
+  } else if ( VERBOSE_MODE ) Serial.println(F("Fast boot, Bluefruit already set up"));
+	
 	// GPD end of replaced section
 	
 	
   String stringOne =  String(0x45, HEX);
 	
   if ( VERBOSE_MODE ) Serial.println(stringOne);
-}
-
-// used by processReading()
-// ctb
-enum State {
-  PRESSING,
-  RELEASING,
-};
 
-State state = RELEASING;
-byte lastKeyState = 0;
-
-// used by sendKey()
-// ctb
-enum Mode {
-  ALPHA,
-  NUMSYM,
-  FUNCTION
-};
-
-bool isNumsymLocked = false;
-keymap_t latchMods = 0x00;  // currently latched modKeys
-keymap_t modKeys = 0x00;  // current modifyers ( L/Rshift,L/Ralt, L/Rctrl, L/Rgui )
-
-Mode mode = ALPHA;
-
-// used by processREADING and loop
-byte previousStableReading = 0;
-byte currentStableReading = 0;
-long lastDebounceTime = 0;  // the last time the output pin was toggled
-long debounceDelay = 10;    // the debounce time; increase if the output flickers
-//=====RESET=====================RESET==========================
-void reset(){
-	mode = ALPHA;
-	latchMods=0x00;
-	modKeys = 0x00;
-	isNumsymLocked = false;
-	sendRawKeyUp();
-}
-//=====SEND KEY====================SEND KEY========================
-// used by processReading()
-// ctb
-void sendKey(byte keyState){
-  keymap_t theKey;  
-  // Determine the key based on the current mode's keymap
-  if (mode == ALPHA) {
-    theKey = keymap_default[keyState];
-  } else if (mode == NUMSYM) {
-    theKey = keymap_numsym[keyState];
-  } else {
-    theKey = keymap_function[keyState];
+  ackPacing = ACK_PACING;
+  chorderInit();
+
+  // at a desk with the cable in, reports go straight over USB; loop()
+  // keeps following the cable, as the computer may not have enumerated
+  // the board yet this early
+  if ( USB_WHEN_CABLED ) cableBackend = &usbBackend;
+  outputCabled(usbHidAttached());
+  if ( VERBOSE_MODE ) Serial.print(F("Typing over "));
+  if ( VERBOSE_MODE ) Serial.println(outputBackend->name);
+  if ( VERBOSE_MODE ) Serial.print(F("Setup took "));
+  if ( VERBOSE_MODE ) Serial.print(bootStats.readyMs);
+  if ( VERBOSE_MODE ) Serial.println(F(" ms"));
+  if ( VERBOSE_MODE && batteryStats.percent != BatteryUnknown ) {
+    Serial.print(F("Battery "));
+    Serial.print(batteryStats.millivolts);
+    Serial.print(F(" mV, "));
+    Serial.print(batteryStats.percent);
+    Serial.println(F("%"));
   }
-	
-  switch (theKey)  {
-		// Handle mode switching - return immediately after the mode has changed
-		// Handle basic mode switching
-  case LATCH:
-		if ( latchMods == 0x00 ) {  // latch was not set, so set it  current modKeys 
-			latchMods = modKeys;
-		} else {
-      latchMods = 0x00;   // latch was set, so clear it.   
-		}
-		break;
-  case MODE_NUM:
-    if (mode == NUMSYM) {
-      mode = ALPHA;
-    } else {
-      mode = NUMSYM;
-    }
-    return;
-  case MODE_FUNC:
-    if (mode == FUNCTION) {
-      mode = ALPHA;
-    } else {
-      mode = FUNCTION;
-    }
-    return;
-  case MODE_RESET:
-		reset();
-    return;
-  case MODE_MRESET:
-		reset();
-    digitalWrite(EnPin, LOW);  // turn off 3.3v regulator enable.
-    return;
-		// something with a battery only		
-	case BAT_LVL:
-		// get and send the battedy level, then
-		// do a mode_reset
-    gAsBattLvl();
-		reset();
-    return;
-	case MODE_FRESET:
-    sendFactoryReset();
-    return;
-		// back to common code
-		// Handle mode locks
-  case MODE_NUMLCK:
-    if (isNumsymLocked){
-      isNumsymLocked = false;
-      mode = ALPHA;
-    } else {
-      isNumsymLocked = true;
-      mode = NUMSYM;
-    }
-    return;
-		// Handle modifier keys toggling
-  case MOD_LCTRL:
-    modKeys = modKeys ^ 0x01;
-    return;
-  case MOD_LSHIFT:
-    modKeys = modKeys ^ 0x02;
-    return;
-  case MOD_LALT:
-    modKeys = modKeys ^ 0x04;
-    return;
-  case MOD_LGUI:
-    modKeys = modKeys ^ 0x08;
-    return;
-  case MOD_RCTRL:
-    modKeys = modKeys ^ 0x10;
-    return;
-  case MOD_RSHIFT:
-    modKeys = modKeys ^ 0x20;
-    return;
-  case MOD_RALT:
-    modKeys = modKeys ^ 0x40;
-    return;
-  case MOD_RGUI:
-    modKeys = modKeys ^ 0x80;
-    return;
-		// Handle special keys
-  case MULTI_NumShift:
-    if (mode == NUMSYM) {
-      mode = ALPHA;
-    } else {
-      mode = NUMSYM;
-    }
-    modKeys = modKeys ^ 0x02;
-    return;
-  case MULTI_CtlAlt:
-    modKeys = modKeys ^ 0x01;
-    modKeys = modKeys ^ 0x04;
-    return;
-		/* Everything after this sends actual keys to the system; break rather than
- 			 return since we want to reset the modifiers after these keys are sent. */
-  case MACRO_000:
-	  sendRawKey(0x00, ENUMKEY_0);
-    sendRawKey(0x00, ENUMKEY_0);
-    sendRawKey(0x00, ENUMKEY_0);
-    break;
-  case MACRO_00:
-    sendRawKey(0x00, ENUMKEY_0);
-    sendRawKey(0x00, ENUMKEY_0);
-    break;
-  case MACRO_quotes:
-    sendRawKey(0x02, 0x34);
-    delay(InterstitialDelay);
-    sendRawKey(0x02, 0x34);
-    delay(InterstitialDelay);
-    sendRawKey(0x00, 0x50);
-    break;
-  case MACRO_parens:
-    sendRawKey(0x02, 0x26);
-    delay(InterstitialDelay);
-    sendRawKey(0x02, 0x27);
-    delay(InterstitialDelay);
-    sendRawKey(0x00, 0x50);
-    break;
-  case MACRO_dollar:
-    sendRawKey(0x02, 0x21);
-    break;
-  case MACRO_percent:
-    sendRawKey(0x02, 0x22);
-    break;
-  case MACRO_ampersand:
-    sendRawKey(0x02, 0x24);
-    break;
-  case MACRO_asterisk:
-    sendRawKey(0x02, 0x25);
-    break;
-  case MACRO_question:
-    sendRawKey(0x02, 0x38);
-    break;
-  case MACRO_plus:
-    sendRawKey(0x02, 0x2E);
-    break;
-  case MACRO_openparen:
-    sendRawKey(0x02, 0x26);
-    break;
-  case MACRO_closeparen:
-    sendRawKey(0x02, 0x27);
-    break;
-  case MACRO_opencurly:
-    sendRawKey(0x02, 0x2F);
-    break;
-  case MACRO_closecurly:
-    sendRawKey(0x02, 0x30);
-    break;
-  case MACRO_1 :
-		// er
-		sendRawKey(modKeys, ENUMKEY_E);
-		delay(InterstitialDelay);
-		sendRawKey(latchMods, ENUMKEY_R);
-		break;
-	case MACRO_2:
-		// th
-		sendRawKey(modKeys, ENUMKEY_T);
-		delay(InterstitialDelay);
-		sendRawKey(latchMods, ENUMKEY_H);
-		break;
-	case MACRO_3:
-		// an
-		sendRawKey(modKeys, ENUMKEY_A);
-		delay(InterstitialDelay);
-		sendRawKey(latchMods, ENUMKEY_N);
-		break;
-	case MACRO_4:
-		// in
-		sendRawKey(modKeys, ENUMKEY_I);
-		delay(InterstitialDelay);
-		sendRawKey(latchMods, ENUMKEY_N);
-		break;
-		// macro test is a long string to confirm length of interstitial delay
-	case MACRO_TEST:
-		sendRawKey (modKeys, ENUMKEY_A);
-		delay(InterstitialDelay);
-		sendRawKey (modKeys, ENUMKEY_B);
-		delay(InterstitialDelay);
-		sendRawKey (modKeys, ENUMKEY_C);
-		delay(InterstitialDelay);
-		sendRawKey (modKeys, ENUMKEY_D);
-		delay(InterstitialDelay);
-		sendRawKey (modKeys, ENUMKEY_E);
-		delay(InterstitialDelay);
-		sendRawKey (modKeys, ENUMKEY_F);
-		delay(InterstitialDelay);
-		sendRawKey (modKeys, ENUMKEY_G);
-		delay(InterstitialDelay);
-		sendRawKey (modKeys, ENUMKEY_H);
-		break;
-	case MACRO_SHIFTDN:
-		modKeys = MOD_LSHIFT;
-   	sendRawKeyDn (0x02, 0x00);
-		break;
-		// Handle Android specific keys
-  case ANDROID_search:
-    sendRawKey(0x04, 0x2C);
-    break;
-  case ANDROID_home:
-    sendRawKey(0x04, 0x29);
-    break;
-  case ANDROID_menu:
-    sendRawKey(0x10, 0x29);
-    break;
-  case ANDROID_back:
-    sendRawKey(0x00, 0x29);
-    break;
-  case ANDROID_dpadcenter:
-    sendRawKey(0x00, 0x5D);
-    break;
-  case MEDIA_playpause:
-    sendControlKey("PLAYPAUSE");
-    break;
-  case MEDIA_stop:
-    sendControlKey("MEDIASTOP");
-    break;
-  case MEDIA_next:
-    sendControlKey("MEDIANEXT");
-    break;
-  case MEDIA_previous:
-    sendControlKey("MEDIAPREVIOUS");
-    break;
-  case MEDIA_volup:
-    sendControlKey("VOLUME+,500");
-    break;
-  case MEDIA_voldn:
-    sendControlKey("VOLUME-,500");
-    break;
-		// Send the key
-  default:
-    sendRawKey(modKeys, theKey);
-    break;
-  }
-	
-  modKeys = latchMods; //sets modKeys to any currently latched mods, or 0x00 if none
-  mode = ALPHA;
-	// Reset the modKeys and mode based on
-	if (isNumsymLocked){
-    mode = NUMSYM;
+  if ( VERBOSE_MODE && overlayStats.status == OVERLAY_BAD ) Serial.println(F("Keymap overlay failed its checks, not used"));
+  if ( VERBOSE_MODE && overlayStats.status == OVERLAY_OK ) {
+    Serial.print(F("Keymap overlay: "));
+    Serial.print(overlayStats.entries);
+    Serial.print(F(" chords, loaded in "));
+    Serial.print(overlayStats.loadMicros);
+    Serial.println(F(" us"));
   }
 }
 
-//======SEND RAW KEY====================SEND RAW KEY================
-// ctb
-// used in sendKey()
-//
-// new sendRawKey to make sure all is working as expected
-// before trying to impliment seporate watching for key down and key up
-// to allow host side key repeat
-// 
-
-
-void sendRawKey(char modKey, char rawKey){
-	sendRawKeyDn(modKey, rawKey);
-	sendRawKeyUp();
-}
-
-//======SEND RAW KEY DOWN===============SEND RAW KEY DOWN============
-// connectivity specific - This is for BT/BLE
-// used in sendRawKey()
-//
-
-void sendRawKeyDn(char modKey, char rawKey){
-	// Format for Bluefruit Feather is MOD-00-KEY.
-	// Plan: use print to only print the last 2 ch so that we get 2 char
-	// String keys = String(modKey, HEX) + "-00-" + String(rawKey, HEX);
-	
-	
-	// pad & trim modKey to ensure 2 digit hexidecimal is sent
-	String tmpModKey = "00" + String(modKey, HEX);
-	int modKeyLen = tmpModKey.length() - 2;
-	// pad & trim rawKey to ensure 2 digit hexidecimal is sent
-	String tmpRawKey = "00" + String(rawKey, HEX);
-	int rawKeyLen = tmpRawKey.length() - 2;
-	
-	ble.print("AT+BLEKEYBOARDCODE=");
-	ble.println(String(&tmpModKey[modKeyLen]) + "-00-" + String(&tmpRawKey[rawKeyLen]));
-	
-	
-}
-
-//======SEND RAW KEY UP==============SEND RAW KEY UP==================
-// connectivity specific - This is for BT/BLE
-// used in sendRawKey()  and sendString()
-//
-void sendRawKeyUp(){
-	ble.println("AT+BLEKEYBOARDCODE=00-00");
-}  
-//======SEND STRING============SEND STRING==========================
-// connectivity specific - This is for BT/BLE
-// Currently this is only for testing, it was temporarily added to MRESET
-//
-void sendString(String StringOut){
-  // 
-  ble.print("AT+BleKeyboard=");
-  ble.println(StringOut);
-  sendRawKeyUp(); // just in case as there have been some odd key repeats happening.
-}  
-
-//======SEND MOUSE KEY=====SEND MOUSE KEY===========================
-// connectivity specific - This is for BT/BLE
-// 
-void sendMouseKey(String MouseKey){
-	ble.print("AT+BleHidMouseButton=");
-	ble.println(MouseKey);
-	delay(HalfSec);
-	ble.println("AT+BleHidMouseButton=0");
-}
-//======SEND CONTROL KEY============SEND CONTROL KEY==================
-// connectivity specific -  This is for BT/BLE
-// used in sendKey()
-//
-void sendControlKey(String cntrlName){
-  // note: for Volume +/- and the few other keys that take a time to hold, simply add it into the string
-  // for example:
-  //    sendControlKey("VOLUME+,500")
-  // will send Volume up and hold it for half a second
-  ble.print("AT+BleHidControlKey=");
-  ble.println(cntrlName);
-}
-//======GET AND SEND BATTERY LEVEL==================================
-// board specific this is for BLE feather
-// note needs #define VBATPIN A9 which is up top with other defines.
-void gAsBattLvl() {   
-	float measuredvbat = analogRead(VBATPIN);
-	measuredvbat *= 2;    // we divided by 2, so multiply back
-	measuredvbat *= 3.3;  // Multiply by 3.3V, our reference voltage
-	measuredvbat /= 1024; // convert to voltage
-	sendString( " Kbd Batt: " );
-	sendString( String(measuredvbat) );
-	sendString(  "volts. " );
-}
 //======SEND FACTORY RESET============SEND FACTORY RESET===============
 //  board specific - This is for BLE feather
 // Factory Reset will clear the Bluetooth known hosts table
@@ -640,55 +475,25 @@ void sendFactoryReset(){
 		error(F("Factory reset failed!"));
 	}
 }
-//=====PROCESS READING==================PROCESS READING===============
-// ctb
-// used in loop()
-//
-// check if was pressing chord and now releasing, change to releasing,
-//                                                 then send the key
-//         if chord was not pressing and now is, change to pressing
-//
-void processReading(){
-	switch (state) {
-	case PRESSING:
-		if (previousStableReading & ~currentStableReading) {
-			state = RELEASING;
-			sendKey(previousStableReading);
-		} 
-		break;
-		
-	case RELEASING:
-		if (currentStableReading & ~previousStableReading) {
-			state = PRESSING;
-		}
-		break;
-	}
-}
-
 //========LOOP=========================LOOP==================
 // ctb
 void loop() {
-  // Build the current key state.
-  byte keyState = 0, mask = 1;
-  for (int i = 0; i < 7; i++) {
-    if (switch_pins[i].isDown()) keyState |= mask;
-    mask <<= 1;
+  chorderLoop();
+  outputCabled(usbHidAttached());  // plugged in or pulled out since
+#if VERBOSE_MODE
+  // stage latencies (Latency.h) on the serial console once a minute
+  static unsigned long lastLatencyReport = 0;
+  if (halMillis() - lastLatencyReport >= 60000) {
+    lastLatencyReport = halMillis();
+    latencyReport();
   }
-	
-  if (lastKeyState != keyState) {
-    lastDebounceTime = millis();
-  }
-	
-  if ((millis() - lastDebounceTime) > debounceDelay) {
-    // whatever the reading is at, it's been there for longer
-    // than the debounce delay, so take it as the actual current state:
-    currentStableReading = keyState;
+  // boot to first key (Chorder.h bootStats) once, when it is known
+  static bool isBootReported = false;
+  if (!isBootReported && bootStats.firstKeyMs) {
+    isBootReported = true;
+    Serial.print(F("Boot to first key "));
+    Serial.print(bootStats.firstKeyMs);
+    Serial.println(F(" ms"));
   }
-	
-  if (previousStableReading != currentStableReading) {
-    processReading();
-    previousStableReading = currentStableReading;
-  }
-	
-  lastKeyState = keyState;
+#endif
 }
@@ -0,0 +1,89 @@
+// HidReport.cpp
+// see HidReport.h
+
+#include "HidReport.h"
+#include "KeyCodes.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+//=====KEY REPORT=======================KEY REPORT==================
+void hidKeyReport(uint8_t *report, byte modKey, byte rawKey){
+  memset(report, 0, HidKeyReportSize);
+  report[0] = modKey;
+  report[2] = rawKey;
+}
+
+//=====CONSUMER CONTROL=================CONSUMER CONTROL============
+struct ConsumerName {
+  char name[14];
+  uint16_t usage;
+};
+
+// the names the chorder sends, see media_controls in KeyTables.h
+static const ConsumerName consumerNames[] PROGMEM = {
+  { "PLAYPAUSE",     0x00CD },
+  { "MEDIANEXT",     0x00B5 },
+  { "MEDIAPREVIOUS", 0x00B6 },
+  { "MEDIASTOP",     0x00B7 },
+  { "VOLUME+",       0x00E9 },
+  { "VOLUME-",       0x00EA },
+  { "MUTE",          0x00E2 },
+};
+
+uint16_t hidConsumerUsage(const char *name, unsigned int *holdMs){
+  const char *comma = strchr(name, ',');
+  size_t length = comma ? (size_t)(comma - name) : strlen(name);
+  *holdMs = comma ? (unsigned int)atoi(comma + 1) : 0;
+  for (byte i = 0; i < sizeof(consumerNames) / sizeof(consumerNames[0]); i++) {
+    ConsumerName entry;
+    memcpy_P(&entry, &consumerNames[i], sizeof(entry));
+    if (strlen(entry.name) == length && !strncmp(entry.name, name, length)) return entry.usage;
+  }
+  return 0;
+}
+
+//=====ASCII============================ASCII=======================
+const byte AsciiShift = 0x80;  // in asciiKeys, the key wants left shift
+#define S(key) (AsciiShift | (key))
+
+// ' ' to '~'
+static const byte asciiKeys[] PROGMEM = {
+  ENUMKEY_spc,      S(ENUMKEY_1),     S(ENUMKEY_ping),  S(ENUMKEY_3),      //  !"#
+  S(ENUMKEY_4),     S(ENUMKEY_5),     S(ENUMKEY_7),     ENUMKEY_ping,      // $%&'
+  S(ENUMKEY_9),     S(ENUMKEY_0),     S(ENUMKEY_8),     S(ENUMKEY_equal),  // ()*+
+  ENUMKEY_comma,    ENUMKEY_minus,    ENUMKEY_dot,      ENUMKEY_slash,     // ,-./
+  ENUMKEY_0,        ENUMKEY_1,        ENUMKEY_2,        ENUMKEY_3,         // 0123
+  ENUMKEY_4,        ENUMKEY_5,        ENUMKEY_6,        ENUMKEY_7,         // 4567
+  ENUMKEY_8,        ENUMKEY_9,        S(ENUMKEY_smcol), ENUMKEY_smcol,     // 89:;
+  S(ENUMKEY_comma), ENUMKEY_equal,    S(ENUMKEY_dot),   S(ENUMKEY_slash),  // <=>?
+  S(ENUMKEY_2),     S(ENUMKEY_A),     S(ENUMKEY_B),     S(ENUMKEY_C),      // @ABC
+  S(ENUMKEY_D),     S(ENUMKEY_E),     S(ENUMKEY_F),     S(ENUMKEY_G),      // DEFG
+  S(ENUMKEY_H),     S(ENUMKEY_I),     S(ENUMKEY_J),     S(ENUMKEY_K),      // HIJK
+  S(ENUMKEY_L),     S(ENUMKEY_M),     S(ENUMKEY_N),     S(ENUMKEY_O),      // LMNO
+  S(ENUMKEY_P),     S(ENUMKEY_Q),     S(ENUMKEY_R),     S(ENUMKEY_S),      // PQRS
+  S(ENUMKEY_T),     S(ENUMKEY_U),     S(ENUMKEY_V),     S(ENUMKEY_W),      // TUVW
+  S(ENUMKEY_X),     S(ENUMKEY_Y),     S(ENUMKEY_Z),     ENUMKEY_lbr,       // XYZ[
+  ENUMKEY_bckslsh,  ENUMKEY_rbr,      S(ENUMKEY_6),     S(ENUMKEY_minus),  // \]^_
+  ENUMKEY_grave,    ENUMKEY_A,        ENUMKEY_B,        ENUMKEY_C,         // `abc
+  ENUMKEY_D,        ENUMKEY_E,        ENUMKEY_F,        ENUMKEY_G,         // defg
+  ENUMKEY_H,        ENUMKEY_I,        ENUMKEY_J,        ENUMKEY_K,         // hijk
+  ENUMKEY_L,        ENUMKEY_M,        ENUMKEY_N,        ENUMKEY_O,         // lmno
+  ENUMKEY_P,        ENUMKEY_Q,        ENUMKEY_R,        ENUMKEY_S,         // pqrs
+  ENUMKEY_T,        ENUMKEY_U,        ENUMKEY_V,        ENUMKEY_W,         // tuvw
+  ENUMKEY_X,        ENUMKEY_Y,        ENUMKEY_Z,        S(ENUMKEY_lbr),    // xyz{
+  S(ENUMKEY_bckslsh), S(ENUMKEY_rbr), S(ENUMKEY_grave),                    // |}~
+};
+
+static_assert(sizeof(asciiKeys) == '~' - ' ' + 1, "an asciiKeys entry for ' ' to '~'");
+
+bool hidFromAscii(char c, byte *modKey, byte *rawKey){
+  byte key;
+  if (c >= ' ' && c <= '~') key = pgm_read_byte(&asciiKeys[c - ' ']);
+  else if (c == '\n') key = ENUMKEY_enter;
+  else if (c == '\t') key = ENUMKEY_tab;
+  else return false;
+  *modKey = key & AsciiShift ? 0x02 : 0x00;
+  *rawKey = key & ~AsciiShift;
+  return true;
+}
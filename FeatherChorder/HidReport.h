@@ -0,0 +1,26 @@
+// HidReport.h
+// What a USB HID keyboard is sent, for the output backends that talk HID
+// themselves rather than through the Bluefruit's AT commands (see
+// OutputBackend.h): the 8 byte boot keyboard report, the consumer
+// control usages behind the Bluefruit's media key names, and the key
+// that types each printable ASCII character on a US layout.
+
+#ifndef HID_REPORT_H
+#define HID_REPORT_H
+
+#include "ChorderHal.h"
+
+// modifiers, reserved, then up to 6 keys
+const byte HidKeyReportSize = 8;
+void hidKeyReport(uint8_t *report, byte modKey, byte rawKey);
+
+// the consumer control usage for an AT+BleHidControlKey name like
+// "PLAYPAUSE" or "VOLUME+,500", 0 for one we don't know; the time to
+// hold it goes to *holdMs (0 when none is given)
+uint16_t hidConsumerUsage(const char *name, unsigned int *holdMs);
+
+// modifier and key that type 'c', false for a character the US layout
+// has no key for
+bool hidFromAscii(char c, byte *modKey, byte *rawKey);
+
+#endif
@@ -151,13 +151,50 @@ enum keycodes {
   MEDIA_volup,     // Volume up
   MEDIA_voldn,     // Volume dn
 
-/* And finally macros, that generate multiple key presses */
-  DIV_Macro,
-  MACRO_000,  // 000
-  MACRO_00,             // 00
-  MACRO_quotes,         // "" and left arrow
-  MACRO_parens,         // () and left arrow
-  MACRO_dollar,         // aka, FORCE_LSHIFT|KEY_4
+/* Some new macros for a few BT functions */
+  BAT_LVL,  // print the batter level of the  LiPo
+  TRACE_DUMP,  // write the chord trace (Trace.h) to the USB serial port
+  LATENCY_REPORT,  // stage latencies (Latency.h) to the serial port, typed summary
+  USAGE_DUMP,  // chord usage counts (Usage.h) to the USB serial port
+/* latch (I can't bring myself to call it "latchkey") */ 
+  LATCH,
+  MODE_POINTER,  // Pointer (mouse) mode, locked until pressed again
+  RECORD_BINDING,  // the next chord gets the code of the one after it (KeymapOverlay.h)
+
+/* Mouse keys for the POINTER layer (Pointer.h).  The moves and scrolls
+   go on for as long as their chord is held, each is a row of
+   pointer_moves (KeyTables.h); the buttons click when the chord is sent. */
+  DIV_Pointer,
+  POINTER_up=DIV_Pointer,
+  POINTER_down,
+  POINTER_left,
+  POINTER_right,
+  POINTER_upleft,
+  POINTER_upright,
+  POINTER_downleft,
+  POINTER_downright,
+  POINTER_scrollup,
+  POINTER_scrolldown,
+  DIV_PointerButton,
+  POINTER_lclick=DIV_PointerButton,
+  POINTER_rclick,
+  POINTER_mclick,
+  POINTER_drag,         // left button down, up on the next POINTER_drag
+
+/* Macros kept in the EEPROM overlay (KeymapOverlay.h) rather than flash,
+   so they can be changed without reflashing; the code minus
+   DIV_OverlayMacro is the slot.  The macro codes are all but used up,
+   so there are only a few. */
+  DIV_OverlayMacro,
+  OVERLAY_MACRO_0=DIV_OverlayMacro,
+  OVERLAY_MACRO_1,
+  OVERLAY_MACRO_2,
+
+/* Keys sent with fixed modifiers, one tap each.  Every code from
+   DIV_Combo up to DIV_Macro is a modifier byte and a key in key_combos
+   (KeyTables.h), the code minus DIV_Combo is its place there. */
+  DIV_Combo,
+  MACRO_dollar=DIV_Combo,  // aka, FORCE_LSHIFT|KEY_4
   MACRO_percent,        // aka, FORCE_LSHIFT|KEY_5
   MACRO_ampersand,      // aka, FORCE_LSHIFT|KEY_7
   MACRO_asterisk,       // aka, FORCE_LSHIFT|KEY_8
@@ -173,6 +210,16 @@ enum keycodes {
   ANDROID_back,         // aka, KEY_esc with NO MODS
   ANDROID_dpadcenter,   // aka, KEY_KP5 with NO MODS
 
+/* And finally macros, that generate multiple key presses.  Every code
+   from DIV_Macro up is a macro, the code minus DIV_Macro is its place in
+   macro_table (MacroTable.h), so adding one is a table entry; the names
+   below are just for the ones we have. */
+  DIV_Macro,
+  MACRO_000=DIV_Macro,  // 000
+  MACRO_00,             // 00
+  MACRO_quotes,         // "" and left arrow
+  MACRO_parens,         // () and left arrow
+
   /* Trying some multi-key macros on the 4 unused keys */
   MACRO_1,
   MACRO_2,
@@ -180,11 +227,27 @@ enum keycodes {
   MACRO_4,
   MACRO_TEST,           // a - h to test interstitial delay
   MACRO_SHIFTDN,        // try for shift down
-  /* Some new macros for a few BT functions */
-  BAT_LVL,  // print the batter level of the  LiPo
-  /* and last of all latch (I can't bring myself to call it "latchkey") */ 
-  LATCH,
-  DIV_Last
+  DIV_Last,
+
+/* Words and phrases, each typed as a single string.  Every code from
+   DIV_Word up is a word, the code minus DIV_Word is its place in
+   dictionary_words (WordTable.h). */
+  DIV_Word = 0xB0,
+  WORD_about = DIV_Word,
+  WORD_and,
+  WORD_for,
+  WORD_from,
+  WORD_have,
+  WORD_that,
+  WORD_the,
+  WORD_their,
+  WORD_there,
+  WORD_this,
+  WORD_which,
+  WORD_with,
+  WORD_would,
+  WORD_you,
+  DIV_WordLast
 };
 
 const int RAW_LGUI = 0xE3;
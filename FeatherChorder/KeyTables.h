@@ -0,0 +1,117 @@
+// KeyTables.h
+// The key codes that are just data, split out like MacroTable.h: what
+// each modifier code toggles, the media keys' control names and the keys
+// sent with fixed modifiers.  Each table is indexed by the code minus the
+// first code of its range in KeyCodes.h, so dispatchKey() finds any of
+// them with a range check and one read; the static_asserts keep the
+// tables and the ranges in step.  The pointer moves are read the same
+// way, by Pointer.cpp.  Last, the keys that repeat when held,
+// a short list looked through once per chord.
+
+/**************************************
+ * modifier bit for MOD_LCTRL -       *
+ * MOD_RGUI, from DIV_Mods + 1        *
+ **************************************/
+const uint8_t modifier_bits[] PROGMEM = {
+  0x01,  // MOD_LCTRL
+  0x02,  // MOD_LSHIFT
+  0x04,  // MOD_LALT
+  0x08,  // MOD_LGUI
+  0x10,  // MOD_RCTRL
+  0x20,  // MOD_RSHIFT
+  0x40,  // MOD_RALT
+  0x80,  // MOD_RGUI
+};
+
+static_assert(sizeof(modifier_bits) == DIV_Modes - MOD_LCTRL,
+              "a modifier_bits entry for each MOD_ code");
+
+/**************************************
+ * AT+BleHidControlKey names for      *
+ * MEDIA_playpause - MEDIA_voldn      *
+ **************************************/
+// the names are in flash too, sent with sendControlKeyP()
+static const char media_playpause[] PROGMEM = "PLAYPAUSE";
+static const char media_next[] PROGMEM = "MEDIANEXT";
+static const char media_previous[] PROGMEM = "MEDIAPREVIOUS";
+static const char media_stop[] PROGMEM = "MEDIASTOP";
+static const char media_volup[] PROGMEM = "VOLUME+,500";
+static const char media_voldn[] PROGMEM = "VOLUME-,500";
+
+const char * const media_controls[] PROGMEM = {
+  media_playpause,   // MEDIA_playpause
+  media_next,        // MEDIA_next
+  media_previous,    // MEDIA_previous
+  media_stop,        // MEDIA_stop
+  media_volup,       // MEDIA_volup
+  media_voldn,       // MEDIA_voldn
+};
+
+static_assert(sizeof(media_controls) / sizeof(media_controls[0]) == MEDIA_voldn + 1 - MEDIA_playpause,
+              "a media_controls entry for each MEDIA_ code");
+
+/**************************************
+ * modifiers and key, from DIV_Combo  *
+ **************************************/
+const uint8_t key_combos[][2] PROGMEM = {
+  { 0x02, ENUMKEY_4 },      // MACRO_dollar
+  { 0x02, ENUMKEY_5 },      // MACRO_percent
+  { 0x02, ENUMKEY_7 },      // MACRO_ampersand
+  { 0x02, ENUMKEY_8 },      // MACRO_asterisk
+  { 0x02, ENUMKEY_slash },  // MACRO_question
+  { 0x02, ENUMKEY_equal },  // MACRO_plus
+  { 0x02, ENUMKEY_9 },      // MACRO_openparen
+  { 0x02, ENUMKEY_0 },      // MACRO_closeparen
+  { 0x02, ENUMKEY_lbr },    // MACRO_opencurly
+  { 0x02, ENUMKEY_rbr },    // MACRO_closecurly
+  { 0x04, ENUMKEY_spc },    // ANDROID_search
+  { 0x04, ENUMKEY_esc },    // ANDROID_home
+  { 0x10, ENUMKEY_esc },    // ANDROID_menu
+  { 0x00, ENUMKEY_esc },    // ANDROID_back
+  { 0x00, ENUMKEY_KP5 },    // ANDROID_dpadcenter
+};
+
+static_assert(sizeof(key_combos) / sizeof(key_combos[0]) == DIV_Macro - DIV_Combo,
+              "a key_combos entry for each code from DIV_Combo to DIV_Macro");
+
+/**************************************
+ * pointer direction, x y wheel, for  *
+ * DIV_Pointer - POINTER_scrolldown   *
+ **************************************/
+// 127 is full speed on that axis, the diagonals 90 (127 / sqrt 2) on
+// both so they go as fast; y grows down the screen, the wheel up
+const int8_t pointer_moves[][3] PROGMEM = {
+  {    0, -127,    0 },  // POINTER_up
+  {    0,  127,    0 },  // POINTER_down
+  { -127,    0,    0 },  // POINTER_left
+  {  127,    0,    0 },  // POINTER_right
+  {  -90,  -90,    0 },  // POINTER_upleft
+  {   90,  -90,    0 },  // POINTER_upright
+  {  -90,   90,    0 },  // POINTER_downleft
+  {   90,   90,    0 },  // POINTER_downright
+  {    0,    0,  127 },  // POINTER_scrollup
+  {    0,    0, -127 },  // POINTER_scrolldown
+};
+
+static_assert(sizeof(pointer_moves) / sizeof(pointer_moves[0]) == DIV_PointerButton - DIV_Pointer,
+              "a pointer_moves entry for each code from DIV_Pointer to DIV_PointerButton");
+
+/**************************************
+ * keys that repeat while their chord *
+ * is held, see repeatHoldMs          *
+ **************************************/
+const uint8_t repeat_keys[] PROGMEM = {
+  ENUMKEY_bckspc,
+  ENUMKEY_del,
+  ENUMKEY_spc,
+  ENUMKEY_tab,
+  ENUMKEY_enter,
+  ENUMKEY_rarr,
+  ENUMKEY_larr,
+  ENUMKEY_darr,
+  ENUMKEY_uarr,
+  ENUMKEY_pgup,
+  ENUMKEY_pgdn,
+};
+
+// end KeyTables.h
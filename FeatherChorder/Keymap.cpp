@@ -0,0 +1,40 @@
+// Keymap.cpp
+// see Keymap.h
+
+#include "Keymap.h"
+#include "KeyCodes.h"
+#include "KeymapOverlay.h"
+#include "ChordMappings.h"
+
+const byte keymapLayerCount = sizeof(keymap_layers) / sizeof(keymap_layers[0]);
+
+//=====LOOKUP===========================LOOKUP======================
+// the EEPROM overlay first, see KeymapOverlay.h
+keymap_t keymapLookup(byte layer, byte chord){
+  byte code;
+  if (overlayLookup(layer, chord, &code)) return code;
+  return keymapChartLookup(layer, chord);
+}
+
+// dense layers are a straight index, sparse ones a binary search of
+// the sorted chord list (6 steps for the function layer)
+keymap_t keymapChartLookup(byte layer, byte chord){
+  if (layer >= keymapLayerCount) return ENUMKEY__;
+
+  keymap_layer_t l;
+  memcpy_P(&l, &keymap_layers[layer], sizeof(l));
+  if (l.dense) return pgm_read_byte(&l.dense[chord]);
+
+  byte lo = 0, hi = l.sparseCount;
+  while (lo < hi) {
+    byte mid = (lo + hi) >> 1;
+    byte midChord = pgm_read_byte(&l.sparse[mid].chord);
+    if (midChord == chord) return pgm_read_byte(&l.sparse[mid].key);
+    if (midChord < chord) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return ENUMKEY__;
+}
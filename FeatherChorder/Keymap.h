@@ -0,0 +1,20 @@
+// Keymap.h
+// Single way into the chord tables of ChordMappings.h, which live in
+// flash, and the overlay over them.  Used by sendKey().
+
+#ifndef KEYMAP_H
+#define KEYMAP_H
+
+#include "ChorderHal.h"
+
+typedef uint8_t keymap_t;
+
+extern const byte keymapLayerCount;
+
+// what 'chord' (0 - 127) is bound to in 'layer', ENUMKEY__ if nothing;
+// an entry in the EEPROM overlay (KeymapOverlay.h) wins over the chart
+keymap_t keymapLookup(byte layer, byte chord);
+// the chart's tables alone
+keymap_t keymapChartLookup(byte layer, byte chord);
+
+#endif
@@ -0,0 +1,167 @@
+// KeymapOverlay.cpp
+// see KeymapOverlay.h
+
+#include "KeymapOverlay.h"
+#include "KeyCodes.h"
+#include "OutputQueue.h"
+
+#include <string.h>
+
+static_assert(OverlayMacros == DIV_Combo - DIV_OverlayMacro, "an OVERLAY_MACRO_ code for each slot");
+
+OverlayStats overlayStats;
+
+static byte overlayIndex[OverlayIndexSize];  // entry number + 1, 0 empty
+static unsigned int entriesAt = 0;           // EEPROM address of entry 0
+static unsigned int macroAt[OverlayMacros];  // of each slot's tap count, 0 none
+
+static unsigned int entryAt(byte e){
+  return entriesAt + 3 * e;
+}
+
+static byte slotOf(byte layer, byte chord){
+  return ((layer << 7 | chord) * 37u) & (OverlayIndexSize - 1);
+}
+
+// Fletcher-16 of the counts and the body up to 'end', seeded as in
+// Usage.cpp so an all 0 image doesn't check out
+static uint16_t checksum(unsigned int end){
+  uint16_t a = 0x5A, b = 0xA5;
+  for (unsigned int addr = OverlayEepromStart + 2; addr < end; addr++) {
+    if (addr == OverlayEepromStart + 4) addr += 2;
+    a = (a + halEepromRead(addr)) % 255;
+    b = (b + a) % 255;
+  }
+  return b << 8 | a;
+}
+
+// the entry 'chord' has in 'layer', its place in the index when it has
+// none; the index is never full so an empty place ends the probe
+static byte probe(byte layer, byte chord, bool *isFound){
+  byte slot = slotOf(layer, chord);
+  for (; overlayIndex[slot]; slot = (slot + 1) & (OverlayIndexSize - 1)) {
+    unsigned int at = entryAt(overlayIndex[slot] - 1);
+    if (halEepromRead(at) == layer && halEepromRead(at + 1) == chord) break;
+  }
+  *isFound = overlayIndex[slot] != 0;
+  return slot;
+}
+
+//=====LOAD=============================LOAD========================
+static byte load(){
+  unsigned int at = OverlayEepromStart;
+  byte magic = halEepromRead(at);
+  if (magic == 0xFF) return OVERLAY_NONE;  // erased
+  if (magic != OverlayMagic || halEepromRead(at + 1) != OverlayVersion) return OVERLAY_BAD;
+  byte macros = halEepromRead(at + 2);
+  byte entries = halEepromRead(at + 3);
+  if (macros > OverlayMacros || entries > OverlayMaxEntries) return OVERLAY_BAD;
+
+  unsigned int p = at + OverlayHeaderSize;
+  for (byte m = 0; m < macros; m++) {
+    byte taps = halEepromRead(p);
+    if (taps > OverlayMacroTaps) return OVERLAY_BAD;
+    macroAt[m] = p;
+    p += 1 + 2 * taps;
+    if (p > OverlayEepromEnd) return OVERLAY_BAD;
+  }
+  entriesAt = p;
+  unsigned int end = p + 3 * entries;
+  if (end > OverlayEepromEnd) return OVERLAY_BAD;
+  if ((halEepromRead(at + 4) | (uint16_t)halEepromRead(at + 5) << 8) != checksum(end))
+    return OVERLAY_BAD;
+
+  for (byte e = 0; e < entries; e++) {
+    byte layer = halEepromRead(entryAt(e));
+    byte chord = halEepromRead(entryAt(e) + 1);
+    if (layer >= OverlayLayers || !chord || chord > 0x7F) return OVERLAY_BAD;
+    bool isFound;
+    byte slot = probe(layer, chord, &isFound);
+    if (isFound) return OVERLAY_BAD;  // the same chord twice
+    overlayIndex[slot] = e + 1;
+  }
+  overlayStats.macros = macros;
+  overlayStats.entries = entries;
+  return OVERLAY_OK;
+}
+
+void overlayInit(){
+  unsigned long start = halMicros();
+  memset(overlayIndex, 0, sizeof(overlayIndex));
+  memset(macroAt, 0, sizeof(macroAt));
+  overlayStats = OverlayStats();
+  overlayStats.status = load();
+  if (overlayStats.status != OVERLAY_OK) {
+    // nothing of a bad image is used
+    memset(overlayIndex, 0, sizeof(overlayIndex));
+    memset(macroAt, 0, sizeof(macroAt));
+    overlayStats.macros = 0;
+    overlayStats.entries = 0;
+  }
+  overlayStats.loadMicros = halMicros() - start;
+}
+
+//=====LOOKUP===========================LOOKUP======================
+bool overlayLookup(byte layer, byte chord, byte *code){
+  if (!overlayStats.entries) return false;
+  bool isFound;
+  byte slot = probe(layer, chord, &isFound);
+  if (!isFound) return false;
+  *code = halEepromRead(entryAt(overlayIndex[slot] - 1) + 2);
+  return true;
+}
+
+void overlayMacro(byte slot){
+  if (slot >= OverlayMacros || !macroAt[slot]) return;
+  unsigned int p = macroAt[slot];
+  byte taps = halEepromRead(p++);
+  for (byte t = 0; t < taps; t++, p += 2) {
+    if (t) queueGap();
+    queueKeyDown(halEepromRead(p), halEepromRead(p + 1));
+    queueKeyUp();
+  }
+}
+
+//=====BIND=============================BIND========================
+static void writeCountAndSum(byte entries){
+  halEepromWrite(OverlayEepromStart + 3, entries);
+  uint16_t sum = checksum(entryAt(entries));
+  halEepromWrite(OverlayEepromStart + 4, sum & 0xFF);
+  halEepromWrite(OverlayEepromStart + 5, sum >> 8);
+}
+
+bool overlayBind(byte layer, byte chord, byte code, byte chartCode){
+  if (overlayStats.status != OVERLAY_OK) {
+    // erased, or a bad image: an empty one to start from
+    halEepromWrite(OverlayEepromStart, OverlayMagic);
+    halEepromWrite(OverlayEepromStart + 1, OverlayVersion);
+    halEepromWrite(OverlayEepromStart + 2, 0);
+    entriesAt = OverlayEepromStart + OverlayHeaderSize;
+    writeCountAndSum(0);
+    overlayInit();
+  }
+  byte entries = overlayStats.entries;
+  bool isFound;
+  byte slot = probe(layer, chord, &isFound);
+  if (isFound) {
+    byte e = overlayIndex[slot] - 1;
+    if (code == chartCode) {
+      // back to the chart: the last entry fills its place
+      entries--;
+      for (byte i = 0; i < 3 && e != entries; i++)
+        halEepromWrite(entryAt(e) + i, halEepromRead(entryAt(entries) + i));
+    } else {
+      halEepromWrite(entryAt(e) + 2, code);
+    }
+  } else {
+    if (code == chartCode) return true;
+    if (entries == OverlayMaxEntries || entryAt(entries) + 3 > OverlayEepromEnd) return false;
+    halEepromWrite(entryAt(entries), layer);
+    halEepromWrite(entryAt(entries) + 1, chord);
+    halEepromWrite(entryAt(entries) + 2, code);
+    entries++;
+  }
+  writeCountAndSum(entries);
+  overlayInit();
+  return true;
+}
@@ -0,0 +1,76 @@
+// KeymapOverlay.h
+// Chords rebound without reflashing: a sparse list of layer/chord -> code
+// entries and a few macro slots kept in EEPROM after the usage counts.
+// overlayInit() checks it at boot and builds an index in RAM, and
+// keymapLookup() asks overlayLookup() before the flash tables, so an
+// entry wins over ChordMappings.h.  A lookup is a hash of layer and
+// chord into the index, a probe or two, and the entry's bytes read from
+// EEPROM; with no overlay it is one compare.
+//
+// The image, from OverlayEepromStart:
+//   0  OverlayMagic
+//   1  OverlayVersion
+//   2  macro count
+//   3  entry count
+//   4  Fletcher-16 of bytes 2 and 3 and the body, low byte first
+//   6  the macros, each a tap count then that many modifier, key pairs
+//      the entries, each layer, chord, code
+// Entries are in no order, so recording one is a few byte writes at the
+// end.  tools/overlay_image makes images from a text file and checks
+// them with this same loader.
+//
+// RECORD_BINDING (a function layer chord) records one from the keyboard:
+// the next chord pressed (the mode keys still switch layers on the way)
+// is the one to change, and the chord after that gives the code it
+// gets; RECORD_BINDING again instead puts the chart's code back.
+// MODE_RESET, or RECORD_BINDING before a chord is picked, gives up.  Writing takes a few EEPROM bytes, tens of ms; a
+// power cut halfway leaves an image that fails its checksum, so the
+// board types from the chart alone until the next recording starts it
+// over.
+
+#ifndef KEYMAP_OVERLAY_H
+#define KEYMAP_OVERLAY_H
+
+#include "ChorderHal.h"
+#include "Usage.h"
+
+const unsigned int OverlayEepromStart = UsageEepromEnd;
+const unsigned int OverlayEepromEnd = HalEepromSize;
+const byte OverlayMagic = 0x4B;      // 'K'
+const byte OverlayVersion = 1;
+const byte OverlayHeaderSize = 6;
+const byte OverlayLayers = 4;        // Mode in Chorder.cpp
+const byte OverlayMaxEntries = 48;
+const byte OverlayMacros = 3;        // OVERLAY_MACRO_0 - 2
+const byte OverlayMacroTaps = 10;    // 3 queued events each, see OutputQueue.h
+const byte OverlayIndexSize = 64;    // a power of 2, under 3/4 full
+
+static_assert(OverlayEepromStart + OverlayHeaderSize + OverlayMacros * (1 + 2 * OverlayMacroTaps) +
+                  OverlayMaxEntries * 3 <= OverlayEepromEnd,
+              "a full overlay has to fit in the EEPROM");
+
+enum OverlayStatus {
+  OVERLAY_NONE,  // erased, the chart alone
+  OVERLAY_OK,
+  OVERLAY_BAD    // failed its checks, the chart alone
+};
+
+struct OverlayStats {
+  byte status;
+  byte entries;
+  byte macros;
+  unsigned long loadMicros;  // the last overlayInit()
+};
+extern OverlayStats overlayStats;
+
+// check the image in EEPROM and index it, at boot and after a change
+void overlayInit();
+// the code the overlay gives 'chord' in 'layer'; false when it has none
+bool overlayLookup(byte layer, byte chord, byte *code);
+// queue the taps of macro slot 'slot', nothing if it is empty
+void overlayMacro(byte slot);
+// 'chord' in 'layer' types 'code' from now on, an entry dropped when
+// that is what the chart has ('chartCode'); false when the overlay is full
+bool overlayBind(byte layer, byte chord, byte code, byte chartCode);
+
+#endif
@@ -0,0 +1,120 @@
+// Latency.cpp
+// see Latency.h
+
+#include "Latency.h"
+#include "Trace.h"
+
+#include <string.h>
+
+LatencyHistogram latencyHistograms[LatencyStages];
+
+const byte StageNameSize = 9;  // "debounce" and its 0
+static const char stageNames[LatencyStages][StageNameSize] PROGMEM = {
+  "debounce", "chord", "dispatch", "queue", "format", "write", "ack", "total"
+};
+
+void latencyInit(){
+  memset(latencyHistograms, 0, sizeof(latencyHistograms));
+}
+
+static byte bucketOf(unsigned long micros){
+  byte b = 0;
+  micros >>= 3;
+  while (micros && b < LatencyBuckets - 1) {
+    micros >>= 1;
+    b++;
+  }
+  return b;
+}
+
+void latencyRecord(byte stage, unsigned long micros){
+  LatencyHistogram &h = latencyHistograms[stage];
+  uint16_t &n = h.count[bucketOf(micros)];
+  if (n != 0xFFFF) n++;
+  if (micros > h.maxMicros) h.maxMicros = micros;
+}
+
+unsigned long latencyCount(byte stage){
+  unsigned long n = 0;
+  for (byte b = 0; b < LatencyBuckets; b++) n += latencyHistograms[stage].count[b];
+  return n;
+}
+
+unsigned long latencyPercentile(byte stage, byte percent){
+  const LatencyHistogram &h = latencyHistograms[stage];
+  unsigned long total = latencyCount(stage);
+  if (!total) return 0;
+  unsigned long want = (total * percent + 99) / 100, seen = 0;
+  for (byte b = 0; b < LatencyBuckets - 1; b++) {
+    seen += h.count[b];
+    if (seen >= want) {
+      unsigned long edge = 8ul << b;
+      return edge < h.maxMicros ? edge : h.maxMicros;
+    }
+  }
+  return h.maxMicros;
+}
+
+//=====REPORT===========================REPORT======================
+// text in PROGMEM, PSTR("..."), without its 0
+static char *putText_P(char *p, const char *flashText){
+  size_t n = strlen_P(flashText);
+  memcpy_P(p, flashText, n);
+  return p + n;
+}
+
+static char *putStageName(char *p, byte stage){
+  char c;
+  for (const char *name = stageNames[stage]; (c = pgm_read_byte(name)); name++) *p++ = c;
+  return p;
+}
+
+// at most 7 digits
+static unsigned long summaryMicros(unsigned long micros){
+  return micros > 9999999 ? 9999999 : micros;
+}
+
+// a stage's report line at its longest: the name, a count of up to
+// 16 * 65535 and three clamped times, then the buckets at 5 digits each
+const byte CountDigits = 7, MicrosDigits = 7, BucketDigits = 5;
+const byte LatencyReportSize = StageNameSize - 1 + 3 + CountDigits + 3 * (5 + MicrosDigits) + 2 +
+                               LatencyBuckets * (1 + BucketDigits) + 1;
+static_assert(LatencyBuckets * 65535ul <= 9999999, "a stage's count fits its digits");
+
+void latencyReport(){
+  char line[LatencyReportSize];
+  halLogP(PSTR("latency us: n p50 p90 max, then buckets <8 <16 <32 ... <131072 and over"));
+  for (byte s = 0; s < LatencyStages; s++) {
+    char *p = putStageName(line, s);
+    p = putText_P(p, PSTR(" n "));
+    p = logDecimal(p, latencyCount(s));
+    p = putText_P(p, PSTR(" p50 "));
+    p = logDecimal(p, summaryMicros(latencyPercentile(s, 50)));
+    p = putText_P(p, PSTR(" p90 "));
+    p = logDecimal(p, summaryMicros(latencyPercentile(s, 90)));
+    p = putText_P(p, PSTR(" max "));
+    p = logDecimal(p, summaryMicros(latencyHistograms[s].maxMicros));
+    *p++ = ' ';
+    *p++ = ':';
+    for (byte b = 0; b < LatencyBuckets; b++) {
+      *p++ = ' ';
+      p = logDecimal(p, latencyHistograms[s].count[b]);
+    }
+    *p = 0;
+    halLog(line);
+  }
+}
+
+void latencySummary(char *buf){
+  char *p = putText_P(buf, PSTR("lat us p50/p90"));
+  for (byte s = 0; s < LatencyStages; s++) {
+    *p++ = ' ';
+    memcpy_P(p, stageNames[s], 3);
+    p += 3;
+    *p++ = ' ';
+    p = logDecimal(p, summaryMicros(latencyPercentile(s, 50)));
+    *p++ = '/';
+    p = logDecimal(p, summaryMicros(latencyPercentile(s, 90)));
+  }
+  *p = 0;
+}
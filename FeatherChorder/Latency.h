@@ -0,0 +1,50 @@
+// Latency.h
+// Where the time goes between a finger moving and a report leaving for
+// the Bluefruit.  Each stage below is timed with halMicros() where it
+// happens and counted into a histogram of log2 buckets in RAM, so the
+// board (LATENCY_REPORT chord, or the serial console with VERBOSE_MODE)
+// and the host benchmarks report the same numbers.  On the host the
+// clock is simulated and only moves between scans, so the stages that
+// are CPU time (dispatch, format, write) read 0 there.
+
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include "ChorderHal.h"
+
+enum LatencyStage {
+  LAT_DEBOUNCE,  // raw switch change -> debounced change
+  LAT_CHORD,     // first switch of the chord down -> chord decided
+  LAT_DISPATCH,  // sendKey(): the lookup, modes and queueing
+  LAT_QUEUE,     // an event waiting in the output queue (ms steps)
+  LAT_FORMAT,    // building a key report command
+  LAT_WRITE,     // halPrintln(), over SPI to the module
+  LAT_ACK,       // command written -> the module's answer (ackPacing)
+  LAT_TOTAL,     // switch change that completed a chord -> first report
+  LatencyStages
+};
+
+// bucket 0 is under 8 us, bucket i under 8 << i us, the last one open
+const byte LatencyBuckets = 16;
+
+struct LatencyHistogram {
+  uint16_t count[LatencyBuckets];  // stop at 65535
+  unsigned long maxMicros;
+};
+extern LatencyHistogram latencyHistograms[LatencyStages];
+
+void latencyInit();
+void latencyRecord(byte stage, unsigned long micros);
+unsigned long latencyCount(byte stage);
+// the upper edge of the bucket holding 'percent' of the stage's samples
+// (its max for the open bucket), 0 with no samples
+unsigned long latencyPercentile(byte stage, byte percent);
+// a line per stage through halLog(): count, p50, p90, max and buckets;
+// times over 10 s show as 9999999
+void latencyReport();
+// "lat us p50/p90 deb 8/16 ..." in buf, for typing out with sendString();
+// times over 10 s show as 9999999
+const byte LatencySummarySize = 15 + LatencyStages * 20;
+void latencySummary(char *buf);
+
+#endif
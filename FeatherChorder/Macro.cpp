@@ -0,0 +1,59 @@
+// Macro.cpp
+// see Macro.h
+
+#include "Macro.h"
+#include "Chorder.h"
+#include "KeyCodes.h"
+#include "OutputQueue.h"
+#include "MacroTable.h"
+
+const byte macroCount = sizeof(macro_table) / sizeof(macro_table[0]);
+static const byte macroStringCount = sizeof(macro_strings) / sizeof(macro_strings[0]);
+
+//=====RUN MACRO========================RUN MACRO===================
+void runMacro(byte index, byte modKeys, byte latchMods){
+  if (index >= macroCount) return;
+
+  const uint8_t *pc;
+  memcpy_P(&pc, &macro_table[index], sizeof(pc));
+
+  for (;;) {
+    byte op = pgm_read_byte(pc++);
+    switch (op) {
+    case MOP_TAP:
+    case MOP_PRESS: {
+      byte mod = pgm_read_byte(pc++);
+      byte key = pgm_read_byte(pc++);
+      queueKeyDown(mod, key);
+      if (op == MOP_TAP) queueKeyUp();
+      break;
+    }
+    case MOP_TAPC:
+    case MOP_TAPL:
+      queueKeyDown(op == MOP_TAPC ? modKeys : latchMods, pgm_read_byte(pc++));
+      queueKeyUp();
+      break;
+    case MOP_RELEASE:
+      queueKeyUp();
+      break;
+    case MOP_MODS:
+      modKeys |= pgm_read_byte(pc++);
+      break;
+    case MOP_WAIT:
+      queueWait(pgm_read_byte(pc++));
+      break;
+    case MOP_GAP:
+      queueGap();
+      break;
+    case MOP_STRING: {
+      byte n = pgm_read_byte(pc++);
+      const char *text = 0;
+      if (n < macroStringCount) memcpy_P(&text, &macro_strings[n], sizeof(text));
+      if (text) queueStringP(text);
+      break;
+    }
+    default:  // MOP_END, or something we don't know
+      return;
+    }
+  }
+}
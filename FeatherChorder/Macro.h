@@ -0,0 +1,59 @@
+// Macro.h
+// Macros are small programs in flash (MacroTable.h) run by runMacro()
+// onto the output queue, so a new macro is data rather than another
+// case in sendKey().
+//
+// A macro is a list of ops, written with the M_ helpers below and
+// ended with M_END:
+//   M_TAP(mod, key)     key down with 'mod' modifiers, then key up
+//   M_TAPC(key)         tap with the current modKeys (incl. M_MODS)
+//   M_TAPL(key)         tap with only the latched modifiers
+//   M_PRESS(mod, key)   key down only
+//   M_RELEASE           all keys up
+//   M_MODS(mod)         add 'mod' to the current modifiers for M_TAPC
+//   M_WAIT(ms)          pause the output, 1 - 255 ms
+//   M_GAP               pause for InterstitialDelay, or with ackPacing
+//                       until the module has answered
+//   M_STRING(n)         type macro_strings[n] with AT+BleKeyboard
+//   M_END
+
+#ifndef MACRO_H
+#define MACRO_H
+
+#include "ChorderHal.h"
+
+enum MacroOp {
+  MOP_END,
+  MOP_TAP,
+  MOP_TAPC,
+  MOP_TAPL,
+  MOP_PRESS,
+  MOP_RELEASE,
+  MOP_MODS,
+  MOP_WAIT,
+  MOP_GAP,
+  MOP_STRING
+};
+
+#define M_TAP(mod, key)    MOP_TAP, (mod), (key)
+#define M_TAPC(key)        MOP_TAPC, (key)
+#define M_TAPL(key)        MOP_TAPL, (key)
+#define M_PRESS(mod, key)  MOP_PRESS, (mod), (key)
+#define M_RELEASE          MOP_RELEASE
+#define M_MODS(mod)        MOP_MODS, (mod)
+#define M_WAIT(ms)         MOP_WAIT, (ms)
+#define M_GAP              MOP_GAP
+#define M_STRING(n)        MOP_STRING, (n)
+#define M_END              MOP_END
+
+// key codes from DIV_Macro up to here are macros, the words of
+// Dictionary.h follow
+const byte MacroCodeEnd = 0xB0;
+
+extern const byte macroCount;
+
+// queue macro number 'index' with the given current and latched
+// modifiers; unknown numbers do nothing
+void runMacro(byte index, byte modKeys, byte latchMods);
+
+#endif
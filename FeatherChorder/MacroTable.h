@@ -0,0 +1,74 @@
+// MacroTable.h
+// The macros, split out like ChordMappings.h so they can be changed
+// without touching code.  Ops are described in Macro.h.
+//
+// To add one: write its ops below, add it to the end of macro_table,
+// and use DIV_Macro + its place in the table in a keymap (or give it a
+// name at the end of the macro codes in KeyCodes.h).
+
+/**************************************
+ * text typed by M_STRING(n)          *
+ **************************************/
+// none yet; entries are PROGMEM strings, e.g.
+//   const char macro_string_hello[] PROGMEM = "hello";
+const char * const macro_strings[] PROGMEM = {
+  0
+};
+
+/**************************************
+ * the macros                         *
+ **************************************/
+const uint8_t macro_000[] PROGMEM = {
+  M_TAP(0x00, ENUMKEY_0), M_TAP(0x00, ENUMKEY_0), M_TAP(0x00, ENUMKEY_0), M_END
+};
+const uint8_t macro_00[] PROGMEM = {
+  M_TAP(0x00, ENUMKEY_0), M_TAP(0x00, ENUMKEY_0), M_END
+};
+// "" and a back arrow
+const uint8_t macro_quotes[] PROGMEM = {
+  M_TAP(0x02, ENUMKEY_ping), M_GAP, M_TAP(0x02, ENUMKEY_ping), M_GAP,
+  M_TAP(0x00, ENUMKEY_larr), M_END
+};
+// () and a back arrow
+const uint8_t macro_parens[] PROGMEM = {
+  M_TAP(0x02, ENUMKEY_9), M_GAP, M_TAP(0x02, ENUMKEY_0), M_GAP,
+  M_TAP(0x00, ENUMKEY_larr), M_END
+};
+// bigrams: latched mods and caps lock affect both letters, other
+// modifiers like shift only the first
+const uint8_t macro_1[] PROGMEM = { M_TAPC(ENUMKEY_E), M_GAP, M_TAPL(ENUMKEY_R), M_END };  // er
+const uint8_t macro_2[] PROGMEM = { M_TAPC(ENUMKEY_T), M_GAP, M_TAPL(ENUMKEY_H), M_END };  // th
+const uint8_t macro_3[] PROGMEM = { M_TAPC(ENUMKEY_A), M_GAP, M_TAPL(ENUMKEY_N), M_END };  // an
+const uint8_t macro_4[] PROGMEM = { M_TAPC(ENUMKEY_I), M_GAP, M_TAPL(ENUMKEY_N), M_END };  // in
+// a long string to confirm length of interstitial delay
+const uint8_t macro_test[] PROGMEM = {
+  M_TAPC(ENUMKEY_A), M_GAP, M_TAPC(ENUMKEY_B), M_GAP, M_TAPC(ENUMKEY_C), M_GAP,
+  M_TAPC(ENUMKEY_D), M_GAP, M_TAPC(ENUMKEY_E), M_GAP, M_TAPC(ENUMKEY_F), M_GAP,
+  M_TAPC(ENUMKEY_G), M_GAP, M_TAPC(ENUMKEY_H), M_END
+};
+// try for shift down
+const uint8_t macro_shiftdn[] PROGMEM = { M_PRESS(0x02, ENUMKEY__), M_END };
+
+/**************************************
+ * in the order of the macro codes    *
+ * in KeyCodes.h, from DIV_Macro      *
+ **************************************/
+const uint8_t * const macro_table[] PROGMEM = {
+  macro_000,            // MACRO_000
+  macro_00,             // MACRO_00
+  macro_quotes,         // MACRO_quotes
+  macro_parens,         // MACRO_parens
+  macro_1,              // MACRO_1
+  macro_2,              // MACRO_2
+  macro_3,              // MACRO_3
+  macro_4,              // MACRO_4
+  macro_test,           // MACRO_TEST
+  macro_shiftdn,        // MACRO_SHIFTDN
+};
+
+static_assert(sizeof(macro_table) / sizeof(macro_table[0]) >= DIV_Last - DIV_Macro,
+              "every named macro code in KeyCodes.h needs a macro_table entry");
+static_assert(DIV_Macro + sizeof(macro_table) / sizeof(macro_table[0]) <= MacroCodeEnd,
+              "macro_table has more entries than there are macro codes");
+
+// end MacroTable.h
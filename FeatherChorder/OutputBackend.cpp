@@ -0,0 +1,90 @@
+// OutputBackend.cpp
+// see OutputBackend.h; the Bluefruit backend, moved here from the send
+// functions in Chorder.cpp
+
+#include "OutputBackend.h"
+#include "AckPacing.h"
+#include "AtCommand.h"
+#include "Latency.h"
+
+const OutputBackend *outputBackend = &bleBackend;
+
+void outputSelect(const OutputBackend *backend){
+  outputBackend = backend;
+}
+
+const OutputBackend *cableBackend = 0;
+
+void outputCabled(bool isCabled){
+  const OutputBackend *wanted = isCabled && cableBackend ? cableBackend : &bleBackend;
+  if (wanted == outputBackend) return;
+  outputBackend->keyUp();
+  outputSelect(wanted);
+}
+
+bool cableLinkUp(bool isConfigured, bool hasVbus, bool isSuspended){
+  return isConfigured && hasVbus && !isSuspended;
+}
+
+//=====BLUEFRUIT========================BLUEFRUIT===================
+// Format for Bluefruit Feather is MOD-00-KEY, see atKeyboardCode().
+// Built on the stack and sent in one go, no String on the heap.
+static void bleKeyDown(byte modKey, byte rawKey){
+  char command[AtKeyboardCodeLen + 1];
+  unsigned long start = halMicros();
+  atKeyboardCode(command, modKey, rawKey);
+  latencyRecord(LAT_FORMAT, halMicros() - start);
+  atSendKey(command);
+}
+
+static void bleKeyUp(){
+  char command[AtKeyboardReleaseLen + 1];
+  atKeyboardRelease(command);
+  atSendKey(command);
+}
+
+// note: for Volume +/- and the few other keys that take a time to hold,
+// the module takes the time after a comma, "VOLUME+,500"
+static void bleControl(const char *cntrlName){
+  char command[AtCommandSize];
+  atCommandWithText(command, PSTR("AT+BleHidControlKey="), cntrlName);
+  atSend(command);
+}
+
+// text longer than one AT command goes out over several
+static void bleText(const char *text, bool isFlash){
+  char command[AtCommandSize];
+  if (isFlash) {
+    do {
+      text += atCommandWithTextP(command, PSTR("AT+BleKeyboard="), text);
+      atSend(command);
+    } while (pgm_read_byte(text));
+  } else {
+    do {
+      text += atCommandWithText(command, PSTR("AT+BleKeyboard="), text);
+      atSend(command);
+    } while (*text);
+  }
+}
+
+static void bleMouseButton(const char *buttons){
+  char command[AtCommandSize];
+  atCommandWithText(command, PSTR("AT+BleHidMouseButton="), buttons);
+  atSend(command);
+}
+
+static void bleMouseMove(int8_t x, int8_t y, int8_t wheel){
+  char command[AtMouseMoveSize];
+  atMouseMove(command, x, y, wheel);
+  atSend(command);
+}
+
+static void bleBattery(byte percent){
+  char command[AtBatteryLevelSize];
+  atBatteryLevel(command, percent);
+  atSend(command);
+}
+
+const OutputBackend bleBackend = {
+  "ble", bleKeyDown, bleKeyUp, bleControl, bleText, bleMouseButton, bleMouseMove, bleBattery
+};
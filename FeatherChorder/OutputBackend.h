@@ -0,0 +1,51 @@
+// OutputBackend.h
+// Where key reports go.  Everything the chorder types goes through
+// sendRawKeyDn(), sendRawKeyUp(), sendControlKey() and the text senders
+// in Chorder.cpp, which hand it to the selected backend:
+//   bleBackend   AT commands to the Bluefruit over SPI (the default)
+//   usbBackend   binary HID reports over the 32u4's own USB, when cabled
+//                (UsbHid.h, on the board only)
+//   mockBackend  the reports kept for host tests (host/MockBackend.h)
+// A backend with no text() gets text typed a key at a time with
+// hidFromAscii(); one with no mouseButton() or mouseMove() ignores the
+// mouse keys, and one with no battery() doesn't report the battery.
+
+#ifndef OUTPUT_BACKEND_H
+#define OUTPUT_BACKEND_H
+
+#include "ChorderHal.h"
+
+struct OutputBackend {
+  const char *name;
+  void (*keyDown)(byte modKey, byte rawKey);  // this key and modifiers down
+  void (*keyUp)();                            // all keys up
+  // consumer key by its AT+BleHidControlKey name, "PLAYPAUSE", "VOLUME+,500"
+  void (*control)(const char *cntrlName);
+  // a whole string, from flash when isFlash; may be 0
+  void (*text)(const char *text, bool isFlash);
+  void (*mouseButton)(const char *buttons);   // "L", "0" ..., may be 0
+  // relative motion, y down and the wheel up; may be 0
+  void (*mouseMove)(int8_t x, int8_t y, int8_t wheel);
+  void (*battery)(byte percent);              // Battery.h, may be 0
+};
+
+extern const OutputBackend bleBackend;
+extern const OutputBackend *outputBackend;  // the one in use
+
+// chorderInit() selects bleBackend; setup() may pick another after it
+void outputSelect(const OutputBackend *backend);
+
+// the backend for while a computer is on the cable, 0 (the default) for
+// BLE always; setup() sets it and loop() reports the cable every pass to
+// outputCabled(), which selects cableBackend while 'isCabled' and
+// bleBackend when not.  On a change the keys down on the backend left
+// behind are let go first, so a cable pulled mid chord leaves none stuck.
+extern const OutputBackend *cableBackend;
+void outputCabled(bool isCabled);
+
+// whether the cable is still good for reports: the computer enumerated
+// us, VBUS is still there (a cable pulled after that leaves the USB
+// configured) and the computer hasn't suspended the bus
+bool cableLinkUp(bool isConfigured, bool hasVbus, bool isSuspended);
+
+#endif
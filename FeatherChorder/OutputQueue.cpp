@@ -0,0 +1,167 @@
+// OutputQueue.cpp
+// see OutputQueue.h
+
+#include "OutputQueue.h"
+#include "AckPacing.h"
+#include "Chorder.h"
+#include "Latency.h"
+
+enum OutputType {
+  OUT_KEY_DOWN,
+  OUT_KEY_UP,
+  OUT_CONTROL,
+  OUT_CONTROL_P,
+  OUT_STRING_P,
+  OUT_WAIT,
+  OUT_WORD,
+  OUT_GAP,
+  OUT_MOUSE_P
+};
+
+struct OutputEvent {
+  byte type;
+  uint16_t queuedMs;       // low bits of halMillis(), for LAT_QUEUE
+  union {
+    byte key[2];           // OUT_KEY_DOWN, modifiers then key
+                           // OUT_WORD, index then case
+    const char *text;      // OUT_CONTROL, OUT_CONTROL_P, OUT_STRING_P, OUT_MOUSE_P
+    unsigned int waitMs;   // OUT_WAIT
+  } arg;
+};
+
+static OutputEvent queue[OutputQueueSize];
+static byte head = 0;   // next to send
+static byte count = 0;
+static unsigned long readyAt = 0;  // nothing goes out before this (ms)
+
+OutputStats outputStats;
+
+//=====SEND=============================SEND========================
+// send the event at the head of the queue, which must be due
+static void sendHead(){
+  OutputEvent &e = queue[head];
+  head = (head + 1) % OutputQueueSize;
+  count--;
+  if (e.type != OUT_WAIT && e.type != OUT_GAP) {
+    outputStats.sent++;
+    latencyRecord(LAT_QUEUE, (uint16_t)((uint16_t)halMillis() - e.queuedMs) * 1000ul);
+  }
+  switch (e.type) {
+  case OUT_KEY_DOWN:
+    sendRawKeyDn(e.arg.key[0], e.arg.key[1]);
+    break;
+  case OUT_KEY_UP:
+    sendRawKeyUp();
+    break;
+  case OUT_CONTROL:
+    sendControlKey(e.arg.text);
+    break;
+  case OUT_CONTROL_P:
+    sendControlKeyP(e.arg.text);
+    break;
+  case OUT_STRING_P:
+    sendStringP(e.arg.text);
+    break;
+  case OUT_WAIT:
+    readyAt = halMillis() + e.arg.waitMs;
+    break;
+  case OUT_GAP:
+    // with ackPacing the next event waits for the answers instead
+    if (!ackPacing) readyAt = halMillis() + InterstitialDelay;
+    break;
+  case OUT_WORD:
+    sendWord(e.arg.key[0], e.arg.key[1]);
+    break;
+  case OUT_MOUSE_P:
+    sendMouseKeyP(e.arg.text);
+    break;
+  }
+}
+
+static bool headIsDue(){
+  return (long)(halMillis() - readyAt) >= 0 && !ackWaiting();
+}
+
+// wait until the head can go and send it
+static void stall(){
+  unsigned long now = halMillis();
+  if (!headIsDue()) {
+    outputStats.stalls++;
+    if ((long)(readyAt - now) > 0) halDelay(readyAt - now);
+    while (ackWaiting()) halDelay(1);
+    outputStats.stalledMs += halMillis() - now;
+  }
+  sendHead();
+}
+
+//=====QUEUE============================QUEUE=======================
+static OutputEvent &push(byte type){
+  // a full queue means loop() has to wait for a delay to run out
+  if (count == OutputQueueSize) stall();
+  OutputEvent &e = queue[(head + count) % OutputQueueSize];
+  e.type = type;
+  e.queuedMs = halMillis();
+  count++;
+  if (count > outputStats.maxDepth) outputStats.maxDepth = count;
+  return e;
+}
+
+void queueKeyDown(byte modKey, byte rawKey){
+  OutputEvent &e = push(OUT_KEY_DOWN);
+  e.arg.key[0] = modKey;
+  e.arg.key[1] = rawKey;
+}
+
+void queueKeyUp(){
+  push(OUT_KEY_UP);
+}
+
+void queueControlKey(const char *cntrlName){
+  push(OUT_CONTROL).arg.text = cntrlName;
+}
+
+void queueControlKeyP(const char *flashName){
+  push(OUT_CONTROL_P).arg.text = flashName;
+}
+
+void queueMouseButtonP(const char *flashButtons){
+  push(OUT_MOUSE_P).arg.text = flashButtons;
+}
+
+void queueStringP(const char *flashText){
+  push(OUT_STRING_P).arg.text = flashText;
+}
+
+void queueWait(unsigned int ms){
+  push(OUT_WAIT).arg.waitMs = ms;
+}
+
+void queueGap(){
+  push(OUT_GAP);
+}
+
+void queueWord(byte index, byte wordCase){
+  OutputEvent &e = push(OUT_WORD);
+  e.arg.key[0] = index;
+  e.arg.key[1] = wordCase;
+}
+
+//=====DRAIN============================DRAIN=======================
+void outputService(){
+  if (!count) ackService();  // answers still come in with nothing to send
+  while (count && headIsDue()) sendHead();
+}
+
+void outputFlush(){
+  while (count) stall();
+}
+
+void outputClear(){
+  head = 0;
+  count = 0;
+  readyAt = halMillis();
+}
+
+byte outputQueueDepth(){
+  return count;
+}
@@ -0,0 +1,37 @@
+// OutputQueue.h
+// Keys sendKey() wants to send are queued here and sent from loop() as
+// they come due, so a macro with InterstitialDelay between its keys no
+// longer stops the switch scan while it goes out.
+
+#ifndef OUTPUT_QUEUE_H
+#define OUTPUT_QUEUE_H
+
+#include "ChorderHal.h"
+
+// queued events, a full MACRO_TEST takes 23
+const byte OutputQueueSize = 32;
+
+void queueKeyDown(byte modKey, byte rawKey);
+void queueKeyUp();
+void queueControlKey(const char *cntrlName);  // name must stay valid, use literals
+void queueControlKeyP(const char *flashName); // a name in PROGMEM, see sendControlKeyP()
+void queueMouseButtonP(const char *flashButtons);  // in PROGMEM, see sendMouseKeyP()
+void queueStringP(const char *flashText);     // text in PROGMEM, see sendStringP()
+void queueWait(unsigned int ms);              // nothing more goes out for ms
+void queueGap();  // InterstitialDelay, or just the answers with ackPacing
+void queueWord(byte index, byte wordCase);    // see sendWord()
+
+void outputService();  // send whatever is due, called every loop()
+void outputFlush();    // send everything now, waiting out queued delays
+void outputClear();    // drop anything not sent yet
+byte outputQueueDepth();
+
+struct OutputStats {
+  byte maxDepth;            // deepest the queue has been
+  unsigned int stalls;      // times loop() had to wait for the queue
+  unsigned long stalledMs;  // and for how long in total
+  unsigned long sent;       // events sent that report, not waits or gaps
+};
+extern OutputStats outputStats;
+
+#endif
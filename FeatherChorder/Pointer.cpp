@@ -0,0 +1,139 @@
+// Pointer.cpp
+// see Pointer.h
+
+#include "Pointer.h"
+#include "AckPacing.h"
+#include "Chorder.h"
+#include "KeyCodes.h"
+#include "KeyTables.h"
+#include "OutputBackend.h"
+#include "OutputQueue.h"
+
+unsigned int pointerStartSpeed = 100;
+unsigned int pointerTopSpeed = 1200;
+unsigned int pointerAccelMs = 1000;
+byte pointerIntervalMs = 15;
+
+PointerStats pointerStats;
+
+// motion is kept in counts * PointerUnit: a pointer_moves value (127 for
+// full speed) times counts/s times ms
+const long PointerUnit = 127000l;
+// no more than this builds up while the link is slow
+const long PointerMaxPending = 4 * 127 * PointerUnit;
+
+static int8_t direction[3];          // the move held, from pointer_moves
+static bool isMoving = false;
+static unsigned long moveStartMs = 0;
+static unsigned long lastStepMs = 0;
+static unsigned long lastSentMs = 0;
+static long pending[3];              // x, y, wheel still to send
+
+static byte buttons = 0;             // held by a drag, bit 0 left
+const byte ButtonLeft = 1;
+
+// the AT+BleHidMouseButton mask for 'bits', left 1 right 2 middle 4;
+// in flash, queued with queueMouseButtonP()
+static const char buttonNames[8][MouseButtonsSize] PROGMEM = {
+  "0", "L", "R", "LR", "M", "LM", "RM", "LRM"
+};
+
+//=====SPEED============================SPEED=======================
+// counts/s after a move has been held 'heldMs'
+static unsigned long speedAfter(unsigned long heldMs){
+  if (!pointerAccelMs || heldMs >= pointerAccelMs) return pointerTopSpeed;
+  unsigned long rise = pointerTopSpeed > pointerStartSpeed ? pointerTopSpeed - pointerStartSpeed : 0;
+  return pointerStartSpeed + rise * heldMs / pointerAccelMs * heldMs / pointerAccelMs;
+}
+
+// the motion of the move held up to now
+static void step(unsigned long now){
+  unsigned long ms = now - lastStepMs;
+  if (!ms) return;
+  lastStepMs = now;
+  if (ms > 100) ms = 100;  // a scan held up that long loses the rest
+  unsigned long speed = speedAfter(now - moveStartMs);
+  for (byte axis = 0; axis < 3; axis++) {
+    long rate = axis == 2 ? speed / PointerScrollRatio : speed;
+    pending[axis] += direction[axis] * rate * (long)ms;
+    if (pending[axis] > PointerMaxPending) pending[axis] = PointerMaxPending;
+    if (pending[axis] < -PointerMaxPending) pending[axis] = -PointerMaxPending;
+  }
+}
+
+// the whole counts of pending[axis], no more than fit in a command
+static int8_t whole(byte axis){
+  long counts = pending[axis] / PointerUnit;
+  if (counts > 127) return 127;
+  if (counts < -127) return -127;
+  return counts;
+}
+
+//=====POINTER==========================POINTER=====================
+void pointerInit(){
+  isMoving = false;
+  buttons = 0;
+  lastSentMs = halMillis();
+  for (byte axis = 0; axis < 3; axis++) pending[axis] = 0;
+  pointerStats = PointerStats();
+}
+
+void pointerHeld(byte theKey){
+  bool isMove = theKey >= DIV_Pointer && theKey < DIV_PointerButton;
+  if (!isMove && !isMoving) return;
+  unsigned long now = halMillis();
+  if (isMoving) step(now);
+  if (!isMove) {
+    // what is left under a count isn't worth a command
+    isMoving = false;
+    for (byte axis = 0; axis < 3; axis++) pending[axis] = (long)whole(axis) * PointerUnit;
+    return;
+  }
+  // another move straight from this one keeps its speed
+  if (!isMoving) moveStartMs = lastStepMs = now;
+  isMoving = true;
+  for (byte axis = 0; axis < 3; axis++)
+    direction[axis] = (int8_t)pgm_read_byte(&pointer_moves[theKey - DIV_Pointer][axis]);
+}
+
+void pointerKey(byte theKey){
+  if (theKey == POINTER_drag) {
+    buttons ^= ButtonLeft;
+    queueMouseButtonP(buttonNames[buttons]);
+  } else if (theKey >= POINTER_lclick && theKey <= POINTER_mclick) {
+    queueMouseButtonP(buttonNames[buttons | 1 << (theKey - POINTER_lclick)]);
+    queueMouseButtonP(buttonNames[buttons]);
+  }
+}
+
+void pointerStop(){
+  isMoving = false;
+  for (byte axis = 0; axis < 3; axis++) pending[axis] = 0;
+  if (!buttons) return;
+  buttons = 0;
+  queueMouseButtonP(buttonNames[0]);
+}
+
+bool pointerBusy(){
+  return isMoving || pending[0] || pending[1] || pending[2];
+}
+
+void pointerService(){
+  if (!pointerBusy()) return;
+  unsigned long now = halMillis();
+  if (isMoving) step(now);
+  // keys and buttons go first, and one command at a time
+  if (now - lastSentMs < pointerIntervalMs || outputQueueDepth() || ackWaiting()) return;
+  int8_t counts[3] = { whole(0), whole(1), whole(2) };
+  if (!counts[0] && !counts[1] && !counts[2]) return;
+  lastSentMs = now;
+  for (byte axis = 0; axis < 3; axis++) pending[axis] -= (long)counts[axis] * PointerUnit;
+  if (!outputBackend->mouseMove) return;  // a backend with no mouse
+  outputBackend->mouseMove(counts[0], counts[1], counts[2]);
+  pointerStats.moves++;
+  for (byte axis = 0; axis < 3; axis++) {
+    byte size = counts[axis] < 0 ? -counts[axis] : counts[axis];
+    pointerStats.counts += size;
+    if (size > pointerStats.maxStep) pointerStats.maxStep = size;
+  }
+}
@@ -0,0 +1,54 @@
+// Pointer.h
+// The POINTER layer: MODE_POINTER locks the chorder into it until it is
+// pressed again (or MODE_RESET), and its chords work a mouse.  A chord
+// bound to a move or scroll (POINTER_up ... POINTER_scrolldown) moves
+// the pointer for as long as it is held, faster the longer it is held:
+//
+//   speed = pointerStartSpeed
+//         + (pointerTopSpeed - pointerStartSpeed) * (t / pointerAccelMs)^2
+//
+// in counts a second, t capped at pointerAccelMs, so a short hold is a
+// fine move and a long one crosses the screen; a scroll goes at
+// 1 / PointerScrollRatio of that.  The buttons click when their chord
+// is sent; POINTER_drag holds the left one down until it is sent again.
+//
+// Nothing waits.  pointerService() runs from every scan while a move is
+// held, adds the motion up in fixed point, and sends what has built up
+// as one AT+BleHidMouseMove no more than once a pointerIntervalMs (about
+// the BLE connection interval, the most often a report gets to the host
+// anyway), and only when the output queue is empty and the module has
+// answered the command before.  A slow link gets fewer, bigger moves
+// rather than a backlog.
+
+#ifndef POINTER_H
+#define POINTER_H
+
+#include "ChorderHal.h"
+
+extern unsigned int pointerStartSpeed;  // counts/s as a move starts
+extern unsigned int pointerTopSpeed;    // counts/s once held pointerAccelMs
+extern unsigned int pointerAccelMs;
+extern byte pointerIntervalMs;          // at most one move command per this
+const byte PointerScrollRatio = 32;     // wheel speed is the pointer's / this
+
+struct PointerStats {
+  unsigned long moves;    // move commands sent
+  unsigned long counts;   // |x| + |y| + |wheel| over them
+  byte maxStep;           // the biggest on one axis in one command
+};
+extern PointerStats pointerStats;
+
+void pointerInit();
+// the code of the chord held in the POINTER layer as the switches
+// change, ENUMKEY__ when there is none (or it was lifted)
+void pointerHeld(byte theKey);
+// a POINTER_ code sent: the buttons click or drag, the moves are done
+void pointerKey(byte theKey);
+// the motion stops and a drag lets go, for reset()
+void pointerStop();
+// moving, or motion still to send: the scan has to keep running
+bool pointerBusy();
+// motion due goes out, called every scan
+void pointerService();
+
+#endif
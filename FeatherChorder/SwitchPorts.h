@@ -0,0 +1,29 @@
+// SwitchPorts.h
+// Where the chording switches sit on the 32u4 ports, and how to turn one
+// read of PIND and PINF into keyState without seven digitalRead() calls.
+//
+//   keyState bit  switch        Arduino pin  port bit
+//   0             Pinky         6            PD7
+//   1             Ring          A5           PF0
+//   2             Middle        A4           PF1
+//   3             Index         A3           PF4
+//   4             Near Thumb    A2           PF5
+//   5             Center Thumb  A1           PF6
+//   6             Far Thumb     A0           PF7
+//
+// The switches pull to ground, so a 0 on the port is a closed switch.
+
+#ifndef SWITCH_PORTS_H
+#define SWITCH_PORTS_H
+
+#include <Arduino.h>
+
+inline uint8_t switchesFromPorts(uint8_t pind, uint8_t pinf){
+  uint8_t d = ~pind;
+  uint8_t f = ~pinf;
+  return (uint8_t)((d >> 7)              // PD7 -> bit 0
+                 | ((f & 0x03) << 1)     // PF0, PF1 -> bits 1, 2
+                 | ((f & 0xF0) >> 1));   // PF4 - PF7 -> bits 3 - 6
+}
+
+#endif
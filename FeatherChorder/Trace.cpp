@@ -0,0 +1,99 @@
+// Trace.cpp
+// see Trace.h
+
+#include "Trace.h"
+#include "AtCommand.h"
+#include "Chorder.h"
+#include "Debounce.h"
+
+static TraceEntry ring[TraceSize];
+static byte head = 0;  // next to write
+static byte count = 0;
+static unsigned long seq = 0;
+
+static const char kindLetters[] PROGMEM = "rscdut";
+
+void traceInit(){
+  head = 0;
+  count = 0;
+  seq = 0;
+}
+
+void traceRecord(byte kind, byte a, byte b){
+  TraceEntry &e = ring[head];
+  e.ms = (uint16_t)halMillis();
+  e.kind = kind;
+  e.a = a;
+  e.b = b;
+  head = (head + 1) % TraceSize;
+  if (count < TraceSize) count++;
+  seq++;
+}
+
+byte traceCount(){
+  return count;
+}
+
+unsigned long traceSeq(){
+  return seq;
+}
+
+const TraceEntry &traceEntry(byte i){
+  return ring[(head + TraceSize - count + i) % TraceSize];
+}
+
+//=====DUMP=============================DUMP========================
+char *logDecimal(char *p, unsigned long n){
+  char digits[10];
+  byte used = 0;
+  do {
+    digits[used++] = '0' + n % 10;
+    n /= 10;
+  } while (n);
+  while (used) *p++ = digits[--used];
+  return p;
+}
+
+char *logHex(char *p, byte n){
+  *p++ = ' ';
+  *p++ = pgm_read_byte(&hexDigits[n >> 4]);
+  *p++ = pgm_read_byte(&hexDigits[n & 0x0F]);
+  return p;
+}
+
+byte traceLine(char *buf, const TraceEntry &e){
+  char *p = logDecimal(buf, e.ms);
+  *p++ = ' ';
+  *p++ = pgm_read_byte(&kindLetters[e.kind]);
+  if (e.kind <= TRACE_CHORD || e.kind == TRACE_DOWN) p = logHex(p, e.a);
+  if (e.kind == TRACE_CHORD || e.kind == TRACE_DOWN) p = logHex(p, e.b);
+  *p = 0;
+  return p - buf;
+}
+
+void traceDump(){
+  char line[96];
+  char *p = logDecimal(line + 6, count);  // after "trace "
+  memcpy_P(line, PSTR("trace "), 6);
+  memcpy_P(p, PSTR(" debounce "), 10);
+  p = logDecimal(p + 10, debounceDelay);
+  memcpy_P(p, PSTR(" eager"), 6);
+  p = logHex(p + 6, eagerSwitches);
+  memcpy_P(p, PSTR(" hold "), 6);
+  p = logDecimal(p + 6, holdDwellMs);
+  memcpy_P(p, PSTR(" rollover "), 10);
+  p = logDecimal(p + 10, rolloverChords);
+  memcpy_P(p, PSTR(" held"), 5);
+  p = logHex(p + 5, rolloverHeldSwitches);
+  memcpy_P(p, PSTR(" repeat "), 8);
+  p = logDecimal(p + 8, repeatHoldMs);
+  memcpy_P(p, PSTR(" layers"), 7);
+  p = logHex(p + 7, repeatLayers);
+  *p = 0;
+  halLog(line);
+  for (byte i = 0; i < count; i++) {
+    traceLine(line, traceEntry(i));
+    halLog(line);
+  }
+  halLogP(PSTR("end"));
+}
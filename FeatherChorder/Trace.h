@@ -0,0 +1,64 @@
+// Trace.h
+// A small ring of what the chorder saw and did, the last TraceSize
+// events: raw switch changes, debounced (stable) changes, chords looked
+// up and the reports sent.  TRACE_DUMP (a function layer chord) writes it
+// out with halLog() so a missed or doubled chord can be looked at, and
+// fed back through the same code on a PC with chord_replay.
+//
+// The dump is one line per event, oldest first:
+//   trace <entries> debounce <ms> eager <hex> hold <ms> rollover <0|1>
+//         held <hex> repeat <ms> layers <hex>
+//   <ms> r <keyState>      raw switches changed
+//   <ms> s <keyState>      debounced switches changed
+//   <ms> c <chord> <code>  chord looked up, the key code it gave
+//   <ms> d <mod> <key>     key report, keys down
+//   <ms> u                 key report, all keys up
+//   <ms> t                 text or control command
+//   end
+// ms is the low 16 bits of halMillis(), values are hex.
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "ChorderHal.h"
+
+enum TraceKind {
+  TRACE_RAW,
+  TRACE_STABLE,
+  TRACE_CHORD,
+  TRACE_DOWN,
+  TRACE_UP,
+  TRACE_TEXT
+};
+
+struct TraceEntry {
+  uint16_t ms;
+  byte kind;
+  byte a;
+  byte b;
+};
+
+// 5 bytes each
+const byte TraceSize = 48;
+// room traceLine() needs, terminating 0 included
+const byte TraceLineSize = 16;
+
+void traceInit();
+void traceRecord(byte kind, byte a = 0, byte b = 0);
+byte traceCount();
+// events recorded since traceInit(), kept or not; the ones since an
+// earlier traceSeq() are the last (traceSeq() - earlier) entries
+unsigned long traceSeq();
+// entry 'i', 0 the oldest kept
+const TraceEntry &traceEntry(byte i);
+// one dump line for 'e', returns its length
+byte traceLine(char *buf, const TraceEntry &e);
+// the whole ring through halLog()
+void traceDump();
+
+// for building halLog() lines: 'n' at 'p' in decimal, or as " hh", and
+// where it ended
+char *logDecimal(char *p, unsigned long n);
+char *logHex(char *p, byte n);
+
+#endif
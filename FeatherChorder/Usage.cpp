@@ -0,0 +1,237 @@
+// Usage.cpp
+// see Usage.h
+
+#include "Usage.h"
+#include "Dictionary.h"
+#include "KeyCodes.h"
+#include "Macro.h"
+#include "Trace.h"
+
+#include <string.h>
+
+UsageStats usageStats;
+unsigned long usageFlushMs = 600000ul;  // 10 minutes
+
+static uint16_t seq = 0;          // of the newest slot in EEPROM
+static byte slot = UsageSlots - 1;
+static bool isDirty = false;      // counted since the last flush began
+static unsigned long lastFlushMs = 0;
+
+// a flush in progress: the body, then the 4 header bytes
+static bool isFlushing = false;
+static unsigned int flushAt = 0;
+static byte header[4];
+
+static unsigned int slotStart(byte s){
+  return UsageEepromStart + s * UsageSlotSize;
+}
+
+static uint16_t readWord(unsigned int addr){
+  return halEepromRead(addr) | (uint16_t)halEepromRead(addr + 1) << 8;
+}
+
+// Fletcher-16 of the body as it is in EEPROM; neither byte can be 0xFF,
+// so an erased header never checks out
+static uint16_t checksum(unsigned int body){
+  uint16_t a = 0x5A, b = 0xA5;  // nor does an all 0 slot
+  for (unsigned int i = 0; i < sizeof(UsageStats); i++) {
+    a = (a + halEepromRead(body + i)) % 255;
+    b = (b + a) % 255;
+  }
+  return b << 8 | a;
+}
+
+void usageInit(){
+  memset(&usageStats, 0, sizeof(usageStats));
+  seq = 0;
+  slot = UsageSlots - 1;  // so the first flush goes to slot 0
+  isDirty = false;
+  isFlushing = false;
+  lastFlushMs = halMillis();
+
+  bool isFound = false;
+  for (byte s = 0; s < UsageSlots; s++) {
+    unsigned int start = slotStart(s);
+    if (readWord(start + 2) != checksum(start + 4)) continue;
+    uint16_t n = readWord(start);
+    if (!isFound || (int16_t)(n - seq) > 0) {
+      isFound = true;
+      seq = n;
+      slot = s;
+    }
+  }
+  if (!isFound) return;
+  byte *stats = (byte *)&usageStats;
+  for (unsigned int i = 0; i < sizeof(UsageStats); i++)
+    stats[i] = halEepromRead(slotStart(slot) + 4 + i);
+}
+
+//=====COUNT============================COUNT=======================
+// a chord's 6 bits start at bit 6 * chord of its layer, low bits first,
+// and run into the next byte unless they start in the low 2 bits
+byte usageChordCount(byte layer, byte chord){
+  unsigned int bit = (chord & 0x7F) * 6u;
+  const byte *at = &usageStats.chords[layer][bit >> 3];
+  unsigned int bits = at[0];
+  if ((bit & 7) > 2) bits |= (unsigned int)at[1] << 8;
+  return bits >> (bit & 7) & UsageChordMax;
+}
+
+void usageSetChordCount(byte layer, byte chord, byte n){
+  unsigned int bit = (chord & 0x7F) * 6u;
+  byte *at = &usageStats.chords[layer][bit >> 3];
+  byte shift = bit & 7;
+  unsigned int mask = (unsigned int)UsageChordMax << shift;
+  unsigned int bits = (unsigned int)(n & UsageChordMax) << shift;
+  at[0] = (at[0] & ~mask) | bits;
+  if (shift > 2) at[1] = (at[1] & ~(mask >> 8)) | bits >> 8;
+}
+
+// the whole lot, so a full counter keeps its place among the others
+static void halve(){
+  for (byte l = 0; l < UsageLayers; l++)
+    for (byte c = 0; c < 128; c++) usageSetChordCount(l, c, usageChordCount(l, c) >> 1);
+  for (byte m = 0; m < UsageModeKeys; m++) usageStats.modeKeys[m] >>= 1;
+  usageStats.macros >>= 1;
+  usageStats.words >>= 1;
+  usageStats.function >>= 1;
+  if (usageStats.halvings != 0xFFFF) usageStats.halvings++;
+}
+
+static void bump(uint16_t &n){
+  if (n == 0xFFFF) halve();
+  n++;
+}
+
+void usageCount(byte layer, byte chord, byte theKey){
+  if (layer < UsageLayers) {
+    if (usageChordCount(layer, chord) == UsageChordMax) halve();
+    usageSetChordCount(layer, chord, usageChordCount(layer, chord) + 1);
+  } else if (layer == UsageLayers) {
+    bump(usageStats.function);  // POINTER past it isn't typing
+  }
+  switch (theKey) {
+  case MODE_NUM:       bump(usageStats.modeKeys[USAGE_NUM]); break;
+  case MODE_NUMLCK:    bump(usageStats.modeKeys[USAGE_NUMLCK]); break;
+  case MODE_FUNC:      bump(usageStats.modeKeys[USAGE_FUNC]); break;
+  case MULTI_NumShift: bump(usageStats.modeKeys[USAGE_NUMSHIFT]); break;
+  default:
+    // the fixed modifier combos are MACRO_ too
+    if (theKey >= DIV_Combo && theKey < MacroCodeEnd) bump(usageStats.macros);
+    else if (theKey >= DIV_Word && theKey < DictionaryCodeEnd) bump(usageStats.words);
+    break;
+  }
+  isDirty = true;
+}
+
+//=====FLUSH============================FLUSH=======================
+static void startFlush(){
+  isFlushing = true;
+  flushAt = 0;
+  isDirty = false;
+  lastFlushMs = halMillis();
+}
+
+// the next byte of the flush, and on until one actually had to be
+// written; true while there is more to do
+static bool flushStep(){
+  byte next = (slot + 1) % UsageSlots;
+  unsigned int body = slotStart(next) + 4;
+  const byte *stats = (const byte *)&usageStats;
+  while (flushAt < sizeof(UsageStats) + 4) {
+    unsigned int addr;
+    byte value;
+    if (flushAt < sizeof(UsageStats)) {
+      addr = body + flushAt;
+      value = stats[flushAt];
+    } else {
+      if (flushAt == sizeof(UsageStats)) {
+        uint16_t sum = checksum(body);
+        header[0] = (byte)(seq + 1);
+        header[1] = (byte)((seq + 1) >> 8);
+        header[2] = (byte)sum;
+        header[3] = (byte)(sum >> 8);
+      }
+      // the checksum before the sequence number
+      byte h = (flushAt - sizeof(UsageStats) + 2) % 4;
+      addr = body - 4 + h;
+      value = header[h];
+    }
+    flushAt++;
+    if (halEepromRead(addr) != value) {
+      halEepromWrite(addr, value);
+      return true;
+    }
+  }
+  isFlushing = false;
+  seq++;
+  slot = next;
+  return false;
+}
+
+void usageService(){
+  if (!isFlushing) {
+    if (!isDirty || !usageFlushMs || halMillis() - lastFlushMs < usageFlushMs) return;
+    startFlush();
+  }
+  flushStep();
+}
+
+void usageFlush(){
+  if (!isFlushing) {
+    if (!isDirty) return;
+    startFlush();
+  }
+  while (flushStep()) {}
+}
+
+bool usageFlushing(){
+  return isFlushing;
+}
+
+//=====DUMP=============================DUMP========================
+// text in PROGMEM, PSTR("..."), without its 0
+static char *putText_P(char *p, const char *flashText){
+  size_t n = strlen_P(flashText);
+  memcpy_P(p, flashText, n);
+  return p + n;
+}
+
+void usageDump(){
+  char line[64];
+  char *p = putText_P(line, PSTR("usage halved "));
+  p = logDecimal(p, usageStats.halvings);
+  p = putText_P(p, PSTR(" macros "));
+  p = logDecimal(p, usageStats.macros);
+  p = putText_P(p, PSTR(" words "));
+  p = logDecimal(p, usageStats.words);
+  p = putText_P(p, PSTR(" function "));
+  p = logDecimal(p, usageStats.function);
+  *p = 0;
+  halLog(line);
+
+  p = putText_P(line, PSTR("mode num "));
+  p = logDecimal(p, usageStats.modeKeys[USAGE_NUM]);
+  p = putText_P(p, PSTR(" numlck "));
+  p = logDecimal(p, usageStats.modeKeys[USAGE_NUMLCK]);
+  p = putText_P(p, PSTR(" func "));
+  p = logDecimal(p, usageStats.modeKeys[USAGE_FUNC]);
+  p = putText_P(p, PSTR(" numshift "));
+  p = logDecimal(p, usageStats.modeKeys[USAGE_NUMSHIFT]);
+  *p = 0;
+  halLog(line);
+
+  for (byte l = 0; l < UsageLayers; l++) {
+    for (byte row = 0; row < 128; row += 16) {
+      byte counts[16];
+      bool isUsed = false;
+      for (byte c = 0; c < 16; c++) isUsed |= (counts[c] = usageChordCount(l, row + c)) != 0;
+      if (!isUsed) continue;
+      p = logHex(logDecimal(line, l), row);
+      for (byte c = 0; c < 16; c++) p = logHex(p, counts[c]);
+      *p = 0;
+      halLog(line);
+    }
+  }
+  halLogP(PSTR("end"));
+}
@@ -0,0 +1,80 @@
+// Usage.h
+// Which chords get used, so a layout change can be made from data rather
+// than guesswork.  sendKey() counts every chord of the ALPHA and NUMSYM
+// layers in 6 bits each, four to three bytes so the 256 counts take 192
+// bytes of SRAM, and the mode keys, macros, words and function layer
+// chords in 16 bits.  When a chord's count would go past UsageChordMax
+// every count is halved, so they saturate together and stay comparable.
+//
+// The counts are kept in EEPROM across power cycles, in UsageSlots slots
+// used in turn so each flush wears the other one.  A flush is due once
+// the counts changed and usageFlushMs has gone by; it is written a cell
+// at a time on quiet passes (usageService() from idle()), body first and
+// the sequence and checksum last, so a power cut mid-flush leaves the
+// slot before it to load.
+//
+// USAGE_DUMP (a function layer chord) writes them out with halLog(), for
+// tools/layout_optimizer:
+//   usage halved <n> macros <n> words <n> function <n>
+//   mode num <n> numlck <n> func <n> numshift <n>
+//   <layer> <chord> <16 counts>   a row of 16 chords, only rows in use
+//   end
+// layer is 0 ALPHA, 1 NUMSYM, chord and counts are hex.
+
+#ifndef USAGE_H
+#define USAGE_H
+
+#include "ChorderHal.h"
+
+// the layers counted per chord, ALPHA and NUMSYM in Mode order
+const byte UsageLayers = 2;
+
+enum UsageModeKey {
+  USAGE_NUM,       // MODE_NUM
+  USAGE_NUMLCK,    // MODE_NUMLCK
+  USAGE_FUNC,      // MODE_FUNC
+  USAGE_NUMSHIFT,  // MULTI_NumShift
+  UsageModeKeys
+};
+
+const byte UsageChordMax = 63;
+const byte UsageChordBytes = 128 * 6 / 8;
+
+struct UsageStats {
+  byte chords[UsageLayers][UsageChordBytes];  // see usageChordCount()
+  uint16_t modeKeys[UsageModeKeys];
+  uint16_t macros;
+  uint16_t words;
+  uint16_t function;  // chords in the FUNCTION layer
+  uint16_t halvings;  // times everything was halved
+};
+extern UsageStats usageStats;
+
+// the EEPROM the slots take from UsageEepromStart, each a sequence
+// number and checksum ahead of the UsageStats; a slot keeps the size it
+// had with a byte per chord, so the overlay after them stays put
+const unsigned int UsageEepromStart = 0;
+const byte UsageSlots = 2;
+const unsigned int UsageSlotSize = 276;
+static_assert(4 + sizeof(UsageStats) <= UsageSlotSize, "the counts fit their slot");
+const unsigned int UsageEepromEnd = UsageEepromStart + UsageSlots * UsageSlotSize;
+
+// time between flushes of changed counts, 0 only flushes on usageFlush()
+extern unsigned long usageFlushMs;
+
+// the newest good slot from EEPROM, all 0 if there is none
+void usageInit();
+// a chord looked up in 'layer', and the key code it gave
+void usageCount(byte layer, byte chord, byte theKey);
+// the count of 'chord' in 'layer' (ALPHA or NUMSYM), 0 - UsageChordMax
+byte usageChordCount(byte layer, byte chord);
+void usageSetChordCount(byte layer, byte chord, byte n);
+// some of a due flush, called on quiet passes
+void usageService();
+// all of it now, before the power goes
+void usageFlush();
+bool usageFlushing();
+// the counts through halLog()
+void usageDump();
+
+#endif
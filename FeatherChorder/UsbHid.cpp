@@ -0,0 +1,87 @@
+// UsbHid.cpp
+// see UsbHid.h
+
+#include "UsbHid.h"
+
+#ifdef USBCON
+
+#include "HidReport.h"
+#include "Latency.h"
+
+#include <HID.h>
+
+const uint8_t KeyboardReportId = 2;  // the ids the Arduino Keyboard library uses
+const uint8_t ConsumerReportId = 3;
+
+static const uint8_t usbHidDescriptor[] PROGMEM = {
+  // keyboard: modifiers, reserved, 6 keys up to 0xFF so the RAW_ codes go too
+  0x05, 0x01, 0x09, 0x06, 0xA1, 0x01, 0x85, KeyboardReportId,
+  0x05, 0x07, 0x19, 0xE0, 0x29, 0xE7, 0x15, 0x00, 0x25, 0x01,
+  0x75, 0x01, 0x95, 0x08, 0x81, 0x02,
+  0x95, 0x01, 0x75, 0x08, 0x81, 0x03,
+  0x95, 0x06, 0x75, 0x08, 0x15, 0x00, 0x26, 0xFF, 0x00,
+  0x05, 0x07, 0x19, 0x00, 0x29, 0xFF, 0x81, 0x00,
+  0xC0,
+  // consumer control: one 16 bit usage
+  0x05, 0x0C, 0x09, 0x01, 0xA1, 0x01, 0x85, ConsumerReportId,
+  0x15, 0x00, 0x26, 0xFF, 0x03, 0x19, 0x00, 0x2A, 0xFF, 0x03,
+  0x75, 0x10, 0x95, 0x01, 0x81, 0x00,
+  0xC0,
+};
+
+// the descriptor has to be in place before the computer enumerates the
+// board, so it is added while static objects are built, as Keyboard does
+static struct UsbHidSetup {
+  UsbHidSetup(){
+    static HIDSubDescriptor node(usbHidDescriptor, sizeof(usbHidDescriptor));
+    HID().AppendDescriptor(&node);
+  }
+} usbHidSetup;
+
+// the core sets configured on enumeration and never clears it when the
+// cable goes, so VBUS and the suspend state are read too
+bool usbHidAttached(){
+  return cableLinkUp(USBDevice.configured(), USBSTA & _BV(VBUS), USBDevice.isSuspended());
+}
+
+//=====BACKEND==========================BACKEND=====================
+static void usbKeyDown(byte modKey, byte rawKey){
+  uint8_t report[HidKeyReportSize];
+  hidKeyReport(report, modKey, rawKey);
+  unsigned long start = halMicros();
+  HID().SendReport(KeyboardReportId, report, sizeof(report));
+  latencyRecord(LAT_WRITE, halMicros() - start);
+}
+
+static void usbKeyUp(){
+  uint8_t report[HidKeyReportSize];
+  hidKeyReport(report, 0, 0);
+  HID().SendReport(KeyboardReportId, report, sizeof(report));
+}
+
+// pressed and let go at once; a hold time (",500") is not waited out,
+// each press is one step of the volume
+static void usbControl(const char *cntrlName){
+  unsigned int holdMs;
+  uint16_t usage = hidConsumerUsage(cntrlName, &holdMs);
+  if (!usage) return;
+  HID().SendReport(ConsumerReportId, &usage, sizeof(usage));
+  usage = 0;
+  HID().SendReport(ConsumerReportId, &usage, sizeof(usage));
+}
+
+// no text (typed a key at a time) and no mouse
+const OutputBackend usbBackend = {
+  "usb", usbKeyDown, usbKeyUp, usbControl, 0, 0, 0, 0
+};
+
+#else
+
+bool usbHidAttached(){
+  return false;
+}
+
+// not a board with its own USB: the Bluefruit
+const OutputBackend usbBackend = bleBackend;
+
+#endif
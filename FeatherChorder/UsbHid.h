@@ -0,0 +1,18 @@
+// UsbHid.h
+// The 32u4's own USB as a keyboard: usbBackend sends the 8 byte HID
+// reports of HidReport.h straight to the computer at the other end of
+// the cable, no AT formatting, SPI or BLE connection interval on the way.
+// Board only, the host build uses host/MockBackend.h.
+
+#ifndef USB_HID_H
+#define USB_HID_H
+
+#include "OutputBackend.h"
+
+// a computer has enumerated us and is still there and awake, not just a
+// charger on the cable, see cableLinkUp()
+bool usbHidAttached();
+
+extern const OutputBackend usbBackend;
+
+#endif
@@ -0,0 +1,33 @@
+// WordTable.h
+// The words and phrases typed by the WORD_ codes, split out like
+// MacroTable.h so they can be changed without touching code.
+//
+// Kept sorted and front coded to save flash: each entry is one byte of
+// how many leading characters it shares with the entry before, plus 1,
+// then the rest of its text.  That byte also ends the entry before, so a
+// word costs its unshared characters and one byte.  Entries are in the
+// order of the WORD_ codes in KeyCodes.h; to add one, put it in its
+// sorted place in both and fix up the shared count of the entry after
+// it.  Lower case letters, ' and spaces only, at most
+// DictionaryWordSize - 1 characters.
+
+const char dictionary_words[] PROGMEM =
+  "\001" "about"   // about
+  "\002" "nd"      // and
+  "\001" "for"     // for
+  "\002" "rom"     // from
+  "\001" "have"    // have
+  "\001" "that"    // that
+  "\003" "e"       // the
+  "\004" "ir"      // their
+  "\004" "re"      // there
+  "\003" "is"      // this
+  "\001" "which"   // which
+  "\002" "ith"     // with
+  "\002" "ould"    // would
+  "\001" "you";    // you
+
+static_assert(DIV_Word == MacroCodeEnd, "words start where the macros end");
+static_assert(DIV_WordLast <= DictionaryCodeEnd, "more WORD_ codes than there is room for");
+
+// end WordTable.h
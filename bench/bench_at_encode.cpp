@@ -0,0 +1,114 @@
+// bench_at_encode.cpp
+// Microbenchmark of the keystroke AT command formatting: the String
+// version sendRawKeyDn() used to have (LegacyAtCommand.h) against the
+// fixed-buffer encoder in AtCommand.cpp.  Reports time per keystroke
+// (TSC cycles where available), transport calls, heap allocations and
+// heap high-water mark as the AVR would count them.
+//
+//   bench_at_encode [--keys N]
+
+#include "AtCommand.h"
+#include "LegacyAtCommand.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+
+// stands in for ble.print()/println(), just enough work not to be optimized out
+static volatile unsigned long sinkBytes = 0;
+static unsigned long sinkCalls = 0;
+static void sink(const char *text){
+  sinkBytes += strlen(text);
+  sinkCalls++;
+}
+
+struct Result {
+  double cyclesPerKey;
+  double nanosPerKey;
+  double callsPerKey;
+  double allocationsPerKey;
+  unsigned long heapPeak;
+};
+
+static unsigned long long cycles(){
+#ifdef HAVE_TSC
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+template <typename Encode>
+static Result run(unsigned long keys, Encode encode){
+  sinkCalls = 0;
+  unsigned long allocations = stringHeap.allocations;
+  stringHeap.peak = stringHeap.inUse;
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+  unsigned long long c0 = cycles();
+  for (unsigned long i = 0; i < keys; i++) {
+    encode((byte)(i >> 8), (byte)i);
+  }
+  unsigned long long c1 = cycles();
+  std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+  Result r;
+  r.cyclesPerKey = (double)(c1 - c0) / keys;
+  r.nanosPerKey = std::chrono::duration<double, std::nano>(t1 - t0).count() / keys;
+  r.callsPerKey = (double)sinkCalls / keys;
+  r.allocationsPerKey = (double)(stringHeap.allocations - allocations) / keys;
+  r.heapPeak = stringHeap.peak;
+  return r;
+}
+
+static void legacyEncode(byte modKey, byte rawKey){
+  sink(LegacyKeyboardCodePrefix);
+  sink(legacyKeyboardCodeTail(modKey, rawKey).c_str());
+}
+
+static void fixedEncode(byte modKey, byte rawKey){
+  char command[AtKeyboardCodeLen + 1];
+  atKeyboardCode(command, modKey, rawKey);
+  sink(command);
+}
+
+static void print(const char *name, const Result &r, unsigned long stackBytes){
+  printf("  %-8s %9.1f cycles %8.1f ns %6.2f calls %6.2f allocs  heap peak %4lu B  stack buf %3lu B\n",
+         name, r.cyclesPerKey, r.nanosPerKey, r.callsPerKey, r.allocationsPerKey,
+         r.heapPeak, stackBytes);
+}
+
+int main(int argc, char **argv){
+  unsigned long keys = 1000000;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--keys") && i + 1 < argc) keys = strtoul(argv[++i], 0, 10);
+    else {
+      fprintf(stderr, "usage: %s [--keys N]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  // warm both up once so neither pays for first-touch page faults
+  run(1000, legacyEncode);
+  run(1000, fixedEncode);
+
+  Result legacy = run(keys, legacyEncode);
+  Result fixed = run(keys, fixedEncode);
+
+  printf("bench_at_encode: %lu keystrokes%s\n", keys,
+#ifdef HAVE_TSC
+         ""
+#else
+         " (no TSC, cycles read 0)"
+#endif
+         );
+  print("String", legacy, 0);
+  print("encoder", fixed, AtKeyboardCodeLen + 1);
+  printf("  speedup %.1fx\n", legacy.nanosPerKey / fixed.nanosPerKey);
+
+  return fixed.allocationsPerKey == 0 && fixed.callsPerKey == 1 ? 0 : 1;
+}
@@ -0,0 +1,77 @@
+// bench_dictionary.cpp
+// Characters per second a dictionary word delivers as one AT+BleKeyboard
+// string against the same word typed a key at a time the way the bigram
+// macros do it (tap, InterstitialDelay, tap ...).  Time is the simulated
+// time the output queue takes to drain, plus a per command cost for the
+// SPI transaction and BLE link that the host HAL doesn't have; measure
+// it on the board and pass it in.
+//
+//   bench_dictionary [--command-ms N]
+
+#include "ChordDriver.h"
+#include "Chorder.h"
+#include "Dictionary.h"
+#include "KeyCodes.h"
+#include "OutputQueue.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct Totals {
+  unsigned long chars;
+  unsigned long micros;
+  unsigned long commands;
+  unsigned long bytes;
+};
+
+static void drain(Totals &t){
+  unsigned long start = hostMicros();
+  outputFlush();
+  t.micros += hostMicros() - start;
+  t.commands += hostCommandCount();
+  t.bytes += hostTrafficBytes();
+}
+
+static void report(const char *name, const Totals &t, double commandMs){
+  double ms = t.micros / 1000.0 + t.commands * commandMs;
+  printf("  %-14s %4lu chars %9.1f ms %5lu commands %6lu bytes %8.1f chars/s\n",
+         name, t.chars, ms, t.commands, t.bytes, t.chars * 1000.0 / ms);
+}
+
+int main(int argc, char **argv){
+  double commandMs = 8;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--command-ms") && i + 1 < argc) commandMs = atof(argv[++i]);
+    else {
+      fprintf(stderr, "usage: %s [--command-ms N]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  Totals words = { 0, 0, 0, 0 }, keys = { 0, 0, 0, 0 };
+  char word[DictionaryWordSize];
+  for (byte i = 0; i < dictionaryWordCount; i++) {
+    byte len = dictionaryWord(i, word);
+
+    driverReset();
+    typeWord(i, 0x00, 0x00);
+    drain(words);
+    words.chars += len;
+
+    driverReset();
+    for (byte k = 0; k < len; k++) {
+      if (k) queueGap();
+      queueKeyDown(0x00, ENUMKEY_A + (word[k] - 'a'));
+      queueKeyUp();
+    }
+    drain(keys);
+    keys.chars += len;
+  }
+
+  printf("bench_dictionary: %u words, %.1f ms per AT command\n",
+         (unsigned)dictionaryWordCount, commandMs);
+  report("key at a time", keys, commandMs);
+  report("dictionary", words, commandMs);
+  return words.micros <= keys.micros ? 0 : 1;
+}
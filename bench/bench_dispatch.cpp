@@ -0,0 +1,117 @@
+// bench_dispatch.cpp
+// Cost of dispatchKey(), the part of sendKey() after the keymap lookup,
+// for every key code, grouped by the KeyCodes.h ranges.  Each code is
+// dispatched many times onto an empty output queue and the median TSC
+// cycles kept; the report has the mean and the worst code per range.
+// Host cycles, not AVR ones, but the shape (a range check and a table
+// read against a walk through a switch) carries over.
+//
+// Codes that talk to the module or the serial port themselves (resets,
+// BAT_LVL, TRACE_DUMP, LATENCY_REPORT) are left out, they aren't typing.
+//
+//   bench_dispatch [--runs N]
+
+#include "ChordDriver.h"
+#include "Chorder.h"
+#include "Dictionary.h"
+#include "KeyCodes.h"
+#include "Macro.h"
+#include "OutputQueue.h"
+
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+
+static unsigned long long cycles(){
+#ifdef HAVE_TSC
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+struct Range {
+  const char *name;
+  int first, last;  // codes, inclusive
+  double total;
+  int count;
+  unsigned long long worst;
+  int worstCode;
+};
+
+static bool isCommand(int code){
+  return code == MODE_RESET || code == MODE_MRESET || code == MODE_FRESET ||
+         code == BAT_LVL || code == TRACE_DUMP || code == LATENCY_REPORT;
+}
+
+int main(int argc, char **argv){
+  int runs = 2001;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--runs") && i + 1 < argc) runs = atoi(argv[++i]) | 1;
+    else {
+      fprintf(stderr, "usage: %s [--runs N]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  Range ranges[] = {
+    { "keys",      ENUMKEY_errorRollOver, DIV_Mods - 1, 0, 0, 0, 0 },
+    { "modifiers", MOD_LCTRL, MOD_RGUI,                 0, 0, 0, 0 },
+    { "modes",     MODE_RESET, MULTI_CtlAlt,            0, 0, 0, 0 },
+    { "media",     MEDIA_playpause, MEDIA_voldn,        0, 0, 0, 0 },
+    { "latch",     LATCH, LATCH,                        0, 0, 0, 0 },
+    { "combos",    MACRO_dollar, ANDROID_dpadcenter,    0, 0, 0, 0 },
+    { "macros",    MACRO_000, DIV_Last - 1,             0, 0, 0, 0 },
+    { "words",     DIV_Word, DIV_WordLast - 1,          0, 0, 0, 0 },
+    { "raw",       DictionaryCodeEnd, 0xFF,             0, 0, 0, 0 },
+  };
+  const int rangeCount = sizeof(ranges) / sizeof(ranges[0]);
+
+  driverReset();
+  std::vector<unsigned long long> samples(runs);
+  unsigned long long worst = 0;
+  int worstCode = 0;
+  for (int r = 0; r < rangeCount; r++) {
+    Range &range = ranges[r];
+    for (int code = range.first; code <= range.last; code++) {
+      if (isCommand(code)) continue;
+      if (code >= MACRO_dollar && code <= ANDROID_dpadcenter && range.first != MACRO_dollar) continue;
+      for (int i = 0; i < runs; i++) {
+        outputClear();
+        unsigned long long c0 = cycles();
+        dispatchKey(code);
+        samples[i] = cycles() - c0;
+      }
+      std::nth_element(samples.begin(), samples.begin() + runs / 2, samples.end());
+      unsigned long long median = samples[runs / 2];
+      range.total += median;
+      range.count++;
+      if (median > range.worst) range.worst = median, range.worstCode = code;
+      if (median > worst) worst = median, worstCode = code;
+    }
+  }
+  outputClear();
+
+  printf("bench_dispatch: median of %d dispatches per code%s\n", runs,
+#ifdef HAVE_TSC
+         ""
+#else
+         " (no TSC, cycles read 0)"
+#endif
+         );
+  for (int r = 0; r < rangeCount; r++) {
+    const Range &range = ranges[r];
+    if (!range.count) continue;
+    printf("  %-10s %3d codes  mean %6.1f cycles  worst %5llu (0x%02X)\n", range.name, range.count,
+           range.total / range.count, range.worst, range.worstCode);
+  }
+  printf("  worst code 0x%02X, %llu cycles\n", worstCode, worst);
+  return 0;
+}
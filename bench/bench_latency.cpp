@@ -0,0 +1,163 @@
+// bench_latency.cpp
+// Scan-to-keystroke benchmark for the chorder core on the host.
+//
+// Types a synthetic text through the default keymap with human-like finger
+// timing (staggered landing and lifting, contact bounce) and reports, per
+// chord:
+//   - CPU time of the loop() pass that emitted the chord, and of idle passes
+//   - simulated latency from the first finger lifting and from the last
+//     finger landing to the first AT command
+//   - AT commands and bytes put on the wire
+//   - the per stage histograms of Latency.h, as the board reports them
+// and fails if the text that came out is not the text that went in.
+//
+//   bench_latency [--chords N] [--seed S]
+
+#include "ChordDriver.h"
+#include "Chorder.h"
+#include "Latency.h"
+#include "TypingSession.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+static const char *sampleText =
+  "the quick brown fox jumps over the lazy dog while seven brave wizards "
+  "hex a jolly quartz sphinx and in the end there is another kind of "
+  "rhythm to chording than to typing on a row of keys ";
+
+struct Sample {
+  double emitNanos;        // CPU time of the pass that emitted
+  double releaseLatencyMs; // first finger up -> first command
+  double pressLatencyMs;   // last finger down -> first command
+  unsigned long commands;
+  unsigned long bytes;
+};
+
+static double idleNanos = 0;
+static unsigned long idlePasses = 0;
+
+// one loop() pass, timed; returns true if it put something on the wire
+static bool timedPass(double *nanos){
+  unsigned long before = hostCommandCount();
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+  chorderLoop();
+  std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+  *nanos = std::chrono::duration<double, std::nano>(t1 - t0).count();
+  hostAdvanceMicros(scanTickMicros);
+  return hostCommandCount() != before;
+}
+
+static double percentile(std::vector<double> v, double p){
+  if (v.empty()) return 0;
+  std::sort(v.begin(), v.end());
+  size_t i = (size_t)(p * (v.size() - 1) + 0.5);
+  return v[i];
+}
+
+static void report(const char *name, const std::vector<double> &v, const char *unit){
+  printf("  %-28s p50 %9.2f  p90 %9.2f  p99 %9.2f  max %9.2f %s\n", name,
+         percentile(v, 0.50), percentile(v, 0.90), percentile(v, 0.99),
+         percentile(v, 1.0), unit);
+}
+
+int main(int argc, char **argv){
+  unsigned long chords = 2000;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--chords") && i + 1 < argc) chords = strtoul(argv[++i], 0, 10);
+    else if (!strcmp(argv[i], "--seed") && i + 1 < argc) sessionSeed(strtoul(argv[++i], 0, 10));
+    else {
+      fprintf(stderr, "usage: %s [--chords N] [--seed S]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  driverReset();
+  scanTickMicros = 50;
+
+  std::vector<Sample> samples;
+  std::string intended;
+  std::string allTraffic;
+  size_t textLen = strlen(sampleText);
+
+  for (unsigned long n = 0; n < chords; n++) {
+    char c = sampleText[n % textLen];
+    byte chord = chordFor(c);
+    intended += c;
+
+    unsigned long lastDown, firstUp;
+    std::vector<FingerEvent> events = fingerEvents(chord, hostMicros(), steadyTypist,
+                                                   &lastDown, &firstUp);
+    unsigned long end = events.back().atMicros + steadyTypist.gapMin
+                        + sessionRandom(steadyTypist.gapSpread);
+
+    Sample s = { 0, -1, -1, 0, 0 };
+    hostClearTraffic();
+    byte switches = 0;
+    size_t next = 0;
+    while (hostMicros() < end) {
+      while (next < events.size() && events[next].atMicros <= hostMicros()) {
+        if (events[next].down) switches |= 1 << events[next].bit;
+        else switches &= ~(1 << events[next].bit);
+        next++;
+      }
+      hostSetSwitches(switches);
+      unsigned long passStart = hostMicros();
+      double nanos;
+      if (timedPass(&nanos)) {
+        if (s.releaseLatencyMs < 0) {
+          s.emitNanos = nanos;
+          s.releaseLatencyMs = (passStart - (double)firstUp) / 1000.0;
+          s.pressLatencyMs = (passStart - (double)lastDown) / 1000.0;
+        }
+      } else {
+        idleNanos += nanos;
+        idlePasses++;
+      }
+    }
+    s.commands = hostCommandCount();
+    s.bytes = hostTrafficBytes();
+    allTraffic += hostTraffic();
+    samples.push_back(s);
+  }
+
+  std::vector<double> emit, rel, press, cmds, bytes;
+  for (size_t i = 0; i < samples.size(); i++) {
+    if (samples[i].releaseLatencyMs < 0) continue;
+    emit.push_back(samples[i].emitNanos);
+    rel.push_back(samples[i].releaseLatencyMs);
+    press.push_back(samples[i].pressLatencyMs);
+    cmds.push_back(samples[i].commands);
+    bytes.push_back(samples[i].bytes);
+  }
+
+  std::string typed = decodeTyped(allTraffic);
+  printf("bench_latency: %lu chords, %zu emitted, scan tick %lu us\n",
+         chords, emit.size(), scanTickMicros);
+  report("emitting pass CPU", emit, "ns");
+  printf("  %-28s mean %9.2f ns over %lu passes\n", "idle pass CPU",
+         idlePasses ? idleNanos / idlePasses : 0.0, idlePasses);
+  printf("  %-28s %lu of %lu passes stopped after the read, %lu switch changes\n",
+         "quiet passes", scanStats.idleScans, scanStats.scans, scanStats.changes);
+  report("first lift -> first AT", rel, "ms");
+  report("last landing -> first AT", press, "ms");
+  report("AT commands per chord", cmds, "");
+  report("AT bytes per chord", bytes, "");
+  latencyReport();
+  const std::string &log = hostLog();
+  for (size_t at = 0, end; (end = log.find('\n', at)) != std::string::npos; at = end + 1)
+    printf("  %s\n", log.substr(at, end - at).c_str());
+
+  if (typed != intended) {
+    printf("FAIL: typed text differs from intended text\n  intended: %.60s\n  typed:    %.60s\n",
+           intended.c_str(), typed.c_str());
+    return 1;
+  }
+  printf("typed text matches\n");
+  return 0;
+}
@@ -0,0 +1,125 @@
+// bench_pacing.cpp
+// Every macro sent at the fixed InterstitialDelay pace against paced by
+// the module's answers (AckPacing.h): on a good link, on one where the
+// first answer of each macro is ERROR, and on a slow one whose answers
+// come after ackTimeoutMs.  The keys have to come out the same, resends
+// aside.  Time is simulated, the time the output queue takes to drain;
+// the fixed pace only waits at M_GAP, so the macros with gaps are also
+// totalled on their own.
+//
+//   bench_pacing [--ack-ms N] [--slow-ack-ms N]
+
+#include "AckPacing.h"
+#include "ChordDriver.h"
+#include "Chorder.h"
+#include "KeyCodes.h"
+#include "Macro.h"
+#include "OutputQueue.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct Totals {
+  unsigned long micros;
+  unsigned long commands;
+  AckStats acks;
+};
+
+// the traffic with a resent report (the same line twice running) once
+static std::string withoutResends(const std::string &traffic){
+  std::string out, last;
+  size_t at = 0, end;
+  while ((end = traffic.find('\n', at)) != std::string::npos) {
+    std::string line = traffic.substr(at, end + 1 - at);
+    if (line != last) out += line;
+    last = line;
+    at = end + 1;
+  }
+  return out;
+}
+
+static void add(Totals &to, const Totals &t){
+  to.micros += t.micros;
+  to.commands += t.commands;
+  to.acks.acks += t.acks.acks;
+  to.acks.errors += t.acks.errors;
+  to.acks.retries += t.acks.retries;
+  to.acks.timeouts += t.acks.timeouts;
+  to.acks.late += t.acks.late;
+  to.acks.ackMicros += t.acks.ackMicros;
+}
+
+static std::string runOne(byte index, bool paced, unsigned long ackMicros, bool fail, Totals &t){
+  driverReset();
+  ackPacing = paced;
+  hostSetAckDelay(ackMicros);
+  if (fail) hostFailNext(1);
+  runMacro(index, 0x00, 0x00);
+  unsigned long start = hostMicros();
+  outputFlush();
+  unsigned long took = hostMicros() - start;
+  if (ackMicros != HostNoAck) hostAdvanceMicros(ackMicros);  // the last answer, for the counters
+  ackService();
+  Totals one = { took, hostCommandCount(), ackStats };
+  add(t, one);
+  return withoutResends(hostTraffic());
+}
+
+static void report(const char *name, const Totals &t){
+  unsigned long timed = t.acks.acks + t.acks.errors - t.acks.late;
+  printf("  %-12s %8.1f ms %4lu commands  ack %5.1f ms  %3lu errors %3lu retries"
+         " %3lu timeouts %3lu late\n",
+         name, t.micros / 1000.0, t.commands,
+         timed ? t.acks.ackMicros / 1000.0 / timed : 0.0,
+         t.acks.errors, t.acks.retries, t.acks.timeouts, t.acks.late);
+}
+
+int main(int argc, char **argv){
+  double ackMs = 7.5, slowAckMs = 80;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--ack-ms") && i + 1 < argc) ackMs = atof(argv[++i]);
+    else if (!strcmp(argv[i], "--slow-ack-ms") && i + 1 < argc) slowAckMs = atof(argv[++i]);
+    else {
+      fprintf(stderr, "usage: %s [--ack-ms N] [--slow-ack-ms N]\n", argv[0]);
+      return 2;
+    }
+  }
+  unsigned long ackMicros = (unsigned long)(ackMs * 1000);
+  unsigned long slowMicros = (unsigned long)(slowAckMs * 1000);
+
+  Totals fixed = Totals(), good = Totals(), errors = Totals(), slow = Totals();
+  Totals fixedGaps = Totals(), goodGaps = Totals();
+  int wrong = 0;
+  for (byte i = 0; i < macroCount; i++) {
+    Totals f = Totals(), g = Totals();
+    std::string expected = runOne(i, false, HostNoAck, false, f);
+    if (runOne(i, true, ackMicros, false, g) != expected ||
+        runOne(i, true, ackMicros, true, errors) != expected ||
+        runOne(i, true, slowMicros, false, slow) != expected) {
+      printf("  macro %u differs\n", (unsigned)i);
+      wrong++;
+    }
+    add(fixed, f);
+    add(good, g);
+    if (f.micros) {
+      add(fixedGaps, f);
+      add(goodGaps, g);
+    }
+  }
+  ackPacing = false;
+
+  printf("bench_pacing: %u macros, answers after %.1f ms (slow link %.1f ms),"
+         " timeout %u ms\n",
+         (unsigned)macroCount, ackMs, slowAckMs, ackTimeoutMs);
+  report("fixed", fixed);
+  report("paced", good);
+  report("errors", errors);
+  report("slow link", slow);
+  report("fixed, gaps", fixedGaps);
+  report("paced, gaps", goodGaps);
+  if (goodGaps.micros)
+    printf("  macros with gaps go out %.1fx faster paced\n",
+           (double)fixedGaps.micros / goodGaps.micros);
+  return wrong || goodGaps.micros >= fixedGaps.micros ? 1 : 0;
+}
@@ -0,0 +1,196 @@
+// bench_soak.cpp
+// End to end soak of the chorder core against the emulated Bluefruit
+// (BluefruitEmulator.h), on a link as bad as asked for.
+//
+// The module is set up the way the board's setup() does it, on a clean
+// link; then the faults go on and synthetic text is typed through the
+// default keymap with human-like finger timing (TypingSession.h) for the
+// given simulated time, in chunks that each end with the output queue
+// drained.  It reports:
+//   - throughput, in chords and AT commands per simulated second, and
+//     how much faster than real time the run went
+//   - latency from the first finger lifting and from the last finger
+//     landing to the key reaching the module, as percentiles
+//   - what the module and the ack pacing (AckPacing.h) made of the faults
+// and fails when the text the module typed is not the text intended,
+// showing the first place it differs.
+//
+//   bench_soak [--minutes N] [--seed S] [--typist steady|fast|rolling] [--no-pacing]
+//              [--latency-ms N] [--jitter-ms N] [--drop N] [--garble N]
+//              [--reorder N] [--refuse N]
+// the fault rates are per 1000 answers (commands for --refuse).
+
+#include "AckPacing.h"
+#include "BluefruitEmulator.h"
+#include "ChordDriver.h"
+#include "Chorder.h"
+#include "OutputQueue.h"
+#include "TypingSession.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+static const char *sampleText =
+  "the quick brown fox jumps over the lazy dog while seven brave wizards "
+  "hex a jolly quartz sphinx and in the end there is another kind of "
+  "rhythm to chording than to typing on a row of keys ";
+
+static const char *DeviceName = "FeatherChorder";
+const unsigned long ChunkChords = 200;
+
+static double percentile(std::vector<double> v, double p){
+  if (v.empty()) return 0;
+  std::sort(v.begin(), v.end());
+  size_t i = (size_t)(p * (v.size() - 1) + 0.5);
+  return v[i];
+}
+
+static void report(const char *name, const std::vector<double> &v, const char *unit){
+  printf("  %-28s p50 %9.2f  p90 %9.2f  p99 %9.2f  max %9.2f %s\n", name,
+         percentile(v, 0.50), percentile(v, 0.90), percentile(v, 0.99),
+         percentile(v, 1.0), unit);
+}
+
+//=====SETUP============================SETUP=======================
+// the module's answer lines to 'command', up to its OK or ERROR
+static bool command(const char *text, std::string *reply = 0){
+  halPrintln(text);
+  unsigned long start = hostMicros();
+  char line[32];
+  while (hostMicros() - start < 2 * BluefruitResetMicros) {
+    while (halReadLine(line, sizeof(line))) {
+      if (!strcmp(line, "OK")) return true;
+      if (!strcmp(line, "ERROR")) return false;
+      if (reply) *reply = line;
+    }
+    hostAdvanceMicros(1000);
+  }
+  return false;
+}
+
+// as setup() in FeatherChorder.ino: name, HID and Battery Service set
+// when they differ, then a reset
+static bool setUpModule(){
+  std::string name, hid, battery;
+  bool isAnswered = command("AT+GAPDEVNAME", &name) && command("AT+BleHIDEn", &hid) &&
+                    command("AT+BLEBATTEN", &battery);
+  if (!isAnswered) return false;
+  std::string setName = std::string("AT+GAPDEVNAME=") + DeviceName;
+  if (name != DeviceName && !command(setName.c_str())) return false;
+  if (hid != "1" && !command("AT+BleHIDEn=On")) return false;
+  if (battery != "1" && !command("AT+BLEBATTEN=1")) return false;
+  return command("ATZ");
+}
+
+//=====SOAK=============================SOAK========================
+int main(int argc, char **argv){
+  double minutes = 60;
+  unsigned long seed = 1;
+  bool pacing = true;
+  const Typist *typist = &steadyTypist;
+  const char *typistName = "steady";
+  double latencyMs = 7.5, jitterMs = 5;
+  BluefruitFaults faults = { 0, 0, 5, 5, 5, 0 };
+  for (int i = 1; i < argc; i++) {
+    bool more = i + 1 < argc;
+    if (!strcmp(argv[i], "--minutes") && more) minutes = atof(argv[++i]);
+    else if (!strcmp(argv[i], "--seed") && more) seed = strtoul(argv[++i], 0, 10);
+    else if (!strcmp(argv[i], "--no-pacing")) pacing = false;
+    else if (!strcmp(argv[i], "--latency-ms") && more) latencyMs = atof(argv[++i]);
+    else if (!strcmp(argv[i], "--jitter-ms") && more) jitterMs = atof(argv[++i]);
+    else if (!strcmp(argv[i], "--drop") && more) faults.dropPerMille = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--garble") && more) faults.garblePerMille = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--reorder") && more) faults.reorderPerMille = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--refuse") && more) faults.refusePerMille = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--typist") && more) {
+      typistName = argv[++i];
+      if (!strcmp(typistName, "steady")) typist = &steadyTypist;
+      else if (!strcmp(typistName, "fast")) typist = &fastTypist;
+      else if (!strcmp(typistName, "rolling")) typist = &rollingTypist;
+      else typistName = 0;
+    } else typistName = 0;
+    if (!typistName) {
+      fprintf(stderr, "usage: %s [--minutes N] [--seed S] [--typist steady|fast|rolling] [--no-pacing]\n"
+                      "       [--latency-ms N] [--jitter-ms N] [--drop N] [--garble N] [--reorder N] [--refuse N]\n",
+              argv[0]);
+      return 2;
+    }
+  }
+  faults.latencyMicros = latencyMs * 1000;
+  faults.jitterMicros = jitterMs * 1000;
+
+  hostReset();
+  bluefruitAttach(bluefruitCleanLink, seed);
+  if (!setUpModule() || bluefruitName() != DeviceName || !bluefruitHidOn()) {
+    printf("FAIL: the module didn't take its setup\n");
+    return 1;
+  }
+  hostAdvanceMicros(BluefruitResetMicros);
+  ackPacing = pacing;
+  chorderInit();
+  rolloverChords = typist == &rollingTypist;  // its chords overlap
+  scanTickMicros = 100;
+  sessionSeed(seed);
+  bluefruitSetFaults(faults);
+  bluefruitClearTyped();
+
+  std::chrono::steady_clock::time_point wallStart = std::chrono::steady_clock::now();
+  unsigned long start = hostMicros();
+  unsigned long soakMicros = minutes * 60e6;
+  std::string text(sampleText), intended;
+  std::vector<double> lift, landing;
+  unsigned long chords = 0, commands = 0;
+  while (hostMicros() - start < soakMicros) {
+    size_t at = chords % text.size();
+    std::string rotated = text.substr(at) + text.substr(0, at);
+    unsigned long before = bluefruitStats.commands;
+    SessionResult result = playSession(rotated.c_str(), ChunkChords, *typist);
+    // what is still queued goes out before the next chunk starts
+    while (outputQueueDepth() || ackWaiting()) driveFor(1000);
+    commands += bluefruitStats.commands - before;
+    intended += result.intended;
+    chords += ChunkChords;
+    if (result.errors) continue;  // times only line up where the text does
+    lift.insert(lift.end(), result.liftToKey.begin(), result.liftToKey.end());
+    landing.insert(landing.end(), result.landingToKey.begin(), result.landingToKey.end());
+  }
+  double seconds = (hostMicros() - start) / 1e6;
+  double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+
+  const std::string &typed = bluefruitTyped();
+  printf("bench_soak: %.1f min typed by the %s typist, %lu chords, ack pacing %s%s\n",
+         seconds / 60, typistName, chords, pacing ? "on" : "off",
+         rolloverChords ? ", rollover" : "");
+  printf("  %-28s %.1f ms + 0-%.1f ms, per 1000: %u dropped %u garbled %u reordered %u refused\n",
+         "link", latencyMs, jitterMs, faults.dropPerMille, faults.garblePerMille,
+         faults.reorderPerMille, faults.refusePerMille);
+  printf("  %-28s %.2f chords/s, %.2f AT commands/s, %.0fx real time\n", "throughput",
+         chords / seconds, commands / seconds, wall > 0 ? seconds / wall : 0.0);
+  report("first lift -> typed", lift, "ms");
+  report("last landing -> typed", landing, "ms");
+  printf("  %-28s %lu commands, %lu answers: %lu dropped %lu garbled %lu reordered,"
+         " %lu refused %lu errors\n", "module", bluefruitStats.commands, bluefruitStats.answers,
+         bluefruitStats.dropped, bluefruitStats.garbled, bluefruitStats.reordered,
+         bluefruitStats.refused, bluefruitStats.errors);
+  printf("  %-28s %lu acks %lu errors %lu retries %lu timeouts %lu late %lu lost\n",
+         "ack pacing", ackStats.acks, ackStats.errors, ackStats.retries, ackStats.timeouts,
+         ackStats.late, ackStats.lost);
+
+  if (typed != intended) {
+    size_t at = 0;
+    while (at < typed.size() && at < intended.size() && typed[at] == intended[at]) at++;
+    size_t from = at < 20 ? 0 : at - 20;
+    printf("FAIL: typed text differs from intended text at character %zu of %zu"
+           " (%zu typed)\n  intended: %.40s\n  typed:    %.40s\n",
+           at, intended.size(), typed.size(), intended.c_str() + from,
+           from < typed.size() ? typed.c_str() + from : "");
+    return 1;
+  }
+  printf("typed text matches\n");
+  return 0;
+}
@@ -0,0 +1,28 @@
+// Arduino.h
+// Host stand-in for the few parts of the Arduino core the chorder core
+// uses directly: the integer types, PROGMEM access and String.
+// Everything that touches hardware goes through ChorderHal.h, see
+// HostHal.cpp.
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+typedef uint8_t byte;
+
+#define DEC 10
+#define HEX 16
+
+// flash is just memory on the host
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define memcpy_P(dest, src, n) memcpy((dest), (src), (n))
+#define strlen_P(s) strlen(s)
+#define PSTR(s) (s)
+
+#include "WString.h"
+
+#endif
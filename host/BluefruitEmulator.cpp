@@ -0,0 +1,352 @@
+// BluefruitEmulator.cpp
+// see BluefruitEmulator.h
+
+#include "BluefruitEmulator.h"
+#include "HidReport.h"
+#include "HostHal.h"
+
+#include <ctype.h>
+#include <deque>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+//                                                 latency jitter drop garble reorder refuse
+const BluefruitFaults bluefruitCleanLink = { 5000, 0, 0, 0, 0, 0 };
+const char BluefruitFactoryName[] = "Adafruit Bluefruit LE";
+
+BluefruitStats bluefruitStats;
+
+static bool attached = false;
+static BluefruitFaults faults;
+static unsigned long rngState = 1;
+
+struct ModuleAnswer {
+  unsigned long dueMicros;
+  std::string text;
+};
+static std::deque<ModuleAnswer> answers;
+static unsigned long busyUntil = 0;  // resetting till then
+
+// what the module keeps over a reset
+static std::string name;
+static bool hidOn = false;
+static bool batteryOn = false;
+// and what it doesn't
+static bool hidActive = false;       // HID on at the last reset
+static byte keysDown[6];
+static byte batteryLevel = 0;
+static byte mouseButtons = 0;
+
+static std::string typed;
+static std::vector<unsigned long> typedAt;
+
+// the character each key types, without and with Shift, from the table
+// the USB backend types text with
+static char keyChars[2][256];
+
+// its own small generator, apart from sessionRandom()
+static unsigned long draw(unsigned long range){
+  unsigned long bits = 0;
+  for (int i = 0; i < 2; i++) {
+    rngState = rngState * 1103515245ul + 12345ul;
+    bits = bits << 15 | ((rngState >> 16) & 0x7fff);
+  }
+  return range ? bits % range : 0;
+}
+
+static bool chance(unsigned int perMille){
+  return perMille && draw(1000) < perMille;
+}
+
+//=====ANSWERS==========================ANSWERS=====================
+// one line back, through the faults; the module answers in order, so a
+// line is never due before the one ahead of it unless swapped with it
+static void answer(const char *text){
+  bluefruitStats.answers++;
+  if (chance(faults.dropPerMille)) {
+    bluefruitStats.dropped++;
+    return;
+  }
+  ModuleAnswer a = { hostMicros() + faults.latencyMicros + draw(faults.jitterMicros), text };
+  if (a.dueMicros < busyUntil) a.dueMicros = busyUntil;
+  if (!answers.empty() && answers.back().dueMicros > a.dueMicros) a.dueMicros = answers.back().dueMicros;
+  if (chance(faults.garblePerMille)) {
+    bluefruitStats.garbled++;
+    a.text[draw(a.text.size())] ^= 0x20;
+  }
+  answers.push_back(a);
+  if (answers.size() > 1 && chance(faults.reorderPerMille)) {
+    bluefruitStats.reordered++;
+    answers[answers.size() - 1].text.swap(answers[answers.size() - 2].text);
+  }
+}
+
+static void ok(){
+  answer("OK");
+}
+
+static void error(){
+  bluefruitStats.errors++;
+  answer("ERROR");
+}
+
+bool bluefruitReadLine(char *line, byte size){
+  if (answers.empty() || answers.front().dueMicros > hostMicros()) return false;
+  strncpy(line, answers.front().text.c_str(), size - 1);
+  line[size - 1] = 0;
+  answers.pop_front();
+  return true;
+}
+
+//=====TEXT=============================TEXT========================
+static void type(char c){
+  if (c == '\b') {
+    if (!typed.empty()) {
+      typed.erase(typed.size() - 1);
+      typedAt.pop_back();
+    }
+    return;
+  }
+  typed += c;
+  typedAt.push_back(hostMicros());
+}
+
+static void buildKeyChars(){
+  memset(keyChars, 0, sizeof(keyChars));
+  for (int c = '~'; c >= ' '; c--) {  // the first of two on a key wins
+    byte mod, key;
+    if (hidFromAscii(c, &mod, &key)) keyChars[mod ? 1 : 0][key] = c;
+  }
+  for (int shift = 0; shift < 2; shift++) {
+    keyChars[shift][0x28] = '\n';  // Enter
+    keyChars[shift][0x2A] = '\b';  // Backspace
+    keyChars[shift][0x2B] = '\t';  // Tab
+  }
+}
+
+// "MM-00-KK-..", up to 6 keys; a key not down in the last report is
+// pressed now and types its character
+static bool keyboardCode(const char *args){
+  byte bytes[8];
+  byte n = 0;
+  for (const char *p = args; ; p += 3) {
+    if (n == sizeof(bytes) || !isxdigit(p[0]) || !isxdigit(p[1])) return false;
+    bytes[n++] = strtoul(std::string(p, 2).c_str(), 0, 16);
+    if (!p[2]) break;
+    if (p[2] != '-') return false;
+  }
+  if (n < 2 || bytes[1]) return false;
+  bluefruitStats.keyReports++;
+  byte mod = bytes[0];
+  byte now[6] = { 0 };
+  memcpy(now, bytes + 2, n - 2);
+  for (byte i = 0; i < 6; i++) {
+    if (!now[i] || memchr(keysDown, now[i], sizeof(keysDown))) continue;
+    bluefruitStats.keysTyped++;
+    if (mod & ~0x22) bluefruitStats.shortcuts++;
+    else if (keyChars[mod ? 1 : 0][now[i]]) type(keyChars[mod ? 1 : 0][now[i]]);
+  }
+  memcpy(keysDown, now, sizeof(keysDown));
+  return true;
+}
+
+// AT+BleKeyboard text, the module's escapes undone
+static void keyboardText(const char *text){
+  bluefruitStats.textCommands++;
+  for (const char *p = text; *p; p++) {
+    if (*p != '\\' || !p[1]) {
+      type(*p);
+      continue;
+    }
+    p++;
+    if (*p == 'r' || *p == 'n') type('\n');
+    else if (*p == 't') type('\t');
+    else if (*p == 'b') type('\b');
+    else type(*p);
+  }
+}
+
+//=====MOUSE============================MOUSE=======================
+// "0" or any of L R M B F, then perhaps ",click" and the like
+static bool mouseButton(const char *args){
+  static const char letters[] = "LRMBF";
+  byte bits = 0;
+  const char *p = args;
+  if (*p == '0') p++;
+  else {
+    for (; *p && *p != ','; p++) {
+      const char *at = strchr(letters, toupper(*p));
+      if (!at || !*at) return false;
+      bits |= 1 << (at - letters);
+    }
+  }
+  if (*p && *p != ',') return false;
+  bluefruitStats.mouseButtons++;
+  mouseButtons = bits & 7;
+  return true;
+}
+
+// "X,Y" then perhaps ",WHEEL" and ",PAN", each -128 to 127
+static bool mouseMove(const char *args){
+  const char *p = args;
+  for (int n = 0; n < 4; n++) {
+    char *end;
+    long value = strtol(p, &end, 10);
+    if (end == p || value < -128 || value > 127) return false;
+    if (!*end) {
+      if (n < 1) return false;
+      bluefruitStats.mouseMoves++;
+      return true;
+    }
+    if (*end != ',') return false;
+    p = end + 1;
+  }
+  return false;
+}
+
+//=====COMMANDS=========================COMMANDS====================
+static void reset(bool factory){
+  bluefruitStats.resets++;
+  if (factory) {
+    name = BluefruitFactoryName;
+    hidOn = false;
+    batteryOn = false;
+  }
+  hidActive = hidOn;
+  memset(keysDown, 0, sizeof(keysDown));
+  mouseButtons = 0;
+  busyUntil = hostMicros() + BluefruitResetMicros;
+  ok();
+}
+
+// "On" "1" or "Off" "0" to *on, or a query; false for anything else
+static bool setting(const char *args, bool *on){
+  if (!args) {
+    answer(*on ? "1" : "0");
+    return true;
+  }
+  if (!strcasecmp(args, "On") || !strcmp(args, "1")) *on = true;
+  else if (!strcasecmp(args, "Off") || !strcmp(args, "0")) *on = false;
+  else return false;
+  return true;
+}
+
+void bluefruitCommand(const char *line){
+  bluefruitStats.commands++;
+  if (hostMicros() < busyUntil) {
+    bluefruitStats.lost++;
+    return;
+  }
+  if (chance(faults.refusePerMille)) {
+    bluefruitStats.refused++;
+    error();
+    return;
+  }
+  std::string command(line);
+  const char *args = 0;
+  size_t equals = command.find('=');
+  if (equals != std::string::npos) {
+    command[equals] = 0;
+    args = command.c_str() + equals + 1;
+  }
+  const char *c = command.c_str();
+  bool isHid = !strcasecmp(c, "AT+BLEKEYBOARDCODE") || !strcasecmp(c, "AT+BLEKEYBOARD") ||
+               !strcasecmp(c, "AT+BLEHIDCONTROLKEY") || !strcasecmp(c, "AT+BLEHIDMOUSEBUTTON") ||
+               !strcasecmp(c, "AT+BLEHIDMOUSEMOVE");
+  bool done;
+  if (isHid && (!args || !hidActive)) done = false;
+  else if (!strcasecmp(c, "AT+BLEKEYBOARDCODE")) done = keyboardCode(args);
+  else if (!strcasecmp(c, "AT+BLEKEYBOARD")) {
+    keyboardText(args);
+    done = true;
+  } else if (!strcasecmp(c, "AT+BLEHIDCONTROLKEY")) {
+    unsigned int holdMs;
+    done = hidConsumerUsage(args, &holdMs) || strtoul(args, 0, 0);
+    if (done) bluefruitStats.controlKeys++;
+  } else if (!strcasecmp(c, "AT+BLEHIDMOUSEBUTTON")) done = mouseButton(args);
+  else if (!strcasecmp(c, "AT+BLEHIDMOUSEMOVE")) done = mouseMove(args);
+  else if (!strcasecmp(c, "AT+BLEBATTVAL")) {
+    char *end;
+    long level = args ? strtol(args, &end, 10) : -1;
+    done = batteryOn && args && *args && !*end && level >= 0 && level <= 100;
+    if (done) batteryLevel = level;
+  } else if (!strcasecmp(c, "AT+GAPDEVNAME")) {
+    if (args) name = args;
+    else answer(name.c_str());
+    done = true;
+  } else if (!strcasecmp(c, "AT+BLEHIDEN") || !strcasecmp(c, "AT+BLEKEYBOARDEN"))
+    done = setting(args, &hidOn);
+  else if (!strcasecmp(c, "AT+BLEBATTEN")) done = setting(args, &batteryOn);
+  else if (!strcasecmp(c, "ATZ") && !args) return reset(false);
+  else if (!strcasecmp(c, "AT+FACTORYRESET") && !args) return reset(true);
+  else if (!strcasecmp(c, "AT") && !args) done = true;
+  else done = false;
+  if (done) ok();
+  else error();
+}
+
+//=====MODULE===========================MODULE======================
+void bluefruitAttach(const BluefruitFaults &withFaults, unsigned long seed){
+  if (!keyChars[0]['a']) buildKeyChars();
+  attached = true;
+  faults = withFaults;
+  rngState = seed;
+  bluefruitStats = BluefruitStats();
+  answers.clear();
+  busyUntil = 0;
+  name = BluefruitFactoryName;
+  hidOn = false;
+  batteryOn = false;
+  hidActive = false;
+  memset(keysDown, 0, sizeof(keysDown));
+  batteryLevel = 0;
+  mouseButtons = 0;
+  bluefruitClearTyped();
+}
+
+void bluefruitSetFaults(const BluefruitFaults &withFaults){
+  faults = withFaults;
+}
+
+void bluefruitDetach(){
+  attached = false;
+  answers.clear();
+}
+
+bool bluefruitAttached(){
+  return attached;
+}
+
+const std::string &bluefruitTyped(){
+  return typed;
+}
+
+const std::vector<unsigned long> &bluefruitTypedAt(){
+  return typedAt;
+}
+
+void bluefruitClearTyped(){
+  typed.clear();
+  typedAt.clear();
+}
+
+const std::string &bluefruitName(){
+  return name;
+}
+
+bool bluefruitHidOn(){
+  return hidOn;
+}
+
+byte bluefruitBatteryLevel(){
+  return batteryLevel;
+}
+
+byte bluefruitMouseButtons(){
+  return mouseButtons;
+}
+
+bool bluefruitBusy(){
+  return hostMicros() < busyUntil;
+}
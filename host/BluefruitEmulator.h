@@ -0,0 +1,86 @@
+// BluefruitEmulator.h
+// A stand-in for the Bluefruit LE module on the host, for end to end runs
+// without a board.  Once attached, every halPrintln() goes to it rather
+// than to the plain OK answers of hostSetAckDelay(): it runs the AT
+// commands the firmware uses (AT+BLEKEYBOARDCODE, AT+BleKeyboard,
+// AT+BleHidControlKey, AT+BleHidMouseButton, AT+BleHidMouseMove,
+// AT+BLEBATTVAL, AT+GAPDEVNAME, AT+BleHIDEn, AT+BleKeyboardEn,
+// AT+BLEBATTEN, ATZ, AT+FACTORYRESET), answers them on halReadLine() and
+// decodes the keyboard reports into the text the paired host would see.
+//
+// The link can be made worse with BluefruitFaults: answers late (and
+// jittery, still in order), dropped, garbled or swapped with the one
+// before, and commands refused with an ERROR.  The draws come from their
+// own generator, so the same seed gives the same faults and the typing
+// streams of TypingSession.h are the same with faults or without.
+//
+// A new module is as from the factory: named BluefruitFactoryName, HID
+// off.  Keyboard, mouse and control key commands answer ERROR until
+// AT+BleHIDEn=On and an ATZ, as on the module; ATZ and AT+FACTORYRESET
+// take BluefruitResetMicros, and commands sent meanwhile are lost.
+
+#ifndef BLUEFRUIT_EMULATOR_H
+#define BLUEFRUIT_EMULATOR_H
+
+#include "ChorderHal.h"
+
+#include <string>
+#include <vector>
+
+struct BluefruitFaults {
+  unsigned long latencyMicros;  // command to answer
+  unsigned long jitterMicros;   // plus up to this
+  unsigned int dropPerMille;     // answers never sent
+  unsigned int garblePerMille;   // answers with a character flipped
+  unsigned int reorderPerMille;  // answers sent before the one ahead
+  unsigned int refusePerMille;   // commands not taken, answered ERROR
+};
+extern const BluefruitFaults bluefruitCleanLink;  // 5 ms answers, no faults
+
+const unsigned long BluefruitResetMicros = 1000000;
+extern const char BluefruitFactoryName[];
+
+struct BluefruitStats {
+  unsigned long commands;       // lines received
+  unsigned long errors;         // answered ERROR: unknown, bad or refused
+  unsigned long refused;
+  unsigned long lost;           // received while resetting
+  unsigned long keyReports;
+  unsigned long keysTyped;      // keys that went down, text or not
+  unsigned long shortcuts;      // keys down with Ctrl, Alt or GUI
+  unsigned long textCommands;   // AT+BleKeyboard
+  unsigned long controlKeys;
+  unsigned long mouseButtons;
+  unsigned long mouseMoves;
+  unsigned long resets;         // ATZ and AT+FACTORYRESET
+  unsigned long answers;        // lines answered, dropped ones included
+  unsigned long dropped;
+  unsigned long garbled;
+  unsigned long reordered;
+};
+extern BluefruitStats bluefruitStats;
+
+// a factory fresh module on the link, until bluefruitDetach() or hostReset()
+void bluefruitAttach(const BluefruitFaults &faults, unsigned long seed = 1);
+void bluefruitSetFaults(const BluefruitFaults &faults);
+void bluefruitDetach();
+bool bluefruitAttached();
+
+// the text the host has seen typed: printable keys, Enter as '\n' and Tab
+// as '\t', Backspace taking the last one back, and AT+BleKeyboard text
+// with its \r \n \t \\ escapes; typedAt is when each character came
+const std::string &bluefruitTyped();
+const std::vector<unsigned long> &bluefruitTypedAt();
+void bluefruitClearTyped();
+
+const std::string &bluefruitName();
+bool bluefruitHidOn();
+byte bluefruitBatteryLevel();  // the last AT+BLEBATTVAL
+byte bluefruitMouseButtons();  // left 1 right 2 middle 4
+bool bluefruitBusy();          // resetting
+
+// from HostHal.cpp: a line sent to the module, and its next answer line
+void bluefruitCommand(const char *line);
+bool bluefruitReadLine(char *line, byte size);
+
+#endif
@@ -0,0 +1,28 @@
+// ChordDriver.cpp
+// see ChordDriver.h
+
+#include "ChordDriver.h"
+#include "Chorder.h"
+
+unsigned long scanTickMicros = 100;
+
+void driveFor(unsigned long us){
+  unsigned long end = hostMicros() + us;
+  while (hostMicros() < end) {
+    chorderLoop();
+    hostAdvanceMicros(scanTickMicros);
+  }
+}
+
+void typeChord(byte chord, unsigned long holdMs, unsigned long gapMs){
+  hostSetSwitches(chord);
+  driveFor(holdMs * 1000);
+  hostSetSwitches(0);
+  driveFor(gapMs * 1000);
+}
+
+void driverReset(){
+  hostReset();
+  chorderInit();
+  scanTickMicros = 100;
+}
@@ -0,0 +1,24 @@
+// ChordDriver.h
+// Drives the chorder core on the host the way fingers and loop() would:
+// set switch bits, then let simulated time pass while chorderLoop() runs
+// once per scan tick.
+
+#ifndef CHORD_DRIVER_H
+#define CHORD_DRIVER_H
+
+#include "HostHal.h"
+
+// simulated time between two loop() passes
+extern unsigned long scanTickMicros;
+
+// run chorderLoop() every scan tick for 'us' microseconds
+void driveFor(unsigned long us);
+
+// press every bit of 'chord' at once, hold it, release it all at once
+// and wait 'gapMs' with no switch down
+void typeChord(byte chord, unsigned long holdMs = 40, unsigned long gapMs = 40);
+
+// core, HAL and driver back to power-on state
+void driverReset();
+
+#endif
@@ -0,0 +1,201 @@
+// HostHal.cpp
+// Linux implementation of ChorderHal.h, see HostHal.h.
+
+#include "HostHal.h"
+#include "BluefruitEmulator.h"
+
+#include <deque>
+#include <string.h>
+
+static byte switches = 0;
+static unsigned long nowMicros = 0;
+static std::string traffic;
+static unsigned long commands = 0;
+static unsigned long trafficBytes = 0;
+static int battery = 0;
+static bool poweredOff = false;
+
+struct Answer {
+  unsigned long dueMicros;
+  const char *text;
+};
+static std::deque<Answer> answers;
+static std::string logText;
+static unsigned long ackDelay = HostNoAck;
+static int failNext = 0;
+
+static byte eeprom[HalEepromSize];
+static unsigned long eepromWrites[HalEepromSize];
+static unsigned long eepromWritesLeft = ~0ul;
+static unsigned long eepromReads = 0;
+
+//=====PINS=============================PINS========================
+byte halReadSwitches(){
+  return switches;
+}
+
+void hostSetSwitches(byte keyState){
+  switches = keyState;
+}
+
+//=====CLOCK============================CLOCK=======================
+unsigned long halMillis(){
+  return nowMicros / 1000;
+}
+
+unsigned long halMicros(){
+  return nowMicros;
+}
+
+void halDelay(unsigned long ms){
+  nowMicros += ms * 1000;
+}
+
+// the board's watchdog period
+void halSleep(){
+  nowMicros += HostSleepMicros;
+}
+
+unsigned long hostMicros(){
+  return nowMicros;
+}
+
+void hostAdvanceMicros(unsigned long us){
+  nowMicros += us;
+}
+
+//=====TRANSPORT========================TRANSPORT===================
+void halPrintln(const char *text){
+  std::string::size_type before = traffic.size();
+  traffic += text;
+  traffic += "\r\n";
+  trafficBytes += traffic.size() - before;
+  commands++;
+  if (bluefruitAttached()) return bluefruitCommand(text);
+  if (ackDelay == HostNoAck) return;
+  Answer a = { nowMicros + ackDelay, "OK" };
+  if (!answers.empty() && answers.back().dueMicros > a.dueMicros) a.dueMicros = answers.back().dueMicros;
+  if (failNext) {
+    failNext--;
+    a.text = "ERROR";
+  }
+  answers.push_back(a);
+}
+
+bool halReadLine(char *line, byte size){
+  if (bluefruitAttached()) return bluefruitReadLine(line, size);
+  if (answers.empty() || answers.front().dueMicros > nowMicros) return false;
+  strncpy(line, answers.front().text, size - 1);
+  line[size - 1] = 0;
+  answers.pop_front();
+  return true;
+}
+
+void hostSetAckDelay(unsigned long us){
+  ackDelay = us;
+}
+
+void hostFailNext(int n){
+  failNext = n;
+}
+
+const std::string &hostTraffic(){
+  return traffic;
+}
+
+unsigned long hostCommandCount(){
+  return commands;
+}
+
+unsigned long hostTrafficBytes(){
+  return trafficBytes;
+}
+
+void hostClearTraffic(){
+  traffic.clear();
+  commands = 0;
+  trafficBytes = 0;
+}
+
+//=====EEPROM===========================EEPROM======================
+byte halEepromRead(unsigned int addr){
+  eepromReads++;
+  return addr < HalEepromSize ? eeprom[addr] : 0xFF;
+}
+
+void halEepromWrite(unsigned int addr, byte value){
+  if (addr >= HalEepromSize || eeprom[addr] == value || !eepromWritesLeft) return;
+  if (eepromWritesLeft != ~0ul) eepromWritesLeft--;
+  eeprom[addr] = value;
+  eepromWrites[addr]++;
+}
+
+unsigned long hostEepromReads(){
+  return eepromReads;
+}
+
+unsigned long hostEepromWrites(unsigned int addr){
+  return eepromWrites[addr];
+}
+
+unsigned long hostEepromWriteTotal(){
+  unsigned long total = 0;
+  for (unsigned int i = 0; i < HalEepromSize; i++) total += eepromWrites[i];
+  return total;
+}
+
+void hostEepromPowerFail(unsigned long writes){
+  eepromWritesLeft = writes;
+}
+
+//=====LOG==============================LOG=========================
+void halLog(const char *line){
+  logText += line;
+  logText += '\n';
+}
+
+void halLogP(const char *flashLine){
+  halLog(flashLine);  // flash is just memory on the host
+}
+
+const std::string &hostLog(){
+  return logText;
+}
+
+//=====BOARD============================BOARD=======================
+int halReadBattery(){
+  return battery;
+}
+
+void halPowerOff(){
+  poweredOff = true;
+}
+
+void sendFactoryReset(){
+  halPrintln("AT+FACTORYRESET");
+}
+
+void hostSetBattery(int raw){
+  battery = raw;
+}
+
+bool hostPoweredOff(){
+  return poweredOff;
+}
+
+void hostReset(){
+  switches = 0;
+  nowMicros = 0;
+  hostClearTraffic();
+  battery = 0;
+  poweredOff = false;
+  answers.clear();
+  bluefruitDetach();
+  ackDelay = HostNoAck;
+  failNext = 0;
+  logText.clear();
+  memset(eeprom, 0xFF, sizeof(eeprom));
+  memset(eepromWrites, 0, sizeof(eepromWrites));
+  eepromWritesLeft = ~0ul;
+  eepromReads = 0;
+}
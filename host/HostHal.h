@@ -0,0 +1,56 @@
+// HostHal.h
+// Linux side of ChorderHal.h.  The switches are a byte the test sets, the
+// clock is simulated (halDelay() just moves it forward) and everything the
+// core sends to the Bluefruit is captured as text.
+
+#ifndef HOST_HAL_H
+#define HOST_HAL_H
+
+#include "ChorderHal.h"
+
+#include <string>
+
+// switch bits in the same order the core builds keyState, bit 0 Pinky
+void hostSetSwitches(byte keyState);
+
+// simulated clock, halMillis() is hostMicros() / 1000, and halSleep()
+// moves it on by HostSleepMicros
+const unsigned long HostSleepMicros = 16000;
+unsigned long hostMicros();
+void hostAdvanceMicros(unsigned long us);
+
+// AT traffic captured since the last hostClearTraffic()
+const std::string &hostTraffic();
+unsigned long hostCommandCount();  // completed (println) commands
+unsigned long hostTrafficBytes();  // bytes on the wire, line endings included
+void hostClearTraffic();
+
+// the module's answers to halReadLine(): with an ack delay set every
+// command is answered OK that many us after it was sent (in order, as
+// the module does); hostFailNext() makes the next n answers ERROR.
+// HostNoAck, the default, answers nothing.  A module attached with
+// bluefruitAttach() (BluefruitEmulator.h) answers instead.
+const unsigned long HostNoAck = ~0ul;
+void hostSetAckDelay(unsigned long us);
+void hostFailNext(int n = 1);
+
+// halLog() lines since the last hostReset(), each ending in a newline
+const std::string &hostLog();
+
+// the EEPROM keeps its contents over chorderInit(), like a power cycle;
+// hostReset() erases it.  hostEepromWrites() counts the writes that
+// changed a cell, for wear; after hostEepromPowerFail(n) only n more
+// writes land, as if the power went mid-write.  hostEepromReads()
+// counts reads, for what a load costs on the board.
+unsigned long hostEepromReads();
+unsigned long hostEepromWrites(unsigned int addr);
+unsigned long hostEepromWriteTotal();
+void hostEepromPowerFail(unsigned long writes);
+
+void hostSetBattery(int raw);
+bool hostPoweredOff();
+
+// everything above back to its start state
+void hostReset();
+
+#endif
@@ -0,0 +1,411 @@
+// KeymapCompiler.cpp
+// see KeymapCompiler.h
+
+#include "KeymapCompiler.h"
+
+#include <algorithm>
+#include <map>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+
+static const char switchLetters[] = "FCNIMRP";  // bit 6 down to bit 0
+
+//=====CHORDS===========================CHORDS======================
+int parseChordPattern(const std::string &pattern){
+  int chord = 0, at = 0;
+  for (size_t i = 0; i < pattern.size(); i++) {
+    char c = pattern[i];
+    if (c == ' ') continue;
+    if (at == 7) return -1;
+    if (c == switchLetters[at]) chord |= 0x40 >> at;
+    else if (c != '-') return -1;
+    at++;
+  }
+  return at == 7 ? chord : -1;
+}
+
+std::string chordPattern(int chord){
+  std::string s;
+  for (int at = 0; at < 7; at++) {
+    if (at == 3) s += ' ';
+    s += chord & (0x40 >> at) ? switchLetters[at] : '-';
+  }
+  return s;
+}
+
+//=====PARSE============================PARSE=======================
+static std::string where(const std::string &name, int line){
+  char number[16];
+  snprintf(number, sizeof(number), ":%d: ", line);
+  return name + number;
+}
+
+static bool isName(const std::string &s){
+  if (s.empty() || !(isalpha((unsigned char)s[0]) || s[0] == '_')) return false;
+  for (size_t i = 1; i < s.size(); i++)
+    if (!(isalnum((unsigned char)s[i]) || s[i] == '_')) return false;
+  return true;
+}
+
+static std::string trim(const std::string &s){
+  size_t b = s.find_first_not_of(" \t\r"), e = s.find_last_not_of(" \t\r");
+  return b == std::string::npos ? "" : s.substr(b, e - b + 1);
+}
+
+bool parseChart(const std::string &name, const std::string &text, KeymapChart &chart,
+                std::vector<std::string> &errors){
+  size_t before = errors.size();
+  chart = KeymapChart();
+  chart.name = name;
+  std::istringstream in(text);
+  std::string raw;
+  for (int n = 1; std::getline(in, raw); n++) {
+    std::string line = trim(raw);
+    if (line.empty() || line[0] == '#') continue;
+
+    if (line.compare(0, 6, "layer ") == 0) {
+      std::istringstream words(line.substr(6));
+      ChartLayer layer;
+      std::string layout;
+      words >> layer.mode >> layer.array >> layout;
+      std::getline(words, layer.title);
+      layer.title = trim(layer.title);
+      if (!isName(layer.mode) || !isName(layer.array) ||
+          (layout != "dense" && layout != "sparse" && layout != "auto") || layer.title.size() > 34) {
+        errors.push_back(where(name, n) + "expected: layer <MODE> <array> <dense|sparse|auto> [title]");
+        continue;
+      }
+      layer.dense = layout == "dense";
+      if (layout == "auto") layer.array += "?";  // decided in checkChart()
+      layer.line = n;
+      chart.layers.push_back(layer);
+      continue;
+    }
+
+    // "FCN IMRP code note", the pattern has a space in it
+    if (line.size() < 9) {
+      errors.push_back(where(name, n) + "expected: <FCN IMRP> <code> [note]");
+      continue;
+    }
+    ChartEntry e;
+    e.chord = parseChordPattern(line.substr(0, 8));
+    e.line = n;
+    std::string rest = trim(line.substr(8));
+    size_t space = rest.find_first_of(" \t");
+    e.code = rest.substr(0, space);
+    e.note = space == std::string::npos ? "" : trim(rest.substr(space));
+    if (e.chord < 0) {
+      errors.push_back(where(name, n) + "'" + line.substr(0, 8) + "' is not a chord, want FCN IMRP with - for a switch not pressed");
+    } else if (!isName(e.code)) {
+      errors.push_back(where(name, n) + "expected a key code after the chord");
+    } else if (chart.layers.empty()) {
+      errors.push_back(where(name, n) + "chord before the first layer line");
+    } else {
+      chart.layers.back().entries.push_back(e);
+    }
+  }
+  if (chart.layers.empty() && errors.size() == before)
+    errors.push_back(name + ": no layers");
+  return errors.size() == before;
+}
+
+//=====CHECK============================CHECK=======================
+// where a code leaves the chorder, as sendKey() does it: the mode keys
+// switch (some toggle), modifiers and latches stay in the layer, and
+// anything that sends resets to the first layer, or to POINTER while it
+// is locked (anything sent in it but MODE_RESET)
+static std::vector<std::string> nextModes(const std::string &code, const std::string &mode,
+                                          const std::string &first){
+  std::vector<std::string> next;
+  if (code == "MODE_NUM" || code == "MULTI_NumShift") {
+    next.push_back(mode == "NUMSYM" ? first : "NUMSYM");
+  } else if (code == "MODE_FUNC") {
+    next.push_back(mode == "FUNCTION" ? first : "FUNCTION");
+  } else if (code == "MODE_NUMLCK") {
+    next.push_back("NUMSYM");
+    next.push_back(first);
+  } else if (code == "MODE_POINTER") {
+    next.push_back(mode == "POINTER" ? first : "POINTER");
+  } else if (code == "LATCH" || code == "MULTI_CtlAlt" || code == "MODE_FRESET" ||
+             code.compare(0, 4, "MOD_") == 0) {
+    next.push_back(mode);
+  } else if (mode == "POINTER" && code != "MODE_RESET" && code != "MODE_MRESET") {
+    next.push_back(mode);
+  } else {
+    next.push_back(first);
+  }
+  return next;
+}
+
+bool checkChart(KeymapChart &chart, std::vector<std::string> &errors){
+  size_t before = errors.size();
+  std::map<std::string, size_t> byMode;
+  for (size_t l = 0; l < chart.layers.size(); l++) {
+    ChartLayer &layer = chart.layers[l];
+    if (byMode.count(layer.mode))
+      errors.push_back(where(chart.name, layer.line) + "layer " + layer.mode + " is already in the chart");
+    byMode[layer.mode] = l;
+
+    std::map<int, int> seen;  // chord -> line
+    for (size_t i = 0; i < layer.entries.size(); i++) {
+      const ChartEntry &e = layer.entries[i];
+      if (e.chord == 0)
+        errors.push_back(where(chart.name, e.line) + "--- ---- can't be pressed, nothing would send " + e.code);
+      if (e.code == "ENUMKEY__")
+        errors.push_back(where(chart.name, e.line) + "ENUMKEY__ is what a chord not in the chart does, leave it out");
+      if (seen.count(e.chord)) {
+        char first[16];
+        snprintf(first, sizeof(first), "%d", seen[e.chord]);
+        errors.push_back(where(chart.name, e.line) + chordPattern(e.chord) + " is in " + layer.mode +
+                         " twice, first at line " + first);
+      }
+      seen[e.chord] = e.line;
+    }
+    std::sort(layer.entries.begin(), layer.entries.end(),
+              [](const ChartEntry &a, const ChartEntry &b){ return a.chord < b.chord; });
+
+    // auto: sparse entries are 2 bytes, a dense layer 128
+    if (!layer.array.empty() && layer.array[layer.array.size() - 1] == '?') {
+      layer.array.erase(layer.array.size() - 1);
+      layer.dense = layer.entries.size() * 2 >= 128;
+    }
+  }
+  if (errors.size() != before) return false;
+
+  // every layer reachable from the first and back
+  const std::string &first = chart.layers[0].mode;
+  std::vector<std::set<std::string> > edges(chart.layers.size());
+  for (size_t l = 0; l < chart.layers.size(); l++) {
+    const ChartLayer &layer = chart.layers[l];
+    for (size_t i = 0; i < layer.entries.size(); i++) {
+      std::vector<std::string> next = nextModes(layer.entries[i].code, layer.mode, first);
+      for (size_t k = 0; k < next.size(); k++) {
+        if (!byMode.count(next[k])) {
+          errors.push_back(where(chart.name, layer.entries[i].line) + layer.entries[i].code +
+                           " switches to " + next[k] + ", which has no layer in the chart");
+          continue;
+        }
+        edges[l].insert(next[k]);
+      }
+    }
+  }
+  if (errors.size() != before) return false;
+
+  for (size_t from = 0; from < chart.layers.size(); from++) {
+    std::set<std::string> reached;
+    std::vector<size_t> todo(1, from);
+    while (!todo.empty()) {
+      size_t l = todo.back();
+      todo.pop_back();
+      for (std::set<std::string>::const_iterator it = edges[l].begin(); it != edges[l].end(); ++it) {
+        if (reached.insert(*it).second) todo.push_back(byMode[*it]);
+      }
+    }
+    const ChartLayer &layer = chart.layers[from];
+    if (from == 0) {
+      for (size_t l = 1; l < chart.layers.size(); l++) {
+        if (!reached.count(chart.layers[l].mode))
+          errors.push_back(where(chart.name, chart.layers[l].line) + "layer " + chart.layers[l].mode +
+                           " can't be reached from " + first);
+      }
+    } else if (!reached.count(first)) {
+      errors.push_back(where(chart.name, layer.line) + "layer " + layer.mode +
+                       " only switches among layers that never get back to " + first);
+    }
+  }
+  return errors.size() == before;
+}
+
+// 'enum keycodes {...}' split at the commas with the comments gone,
+// then the 'const int' codes after it
+std::map<std::string, int> keyCodeValues(const std::string &keyCodes){
+  std::map<std::string, int> values;
+  size_t at = keyCodes.find("enum keycodes");
+  size_t open = keyCodes.find('{', at);
+  size_t end = keyCodes.find("};", at);
+  if (at != std::string::npos && open < end && end != std::string::npos) {
+    std::string body;
+    for (size_t i = open + 1; i < end; i++) {
+      if (!keyCodes.compare(i, 2, "//")) i = keyCodes.find('\n', i) - 1;
+      else if (!keyCodes.compare(i, 2, "/*")) i = keyCodes.find("*/", i) + 1;
+      else body += keyCodes[i] == '\n' ? ' ' : keyCodes[i];
+    }
+    std::istringstream items(body);
+    std::string item;
+    int next = 0;
+    while (std::getline(items, item, ',')) {
+      size_t equals = item.find('=');
+      std::string name = trim(item.substr(0, equals));
+      if (!isName(name)) continue;
+      if (equals != std::string::npos) {
+        std::string value = trim(item.substr(equals + 1));
+        std::map<std::string, int>::const_iterator named = values.find(value);
+        next = named != values.end() ? named->second : (int)strtol(value.c_str(), 0, 0);
+      }
+      values[name] = next++;
+    }
+  }
+  for (size_t c = keyCodes.find("const int "); c != std::string::npos;
+       c = keyCodes.find("const int ", c + 1)) {
+    std::istringstream words(keyCodes.substr(c + 10, 64));
+    std::string name, equals, value;
+    words >> name >> equals >> value;
+    if (isName(name) && equals == "=") values[name] = (int)strtol(value.c_str(), 0, 0);
+  }
+  return values;
+}
+
+bool checkCodes(const KeymapChart &chart, const std::string &keyCodes,
+                std::vector<std::string> &errors){
+  size_t before = errors.size();
+  std::map<std::string, int> values = keyCodeValues(keyCodes);
+  if (values.empty()) {
+    errors.push_back("no enum keycodes in KeyCodes.h");
+    return false;
+  }
+  for (size_t l = 0; l < chart.layers.size(); l++) {
+    const ChartLayer &layer = chart.layers[l];
+    for (size_t i = 0; i < layer.entries.size(); i++) {
+      if (!values.count(layer.entries[i].code))
+        errors.push_back(where(chart.name, layer.entries[i].line) + layer.entries[i].code +
+                         " is not in KeyCodes.h");
+    }
+  }
+  return errors.size() == before;
+}
+
+//=====EMIT=============================EMIT========================
+static const char preamble[] =
+  "// ChordMappings.h\n"
+  "// Chordmappings for 7 button chorder, split out from FeatherChorder.ino\n"
+  "// Mappings moved here so they can be changed without risk\n"
+  "// of modifying the rest of the code.\n"
+  "// - Greg\n"
+  "//\n"
+  "// Generated from ChordChart.txt by tools/keymap_compiler, change the\n"
+  "// chart and run it (cmake --build build --target keymap) rather than\n"
+  "// editing this file.\n"
+  "\n"
+  "typedef uint8_t keymap_t;\n"
+  "\n"
+  "// Keymaps live in flash (PROGMEM) and are only read through\n"
+  "// keymapLookup() in Keymap.cpp, so they cost no SRAM.\n"
+  "//\n"
+  "// A layer is either dense, 128 keymap_t indexed by the chord, or sparse,\n"
+  "// a list of the chords that do something, sorted by chord, for layers that\n"
+  "// are mostly ENUMKEY__.  Chords not in a sparse list are ENUMKEY__.\n"
+  "struct keymap_entry_t {\n"
+  "  uint8_t chord;\n"
+  "  keymap_t key;\n"
+  "};\n"
+  "\n"
+  "struct keymap_layer_t {\n"
+  "  const keymap_t *dense;          // 128 entries, or 0 for a sparse layer\n"
+  "  const keymap_entry_t *sparse;   // sorted by chord\n"
+  "  uint8_t sparseCount;\n"
+  "};\n"
+  "\n"
+  "// for the static_asserts below: chords 1 - 127, each once, in order\n"
+  "constexpr bool keymapSparseOk(const keymap_entry_t *e, unsigned n, int last = 0){\n"
+  "  return n == 0 || (e->chord > last && e->chord < 128 && keymapSparseOk(e + 1, n - 1, e->chord));\n"
+  "}\n"
+  "\n"
+  "\n"
+  "/**********************************************************\n"
+  " *  order is  Far Thumb, Center Thumb, Near Thumb button  *\n"
+  " *  Index Finger, Middle Finger, Ring Finger, Pinky       *\n"
+  " *  FCN IMRP                                              *\n"
+  " **********************************************************/\n";
+
+static std::string padded(const std::string &s){
+  std::string out = "  " + s;
+  out.resize(std::max<size_t>(out.size() + 1, 36), ' ');
+  return out;
+}
+
+static std::string entryComment(int chord, const std::string &note){
+  char hex[8];
+  snprintf(hex, sizeof(hex), "0x%02X", chord);
+  std::string out = "// " + chordPattern(chord) + "  " + hex;
+  if (!note.empty()) out += "   " + note;
+  return out + "\n";
+}
+
+static std::string bannerLine(const std::string &text){
+  std::string line = " * " + text;
+  line.resize(38, ' ');
+  return line + "*\n";
+}
+
+static std::string banner(const ChartLayer &layer){
+  if (layer.title.empty() && layer.dense) return "";
+  std::string out = "/**************************************\n";
+  if (!layer.title.empty()) out += bannerLine(layer.title);
+  if (!layer.dense) out += bannerLine("sparse, only the chords in use");
+  return out + " **************************************/\n";
+}
+
+std::string emitMappings(const KeymapChart &chart){
+  std::string out = preamble;
+  for (size_t l = 0; l < chart.layers.size(); l++) {
+    const ChartLayer &layer = chart.layers[l];
+    if (l) out += "\n";
+    out += banner(layer);
+    if (layer.dense) {
+      out += "const keymap_t " + layer.array + "[] PROGMEM = {\n";
+      size_t next = 0;
+      for (int chord = 0; chord < 128; chord++) {
+        if (chord && chord % 8 == 0) out += "\n";
+        const ChartEntry *e = next < layer.entries.size() && layer.entries[next].chord == chord
+                              ? &layer.entries[next++] : 0;
+        std::string code = e ? e->code : "ENUMKEY__";
+        std::string note = e ? e->note : chord ? "" : "no keys pressed";
+        out += padded(code + (chord < 127 ? "," : "")) + entryComment(chord, note);
+      }
+      out += "};\n";
+      out += "static_assert(sizeof(" + layer.array + ") == 128 * sizeof(keymap_t),\n"
+             "              \"" + layer.array + " needs a key for each of the 128 chords\");\n";
+    } else {
+      out += "constexpr keymap_entry_t " + layer.array + "[] PROGMEM = {\n";
+      for (size_t i = 0; i < layer.entries.size(); i++) {
+        const ChartEntry &e = layer.entries[i];
+        if (i && e.chord >> 3 != layer.entries[i - 1].chord >> 3) out += "\n";
+        char chord[8];
+        snprintf(chord, sizeof(chord), "0x%02X", e.chord);
+        out += padded(std::string("{ ") + chord + ", " + e.code + " }" +
+                      (i + 1 < layer.entries.size() ? "," : "")) + entryComment(e.chord, e.note);
+      }
+      out += "};\n";
+      std::string count = "sizeof(" + layer.array + ") / sizeof(" + layer.array + "[0])";
+      out += "static_assert(" + count + " < 128 && keymapSparseOk(" + layer.array + ", " + count + "),\n"
+             "              \"" + layer.array + " wants chords 1 - 127, each once, sorted\");\n";
+    }
+  }
+
+  out += "\n/**************************************\n"
+         " * layers, in the order of Mode in    *\n"
+         " * Chorder.cpp                        *\n"
+         " **************************************/\n"
+         "const keymap_layer_t keymap_layers[] PROGMEM = {\n";
+  for (size_t l = 0; l < chart.layers.size(); l++) {
+    const ChartLayer &layer = chart.layers[l];
+    std::string comma = l + 1 < chart.layers.size() ? "," : "";
+    if (layer.dense) {
+      std::string entry = "  { " + layer.array + ", 0, 0 }" + comma;
+      entry.resize(std::max<size_t>(entry.size() + 1, 46), ' ');
+      out += entry + "// " + layer.mode + "\n";
+    } else {
+      out += "  { 0, " + layer.array + ",\n"
+             "    sizeof(" + layer.array + ") / sizeof(" + layer.array + "[0]) }" + comma +
+             "  // " + layer.mode + "\n";
+    }
+  }
+  char layers[8];
+  snprintf(layers, sizeof(layers), "%u", (unsigned)chart.layers.size());
+  out += "};\n"
+         "static_assert(sizeof(keymap_layers) / sizeof(keymap_layers[0]) == " + std::string(layers) + ",\n"
+         "              \"a layer for each Mode in Chorder.cpp\");\n"
+         "\n// end ChordMappings.h\n";
+  return out;
+}
@@ -0,0 +1,67 @@
+// KeymapCompiler.h
+// Turns the chord chart (FeatherChorder/ChordChart.txt) into
+// ChordMappings.h.  The chart lists, per layer, only the chords that do
+// something, by their FCN IMRP pattern, so a missing line can't shift
+// the chords after it; the tables, their layout and the static_asserts
+// that keep a hand-edited header honest are generated.  Used by
+// tools/keymap_compiler.
+//
+// Chart syntax, '#' starts a comment line:
+//   layer <MODE> <array> <dense|sparse|auto> [title]
+//       a layer, in the order of Mode in Chorder.cpp; auto picks sparse
+//       when that is smaller in flash (under 64 chords), the title goes
+//       in the banner over the table
+//   <FCN IMRP> <code> [note]
+//       a chord, '-' for a switch not pressed, and a KeyCodes.h name;
+//       the note goes into the header's comment
+
+#ifndef KEYMAP_COMPILER_H
+#define KEYMAP_COMPILER_H
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+struct ChartEntry {
+  int chord;
+  std::string code;
+  std::string note;
+  int line;
+};
+
+struct ChartLayer {
+  std::string mode;
+  std::string array;
+  std::string title;
+  bool dense;
+  int line;
+  std::vector<ChartEntry> entries;  // sorted by chord once checked
+};
+
+struct KeymapChart {
+  std::string name;  // file name, for messages
+  std::vector<ChartLayer> layers;
+};
+
+// "--N I-R-" -> 0x1A, -1 if it isn't a chord pattern
+int parseChordPattern(const std::string &pattern);
+std::string chordPattern(int chord);
+
+// each returns false and adds "name:line: message" lines to 'errors'
+bool parseChart(const std::string &name, const std::string &text, KeymapChart &chart,
+                std::vector<std::string> &errors);
+// duplicate chords, chords that can't be pressed, layers that can't be
+// reached from the first one or have no way back to it
+bool checkChart(KeymapChart &chart, std::vector<std::string> &errors);
+// the value of each name in the 'enum keycodes' of KeyCodes.h ('keyCodes')
+// and the 'const int' codes after it
+std::map<std::string, int> keyCodeValues(const std::string &keyCodes);
+// codes that aren't in the 'enum keycodes' of KeyCodes.h ('keyCodes')
+bool checkCodes(const KeymapChart &chart, const std::string &keyCodes,
+                std::vector<std::string> &errors);
+
+// the ChordMappings.h for a checked chart
+std::string emitMappings(const KeymapChart &chart);
+
+#endif
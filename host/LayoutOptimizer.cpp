@@ -0,0 +1,289 @@
+// LayoutOptimizer.cpp
+// see LayoutOptimizer.h
+
+#include "LayoutOptimizer.h"
+
+#include <algorithm>
+#include <map>
+#include <sstream>
+#include <stdio.h>
+#include <string.h>
+
+//=====DUMP=============================DUMP========================
+bool parseUsageDump(const std::string &name, const std::string &text, UsageCounts &counts,
+                    std::vector<std::string> &errors){
+  size_t at = text.rfind("usage halved ");
+  if (at == std::string::npos || (at && text[at - 1] != '\n')) {
+    errors.push_back(name + ": no usage dump (USAGE_DUMP) in it");
+    return false;
+  }
+  memset(&counts, 0, sizeof(counts));
+  std::istringstream in(text.substr(at));
+  std::string line;
+  std::getline(in, line);
+  if (sscanf(line.c_str(), "usage halved %lu macros %lu words %lu function %lu", &counts.halvings,
+             &counts.macros, &counts.words, &counts.function) != 4) {
+    errors.push_back(name + ": can't read '" + line + "'");
+    return false;
+  }
+  std::getline(in, line);
+  if (sscanf(line.c_str(), "mode num %lu numlck %lu func %lu numshift %lu", &counts.modeKeys[0],
+             &counts.modeKeys[1], &counts.modeKeys[2], &counts.modeKeys[3]) != 4) {
+    errors.push_back(name + ": can't read '" + line + "'");
+    return false;
+  }
+  while (std::getline(in, line)) {
+    if (!line.empty() && line[line.size() - 1] == '\r') line.erase(line.size() - 1);
+    if (line == "end") return true;
+    std::istringstream row(line);
+    int layer = -1;
+    unsigned int first = 0, count = 0;
+    row >> layer >> std::hex >> first;
+    if (!row || layer < 0 || layer >= UsageCountLayers || first > 112 || first % 16) {
+      errors.push_back(name + ": can't read '" + line + "'");
+      return false;
+    }
+    for (int c = 0; c < 16; c++) {
+      if (!(row >> count)) {
+        errors.push_back(name + ": want 16 counts in '" + line + "'");
+        return false;
+      }
+      counts.chords[layer][first + c] = count;
+    }
+  }
+  errors.push_back(name + ": the usage dump has no end");
+  return false;
+}
+
+//=====PLAN=============================PLAN========================
+static bool isMovable(const std::string &code){
+  return code.compare(0, 8, "ENUMKEY_") == 0 || code.compare(0, 6, "MACRO_") == 0 ||
+         code.compare(0, 5, "WORD_") == 0;
+}
+
+static int fingers(int chord){
+  int n = 0;
+  for (; chord; chord &= chord - 1) n++;
+  return n;
+}
+
+struct Item {
+  const ChartEntry *entry;
+  int layer;
+  unsigned long count;
+  int slot;    // where it is
+  int placed;  // where it goes, -1 not yet
+};
+
+struct Slot {
+  int layer;
+  int chord;
+  int fingers;   // switch chord included
+  int switches;
+  int cost;
+  int holder;    // item there now, -1 none
+  int taken;     // item going there, -1 free
+};
+
+// the cheapest ALPHA chord that switches to NUMSYM, in fingers
+static int numsymFingers(const KeymapChart &chart){
+  int best = 0;
+  const ChartLayer &alpha = chart.layers[0];
+  for (size_t i = 0; i < alpha.entries.size(); i++) {
+    const ChartEntry &e = alpha.entries[i];
+    if ((e.code == "MODE_NUM" || e.code == "MULTI_NumShift") && (!best || fingers(e.chord) < best))
+      best = fingers(e.chord);
+  }
+  return best;
+}
+
+static void addCost(LayoutCost &total, const Slot &s, unsigned long count){
+  total.chars += count;
+  total.fingers += count * s.fingers;
+  total.switches += count * s.switches;
+  total.cost += count * s.cost;
+}
+
+// the most used first, and among those the ones already cheap, so ties
+// leave things where they are
+static bool byUse(const Item &a, const Item &b, const std::vector<Slot> &slots){
+  if (a.count != b.count) return a.count > b.count;
+  if (slots[a.slot].cost != slots[b.slot].cost) return slots[a.slot].cost < slots[b.slot].cost;
+  return a.slot < b.slot;
+}
+
+LayoutPlan optimizeLayout(const KeymapChart &chart, const UsageCounts &counts, int switchWeight){
+  LayoutPlan plan = LayoutPlan();
+  int toNumsym = numsymFingers(chart);
+  int layers = std::min<int>(UsageCountLayers, chart.layers.size());
+
+  // every chord of the counted layers that a fixed code doesn't hold
+  std::vector<Slot> slots;
+  std::vector<Item> items;
+  for (int l = 0; l < layers; l++) {
+    std::map<int, const ChartEntry *> byChord;
+    for (size_t i = 0; i < chart.layers[l].entries.size(); i++)
+      byChord[chart.layers[l].entries[i].chord] = &chart.layers[l].entries[i];
+    for (int chord = 1; chord < 128; chord++) {
+      const ChartEntry *e = byChord.count(chord) ? byChord[chord] : 0;
+      if (e && !isMovable(e->code)) continue;
+      Slot s;
+      s.layer = l;
+      s.chord = chord;
+      s.switches = l == 1;
+      s.fingers = fingers(chord) + s.switches * toNumsym;
+      s.cost = s.fingers + s.switches * switchWeight;
+      s.holder = e ? (int)items.size() : -1;
+      s.taken = -1;
+      slots.push_back(s);
+      if (!e) continue;
+      Item item = { e, l, counts.chords[l][chord], (int)slots.size() - 1, -1 };
+      items.push_back(item);
+    }
+  }
+  std::sort(items.begin(), items.end(),
+            [&](const Item &a, const Item &b){ return byUse(a, b, slots); });
+  for (size_t i = 0; i < items.size(); i++) slots[items[i].slot].holder = i;
+
+  // the cheapest group of slots goes to the most used, those already in
+  // the group keeping their chord; what is never used only moves when
+  // its chord is taken
+  // cost -> slots, empty chords first, then by chord
+  std::map<int, std::vector<int> > groups;
+  for (size_t s = 0; s < slots.size(); s++) groups[slots[s].cost].push_back(s);
+  for (std::map<int, std::vector<int> >::iterator g = groups.begin(); g != groups.end(); ++g)
+    std::stable_sort(g->second.begin(), g->second.end(),
+                     [&](int a, int b){ return slots[a].holder < 0 && slots[b].holder >= 0; });
+  std::vector<int> remaining;
+  for (size_t i = 0; i < items.size(); i++)
+    if (items[i].count) remaining.push_back(i);
+
+  for (std::map<int, std::vector<int> >::const_iterator g = groups.begin();
+       g != groups.end() && !remaining.empty(); ++g) {
+    const std::vector<int> &group = g->second;
+    size_t room = std::min(group.size(), remaining.size());
+    unsigned long boundary = items[remaining[room - 1]].count;
+    // all above the boundary count, then at it those already in the
+    // group before those that would have to move
+    std::vector<int> chosen, ties, rest;
+    for (size_t r = 0; r < remaining.size(); r++) {
+      const Item &item = items[remaining[r]];
+      if (item.count > boundary) chosen.push_back(remaining[r]);
+      else if (item.count < boundary) rest.push_back(remaining[r]);
+      else ties.push_back(remaining[r]);
+    }
+    std::stable_partition(ties.begin(), ties.end(),
+                          [&](int t){ return slots[items[t].slot].cost == g->first; });
+    for (size_t t = 0; t < ties.size(); t++) {
+      if (chosen.size() < room) chosen.push_back(ties[t]);
+      else rest.push_back(ties[t]);
+    }
+    std::vector<int> newcomers;
+    for (size_t c = 0; c < chosen.size(); c++) {
+      Item &item = items[chosen[c]];
+      if (slots[item.slot].cost == g->first) {
+        item.placed = item.slot;
+        slots[item.slot].taken = chosen[c];
+      } else {
+        newcomers.push_back(chosen[c]);
+      }
+    }
+    size_t next = 0;
+    for (size_t n = 0; n < newcomers.size(); n++) {
+      while (slots[group[next]].taken >= 0) next++;
+      items[newcomers[n]].placed = group[next];
+      slots[group[next]].taken = newcomers[n];
+    }
+    std::sort(rest.begin(), rest.end(),
+              [&](int a, int b){ return byUse(items[a], items[b], slots); });
+    remaining = rest;
+  }
+
+  // the never used: their own chord if still free, else the cheapest one
+  std::vector<int> evicted;
+  for (size_t i = 0; i < items.size(); i++) {
+    Item &item = items[i];
+    if (item.placed >= 0) continue;
+    if (slots[item.slot].taken < 0) {
+      item.placed = item.slot;
+      slots[item.slot].taken = i;
+    } else {
+      evicted.push_back(i);
+    }
+  }
+  for (std::map<int, std::vector<int> >::const_iterator g = groups.begin();
+       g != groups.end() && !evicted.empty(); ++g) {
+    for (size_t s = 0; s < g->second.size() && !evicted.empty(); s++) {
+      if (slots[g->second[s]].taken >= 0) continue;
+      items[evicted.front()].placed = g->second[s];
+      slots[g->second[s]].taken = evicted.front();
+      evicted.erase(evicted.begin());
+    }
+  }
+
+  for (size_t i = 0; i < items.size(); i++) {
+    const Item &item = items[i];
+    addCost(plan.before, slots[item.slot], item.count);
+    addCost(plan.after, slots[item.placed], item.count);
+    if (item.placed == item.slot) continue;
+    LayoutMove move = { item.entry->code, item.count, item.layer, item.entry->chord,
+                        slots[item.placed].layer, slots[item.placed].chord };
+    plan.moves.push_back(move);
+  }
+  return plan;
+}
+
+//=====APPLY============================APPLY=======================
+static std::string chartLine(int chord, const ChartEntry &e){
+  std::string line = chordPattern(chord) + "  " + e.code;
+  if (!e.note.empty()) line += "  " + e.note;
+  return line;
+}
+
+std::string applyLayout(const std::string &chartText, const KeymapChart &chart,
+                        const LayoutPlan &plan){
+  std::vector<std::string> lines;
+  std::istringstream in(chartText);
+  for (std::string line; std::getline(in, line);) lines.push_back(line);
+
+  // what each moved-to chord gets, and which lines lose their code
+  std::map<int, const ChartEntry *> arriving;  // layer * 128 + chord
+  std::map<int, bool> leaving;                 // line
+  for (size_t m = 0; m < plan.moves.size(); m++) {
+    const LayoutMove &move = plan.moves[m];
+    const ChartLayer &from = chart.layers[move.fromLayer];
+    for (size_t i = 0; i < from.entries.size(); i++) {
+      if (from.entries[i].chord != move.fromChord) continue;
+      arriving[move.toLayer * 128 + move.toChord] = &from.entries[i];
+      leaving[from.entries[i].line] = true;
+    }
+  }
+
+  // a chord that had a line takes it over, the others go at the end of
+  // their layer
+  std::map<int, std::string> replaced;                 // line -> text
+  std::map<int, std::vector<std::string> > appended;  // after line
+  for (std::map<int, const ChartEntry *>::const_iterator a = arriving.begin(); a != arriving.end(); ++a) {
+    const ChartLayer &layer = chart.layers[a->first / 128];
+    int chord = a->first % 128, last = layer.line;
+    bool isPlaced = false;
+    for (size_t i = 0; i < layer.entries.size(); i++) {
+      last = std::max(last, layer.entries[i].line);
+      if (layer.entries[i].chord == chord) {
+        replaced[layer.entries[i].line] = chartLine(chord, *a->second);
+        isPlaced = true;
+      }
+    }
+    if (!isPlaced) appended[last].push_back(chartLine(chord, *a->second));
+  }
+
+  std::string out;
+  for (size_t i = 0; i < lines.size(); i++) {
+    int n = i + 1;
+    if (replaced.count(n)) out += replaced[n] + "\n";
+    else if (!leaving.count(n)) out += lines[i] + "\n";
+    for (size_t a = 0; appended.count(n) && a < appended[n].size(); a++)
+      out += appended[n][a] + "\n";
+  }
+  return out;
+}
@@ -0,0 +1,67 @@
+// LayoutOptimizer.h
+// Proposes a chord chart that is cheaper to type, from the usage counts
+// the board dumps (USAGE_DUMP, see Usage.h) against the chart it ran.
+// Used by tools/layout_optimizer.
+//
+// A use of a chord costs its finger count; one in NUMSYM also costs the
+// cheapest ALPHA chord that gets there (MODE_NUM or MULTI_NumShift) plus
+// switchWeight for the detour itself.  Only what types moves (ENUMKEY_,
+// MACRO_ and WORD_ codes in ALPHA and NUMSYM); modes, modifiers and
+// commands stay where they are.  With that cost the cheapest layout puts
+// the most used codes on the cheapest free chords; among equally good
+// ones the plan keeps as many codes where they were as it can, and codes
+// never used don't move unless their chord is wanted.
+
+#ifndef LAYOUT_OPTIMIZER_H
+#define LAYOUT_OPTIMIZER_H
+
+#include "KeymapCompiler.h"
+
+#include <string>
+#include <vector>
+
+// layers 0 ALPHA and 1 NUMSYM, as in Usage.h
+const int UsageCountLayers = 2;
+
+struct UsageCounts {
+  unsigned long chords[UsageCountLayers][128];
+  unsigned long modeKeys[4];  // num, numlck, func, numshift
+  unsigned long macros;
+  unsigned long words;
+  unsigned long function;
+  unsigned long halvings;
+};
+
+// the last dump in 'text', which can be a whole serial log; false and
+// "name: message" lines in 'errors' without one
+bool parseUsageDump(const std::string &name, const std::string &text, UsageCounts &counts,
+                    std::vector<std::string> &errors);
+
+struct LayoutMove {
+  std::string code;
+  unsigned long count;
+  int fromLayer, fromChord;
+  int toLayer, toChord;
+};
+
+// totals over the codes that type, per use
+struct LayoutCost {
+  unsigned long chars;     // uses
+  unsigned long fingers;   // switch chords included
+  unsigned long switches;  // detours through NUMSYM
+  unsigned long cost;      // fingers + switchWeight * switches
+};
+
+struct LayoutPlan {
+  std::vector<LayoutMove> moves;
+  LayoutCost before;
+  LayoutCost after;
+};
+
+// 'chart' parsed and checked (entries sorted by chord)
+LayoutPlan optimizeLayout(const KeymapChart &chart, const UsageCounts &counts, int switchWeight);
+// 'chartText' with the plan's moves made, notes moving with their codes
+std::string applyLayout(const std::string &chartText, const KeymapChart &chart,
+                        const LayoutPlan &plan);
+
+#endif
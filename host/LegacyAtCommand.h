@@ -0,0 +1,26 @@
+// LegacyAtCommand.h
+// The String based sendRawKeyDn() formatting the firmware used before
+// AtCommand.cpp, kept on the host as the reference the encoder is tested
+// and benchmarked against.  It built the command in two parts, the
+// constant prefix and the "MM-00-KK" tail, which went out as a
+// ble.print() and a ble.println().
+
+#ifndef LEGACY_AT_COMMAND_H
+#define LEGACY_AT_COMMAND_H
+
+#include <Arduino.h>
+
+const char LegacyKeyboardCodePrefix[] = "AT+BLEKEYBOARDCODE=";
+
+inline String legacyKeyboardCodeTail(char modKey, char rawKey){
+  // pad & trim modKey to ensure 2 digit hexidecimal is sent
+  String tmpModKey = "00" + String(modKey, HEX);
+  int modKeyLen = tmpModKey.length() - 2;
+  // pad & trim rawKey to ensure 2 digit hexidecimal is sent
+  String tmpRawKey = "00" + String(rawKey, HEX);
+  int rawKeyLen = tmpRawKey.length() - 2;
+
+  return String(&tmpModKey[modKeyLen]) + "-00-" + String(&tmpRawKey[rawKeyLen]);
+}
+
+#endif
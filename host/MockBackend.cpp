@@ -0,0 +1,65 @@
+// MockBackend.cpp
+// see MockBackend.h
+
+#include "MockBackend.h"
+
+#include <stdio.h>
+
+static std::vector<MockReport> reports;
+
+static void keyboard(byte modKey, byte rawKey){
+  MockReport r = MockReport();
+  hidKeyReport(r.key, modKey, rawKey);
+  reports.push_back(r);
+}
+
+static void consumer(uint16_t usage){
+  MockReport r = MockReport();
+  r.isConsumer = true;
+  r.usage = usage;
+  reports.push_back(r);
+}
+
+static void mockKeyDown(byte modKey, byte rawKey){
+  keyboard(modKey, rawKey);
+}
+
+static void mockKeyUp(){
+  keyboard(0, 0);
+}
+
+static void mockControl(const char *cntrlName){
+  unsigned int holdMs;
+  uint16_t usage = hidConsumerUsage(cntrlName, &holdMs);
+  if (!usage) return;
+  consumer(usage);
+  consumer(0);
+}
+
+const OutputBackend mockBackend = {
+  "mock", mockKeyDown, mockKeyUp, mockControl, 0, 0, 0, 0
+};
+
+const std::vector<MockReport> &mockReports(){
+  return reports;
+}
+
+std::string mockDescribe(){
+  std::string out;
+  char line[32];
+  for (size_t i = 0; i < reports.size(); i++) {
+    const MockReport &r = reports[i];
+    if (r.isConsumer) {
+      snprintf(line, sizeof(line), "consumer %04x\n", r.usage);
+    } else {
+      snprintf(line, sizeof(line), "%02x %02x %02x %02x %02x %02x %02x %02x\n", r.key[0], r.key[1],
+               r.key[2], r.key[3], r.key[4], r.key[5], r.key[6], r.key[7]);
+    }
+    out += line;
+  }
+  return out;
+}
+
+void mockReset(){
+  reports.clear();
+}
@@ -0,0 +1,29 @@
+// MockBackend.h
+// An output backend (OutputBackend.h) for host tests that keeps the HID
+// reports the USB backend would have sent, keyboard reports as their 8
+// bytes and consumer keys as the usage pressed then 0.  Like the USB one
+// it has no text() and no mouse.
+
+#ifndef MOCK_BACKEND_H
+#define MOCK_BACKEND_H
+
+#include "HidReport.h"
+#include "OutputBackend.h"
+
+#include <string>
+#include <vector>
+
+extern const OutputBackend mockBackend;
+
+struct MockReport {
+  bool isConsumer;
+  uint8_t key[HidKeyReportSize];  // keyboard report
+  uint16_t usage;                 // consumer report
+};
+
+const std::vector<MockReport> &mockReports();
+// the reports one to a line, "02 00 04 00 00 00 00 00" or "consumer 00cd"
+std::string mockDescribe();
+void mockReset();
+
+#endif
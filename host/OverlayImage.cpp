@@ -0,0 +1,196 @@
+// OverlayImage.cpp
+// see OverlayImage.h
+
+#include "OverlayImage.h"
+#include "KeymapOverlay.h"
+
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+
+static std::string where(const std::string &name, int line){
+  std::ostringstream s;
+  s << name << ":" << line << ": ";
+  return s.str();
+}
+
+// a code name, or a number
+static int codeValue(const std::string &word, const std::map<std::string, int> &codes){
+  std::map<std::string, int>::const_iterator named = codes.find(word);
+  if (named != codes.end()) return named->second;
+  char *end = 0;
+  long value = strtol(word.c_str(), &end, 0);
+  return !word.empty() && !*end && value >= 0 && value <= 0xFF ? (int)value : -1;
+}
+
+//=====BUILD============================BUILD======================
+bool buildOverlay(const std::string &name, const std::string &text, const KeymapChart &chart,
+                  const std::map<std::string, int> &codes, OverlayBytes &image,
+                  std::vector<std::string> &errors){
+  size_t before = errors.size();
+  std::vector<std::vector<unsigned char> > macros;  // the tap bytes of each slot
+  OverlayBytes entries;
+  std::map<int, int> seen;  // layer << 7 | chord -> line
+  int layer = -1;
+
+  std::istringstream in(text);
+  std::string line;
+  for (int number = 1; std::getline(in, line); number++) {
+    if (!line.empty() && line[line.size() - 1] == '\r') line.erase(line.size() - 1);
+    std::istringstream words(line);
+    std::string first;
+    if (!(words >> first) || first[0] == '#') continue;
+
+    if (first == "layer") {
+      std::string mode;
+      words >> mode;
+      layer = -1;
+      for (size_t l = 0; l < chart.layers.size(); l++)
+        if (chart.layers[l].mode == mode) layer = l;
+      if (layer < 0 || layer >= OverlayLayers)
+        errors.push_back(where(name, number) + "no layer " + mode + " in the chart");
+    } else if (first == "macro") {
+      int slot = -1;
+      words >> slot;
+      if (!words || slot < 0 || slot >= OverlayMacros) {
+        errors.push_back(where(name, number) + "a macro slot is 0 to " +
+                         std::to_string(OverlayMacros - 1));
+        continue;
+      }
+      if ((int)macros.size() <= slot) macros.resize(slot + 1);
+      std::vector<unsigned char> &taps = macros[slot];
+      taps.clear();
+      std::string tap;
+      while (words >> tap) {
+        unsigned int mod, key;
+        char dash;
+        if (sscanf(tap.c_str(), "%2x%c%2x", &mod, &dash, &key) != 3 || dash != '-' ||
+            tap.size() != 5) {
+          errors.push_back(where(name, number) + "a tap is MM-KK in hex, not " + tap);
+          break;
+        }
+        taps.push_back(mod);
+        taps.push_back(key);
+      }
+      if (taps.size() > 2u * OverlayMacroTaps)
+        errors.push_back(where(name, number) + "more than " + std::to_string(OverlayMacroTaps) +
+                         " taps");
+    } else {
+      std::string second, code;
+      words >> second >> code;
+      int chord = parseChordPattern(first + " " + second);
+      int value = codeValue(code, codes);
+      if (chord <= 0) {
+        errors.push_back(where(name, number) + "not a chord: " + line);
+      } else if (value < 0) {
+        errors.push_back(where(name, number) + code + " is not in KeyCodes.h");
+      } else if (layer < 0) {
+        errors.push_back(where(name, number) + "a chord before any layer line");
+      } else if (seen.count(layer << 7 | chord)) {
+        errors.push_back(where(name, number) + chordPattern(chord) + " is already on line " +
+                         std::to_string(seen[layer << 7 | chord]));
+      } else {
+        seen[layer << 7 | chord] = number;
+        entries.push_back(layer);
+        entries.push_back(chord);
+        entries.push_back(value);
+      }
+    }
+  }
+  if (entries.size() > 3u * OverlayMaxEntries)
+    errors.push_back(name + ": more than " + std::to_string(OverlayMaxEntries) + " chords");
+  if (errors.size() != before) return false;
+
+  image.assign(OverlayHeaderSize, 0);
+  image[0] = OverlayMagic;
+  image[1] = OverlayVersion;
+  image[2] = macros.size();
+  image[3] = entries.size() / 3;
+  for (size_t m = 0; m < macros.size(); m++) {
+    image.push_back(macros[m].size() / 2);
+    image.insert(image.end(), macros[m].begin(), macros[m].end());
+  }
+  image.insert(image.end(), entries.begin(), entries.end());
+  if (OverlayEepromStart + image.size() > OverlayEepromEnd) {
+    errors.push_back(name + ": the overlay doesn't fit in the EEPROM");
+    return false;
+  }
+  // Fletcher-16 as in KeymapOverlay.cpp
+  unsigned int a = 0x5A, b = 0xA5;
+  for (size_t i = 2; i < image.size(); i++) {
+    if (i == 4) i = OverlayHeaderSize;
+    if (i == image.size()) break;
+    a = (a + image[i]) % 255;
+    b = (b + a) % 255;
+  }
+  image[4] = a;
+  image[5] = b;
+  return true;
+}
+
+//=====INTEL HEX========================INTEL HEX==================
+std::string overlayHex(const OverlayBytes &image){
+  std::string hex;
+  char record[48];
+  for (size_t at = 0; at < image.size(); at += 16) {
+    size_t n = image.size() - at < 16 ? image.size() - at : 16;
+    unsigned int address = OverlayEepromStart + at;
+    unsigned int sum = n + (address >> 8) + (address & 0xFF);
+    char *p = record + sprintf(record, ":%02X%04X00", (unsigned)n, address);
+    for (size_t i = 0; i < n; i++) {
+      p += sprintf(p, "%02X", image[at + i]);
+      sum += image[at + i];
+    }
+    sprintf(p, "%02X\n", -sum & 0xFF);
+    hex += record;
+  }
+  return hex + ":00000001FF\n";
+}
+
+bool parseOverlayHex(const std::string &name, const std::string &text, OverlayBytes &image,
+                     std::vector<std::string> &errors){
+  image.clear();
+  std::istringstream in(text);
+  std::string line;
+  for (int number = 1; std::getline(in, line); number++) {
+    if (!line.empty() && line[line.size() - 1] == '\r') line.erase(line.size() - 1);
+    if (line.empty()) continue;
+    std::vector<unsigned int> bytes;
+    unsigned int byte, sum = 0;
+    for (size_t i = 1; line[0] == ':' && i + 1 < line.size(); i += 2) {
+      if (sscanf(line.c_str() + i, "%2x", &byte) != 1) break;
+      bytes.push_back(byte);
+      sum += byte;
+    }
+    if (line[0] != ':' || line.size() % 2 == 0 || bytes.size() < 5 ||
+        bytes.size() != bytes[0] + 5u || sum & 0xFF) {
+      errors.push_back(where(name, number) + "not an Intel hex record");
+      return false;
+    }
+    if (bytes[3] == 1) return true;  // end of file
+    if (bytes[3] != 0) {
+      errors.push_back(where(name, number) + "only data records go in the EEPROM");
+      return false;
+    }
+    unsigned int address = bytes[1] << 8 | bytes[2];
+    if (address < OverlayEepromStart || address + bytes[0] > OverlayEepromEnd) {
+      errors.push_back(where(name, number) + "data outside the overlay");
+      return false;
+    }
+    size_t at = address - OverlayEepromStart;
+    if (image.size() < at + bytes[0]) image.resize(at + bytes[0], 0xFF);
+    for (unsigned int i = 0; i < bytes[0]; i++) image[at + i] = bytes[4 + i];
+  }
+  errors.push_back(name + ": no end of file record");
+  return false;
+}
+
+//=====LOAD=============================LOAD========================
+int loadOverlay(const OverlayBytes &image){
+  for (unsigned int addr = OverlayEepromStart; addr < OverlayEepromEnd; addr++) {
+    size_t at = addr - OverlayEepromStart;
+    halEepromWrite(addr, at < image.size() ? image[at] : 0xFF);
+  }
+  overlayInit();
+  return overlayStats.status;
+}
@@ -0,0 +1,44 @@
+// OverlayImage.h
+// Makes EEPROM images of the keymap overlay (KeymapOverlay.h) from a text
+// file, and reads them back.  Used by tools/overlay_image.
+//
+// Overlay syntax, '#' starts a comment line:
+//   layer <MODE>
+//       the layer the chords after it are in, a layer of the chart
+//   <FCN IMRP> <code>
+//       a chord and what it types instead of the chart's code, a
+//       KeyCodes.h name or a number (0x2E)
+//   macro <slot> <MM-KK> ...
+//       the taps of OVERLAY_MACRO_<slot>, each a modifier and a key in
+//       hex as in AT+BLEKEYBOARDCODE
+//
+// The image is the bytes from OverlayEepromStart; in Intel hex it is at
+// that address, as avrdude writes the EEPROM (-U eeprom:w:overlay.hex).
+
+#ifndef OVERLAY_IMAGE_H
+#define OVERLAY_IMAGE_H
+
+#include "KeymapCompiler.h"
+
+#include <string>
+#include <vector>
+
+typedef std::vector<unsigned char> OverlayBytes;
+
+// false and "name:line: message" lines in 'errors' when the overlay has
+// mistakes or doesn't fit; 'codes' from keyCodeValues()
+bool buildOverlay(const std::string &name, const std::string &text, const KeymapChart &chart,
+                  const std::map<std::string, int> &codes, OverlayBytes &image,
+                  std::vector<std::string> &errors);
+
+std::string overlayHex(const OverlayBytes &image);
+// false and "name: message" lines in 'errors' for a bad record, or data
+// outside the overlay
+bool parseOverlayHex(const std::string &name, const std::string &text, OverlayBytes &image,
+                     std::vector<std::string> &errors);
+
+// writes 'image' into the host EEPROM and loads it with overlayInit(),
+// as the board does at boot; the OverlayStatus
+int loadOverlay(const OverlayBytes &image);
+
+#endif
@@ -0,0 +1,170 @@
+// StackEstimate.cpp
+// see StackEstimate.h
+
+#include "StackEstimate.h"
+
+#include <algorithm>
+#include <sstream>
+#include <stdlib.h>
+
+//=====NAMES============================NAMES=======================
+std::string functionName(const std::string &declaration){
+  // the name is what comes before the parameter list, less the return type
+  size_t open = declaration.find('(');
+  std::string head = declaration.substr(0, open);
+  // "operator()" and friends keep their parentheses
+  if (head.size() >= 8 && head.compare(head.size() - 8, 8, "operator") == 0 && open != std::string::npos) {
+    size_t close = declaration.find(')', open);
+    open = declaration.find('(', close);
+    head = declaration.substr(0, open);
+  }
+  // back to the space before it, stepping over any <template, arguments>
+  int nesting = 0;
+  for (size_t i = head.size(); i-- > 0;) {
+    char c = head[i];
+    if (c == '>') nesting++;
+    else if (c == '<') nesting--;
+    else if (nesting == 0 && (c == ' ' || c == '*' || c == '&')) return head.substr(i + 1);
+  }
+  return head;
+}
+
+//=====STACK USAGE======================STACK USAGE=================
+void parseStackUsage(const std::string &text, CallGraph &graph){
+  std::istringstream in(text);
+  std::string line;
+  while (std::getline(in, line)) {
+    // file:line:column:declaration TAB bytes TAB qualifiers
+    size_t tab = line.find('\t');
+    if (tab == std::string::npos) continue;
+    std::string where = line.substr(0, tab);
+    size_t colon = where.find(':');
+    for (int i = 0; i < 2 && colon != std::string::npos; i++) colon = where.find(':', colon + 1);
+    if (colon == std::string::npos) continue;
+    std::string name = functionName(where.substr(colon + 1));
+    unsigned bytes = strtoul(line.c_str() + tab + 1, 0, 10);
+    StackFunction &f = graph[name];
+    if (!f.hasFrame || bytes > f.frame) f.frame = bytes;
+    f.hasFrame = true;
+    if (line.find("dynamic", tab) != std::string::npos) f.isDynamic = true;
+  }
+}
+
+//=====DISASSEMBLY======================DISASSEMBLY=================
+// the symbol in "<name>" or "<name+0x12>"
+static std::string symbolIn(const std::string &line, size_t from, bool *hasOffset){
+  size_t open = line.find('<', from);
+  size_t close = line.rfind('>');
+  if (open == std::string::npos || close == std::string::npos || close < open) return "";
+  std::string symbol = line.substr(open + 1, close - open - 1);
+  size_t plus = symbol.rfind("+0x");
+  if (hasOffset) *hasOffset = plus != std::string::npos;
+  return plus == std::string::npos ? symbol : symbol.substr(0, plus);
+}
+
+void parseDisassembly(const std::string &text, CallGraph &graph){
+  std::istringstream in(text);
+  std::string line, current;
+  while (std::getline(in, line)) {
+    if (line.empty()) continue;
+    // "00000abc <sendKey(unsigned char)>:"
+    if (line[line.size() - 1] == ':' && isxdigit((unsigned char)line[0])) {
+      current = functionName(symbolIn(line, 0, 0));
+      graph[current];
+      continue;
+    }
+    if (current.empty()) continue;
+    // "     abc:	0e 94 12 34 	call	0x2468	; 0x2468 <sendRawKeyDn(char, char)>"
+    size_t tab = line.find('\t');
+    if (tab == std::string::npos) continue;
+    tab = line.find('\t', tab + 1);
+    if (tab == std::string::npos) continue;
+    std::string op = line.substr(tab + 1, line.find_first_of(" \t", tab + 1) - tab - 1);
+    if (op == "icall" || op == "eicall" || op == "ijmp" || op == "eijmp") {
+      graph[current].callsIndirect = true;
+      continue;
+    }
+    if (op != "call" && op != "rcall" && op != "jmp" && op != "rjmp") continue;
+    size_t comment = line.find(';', tab);
+    if (comment == std::string::npos) continue;
+    bool hasOffset = false;
+    std::string target = functionName(symbolIn(line, comment, &hasOffset));
+    // a jump inside the function, or into the middle of another, is a branch
+    if (target.empty() || target == current || hasOffset) continue;
+    graph[current].callees.insert(target);
+  }
+}
+
+//=====DEPTH============================DEPTH=======================
+namespace {
+
+struct Walk {
+  const CallGraph &graph;
+  std::map<std::string, unsigned> done;      // deepest chain from a function
+  std::map<std::string, std::string> next;   // and the callee it goes through
+  std::set<std::string> onPath;
+  StackDepth &depth;
+
+  Walk(const CallGraph &g, StackDepth &d) : graph(g), depth(d) {}
+
+  static void note(std::vector<std::string> &list, const std::string &name){
+    if (std::find(list.begin(), list.end(), name) == list.end()) list.push_back(name);
+  }
+
+  unsigned deepest(const std::string &name){
+    std::map<std::string, unsigned>::const_iterator known = done.find(name);
+    if (known != done.end()) return known->second;
+    CallGraph::const_iterator it = graph.find(name);
+    if (it == graph.end()) {
+      note(depth.unknown, name);
+      return done[name] = 0;
+    }
+    const StackFunction &f = it->second;
+    if (!f.hasFrame) note(depth.unknown, name);
+    if (f.callsIndirect) note(depth.indirect, name);
+    if (f.isDynamic) note(depth.dynamic, name);
+
+    onPath.insert(name);
+    unsigned most = 0;
+    std::string through;
+    for (std::set<std::string>::const_iterator c = f.callees.begin(); c != f.callees.end(); ++c) {
+      if (onPath.count(*c)) {
+        note(depth.recursive, *c);
+        continue;
+      }
+      unsigned d = ReturnAddressBytes + deepest(*c);
+      if (d > most) most = d, through = *c;
+    }
+    onPath.erase(name);
+    next[name] = through;
+    return done[name] = f.frame + most;
+  }
+
+  std::vector<std::string> pathFrom(std::string name){
+    std::vector<std::string> path;
+    while (!name.empty() && path.size() < graph.size() + 1) {
+      path.push_back(name);
+      name = next[name];
+    }
+    return path;
+  }
+};
+
+}
+
+bool estimateStack(const CallGraph &graph, const std::string &root, StackDepth &depth){
+  depth = StackDepth();
+  if (!graph.count(root)) return false;
+  Walk walk(graph, depth);
+  depth.bytes = walk.deepest(root);
+  depth.path = walk.pathFrom(root);
+
+  // an interrupt pushes its return address and then its own frame
+  depth.interruptBytes = 0;
+  for (CallGraph::const_iterator it = graph.begin(); it != graph.end(); ++it) {
+    if (it->first.compare(0, 9, "__vector_") != 0) continue;
+    unsigned d = ReturnAddressBytes + walk.deepest(it->first);
+    if (d > depth.interruptBytes) depth.interruptBytes = d, depth.interrupt = it->first;
+  }
+  return true;
+}
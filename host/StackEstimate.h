@@ -0,0 +1,59 @@
+// StackEstimate.h
+// Worst-case stack depth of the firmware from what avr-gcc leaves behind:
+// the frame of each function from -fstack-usage (.su files) and who calls
+// whom from avr-objdump -d -C.  Used by tools/stack_depth for the
+// memory budget (tools/memory_budget.sh).
+//
+// The estimate is the deepest chain of frames from a root (main), each
+// call adding its return address, plus the deepest interrupt handler on
+// top since one can fire anywhere.  Functions are matched by name
+// without their parameters, so overloads share the biggest frame.  Calls
+// through a pointer (icall) and functions with no .su line (libgcc, asm)
+// can't be followed; they are listed with the result rather than guessed.
+
+#ifndef STACK_ESTIMATE_H
+#define STACK_ESTIMATE_H
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+// AVR call/rcall push a 2 byte return address on parts with <= 128 KB
+const unsigned ReturnAddressBytes = 2;
+
+struct StackFunction {
+  unsigned frame;             // bytes, from the .su file
+  bool hasFrame;              // there was a .su line for it
+  bool isDynamic;             // 'dynamic' in the .su file, alloca or VLA
+  bool callsIndirect;         // has an icall/eicall
+  std::set<std::string> callees;
+  StackFunction() : frame(0), hasFrame(false), isDynamic(false), callsIndirect(false) {}
+};
+
+typedef std::map<std::string, StackFunction> CallGraph;
+
+// "Chorder.cpp:121:6:void sendKey(byte)\t16\tstatic", any number of lines
+void parseStackUsage(const std::string &text, CallGraph &graph);
+// avr-objdump -d -C output
+void parseDisassembly(const std::string &text, CallGraph &graph);
+
+// "void sendKey(byte)" and "sendKey(unsigned char)" -> "sendKey"
+std::string functionName(const std::string &declaration);
+
+struct StackDepth {
+  unsigned bytes;                  // root chain, return addresses included
+  std::vector<std::string> path;   // root first
+  unsigned interruptBytes;         // deepest __vector_ handler
+  std::string interrupt;
+  std::vector<std::string> recursive;   // functions on a call cycle
+  std::vector<std::string> unknown;     // reached, no .su line
+  std::vector<std::string> indirect;    // reached, call through a pointer
+  std::vector<std::string> dynamic;     // reached, dynamic frame
+  unsigned total() const { return bytes + interruptBytes; }
+};
+
+// false when 'root' isn't in the graph
+bool estimateStack(const CallGraph &graph, const std::string &root, StackDepth &depth);
+
+#endif
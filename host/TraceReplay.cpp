@@ -0,0 +1,174 @@
+// TraceReplay.cpp
+// see TraceReplay.h
+
+#include "TraceReplay.h"
+#include "ChordDriver.h"
+#include "Chorder.h"
+#include "Debounce.h"
+#include "KeyCodes.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//=====PARSE============================PARSE=======================
+static const char kindLetters[] = "rscdut";
+
+static bool parseEvent(const std::string &line, TraceEvent &e){
+  char kind;
+  unsigned ms, a = 0, b = 0;
+  int n = sscanf(line.c_str(), "%u %c %x %x", &ms, &kind, &a, &b);
+  if (n < 2) return false;
+  const char *at = strchr(kindLetters, kind);
+  if (!at || !kind) return false;
+  e.ms = ms;
+  e.kind = at - kindLetters;
+  e.a = a;
+  e.b = b;
+  return true;
+}
+
+bool parseTrace(const std::string &text, TraceLog &trace, std::string *error){
+  trace = TraceLog();
+  bool inTrace = false;
+  unsigned long base = 0, last = 0;
+  size_t at = 0;
+  while (at < text.size()) {
+    size_t end = text.find('\n', at);
+    if (end == std::string::npos) end = text.size();
+    std::string line = text.substr(at, end - at);
+    at = end + 1;
+    if (!line.empty() && line[line.size() - 1] == '\r') line.erase(line.size() - 1);
+
+    if (!inTrace) {
+      unsigned entries, eager, held;
+      long debounceMs;
+      unsigned hold, rollover;
+      if (sscanf(line.c_str(), "trace %u debounce %ld eager %x hold %u rollover %u held %x",
+                 &entries, &debounceMs, &eager, &hold, &rollover, &held) == 6) {
+        inTrace = true;
+        trace.debounceMs = debounceMs;
+        trace.eager = eager;
+        trace.holdMs = hold;
+        trace.rollover = rollover;
+        trace.held = held;
+        unsigned repeat = 0, layers = 0;
+        const char *more = strstr(line.c_str(), " repeat ");
+        if (more) sscanf(more, " repeat %u layers %x", &repeat, &layers);
+        trace.repeatMs = repeat;
+        trace.repeatLayers = layers;
+      }
+      continue;
+    }
+    if (line == "end") return true;
+    TraceEvent e;
+    if (!parseEvent(line, e)) {
+      if (error) *error = "bad trace line: " + line;
+      return false;
+    }
+    // the board keeps 16 bits of ms, unwrap them
+    unsigned long ms = base + e.ms;
+    if (!trace.events.empty() && ms < last) {
+      base += 0x10000;
+      ms += 0x10000;
+    }
+    e.ms = last = ms;
+    trace.events.push_back(e);
+  }
+  if (error) *error = inTrace ? "trace has no end line" : "no trace found";
+  return false;
+}
+
+//=====REPLAY===========================REPLAY======================
+static bool isOutput(const TraceEvent &e){
+  return e.kind >= TRACE_CHORD;
+}
+
+// the replay starts a while in so the debounce has settled
+const unsigned long ReplayLeadMs = 1000;
+
+ReplayResult replayTrace(const TraceLog &trace, unsigned long scanMicros){
+  ReplayResult result;
+  result.raw = 0;
+  result.firstDiff = std::string::npos;
+  result.shiftMs = 0;
+
+  // the first time every switch is up, debounced, and nothing is queued
+  size_t start = 0;
+  while (start < trace.events.size() &&
+         !(trace.events[start].kind == TRACE_STABLE && trace.events[start].a == 0)) start++;
+  if (start == trace.events.size()) return result;
+  unsigned long startMs = trace.events[start].ms;
+
+  driverReset();
+  scanTickMicros = scanMicros;
+  debounceDelay = trace.debounceMs;
+  eagerSwitches = trace.eager;
+  holdDwellMs = trace.holdMs;
+  rolloverChords = trace.rollover;
+  rolloverHeldSwitches = trace.held;
+  repeatHoldMs = trace.repeatMs;
+  repeatLayers = trace.repeatLayers;
+
+  unsigned long seen = traceSeq();
+  // run the core to 'ms' (trace time), keeping what it records
+  std::vector<TraceEvent> &replayed = result.replayed;
+  auto runTo = [&](unsigned long ms){
+    unsigned long until = (ms - startMs + ReplayLeadMs) * 1000;
+    while (hostMicros() < until) {
+      chorderLoop();
+      unsigned long now = traceSeq();
+      byte fresh = now - seen < traceCount() ? now - seen : traceCount();
+      for (byte i = traceCount() - fresh; i < traceCount(); i++) {
+        const TraceEntry &t = traceEntry(i);
+        TraceEvent e = { halMillis() - ReplayLeadMs + startMs, t.kind, t.a, t.b };
+        if (isOutput(e)) replayed.push_back(e);
+      }
+      seen = now;
+      hostAdvanceMicros(scanTickMicros);
+    }
+  };
+
+  for (size_t i = start + 1; i < trace.events.size(); i++) {
+    const TraceEvent &e = trace.events[i];
+    if (isOutput(e)) result.recorded.push_back(e);
+    if (e.kind != TRACE_RAW) continue;
+    runTo(e.ms);
+    hostSetSwitches(e.a);
+    result.raw++;
+  }
+  runTo(trace.events.back().ms + 1000 + trace.holdMs);
+  // the trace was dumped there, whatever came after isn't in it
+  for (size_t i = 0; i < replayed.size(); i++) {
+    if (replayed[i].kind == TRACE_CHORD && replayed[i].b == TRACE_DUMP) {
+      replayed.resize(i + 1);
+      break;
+    }
+  }
+
+  // compare kinds and values, the times only for how far they moved
+  size_t n = result.recorded.size() < replayed.size() ? result.recorded.size() : replayed.size();
+  size_t downs = 0;
+  for (size_t i = 0; i < n; i++) {
+    const TraceEvent &r = result.recorded[i], &p = replayed[i];
+    if (r.kind != p.kind || r.a != p.a || r.b != p.b) {
+      result.firstDiff = i;
+      break;
+    }
+    if (r.kind == TRACE_DOWN) {
+      result.shiftMs += (double)p.ms - (double)r.ms;
+      downs++;
+    }
+  }
+  if (result.firstDiff == std::string::npos && result.recorded.size() != replayed.size())
+    result.firstDiff = n;
+  if (downs) result.shiftMs /= downs;
+  return result;
+}
+
+std::string describeEvent(const TraceEvent &e){
+  char text[16];
+  TraceEntry t = { 0, e.kind, e.a, e.b };
+  traceLine(text, t);
+  return strchr(text, ' ') + 1;  // without the time
+}
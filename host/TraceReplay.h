@@ -0,0 +1,56 @@
+// TraceReplay.h
+// Reads a trace dumped by TRACE_DUMP (see Trace.h) and feeds its raw
+// switch changes back through the chorder core, so what the core does
+// with them now (other settings, a changed state machine) can be set
+// against what the board did.  Used by tools/chord_replay.
+
+#ifndef TRACE_REPLAY_H
+#define TRACE_REPLAY_H
+
+#include "HostHal.h"
+#include "Trace.h"
+
+#include <string>
+#include <vector>
+
+struct TraceEvent {
+  unsigned long ms;  // unwrapped, from the first event
+  byte kind;         // TraceKind
+  byte a;
+  byte b;
+};
+
+// the settings from the dump's header line and its events
+struct TraceLog {
+  long debounceMs;
+  byte eager;
+  unsigned int holdMs;
+  bool rollover;
+  byte held;
+  unsigned int repeatMs;  // 0 in traces from before hold to repeat
+  byte repeatLayers;
+  std::vector<TraceEvent> events;
+};
+
+// parses the first trace in 'text'; other lines (a serial log around
+// it) are skipped.  False with 'error' set if there is no whole trace.
+bool parseTrace(const std::string &text, TraceLog &trace, std::string *error);
+
+struct ReplayResult {
+  size_t raw;                          // raw changes fed in
+  std::vector<TraceEvent> recorded;    // chords and reports, from the trace
+  std::vector<TraceEvent> replayed;    // and from the replay
+  size_t firstDiff;                    // where they part, or npos
+  double shiftMs;                      // replayed - recorded key down time,
+                                       // on average over matching reports
+};
+
+// replays 'trace' with its own settings, or whatever the caller put in
+// it, from the first point where the trace has every switch up; the core
+// is reset first and scanned every 'scanMicros'
+ReplayResult replayTrace(const TraceLog &trace, unsigned long scanMicros = 100);
+
+// "c 2e 04", "d 00 04", "u", "t"
+std::string describeEvent(const TraceEvent &e);
+
+#endif
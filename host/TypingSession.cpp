@@ -0,0 +1,191 @@
+// TypingSession.cpp
+// see TypingSession.h
+
+#include "TypingSession.h"
+#include "BluefruitEmulator.h"
+#include "ChordDriver.h"
+#include "Chorder.h"
+#include "KeyCodes.h"
+#include "Keymap.h"
+
+#include <algorithm>
+#include <stdlib.h>
+#include <string.h>
+
+//                                 land   hold          lift   gap           roll
+const Typist steadyTypist  = { 15000, 75000, 60000, 15000, 40000, 40000, 0,    0 };
+const Typist fastTypist    = { 12000, 35000, 30000, 10000, 15000, 25000, 0,    0 };
+const Typist rollingTypist = { 12000, 35000, 30000, 10000, 15000, 25000, 3000, 8000 };
+
+// small deterministic generator so every run types the same stream
+static unsigned long rngState = 1;
+
+void sessionSeed(unsigned long seed){
+  rngState = seed;
+}
+
+unsigned long sessionRandom(unsigned long range){
+  rngState = rngState * 1103515245ul + 12345ul;
+  return ((rngState >> 16) & 0x7fff) % range;
+}
+
+//=====TEXT=============================TEXT========================
+byte chordFor(char c){
+  keymap_t wanted = c == ' ' ? ENUMKEY_spc : ENUMKEY_A + (c - 'a');
+  for (int chord = 1; chord < 128; chord++) {
+    if (keymapLookup(0, chord) == wanted) return chord;
+  }
+  return 0;
+}
+
+std::string decodeTyped(const std::string &traffic){
+  std::string typed;
+  const char *prefix = "AT+BLEKEYBOARDCODE=";
+  size_t pos = 0;
+  while ((pos = traffic.find(prefix, pos)) != std::string::npos) {
+    pos += strlen(prefix);
+    size_t eol = traffic.find('\r', pos);
+    std::string args = traffic.substr(pos, eol - pos);
+    if (args.size() == 8) {
+      int key = strtol(args.substr(6, 2).c_str(), 0, 16);
+      if (key == ENUMKEY_spc) typed += ' ';
+      else if (key >= ENUMKEY_A && key <= ENUMKEY_Z) typed += (char)('a' + key - ENUMKEY_A);
+      else typed += '?';
+    }
+    pos = eol;
+  }
+  return typed;
+}
+
+static unsigned long editDistance(const std::string &a, const std::string &b){
+  std::vector<unsigned long> row(b.size() + 1);
+  for (size_t j = 0; j <= b.size(); j++) row[j] = j;
+  for (size_t i = 1; i <= a.size(); i++) {
+    unsigned long diagonal = row[0];
+    row[0] = i;
+    for (size_t j = 1; j <= b.size(); j++) {
+      unsigned long above = row[j];
+      row[j] = std::min(std::min(row[j] + 1, row[j - 1] + 1),
+                        diagonal + (a[i - 1] != b[j - 1]));
+      diagonal = above;
+    }
+  }
+  return row[b.size()];
+}
+
+//=====FINGERS==========================FINGERS=====================
+// each finger chatters a little on both edges
+std::vector<FingerEvent> fingerEvents(byte chord, unsigned long start, const Typist &typist,
+                                      unsigned long *lastDown, unsigned long *firstUp,
+                                      const unsigned long *notBefore){
+  std::vector<FingerEvent> events;
+  unsigned long liftStart = start + typist.holdMin + sessionRandom(typist.holdSpread);
+  *lastDown = start;
+  *firstUp = (unsigned long)-1;
+  for (byte bit = 0; bit < NumSwitches; bit++) {
+    if (!(chord & (1 << bit))) continue;
+    unsigned long down = start + sessionRandom(typist.landSpread);
+    unsigned long up = liftStart + sessionRandom(typist.liftSpread);
+    if (notBefore && down < notBefore[bit]) {
+      up += notBefore[bit] - down;
+      down = notBefore[bit];
+    }
+    for (unsigned long b = sessionRandom(4), t = down; b > 0; b--) {
+      FingerEvent on = { t, bit, true }, off = { t + 300, bit, false };
+      events.push_back(on);
+      events.push_back(off);
+      t += 300 + sessionRandom(700);
+      down = t;
+    }
+    FingerEvent d = { down, bit, true };
+    events.push_back(d);
+    unsigned long finalUp = up;
+    for (unsigned long b = sessionRandom(3), t = up; b > 0; b--) {
+      FingerEvent off = { t, bit, false }, on = { t + 200, bit, true };
+      events.push_back(off);
+      events.push_back(on);
+      t += 200 + sessionRandom(500);
+      finalUp = t;
+    }
+    FingerEvent u = { finalUp, bit, false };
+    events.push_back(u);
+    *lastDown = std::max(*lastDown, down);
+    *firstUp = std::min(*firstUp, up);
+  }
+  std::stable_sort(events.begin(), events.end(),
+                   [](const FingerEvent &a, const FingerEvent &b) { return a.atMicros < b.atMicros; });
+  return events;
+}
+
+//=====PLAY=============================PLAY========================
+SessionResult playSession(const char *text, unsigned long chords, const Typist &typist){
+  SessionResult result;
+  size_t textLen = strlen(text);
+  unsigned long begin = hostMicros();
+
+  // every finger event of the session first, chords may overlap
+  std::vector<FingerEvent> events;
+  std::vector<unsigned long> lastDowns, firstUps;
+  unsigned long freeAt[NumSwitches] = { 0 };
+  unsigned long start = begin;
+  for (unsigned long n = 0; n < chords; n++) {
+    char c = text[n % textLen];
+    result.intended += c;
+    unsigned long lastDown, firstUp;
+    std::vector<FingerEvent> chord = fingerEvents(chordFor(c), start, typist,
+                                                  &lastDown, &firstUp, freeAt);
+    lastDowns.push_back(lastDown);
+    firstUps.push_back(firstUp);
+    for (size_t i = 0; i < chord.size(); i++) {
+      freeAt[chord[i].bit] = chord[i].atMicros + 1000;
+      events.push_back(chord[i]);
+    }
+    if (typist.rollMin) start = firstUp + typist.rollMin + sessionRandom(typist.rollSpread);
+    else start = chord.back().atMicros + typist.gapMin + sessionRandom(typist.gapSpread);
+  }
+  std::stable_sort(events.begin(), events.end(),
+                   [](const FingerEvent &a, const FingerEvent &b) { return a.atMicros < b.atMicros; });
+
+  std::vector<unsigned long> keyTimes;
+  std::string traffic;
+  bool isModule = bluefruitAttached();
+  size_t typedBefore = bluefruitTyped().size();
+  unsigned long end = events.back().atMicros + 100000;
+  byte switches = 0;
+  size_t next = 0;
+  while (hostMicros() < end) {
+    while (next < events.size() && events[next].atMicros <= hostMicros()) {
+      if (events[next].down) switches |= 1 << events[next].bit;
+      else switches &= ~(1 << events[next].bit);
+      next++;
+    }
+    hostSetSwitches(switches);
+    unsigned long passStart = hostMicros();
+    chorderLoop();
+    hostAdvanceMicros(scanTickMicros);
+    if (hostTraffic().empty()) continue;
+    if (isModule) {
+      hostClearTraffic();
+      continue;
+    }
+    size_t keys = decodeTyped(hostTraffic()).size();
+    for (size_t k = 0; k < keys; k++) keyTimes.push_back(passStart);
+    traffic += hostTraffic();
+    hostClearTraffic();
+  }
+
+  if (isModule) {
+    // what the module typed, from the session on
+    result.typed = bluefruitTyped().substr(typedBefore);
+    keyTimes.assign(bluefruitTypedAt().begin() + typedBefore, bluefruitTypedAt().end());
+  } else {
+    result.typed = decodeTyped(traffic);
+  }
+  result.errors = editDistance(result.typed, result.intended);
+  for (size_t i = 0; i < keyTimes.size() && i < lastDowns.size(); i++) {
+    result.landingToKey.push_back(((double)keyTimes[i] - lastDowns[i]) / 1000.0);
+    result.liftToKey.push_back(((double)keyTimes[i] - firstUps[i]) / 1000.0);
+  }
+  result.micros = hostMicros() - begin;
+  return result;
+}
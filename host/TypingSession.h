@@ -0,0 +1,72 @@
+// TypingSession.h
+// Typing sessions to replay through the chorder core on the host: text
+// turned into per finger switch events with human-like timing (fingers
+// land and lift at their own times, contacts bounce), from a fixed seed
+// so every run types the same.  Text is lower case letters and spaces,
+// typed with the default layer.
+
+#ifndef TYPING_SESSION_H
+#define TYPING_SESSION_H
+
+#include "HostHal.h"
+
+#include <string>
+#include <vector>
+
+// timing of one typist, all in us
+struct Typist {
+  unsigned long landSpread;  // the fingers of a chord land within this
+  unsigned long holdMin;     // from the start of the landing to the lifting
+  unsigned long holdSpread;
+  unsigned long liftSpread;  // and lift within this
+  unsigned long gapMin;      // from the last finger up to the next chord
+  unsigned long gapSpread;
+  unsigned long rollMin;     // if set, the next chord starts this long
+  unsigned long rollSpread;  // after the first finger lifts instead
+};
+
+extern const Typist steadyTypist;
+extern const Typist fastTypist;
+extern const Typist rollingTypist;  // lands the next chord while lifting
+
+struct FingerEvent {
+  unsigned long atMicros;
+  byte bit;
+  bool down;
+};
+
+// same seed, same session
+void sessionSeed(unsigned long seed);
+unsigned long sessionRandom(unsigned long range);
+
+// chord for a character, 0 if the default layer has none
+byte chordFor(char c);
+// characters typed, from the key codes in captured AT traffic, '?' for
+// any key that is not a letter or space
+std::string decodeTyped(const std::string &traffic);
+
+// finger events for one chord starting at 'start', sorted by time; also
+// when the last finger finished landing and the first started lifting.
+// 'notBefore', if given, is per switch when that finger is free again; a
+// finger still busy lands (and lifts) that much later.
+std::vector<FingerEvent> fingerEvents(byte chord, unsigned long start, const Typist &typist,
+                                      unsigned long *lastDown, unsigned long *firstUp,
+                                      const unsigned long *notBefore = 0);
+
+struct SessionResult {
+  std::string intended;
+  std::string typed;
+  unsigned long errors;             // edit distance typed -> intended
+  std::vector<double> landingToKey;  // ms, last finger down -> key sent
+  std::vector<double> liftToKey;     // ms, first finger up -> key sent
+  unsigned long micros;             // how long the session took
+};
+
+// type 'chords' characters of 'text' (repeating it) through chorderLoop()
+// every scanTickMicros, from the current state of the core; key times
+// are matched to chords in order, so are only meaningful without errors.
+// With a Bluefruit emulator attached (BluefruitEmulator.h) typed is what
+// the module typed, and key times when it typed it.
+SessionResult playSession(const char *text, unsigned long chords, const Typist &typist);
+
+#endif
@@ -0,0 +1,151 @@
+// WString.cpp
+// Host stand-in for the Arduino String class, see WString.h.
+
+#include "WString.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+StringHeapStats stringHeap = { 0, 0, 0 };
+
+const unsigned int MallocHeader = 2;
+
+void String::init(){
+  _buffer = NULL;
+  _len = 0;
+}
+
+// buffer always holds exactly length + 1 chars
+void String::resize(unsigned int length){
+  char *grown = (char *)realloc(_buffer, length + 1);
+  if (!grown) abort();
+  if (_buffer) stringHeap.inUse -= _len + 1 + MallocHeader;
+  stringHeap.inUse += length + 1 + MallocHeader;
+  if (stringHeap.inUse > stringHeap.peak) stringHeap.peak = stringHeap.inUse;
+  stringHeap.allocations++;
+  _buffer = grown;
+}
+
+void String::copy(const char *cstr, unsigned int length){
+  resize(length);
+  memcpy(_buffer, cstr, length);
+  _buffer[length] = 0;
+  _len = length;
+}
+
+void String::concat(const char *cstr, unsigned int length){
+  unsigned int oldLen = _len;
+  resize(_len + length);
+  memcpy(_buffer + oldLen, cstr, length);
+  _len = oldLen + length;
+  _buffer[_len] = 0;
+}
+
+String::String(const char *cstr){
+  init();
+  copy(cstr, strlen(cstr));
+}
+
+String::String(const String &str){
+  init();
+  copy(str._buffer, str._len);
+}
+
+String::String(char c){
+  init();
+  copy(&c, 1);
+}
+
+// digits of 'v' in 'base', right aligned in buf, returns the first digit
+static const char *formatUnsigned(char *buf, size_t size, unsigned int v, unsigned char base){
+  char *p = buf + size - 1;
+  *p = 0;
+  do {
+    *--p = "0123456789abcdefghijklmnopqrstuvwxyz"[v % base];
+    v /= base;
+  } while (v);
+  return p;
+}
+
+String::String(int value, unsigned char base){
+  char buf[2 + 8 * sizeof(int)];
+  const char *digits = buf;
+  // avr-libc itoa() prints anything but base 10 as unsigned 16 bit
+  if (base == 10) {
+    snprintf(buf, sizeof(buf), "%d", (int16_t)value);
+  } else {
+    digits = formatUnsigned(buf, sizeof(buf), (uint16_t)value, base);
+  }
+  init();
+  copy(digits, strlen(digits));
+}
+
+String::String(unsigned int value, unsigned char base){
+  char buf[2 + 8 * sizeof(int)];
+  const char *digits = formatUnsigned(buf, sizeof(buf), (uint16_t)value, base);
+  init();
+  copy(digits, strlen(digits));
+}
+
+String::String(float value, unsigned char decimalPlaces){
+  char buf[33];
+  snprintf(buf, sizeof(buf), "%.*f", decimalPlaces, value);
+  init();
+  copy(buf, strlen(buf));
+}
+
+String::~String(){
+  if (_buffer) stringHeap.inUse -= _len + 1 + MallocHeader;
+  free(_buffer);
+}
+
+String &String::operator=(const String &rhs){
+  if (this != &rhs) copy(rhs._buffer, rhs._len);
+  return *this;
+}
+
+String &String::operator+=(const String &rhs){
+  concat(rhs._buffer, rhs._len);
+  return *this;
+}
+
+String &String::operator+=(const char *cstr){
+  concat(cstr, strlen(cstr));
+  return *this;
+}
+
+char &String::operator[](unsigned int index){
+  return _buffer[index];
+}
+
+char String::operator[](unsigned int index) const{
+  return index < _len ? _buffer[index] : 0;
+}
+
+bool String::operator==(const String &rhs) const{
+  return _len == rhs._len && memcmp(_buffer, rhs._buffer, _len) == 0;
+}
+
+bool String::operator==(const char *cstr) const{
+  return strcmp(_buffer, cstr) == 0;
+}
+
+String operator+(const String &lhs, const String &rhs){
+  String sum(lhs);
+  sum += rhs;
+  return sum;
+}
+
+String operator+(const String &lhs, const char *rhs){
+  String sum(lhs);
+  sum += rhs;
+  return sum;
+}
+
+String operator+(const char *lhs, const String &rhs){
+  String sum(lhs);
+  sum += rhs;
+  return sum;
+}
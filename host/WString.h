@@ -0,0 +1,55 @@
+// WString.h
+// Host stand-in for the Arduino String class, just the subset the chorder
+// core uses.  Like the AVR original it keeps its text on the heap and grows
+// it with realloc, and int is formatted as the 16 bit int of the 32u4.
+
+#ifndef HOST_WSTRING_H
+#define HOST_WSTRING_H
+
+// heap held by Strings, so host benchmarks can see what the AVR would
+// have had to find room for.  A block costs its size plus the 2 byte
+// avr-libc malloc header.
+struct StringHeapStats {
+  unsigned long inUse;        // bytes, headers included
+  unsigned long peak;         // high-water mark of inUse
+  unsigned long allocations;  // malloc/realloc calls
+};
+extern StringHeapStats stringHeap;
+
+class String {
+ public:
+  String(const char *cstr = "");
+  String(const String &str);
+  explicit String(char c);
+  String(int value, unsigned char base = 10);
+  String(unsigned int value, unsigned char base = 10);
+  String(float value, unsigned char decimalPlaces = 2);
+  ~String();
+
+  String &operator=(const String &rhs);
+  String &operator+=(const String &rhs);
+  String &operator+=(const char *cstr);
+
+  unsigned int length() const { return _len; }
+  const char *c_str() const { return _buffer; }
+  char &operator[](unsigned int index);
+  char operator[](unsigned int index) const;
+
+  bool operator==(const String &rhs) const;
+  bool operator==(const char *cstr) const;
+
+ private:
+  char *_buffer;
+  unsigned int _len;
+
+  void init();
+  void resize(unsigned int length);
+  void copy(const char *cstr, unsigned int length);
+  void concat(const char *cstr, unsigned int length);
+};
+
+String operator+(const String &lhs, const String &rhs);
+String operator+(const String &lhs, const char *rhs);
+String operator+(const char *lhs, const String &rhs);
+
+#endif
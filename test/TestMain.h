@@ -0,0 +1,96 @@
+// TestMain.h
+// Minimal test harness for the host build: each test file defines its
+// cases with TEST() and gets a main() that runs them all and returns
+// non-zero if any CHECK failed.
+
+#ifndef TEST_MAIN_H
+#define TEST_MAIN_H
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+typedef void (*TestFunc)();
+
+struct TestCase {
+  const char *name;
+  TestFunc func;
+  TestCase *next;
+};
+
+extern TestCase *testCases;
+extern int testFailures;
+
+struct TestRegistrar {
+  TestRegistrar(TestCase *tc) { tc->next = testCases; testCases = tc; }
+};
+
+#define TEST(name)                                              \
+  static void name();                                           \
+  static TestCase name##_case = { #name, name, 0 };             \
+  static TestRegistrar name##_registrar(&name##_case);          \
+  static void name()
+
+#define CHECK(cond)                                             \
+  do {                                                          \
+    if (!(cond)) {                                              \
+      printf("  %s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+      testFailures++;                                           \
+    }                                                           \
+  } while (0)
+
+#define CHECK_EQ(expected, actual)                              \
+  do {                                                          \
+    if (!((expected) == (actual))) {                            \
+      printf("  %s:%d: CHECK_EQ(%s, %s) failed\n", __FILE__, __LINE__, #expected, #actual); \
+      testFailures++;                                           \
+    }                                                           \
+  } while (0)
+
+#define CHECK_TRAFFIC(expected)                                 \
+  do {                                                          \
+    if (hostTraffic() != std::string(expected)) {               \
+      printf("  %s:%d: traffic mismatch\n    expected: %s\n    actual:   %s\n", \
+             __FILE__, __LINE__, escapeTraffic(expected).c_str(), \
+             escapeTraffic(hostTraffic()).c_str());             \
+      testFailures++;                                           \
+    }                                                           \
+  } while (0)
+
+// line endings made visible for failure messages
+inline std::string escapeTraffic(const std::string &text){
+  std::string out;
+  for (std::string::size_type i = 0; i < text.size(); i++) {
+    if (text[i] == '\r') out += "\\r";
+    else if (text[i] == '\n') out += "\\n";
+    else out += text[i];
+  }
+  return out;
+}
+
+#ifdef TEST_MAIN
+TestCase *testCases = 0;
+int testFailures = 0;
+
+int main(){
+  // registration pushes to the front, so run in reverse to keep file order
+  TestCase *ordered = 0;
+  while (testCases) {
+    TestCase *tc = testCases;
+    testCases = tc->next;
+    tc->next = ordered;
+    ordered = tc;
+  }
+  int run = 0;
+  for (TestCase *tc = ordered; tc; tc = tc->next) {
+    int before = testFailures;
+    tc->func();
+    printf("%s %s\n", testFailures == before ? "ok  " : "FAIL", tc->name);
+    run++;
+  }
+  printf("%d tests, %d failed checks\n", run, testFailures);
+  return testFailures ? 1 : 0;
+}
+#endif
+
+#endif
@@ -0,0 +1,91 @@
+// test_at_command.cpp
+// Fixed-buffer AT command formatting in AtCommand.cpp.
+
+#define TEST_MAIN
+#include "TestMain.h"
+
+#include "AtCommand.h"
+#include "ChordDriver.h"
+#include "Chorder.h"
+#include "LegacyAtCommand.h"
+
+TEST(keyboardCodeMatchesLegacyStringFormatting){
+  char command[AtKeyboardCodeLen + 1];
+  int mismatches = 0;
+  for (int mod = 0; mod < 256; mod++) {
+    for (int key = 0; key < 256; key++) {
+      CHECK_EQ(AtKeyboardCodeLen, atKeyboardCode(command, mod, key));
+      String legacy = String(LegacyKeyboardCodePrefix) + legacyKeyboardCodeTail(mod, key);
+      if (!(legacy == command)) mismatches++;
+    }
+  }
+  CHECK_EQ(0, mismatches);
+}
+
+TEST(keyboardCodeIsTerminated){
+  char command[AtKeyboardCodeLen + 2];
+  memset(command, 'x', sizeof(command));
+  atKeyboardCode(command, 0x80, 0xE3);
+  CHECK_EQ(std::string("AT+BLEKEYBOARDCODE=80-00-e3"), std::string(command));
+  CHECK_EQ('x', command[AtKeyboardCodeLen + 1]);
+}
+
+TEST(releaseIsEveryKeyUp){
+  char command[AtKeyboardReleaseLen + 2];
+  memset(command, 'x', sizeof(command));
+  CHECK_EQ(AtKeyboardReleaseLen, atKeyboardRelease(command));
+  CHECK_EQ(std::string("AT+BLEKEYBOARDCODE=00-00"), std::string(command));
+  CHECK_EQ('x', command[AtKeyboardReleaseLen + 1]);
+}
+
+TEST(commandWithTextFitsTheBuffer){
+  char command[AtCommandSize];
+  std::string text(200, 'z');
+  size_t used = atCommandWithText(command, PSTR("AT+BleKeyboard="), text.c_str());
+  CHECK_EQ((size_t)AtCommandSize - 1 - strlen("AT+BleKeyboard="), used);
+  CHECK_EQ((size_t)AtCommandSize - 1, strlen(command));
+
+  CHECK_EQ((size_t)5, atCommandWithText(command, PSTR("AT+BleHidControlKey="), "MEDIA"));
+  CHECK_EQ(std::string("AT+BleHidControlKey=MEDIA"), std::string(command));
+}
+
+TEST(mouseMoveIsDecimalWithTheWheelOnlyWhenItMoves){
+  char command[AtMouseMoveSize];
+  CHECK_EQ(24, atMouseMove(command, 5, -12, 0));
+  CHECK_EQ(std::string("AT+BleHidMouseMove=5,-12"), std::string(command));
+  atMouseMove(command, 0, 0, 1);
+  CHECK_EQ(std::string("AT+BleHidMouseMove=0,0,1"), std::string(command));
+  CHECK_EQ(AtMouseMoveSize - 1, atMouseMove(command, -128, -128, -128));
+  CHECK_EQ(std::string("AT+BleHidMouseMove=-128,-128,-128"), std::string(command));
+}
+
+TEST(batteryLevelIsDecimalUpTo100){
+  char command[AtBatteryLevelSize];
+  CHECK_EQ(15, atBatteryLevel(command, 7));
+  CHECK_EQ(std::string("AT+BLEBATTVAL=7"), std::string(command));
+  CHECK_EQ(AtBatteryLevelSize - 1, atBatteryLevel(command, 100));
+  atBatteryLevel(command, 200);
+  CHECK_EQ(std::string("AT+BLEBATTVAL=100"), std::string(command));
+}
+
+TEST(longStringIsSplitOverSeveralCommands){
+  driverReset();
+  std::string text(100, 'q');
+  sendString(text.c_str());
+  std::string expected;
+  size_t room = AtCommandSize - 1 - strlen("AT+BleKeyboard=");
+  for (size_t sent = 0; sent < text.size(); sent += room) {
+    expected += "AT+BleKeyboard=" + text.substr(sent, room) + "\r\n";
+  }
+  expected += "AT+BLEKEYBOARDCODE=00-00\r\n";
+  CHECK_TRAFFIC(expected);
+}
+
+TEST(keystrokeIsOneTransportCallAndNoHeap){
+  driverReset();
+  unsigned long allocations = stringHeap.allocations;
+  sendRawKeyDn(0x02, 0x04);
+  CHECK_EQ(1ul, hostCommandCount());
+  CHECK_EQ(allocations, stringHeap.allocations);
+  CHECK_TRAFFIC("AT+BLEKEYBOARDCODE=02-00-04\r\n");
+}
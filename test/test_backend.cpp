@@ -0,0 +1,190 @@
+// test_backend.cpp
+// Output backends (OutputBackend.h): the Bluefruit one is the default,
+// and with a report backend (the mock, as the USB one) chords, media keys
+// and text go out as HID reports (HidReport.h).
+
+#define TEST_MAIN
+#include "TestMain.h"
+
+#include "ChordDriver.h"
+#include "Chorder.h"
+#include "KeyCodes.h"
+#include "MockBackend.h"
+#include "OutputQueue.h"
+
+const byte CHORD_A      = 0x2E;  // -C- IMR-
+const byte CHORD_LSHIFT = 0x40;  // F-- ----
+const byte CHORD_THE    = 0x58;  // F-N I---
+const byte CHORD_BSPC   = 0x44;  // F-- -M--
+
+static const char keyUp[] = "00 00 00 00 00 00 00 00\n";
+
+static void useMock(){
+  driverReset();
+  mockReset();
+  outputSelect(&mockBackend);
+}
+
+// the mock stands in for the USB backend on the cable
+static void cabled(){
+  driverReset();
+  mockReset();
+  cableBackend = &mockBackend;
+}
+
+TEST(bluefruitIsTheDefault){
+  useMock();
+  chorderInit();
+  CHECK(outputBackend == &bleBackend);
+  typeChord(CHORD_A);
+  CHECK_TRAFFIC("AT+BLEKEYBOARDCODE=00-00-04\r\nAT+BLEKEYBOARDCODE=00-00\r\n");
+  CHECK(mockReports().empty());
+}
+
+TEST(chordsGoOutAsKeyReports){
+  useMock();
+  typeChord(CHORD_A);
+  typeChord(CHORD_LSHIFT);
+  typeChord(CHORD_A);
+  CHECK_EQ(std::string("00 00 04 00 00 00 00 00\n") + keyUp +
+           "02 00 04 00 00 00 00 00\n" + keyUp, mockDescribe());
+  CHECK_EQ(0u, hostTraffic().size());  // nothing to the Bluefruit
+}
+
+TEST(mediaKeysGoOutAsConsumerReports){
+  useMock();
+  dispatchKey(MEDIA_volup);
+  dispatchKey(MEDIA_playpause);
+  outputFlush();
+  CHECK_EQ("consumer 00e9\nconsumer 0000\nconsumer 00cd\nconsumer 0000\n", mockDescribe());
+}
+
+TEST(textIsTypedAKeyAtATime){
+  useMock();
+  typeChord(CHORD_LSHIFT);
+  typeChord(CHORD_THE);
+  CHECK_EQ(std::string("02 00 17 00 00 00 00 00\n") + keyUp +
+           "00 00 0b 00 00 00 00 00\n" + keyUp +
+           "00 00 08 00 00 00 00 00\n" + keyUp + keyUp, mockDescribe());
+
+  mockReset();
+  sendString("a-Z\n\x01");  // no key for \x01
+  CHECK_EQ(std::string("00 00 04 00 00 00 00 00\n") + keyUp +
+           "00 00 2d 00 00 00 00 00\n" + keyUp +
+           "02 00 1d 00 00 00 00 00\n" + keyUp +
+           "00 00 28 00 00 00 00 00\n" + keyUp + keyUp, mockDescribe());
+}
+
+TEST(asciiHasAKeyForEachPrintable){
+  byte mod, key;
+  CHECK(hidFromAscii('a', &mod, &key));
+  CHECK_EQ(0, mod);
+  CHECK_EQ(ENUMKEY_A, key);
+  CHECK(hidFromAscii('A', &mod, &key));
+  CHECK_EQ(2, mod);
+  CHECK_EQ(ENUMKEY_A, key);
+  CHECK(hidFromAscii('~', &mod, &key));
+  CHECK_EQ(2, mod);
+  CHECK_EQ(ENUMKEY_grave, key);
+  CHECK(hidFromAscii(' ', &mod, &key));
+  CHECK_EQ(ENUMKEY_spc, key);
+  CHECK(hidFromAscii('\t', &mod, &key));
+  CHECK_EQ(ENUMKEY_tab, key);
+  CHECK(!hidFromAscii('\x7F', &mod, &key));
+  CHECK(!hidFromAscii('\0', &mod, &key));
+  for (char c = ' '; c <= '~'; c++) {
+    CHECK(hidFromAscii(c, &mod, &key));
+    CHECK(key != ENUMKEY__);
+  }
+}
+
+TEST(consumerUsagesByBluefruitName){
+  unsigned int holdMs = 1;
+  CHECK_EQ(0x00CD, hidConsumerUsage("PLAYPAUSE", &holdMs));
+  CHECK_EQ(0u, holdMs);
+  CHECK_EQ(0x00E9, hidConsumerUsage("VOLUME+,500", &holdMs));
+  CHECK_EQ(500u, holdMs);
+  CHECK_EQ(0x00EA, hidConsumerUsage("VOLUME-", &holdMs));
+  CHECK_EQ(0, hidConsumerUsage("VOLUME", &holdMs));
+  CHECK_EQ(0, hidConsumerUsage("EJECT", &holdMs));
+}
+
+TEST(unknownControlsAndMouseKeysSendNothing){
+  useMock();
+  sendControlKey("EJECT");
+  sendMouseKey("L");
+  CHECK(mockReports().empty());
+  CHECK_EQ(0u, hostTraffic().size());
+}
+
+TEST(outputFollowsTheCable){
+  cabled();
+  outputCabled(false);
+  CHECK(outputBackend == &bleBackend);
+  CHECK_EQ(0u, hostTraffic().size());
+  outputCabled(true);
+  CHECK(outputBackend == &mockBackend);
+  CHECK_TRAFFIC("AT+BLEKEYBOARDCODE=00-00\r\n");  // BLE let go
+  hostClearTraffic();
+  typeChord(CHORD_A);
+  CHECK_EQ(std::string("00 00 04 00 00 00 00 00\n") + keyUp, mockDescribe());
+  CHECK_EQ(0u, hostTraffic().size());
+  mockReset();
+  outputCabled(false);
+  CHECK(outputBackend == &bleBackend);
+  CHECK_EQ(std::string(keyUp), mockDescribe());  // USB let go
+  typeChord(CHORD_A);
+  CHECK_TRAFFIC("AT+BLEKEYBOARDCODE=00-00-04\r\nAT+BLEKEYBOARDCODE=00-00\r\n");
+  cableBackend = 0;
+}
+
+TEST(pullingTheCableUnderAHeldKeyLetsItGo){
+  cabled();
+  unsigned int wasHoldMs = repeatHoldMs, wasDwellMs = holdDwellMs;
+  repeatHoldMs = 250;
+  holdDwellMs = 0;
+  outputCabled(true);
+  mockReset();
+  hostSetSwitches(CHORD_BSPC);
+  driveFor(300000);
+  CHECK_EQ(std::string("00 00 2a 00 00 00 00 00\n"), mockDescribe());
+  outputCabled(false);
+  CHECK_EQ(std::string("00 00 2a 00 00 00 00 00\n") + keyUp, mockDescribe());
+  hostSetSwitches(0);
+  driveFor(40000);
+  CHECK_EQ((size_t)2, mockReports().size());
+  repeatHoldMs = wasHoldMs;
+  holdDwellMs = wasDwellMs;
+  cableBackend = 0;
+}
+
+TEST(theCableIsUpOnlyWhileConfiguredPoweredAndAwake){
+  CHECK(cableLinkUp(true, true, false));
+  CHECK(!cableLinkUp(false, true, false));  // a charger, not enumerated
+  CHECK(!cableLinkUp(true, false, false));  // pulled, still configured
+  CHECK(!cableLinkUp(true, true, true));    // the computer is asleep
+}
+
+TEST(pullingTheCableAfterAConfiguredSessionGoesBackToBluefruit){
+  cabled();
+  outputCabled(cableLinkUp(true, true, false));
+  CHECK(outputBackend == &mockBackend);
+  typeChord(CHORD_A);
+  mockReset();
+  hostClearTraffic();
+  // VBUS gone, the USB still says configured
+  outputCabled(cableLinkUp(true, false, false));
+  CHECK(outputBackend == &bleBackend);
+  CHECK_EQ(std::string(keyUp), mockDescribe());
+  typeChord(CHORD_A);
+  CHECK_TRAFFIC("AT+BLEKEYBOARDCODE=00-00-04\r\nAT+BLEKEYBOARDCODE=00-00\r\n");
+  CHECK_EQ((size_t)1, mockReports().size());  // nothing more to the cable
+  cableBackend = 0;
+}
+
+TEST(withNoCableBackendItStaysOnBluefruit){
+  driverReset();
+  outputCabled(true);
+  CHECK(outputBackend == &bleBackend);
+  CHECK_EQ(0u, hostTraffic().size());
+}
@@ -0,0 +1,146 @@
+// test_battery.cpp
+// The battery monitor (Battery.h): the fixed-point conversion and LiPo
+// curve, the filter, the level published to the Battery Service in the
+// background, and the low battery policy.
+
+#define TEST_MAIN
+#include "TestMain.h"
+
+#include "Battery.h"
+#include "ChordDriver.h"
+#include "Chorder.h"
+#include "MockBackend.h"
+#include "OutputBackend.h"
+
+const int RAW_3V9 = 605;  // 3899 mV, 63%
+const int RAW_3V6 = 559;  // 3602 mV, 4%
+
+// a board powered from a battery at 'raw'
+static void batteryReset(int raw){
+  driverReset();
+  batterySampleMs = 60000;
+  batteryLowPercent = 10;
+  batteryLowIdleMs = 1000;
+  hostSetBattery(raw);
+  chorderInit();
+  hostClearTraffic();
+}
+
+static int published(){
+  const std::string &t = hostTraffic();
+  int n = 0;
+  for (size_t at = t.find("AT+BLEBATTVAL="); at != std::string::npos; at = t.find("AT+BLEBATTVAL=", at + 1)) n++;
+  return n;
+}
+
+TEST(readingsAreMillivoltsWithoutFloat){
+  CHECK_EQ(0u, batteryMillivolts(0));
+  CHECK_EQ(3300u, batteryMillivolts(512));
+  CHECK_EQ(3899u, batteryMillivolts(RAW_3V9));
+  CHECK_EQ(6593u, batteryMillivolts(1023));
+}
+
+TEST(percentFollowsTheLipoCurve){
+  CHECK_EQ(0, batteryPercent(3000));
+  CHECK_EQ(0, batteryPercent(3270));
+  CHECK_EQ(63, batteryPercent(3899));
+  CHECK_EQ(100, batteryPercent(4200));
+  CHECK_EQ(100, batteryPercent(4350));  // charging
+  byte last = 0;
+  for (unsigned int mv = 3000; mv <= 4300; mv += 5) {
+    CHECK(batteryPercent(mv) >= last);
+    last = batteryPercent(mv);
+  }
+}
+
+TEST(theLevelGoesToTheBatteryServiceOnce){
+  batteryReset(RAW_3V9);
+  CHECK_EQ(63, batteryStats.percent);
+  driveFor(100000);
+  CHECK_TRAFFIC("AT+BLEBATTVAL=63\r\n");
+  // a minute on, the same level isn't sent again
+  driveFor(61000000);
+  CHECK_EQ(1, published());
+  CHECK(batteryStats.samples >= 2);  // asleep by then
+  CHECK_EQ(1ul, sleepStats.sleeps);
+}
+
+TEST(theFilterTakesAQuarterOfEachReading){
+  batteryReset(RAW_3V9);
+  hostSetBattery(RAW_3V6);
+  batterySample();
+  unsigned int quarter = 3899u - (3899u - 3602u) / 4;
+  CHECK(batteryStats.millivolts + 1 >= quarter && batteryStats.millivolts <= quarter);
+  // and gets there
+  for (int i = 0; i < 30; i++) batterySample();
+  CHECK(batteryStats.millivolts <= 3603);
+}
+
+TEST(itIsNotSampledWhileTyping){
+  batteryReset(RAW_3V9);
+  unsigned long samples = batteryStats.samples;
+  hostSetSwitches(0x2E);
+  driveFor(120000000);
+  CHECK_EQ(samples, batteryStats.samples);
+  hostSetSwitches(0);
+  driveFor(100000);
+  CHECK_EQ(samples + 1, batteryStats.samples);
+}
+
+TEST(theLevelWaitsForTheKeysToGo){
+  batteryReset(RAW_3V9);
+  typeChord(0x2E);
+  CHECK_TRAFFIC("AT+BLEKEYBOARDCODE=00-00-04\r\nAT+BLEKEYBOARDCODE=00-00\r\n"
+                "AT+BLEBATTVAL=63\r\n");
+}
+
+TEST(noBatteryPublishesNothing){
+  batteryReset(0);
+  driveFor(120000000);
+  CHECK_EQ(0, published());
+  CHECK_EQ(BatteryUnknown, batteryStats.percent);
+  CHECK(!batteryStats.isLow);
+}
+
+TEST(aBackendWithNoBatteryServiceSendsNothing){
+  batteryReset(RAW_3V9);
+  mockReset();
+  outputSelect(&mockBackend);
+  driveFor(100000);
+  CHECK_EQ(BatteryUnknown, batteryStats.published);
+  outputSelect(&bleBackend);
+}
+
+TEST(aLowBatterySleepsSoonerAndScansLess){
+  batteryReset(RAW_3V9);
+  driveFor(2000000);
+  CHECK_EQ(0ul, sleepStats.sleeps);
+  driveFor(10000000);
+  unsigned long scans = scanStats.scans;
+  driveFor(10000000);
+  unsigned long normalScans = scanStats.scans - scans;
+
+  batteryReset(RAW_3V6);
+  CHECK(batteryStats.isLow);
+  CHECK(hostLog().find("battery low\n") != std::string::npos);
+  driveFor(batteryLowIdleMs * 1000 + 100000);
+  CHECK_EQ(1ul, sleepStats.sleeps);
+  scans = scanStats.scans;
+  driveFor(10000000);
+  CHECK(3 * (scanStats.scans - scans) < 2 * normalScans);  // about half
+  // and the first chord still gets through
+  typeChord(0x2E);
+  CHECK(hostTraffic().find("AT+BLEKEYBOARDCODE=00-00-04\r\n") != std::string::npos);
+}
+
+TEST(lowEndsOnlyWellAboveTheThreshold){
+  batteryReset(RAW_3V6);
+  CHECK(batteryStats.isLow);
+  hostSetBattery(574);  // 3699 mV, 12%: over the threshold, not by enough
+  for (int i = 0; i < 30; i++) batterySample();
+  CHECK_EQ(12, batteryStats.percent);
+  CHECK(batteryStats.isLow);
+  hostSetBattery(RAW_3V9);
+  for (int i = 0; i < 30; i++) batterySample();
+  CHECK(!batteryStats.isLow);
+}
@@ -0,0 +1,251 @@
+// test_bluefruit_emulator.cpp
+// The host Bluefruit (BluefruitEmulator.h): the commands it takes and
+// answers, the text it decodes from the key reports, the faults it puts
+// on its answers, and the core typing through it.
+
+#define TEST_MAIN
+#include "TestMain.h"
+
+#include "AckPacing.h"
+#include "BluefruitEmulator.h"
+#include "ChordDriver.h"
+#include "Chorder.h"
+#include "TypingSession.h"
+
+const byte CHORD_A = 0x2E;  // -C- IMR-
+
+// the answer lines to 'command' once they have all come, space separated
+static std::string send(const char *command, unsigned long waitMicros = 10000){
+  halPrintln(command);
+  hostAdvanceMicros(waitMicros);
+  std::string lines;
+  char line[32];
+  while (halReadLine(line, sizeof(line))) lines += (lines.empty() ? "" : " ") + std::string(line);
+  return lines;
+}
+
+// a module as the board's setup() leaves it
+static void setUp(){
+  CHECK_EQ(std::string("OK"), send("AT+BleHIDEn=On"));
+  CHECK_EQ(std::string("OK"), send("AT+BLEBATTEN=1"));
+  CHECK_EQ(std::string("OK"), send("ATZ", BluefruitResetMicros + 10000));
+}
+
+// set up on a clean link, then 'faults' on
+static void module(const BluefruitFaults &faults = bluefruitCleanLink){
+  hostReset();
+  bluefruitAttach(bluefruitCleanLink);
+  setUp();
+  bluefruitSetFaults(faults);
+  bluefruitClearTyped();
+}
+
+TEST(keysAnswerErrorUntilHidIsOnAndReset){
+  hostReset();
+  bluefruitAttach(bluefruitCleanLink);
+  CHECK_EQ(std::string("ERROR"), send("AT+BLEKEYBOARDCODE=00-00-04"));
+  CHECK_EQ(std::string("0 OK"), send("AT+BleHIDEn"));
+  CHECK_EQ(std::string("OK"), send("AT+BleHIDEn=On"));
+  CHECK_EQ(std::string("1 OK"), send("AT+BleHIDEn"));
+  CHECK_EQ(std::string("ERROR"), send("AT+BLEKEYBOARDCODE=00-00-04"));
+  CHECK_EQ(std::string("OK"), send("ATZ", BluefruitResetMicros + 10000));
+  CHECK_EQ(std::string("OK"), send("AT+BLEKEYBOARDCODE=00-00-04"));
+  CHECK_EQ(std::string("a"), bluefruitTyped());
+  CHECK_EQ(1ul, bluefruitStats.resets);
+  CHECK_EQ(2ul, bluefruitStats.errors);
+}
+
+TEST(nameIsReadBackAndKeptOverAReset){
+  hostReset();
+  bluefruitAttach(bluefruitCleanLink);
+  CHECK_EQ(std::string(BluefruitFactoryName) + " OK", send("AT+GAPDEVNAME"));
+  CHECK_EQ(std::string("OK"), send("AT+GAPDEVNAME=FeatherChorder"));
+  send("ATZ", BluefruitResetMicros + 10000);
+  CHECK_EQ(std::string("FeatherChorder OK"), send("AT+GAPDEVNAME"));
+  CHECK_EQ(std::string("FeatherChorder"), bluefruitName());
+}
+
+TEST(factoryResetForgetsTheSetup){
+  module();
+  send("AT+GAPDEVNAME=FeatherChorder");
+  sendFactoryReset();
+  CHECK(bluefruitBusy());
+  hostAdvanceMicros(BluefruitResetMicros);
+  CHECK(!bluefruitBusy());
+  CHECK_EQ(std::string(BluefruitFactoryName), bluefruitName());
+  CHECK(!bluefruitHidOn());
+  CHECK_EQ(std::string("OK ERROR"), send("AT+BLEKEYBOARDCODE=00-00-04"));
+}
+
+TEST(commandsDuringAResetAreLost){
+  module();
+  CHECK_EQ(std::string(""), send("ATZ"));
+  CHECK_EQ(std::string(""), send("AT+BLEKEYBOARDCODE=00-00-04"));
+  CHECK_EQ(std::string("OK"), send("AT", BluefruitResetMicros));  // the ATZ's
+  CHECK_EQ(2ul, bluefruitStats.lost);
+  CHECK_EQ(std::string("OK"), send("AT"));
+  CHECK_EQ(std::string(""), bluefruitTyped());
+}
+
+TEST(keyReportsTypeWhatGoesDown){
+  module();
+  send("AT+BLEKEYBOARDCODE=00-00-0b");     // h
+  send("AT+BLEKEYBOARDCODE=00-00-0b");     // still down, a resend
+  send("AT+BLEKEYBOARDCODE=00-00");
+  send("AT+BLEKEYBOARDCODE=02-00-0C");     // I
+  send("AT+BLEKEYBOARDCODE=02-00-0c-1e");  // I held, ! pressed
+  send("AT+BLEKEYBOARDCODE=00-00");
+  send("AT+BLEKEYBOARDCODE=00-00-2c");     // space
+  send("AT+BLEKEYBOARDCODE=00-00-2a");     // backspace
+  send("AT+BLEKEYBOARDCODE=00-00-28");     // enter
+  send("AT+BLEKEYBOARDCODE=01-00-06");     // Ctrl-C types nothing
+  send("AT+BLEKEYBOARDCODE=00-00");
+  CHECK_EQ(std::string("hI!\n"), bluefruitTyped());
+  CHECK_EQ(bluefruitTyped().size(), bluefruitTypedAt().size());
+  CHECK_EQ(11ul, bluefruitStats.keyReports);
+  CHECK_EQ(7ul, bluefruitStats.keysTyped);
+  CHECK_EQ(1ul, bluefruitStats.shortcuts);
+}
+
+TEST(badKeyReportsAreErrors){
+  module();
+  CHECK_EQ(std::string("ERROR"), send("AT+BLEKEYBOARDCODE=00"));
+  CHECK_EQ(std::string("ERROR"), send("AT+BLEKEYBOARDCODE=00-01-04"));
+  CHECK_EQ(std::string("ERROR"), send("AT+BLEKEYBOARDCODE=00-00-04-05-06-07-08-09-0a"));
+  CHECK_EQ(std::string("ERROR"), send("AT+BLEKEYBOARDCODE=00-00-4"));
+  CHECK_EQ(std::string("ERROR"), send("AT+BLEKEYBOARDCODE"));
+  CHECK_EQ(std::string("ERROR"), send("AT+BLEWHATEVER=1"));
+  CHECK_EQ(0ul, bluefruitStats.keyReports);
+  CHECK_EQ(6ul, bluefruitStats.errors);
+}
+
+TEST(keyboardTextUndoesItsEscapes){
+  module();
+  CHECK_EQ(std::string("OK"), send("AT+BleKeyboard=Hi, there\\r\\tx\\\\y\\b"));
+  CHECK_EQ(std::string("Hi, there\n\tx\\"), bluefruitTyped());
+  CHECK_EQ(1ul, bluefruitStats.textCommands);
+}
+
+TEST(controlKeysMouseAndBattery){
+  module();
+  CHECK_EQ(std::string("OK"), send("AT+BleHidControlKey=VOLUME+,500"));
+  CHECK_EQ(std::string("OK"), send("AT+BleHidControlKey=0x00CD"));
+  CHECK_EQ(std::string("ERROR"), send("AT+BleHidControlKey=LOUDER"));
+  CHECK_EQ(2ul, bluefruitStats.controlKeys);
+  CHECK_EQ(std::string("OK"), send("AT+BleHidMouseButton=LR"));
+  CHECK_EQ(3, bluefruitMouseButtons());
+  CHECK_EQ(std::string("OK"), send("AT+BleHidMouseButton=M,click"));
+  CHECK_EQ(4, bluefruitMouseButtons());
+  CHECK_EQ(std::string("OK"), send("AT+BleHidMouseButton=0"));
+  CHECK_EQ(0, bluefruitMouseButtons());
+  CHECK_EQ(std::string("ERROR"), send("AT+BleHidMouseButton=X"));
+  CHECK_EQ(std::string("OK"), send("AT+BleHidMouseMove=5,-3"));
+  CHECK_EQ(std::string("OK"), send("AT+BleHidMouseMove=0,0,-1"));
+  CHECK_EQ(std::string("ERROR"), send("AT+BleHidMouseMove=300,0"));
+  CHECK_EQ(std::string("ERROR"), send("AT+BleHidMouseMove=5"));
+  CHECK_EQ(2ul, bluefruitStats.mouseMoves);
+  CHECK_EQ(std::string("OK"), send("AT+BLEBATTVAL=87"));
+  CHECK_EQ(87, bluefruitBatteryLevel());
+  CHECK_EQ(std::string("ERROR"), send("AT+BLEBATTVAL=101"));
+  CHECK_EQ(87, bluefruitBatteryLevel());
+}
+
+TEST(answersComeLateAndInOrder){
+  BluefruitFaults slow = { 20000, 10000, 0, 0, 0, 0 };
+  module(slow);
+  for (int i = 0; i < 20; i++) halPrintln(i % 2 ? "AT" : "AT+BLEWHATEVER");
+  char line[8];
+  hostAdvanceMicros(19999);
+  CHECK(!halReadLine(line, sizeof(line)));
+  hostAdvanceMicros(10001);
+  for (int i = 0; i < 20; i++) {
+    CHECK(halReadLine(line, sizeof(line)));
+    CHECK_EQ(std::string(i % 2 ? "OK" : "ERROR"), std::string(line));
+  }
+  CHECK(!halReadLine(line, sizeof(line)));
+}
+
+// 'pairs' of an ERROR and an OK command sent together, on a link
+// dropping, garbling and reordering 10% each
+static std::string faultyAnswers(unsigned long seed, int pairs){
+  BluefruitFaults bad = { 1000, 0, 100, 100, 100, 0 };
+  hostReset();
+  bluefruitAttach(bad, seed);
+  std::string lines;
+  for (int i = 0; i < pairs; i++) {
+    halPrintln("AT+BLEWHATEVER");
+    lines += send("AT", 2000) + "|";
+  }
+  return lines;
+}
+
+TEST(faultsAreCountedAndRepeatable){
+  std::string first = faultyAnswers(7, 1000);
+  CHECK_EQ(2000ul, bluefruitStats.answers);
+  CHECK(bluefruitStats.dropped > 150 && bluefruitStats.dropped < 250);
+  CHECK(bluefruitStats.garbled > 150 && bluefruitStats.garbled < 250);
+  CHECK(bluefruitStats.reordered > 50 && bluefruitStats.reordered < 150);
+  CHECK(first.find("oK") != std::string::npos || first.find("Ok") != std::string::npos);
+  CHECK(first.find("|OK ERROR|") != std::string::npos);  // swapped
+  CHECK_EQ(first, faultyAnswers(7, 1000));
+  CHECK(first != faultyAnswers(8, 1000));
+}
+
+TEST(refusedKeyReportsAreResent){
+  module();
+  ackPacing = true;
+  chorderInit();
+  BluefruitFaults refusing = bluefruitCleanLink;
+  refusing.refusePerMille = 1000;
+  bluefruitSetFaults(refusing);
+  typeChord(CHORD_A);
+  CHECK_EQ(std::string(""), bluefruitTyped());
+  CHECK(ackStats.retries >= AckRetries);
+  bluefruitSetFaults(bluefruitCleanLink);
+  typeChord(CHORD_A);
+  CHECK_EQ(std::string("a"), bluefruitTyped());
+}
+
+TEST(lostAnswersAreNotWaitedForAfterwards){
+  module();
+  ackPacing = true;
+  chorderInit();
+  typeChord(CHORD_A);  // how soon the link answers
+  BluefruitFaults dropping = bluefruitCleanLink;
+  dropping.dropPerMille = 1000;
+  bluefruitSetFaults(dropping);
+  typeChord(CHORD_A, 40, 200);
+  CHECK_EQ(2ul, ackStats.timeouts);
+  bluefruitSetFaults(bluefruitCleanLink);
+  for (int i = 0; i < 5; i++) typeChord(CHORD_A);
+  CHECK_EQ(std::string("aaaaaaa"), bluefruitTyped());
+  CHECK_EQ(2ul, ackStats.timeouts);
+  CHECK_EQ(2ul, ackStats.lost);
+  CHECK_EQ(0ul, ackStats.late);
+}
+
+TEST(sessionTypesThroughAFaultyLink){
+  BluefruitFaults faulty = { 7500, 5000, 50, 50, 50, 0 };
+  module(faulty);
+  ackPacing = true;
+  chorderInit();
+  sessionSeed(3);
+  SessionResult result = playSession("hello from the host ", 200, steadyTypist);
+  CHECK_EQ(result.intended, result.typed);
+  CHECK_EQ(0ul, result.errors);
+  CHECK_EQ((size_t)200, result.landingToKey.size());
+  CHECK(bluefruitStats.dropped > 0);
+  CHECK(ackStats.timeouts > 0);
+  CHECK(ackStats.timeouts - ackStats.lost <= 1);  // the last may be unresolved
+  CHECK_EQ(0ul, ackStats.late);
+  for (size_t i = 0; i < result.landingToKey.size(); i++) CHECK(result.landingToKey[i] >= 0);
+}
+
+TEST(hostResetDetachesTheModule){
+  module();
+  CHECK(bluefruitAttached());
+  hostReset();
+  CHECK(!bluefruitAttached());
+  hostSetAckDelay(1000);
+  CHECK_EQ(std::string("OK"), send("AT+BLEWHATEVER"));
+}
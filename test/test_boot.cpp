@@ -0,0 +1,56 @@
+// test_boot.cpp
+// Boot to first key (Chorder.h bootStats): ready when chorderInit() ran,
+// first key when the first report went out after it, whatever the chord.
+
+#define TEST_MAIN
+#include "TestMain.h"
+
+#include "ChordDriver.h"
+#include "Chorder.h"
+
+const byte CHORD_A   = 0x2E;  // -C- IMR-
+const byte CHORD_NUM = 0x10;  // --N ----  MODE_NUM, sends nothing
+const byte CHORD_THE = 0x58;  // F-N I---
+
+static void bootAt(unsigned long ms){
+  driverReset();
+  hostAdvanceMicros(ms * 1000ul);
+  chorderInit();
+}
+
+TEST(readyIsWhenInitRan){
+  bootAt(300);
+  CHECK_EQ(300ul, bootStats.readyMs);
+  CHECK_EQ(0ul, bootStats.firstKeyMs);
+}
+
+TEST(firstKeyIsTheFirstReport){
+  bootAt(300);
+  typeChord(CHORD_A);
+  unsigned long firstKey = bootStats.firstKeyMs;
+  CHECK(firstKey > bootStats.readyMs);
+  CHECK(firstKey <= hostMicros() / 1000ul);
+  typeChord(CHORD_A);
+  CHECK_EQ(firstKey, bootStats.firstKeyMs);
+}
+
+TEST(chordsThatSendNothingDoNotCount){
+  bootAt(300);
+  typeChord(CHORD_NUM);
+  CHECK_EQ(0ul, bootStats.firstKeyMs);
+  typeChord(CHORD_A);
+  CHECK(bootStats.firstKeyMs != 0);
+}
+
+TEST(wordsCountAsTheFirstKey){
+  bootAt(300);
+  typeChord(CHORD_THE);
+  CHECK(bootStats.firstKeyMs > bootStats.readyMs);
+}
+
+TEST(initStartsTheBootAgain){
+  bootAt(300);
+  typeChord(CHORD_A);
+  bootAt(900);
+  CHECK_EQ(0ul, bootStats.firstKeyMs);
+}
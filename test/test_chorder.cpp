@@ -0,0 +1,135 @@
+// test_chorder.cpp
+// Chord state machine and key sending, driven through the host HAL.
+
+#define TEST_MAIN
+#include "TestMain.h"
+
+#include "ChordDriver.h"
+#include "Chorder.h"
+
+// chords, see ChordMappings.h.  FCN IMRP
+const byte CHORD_A       = 0x2E;  // -C- IMR-
+const byte CHORD_E       = 0x0E;  // --- IMR-
+const byte CHORD_ER      = 0x05;  // --- -M-P  MACRO_1
+const byte CHORD_LSHIFT  = 0x40;  // F-- ----
+const byte CHORD_NUM     = 0x10;  // --N ----
+const byte CHORD_NUM_5   = 0x01;  // --- ---P  in num/sym
+const byte CHORD_LATCH   = 0x1C;  // --N IM--
+const byte CHORD_FUNC    = 0x11;  // --N ---P
+const byte CHORD_BATTERY = 0x0E;  // --- IMR-  in function layer
+
+TEST(singleChordSendsKeyDownThenUp){
+  driverReset();
+  typeChord(CHORD_A);
+  CHECK_TRAFFIC("AT+BLEKEYBOARDCODE=00-00-04\r\n"
+                "AT+BLEKEYBOARDCODE=00-00\r\n");
+}
+
+TEST(nothingIsSentWhileTheChordIsHeld){
+  driverReset();
+  hostSetSwitches(CHORD_A);
+  driveFor(500000);
+  CHECK_EQ(0ul, hostCommandCount());
+  hostSetSwitches(0);
+  driveFor(40000);
+  CHECK_EQ(2ul, hostCommandCount());
+}
+
+TEST(modifierAppliesToTheNextKeyOnly){
+  driverReset();
+  typeChord(CHORD_LSHIFT);
+  CHECK_EQ(0ul, hostCommandCount());
+  typeChord(CHORD_A);
+  typeChord(CHORD_A);
+  CHECK_TRAFFIC("AT+BLEKEYBOARDCODE=02-00-04\r\n"
+                "AT+BLEKEYBOARDCODE=00-00\r\n"
+                "AT+BLEKEYBOARDCODE=00-00-04\r\n"
+                "AT+BLEKEYBOARDCODE=00-00\r\n");
+}
+
+TEST(latchedModifiersStayUntilUnlatched){
+  driverReset();
+  typeChord(CHORD_LSHIFT);
+  typeChord(CHORD_LATCH);
+  typeChord(CHORD_A);
+  typeChord(CHORD_E);
+  typeChord(CHORD_LATCH);
+  typeChord(CHORD_A);
+  CHECK_TRAFFIC("AT+BLEKEYBOARDCODE=02-00-04\r\n"
+                "AT+BLEKEYBOARDCODE=00-00\r\n"
+                "AT+BLEKEYBOARDCODE=02-00-08\r\n"
+                "AT+BLEKEYBOARDCODE=00-00\r\n"
+                "AT+BLEKEYBOARDCODE=00-00-04\r\n"
+                "AT+BLEKEYBOARDCODE=00-00\r\n");
+}
+
+TEST(numModeIsOneShot){
+  driverReset();
+  typeChord(CHORD_NUM);
+  typeChord(CHORD_NUM_5);
+  typeChord(CHORD_NUM_5);
+  CHECK_TRAFFIC("AT+BLEKEYBOARDCODE=00-00-22\r\n"
+                "AT+BLEKEYBOARDCODE=00-00\r\n"
+                "AT+BLEKEYBOARDCODE=00-00-1a\r\n"
+                "AT+BLEKEYBOARDCODE=00-00\r\n");
+}
+
+TEST(bigramMacroShiftsOnlyTheFirstLetter){
+  driverReset();
+  typeChord(CHORD_LSHIFT);
+  typeChord(CHORD_ER);
+  driveFor(InterstitialDelay * 1000);
+  CHECK_TRAFFIC("AT+BLEKEYBOARDCODE=02-00-08\r\n"
+                "AT+BLEKEYBOARDCODE=00-00\r\n"
+                "AT+BLEKEYBOARDCODE=00-00-15\r\n"
+                "AT+BLEKEYBOARDCODE=00-00\r\n");
+}
+
+TEST(bounceShorterThanDebounceIsIgnored){
+  driverReset();
+  // fingers landing with a few ms of chatter, then a clean hold
+  for (int i = 0; i < 4; i++) {
+    hostSetSwitches(CHORD_A);
+    driveFor(2000);
+    hostSetSwitches(CHORD_A & ~0x08);
+    driveFor(1000);
+  }
+  hostSetSwitches(CHORD_A);
+  driveFor(40000);
+  hostSetSwitches(0);
+  driveFor(40000);
+  CHECK_TRAFFIC("AT+BLEKEYBOARDCODE=00-00-04\r\n"
+                "AT+BLEKEYBOARDCODE=00-00\r\n");
+}
+
+TEST(chordIsSentOnFirstRelease){
+  driverReset();
+  hostSetSwitches(CHORD_A);
+  driveFor(40000);
+  hostSetSwitches(CHORD_A & ~0x02);  // lift one finger, others still down
+  driveFor(40000);
+  CHECK_EQ(2ul, hostCommandCount());
+  hostSetSwitches(0);
+  driveFor(40000);
+  CHECK_EQ(2ul, hostCommandCount());
+}
+
+TEST(modeResetReleasesAllKeys){
+  driverReset();
+  typeChord(CHORD_NUM);
+  typeChord(0x70);  // FCN ----  MODE_RESET in every layer
+  CHECK_TRAFFIC("AT+BLEKEYBOARDCODE=00-00\r\n");
+}
+
+TEST(batteryLevelIsTypedOut){
+  driverReset();
+  hostSetBattery(512);  // half scale, 3.3v after the divider
+  typeChord(CHORD_FUNC);
+  typeChord(CHORD_BATTERY);
+  // one command, then the reset's key up and the level (empty at 3.3v)
+  // to the Battery Service
+  CHECK_TRAFFIC("AT+BleKeyboard= Kbd Batt: 3.30volts. \r\n"
+                "AT+BLEKEYBOARDCODE=00-00\r\n"
+                "AT+BLEKEYBOARDCODE=00-00\r\n"
+                "AT+BLEBATTVAL=0\r\n");
+}
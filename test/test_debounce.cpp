@@ -0,0 +1,160 @@
+// test_debounce.cpp
+// Per switch debounce replayed against bounce traces: fingers landing and
+// lifting at their own times, each edge chattering for up to a few ms.
+// Eager switches must type the same as plain per switch debounce, with a
+// lower release-to-send latency.
+
+#define TEST_MAIN
+#include "TestMain.h"
+
+#include "ChordDriver.h"
+#include "Chorder.h"
+#include "Debounce.h"
+#include "Keymap.h"
+
+#include <algorithm>
+#include <vector>
+
+// switch reading from 'us' on, keyState bits as in Chorder
+struct TraceRow {
+  unsigned long us;
+  byte keyState;
+};
+
+struct Trace {
+  byte chord;
+  unsigned long liftUs;  // first finger starts to lift
+  const TraceRow *rows;
+  size_t count;
+};
+
+// -C- IMR-  'a', fingers land over 9 ms, lift over 8 ms
+const TraceRow traceA[] = {
+  {     0, 0x00 },
+  {  1000, 0x08 }, {  1150, 0x00 }, {  1300, 0x08 }, {  1420, 0x00 }, {  1500, 0x08 },
+  {  4000, 0x0C }, {  4200, 0x08 }, {  4300, 0x0C },
+  {  6000, 0x2C }, {  6100, 0x0C }, {  6350, 0x2C }, {  6400, 0x0C }, {  6900, 0x2C },
+  {  9000, 0x2E }, {  9080, 0x2C }, {  9200, 0x2E },
+  { 60000, 0x2C }, { 60120, 0x2E }, { 60300, 0x2C }, { 60700, 0x2E }, { 61000, 0x2C },
+  { 63000, 0x28 }, { 63100, 0x2C }, { 63200, 0x28 },
+  { 65000, 0x20 }, { 65050, 0x28 }, { 65300, 0x20 },
+  { 68000, 0x00 }, { 68200, 0x20 }, { 68500, 0x00 },
+};
+
+// --- ---P  'w', one finger, 4 ms of chatter on the lift
+const TraceRow traceW[] = {
+  {     0, 0x00 },
+  {  2000, 0x01 }, {  2100, 0x00 }, {  2400, 0x01 }, {  2450, 0x00 }, {  3100, 0x01 },
+  { 50000, 0x00 }, { 50300, 0x01 }, { 50900, 0x00 }, { 51000, 0x01 }, { 52500, 0x00 },
+  { 53000, 0x01 }, { 54000, 0x00 },
+};
+
+// -C- I---  'l', the thumb lifts first and bounces back down twice
+const TraceRow traceL[] = {
+  {     0, 0x00 },
+  {   500, 0x08 }, {   700, 0x00 }, {   800, 0x08 },
+  {  1500, 0x28 }, {  1550, 0x08 }, {  1600, 0x28 }, {  1900, 0x08 }, {  2300, 0x28 },
+  { 40000, 0x20 }, { 40400, 0x28 }, { 40600, 0x20 }, { 41800, 0x28 }, { 42000, 0x20 },
+  { 44000, 0x00 }, { 44100, 0x20 }, { 44300, 0x00 },
+};
+
+// --- IM--  'd', long chatter on the middle finger landing
+const TraceRow traceD[] = {
+  {     0, 0x00 },
+  {  1000, 0x04 }, {  1300, 0x00 }, {  1350, 0x04 }, {  1700, 0x00 }, {  1800, 0x04 },
+  {  2600, 0x00 }, {  2700, 0x04 },
+  {  4000, 0x0C }, {  4100, 0x04 }, {  4200, 0x0C },
+  { 35000, 0x04 }, { 35500, 0x0C }, { 35600, 0x04 },
+  { 36500, 0x00 }, { 36700, 0x04 }, { 37000, 0x00 },
+};
+
+#define TRACE(chord, lift, rows) { chord, lift, rows, sizeof(rows) / sizeof(rows[0]) }
+const Trace traces[] = {
+  TRACE(0x2E, 60000, traceA),
+  TRACE(0x01, 50000, traceW),
+  TRACE(0x28, 40000, traceL),
+  TRACE(0x0C, 35000, traceD),
+};
+const size_t traceCount = sizeof(traces) / sizeof(traces[0]);
+
+static std::string tap(byte key){
+  char command[40];
+  snprintf(command, sizeof(command), "AT+BLEKEYBOARDCODE=00-00-%02x\r\n", key);
+  return std::string(command) + "AT+BLEKEYBOARDCODE=00-00\r\n";
+}
+
+// play one trace from a fresh start, returns us from the first lift to
+// the first AT command
+static unsigned long replay(const Trace &trace, byte eager){
+  driverReset();
+  eagerSwitches = eager;
+  unsigned long end = trace.rows[trace.count - 1].us + 60000;
+  unsigned long sentAt = 0;
+  size_t row = 0;
+  while (hostMicros() < end) {
+    while (row < trace.count && trace.rows[row].us <= hostMicros()) {
+      hostSetSwitches(trace.rows[row++].keyState);
+    }
+    unsigned long before = hostCommandCount();
+    chorderLoop();
+    if (!sentAt && hostCommandCount() != before) sentAt = hostMicros();
+    hostAdvanceMicros(scanTickMicros);
+  }
+  return sentAt - trace.liftUs;
+}
+
+static unsigned long median(std::vector<unsigned long> v){
+  std::sort(v.begin(), v.end());
+  return v[v.size() / 2];
+}
+
+TEST(tracesTypeTheirChordOnce){
+  const byte modes[] = { 0x00, 0x7F };
+  for (size_t m = 0; m < sizeof(modes); m++) {
+    for (size_t i = 0; i < traceCount; i++) {
+      replay(traces[i], modes[m]);
+      if (hostTraffic() != tap(keymapLookup(0, traces[i].chord))) {
+        printf("  trace %u, eager %02x\n", (unsigned)i, modes[m]);
+        CHECK_TRAFFIC(tap(keymapLookup(0, traces[i].chord)));
+      }
+    }
+  }
+}
+
+TEST(eagerSwitchesSendSooner){
+  std::vector<unsigned long> settling, eager;
+  for (size_t i = 0; i < traceCount; i++) {
+    settling.push_back(replay(traces[i], 0x00));
+    eager.push_back(replay(traces[i], 0x7F));
+  }
+  printf("  median lift -> send: %lu us per switch, %lu us eager\n",
+         median(settling), median(eager));
+  CHECK(median(settling) >= debounceDelay * 1000ul);
+  CHECK(median(eager) < 1000ul);
+}
+
+TEST(nonEagerSwitchIgnoresAGlitch){
+  driverReset();
+  eagerSwitches = 0x7F & ~0x01;  // Pinky settles, the rest are eager
+  hostSetSwitches(0x01);
+  driveFor(2000);
+  hostSetSwitches(0);
+  driveFor(40000);
+  CHECK_TRAFFIC("");
+  eagerSwitches = 0x7F;
+}
+
+TEST(switchesSettleOnTheirOwn){
+  driverReset();
+  eagerSwitches = 0x00;
+  // the index keeps chattering, the middle finger still comes through
+  hostSetSwitches(0x04);
+  for (int i = 0; i < 10; i++) {
+    hostSetSwitches(0x04 | (i & 1 ? 0x08 : 0));
+    driveFor(1000);
+  }
+  hostSetSwitches(0);
+  driveFor(40000);
+  CHECK_TRAFFIC(tap(keymapLookup(0, 0x04)));
+  eagerSwitches = 0x7F;
+}
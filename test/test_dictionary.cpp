@@ -0,0 +1,108 @@
+// test_dictionary.cpp
+// The word table decodes to the WORD_ codes, and a word chord goes out
+// as one string with the bigram macros' modifier rules.
+
+#define TEST_MAIN
+#include "TestMain.h"
+
+#include "ChordDriver.h"
+#include "Chorder.h"
+#include "Dictionary.h"
+#include "KeyCodes.h"
+#include "Keymap.h"
+#include "Macro.h"
+#include "OutputQueue.h"
+#include "WordTable.h"
+
+const byte CHORD_THE    = 0x58;  // F-N I---
+const byte CHORD_LSHIFT = 0x40;  // F-- ----
+const byte CHORD_FUNC   = 0x11;  // --N ---P
+const byte CHORD_CTRL   = 0x1B;  // --N I-RP  in function layer
+const byte CHORD_LATCH  = 0x1C;  // --N IM--  in function layer
+
+static std::string word(const char *text){
+  return std::string("AT+BleKeyboard=") + text + "\r\n"
+         "AT+BLEKEYBOARDCODE=00-00\r\n";
+}
+
+TEST(tableDecodesToTheWordCodes){
+  const char *words[] = {
+    "about", "and", "for", "from", "have", "that", "the", "their",
+    "there", "this", "which", "with", "would", "you"
+  };
+  CHECK_EQ(sizeof(words) / sizeof(words[0]), (size_t)dictionaryWordCount);
+  char buf[DictionaryWordSize];
+  size_t plain = 0;
+  for (byte i = 0; i < dictionaryWordCount; i++) {
+    CHECK_EQ(strlen(words[i]), (size_t)dictionaryWord(i, buf));
+    CHECK_EQ(std::string(words[i]), std::string(buf));
+    plain += strlen(words[i]) + 1;
+  }
+  CHECK_EQ(0, dictionaryWord(dictionaryWordCount, buf));
+  // smaller than the words one after another, let alone with pointers
+  CHECK(sizeof(dictionary_words) < plain);
+}
+
+TEST(tableIsSortedAndFullyShared){
+  char previous[DictionaryWordSize] = "";
+  char buf[DictionaryWordSize];
+  const char *p = dictionary_words;
+  for (byte i = 0; i < dictionaryWordCount; i++) {
+    dictionaryWord(i, buf);
+    size_t shared = 0;
+    while (previous[shared] && previous[shared] == buf[shared]) shared++;
+    CHECK_EQ(shared + 1, (size_t)(byte)*p);
+    CHECK(strcmp(previous, buf) < 0);
+    p++;
+    while ((byte)*p >= ' ') p++;
+    strcpy(previous, buf);
+  }
+  CHECK_EQ(0, *p);
+}
+
+TEST(wordChordsAreBound){
+  for (byte i = 0; i < dictionaryWordCount; i++) {
+    CHECK_EQ(DIV_Word + i, keymapLookup(0, 0x52 + i));
+  }
+}
+
+TEST(wordGoesOutAsOneString){
+  driverReset();
+  typeChord(CHORD_THE);
+  CHECK_TRAFFIC(word("the"));
+}
+
+TEST(shiftCapitalisesTheFirstLetter){
+  driverReset();
+  typeChord(CHORD_LSHIFT);
+  typeChord(CHORD_THE);
+  typeChord(CHORD_THE);  // the shift was used up
+  CHECK_TRAFFIC(word("The") + word("the"));
+}
+
+TEST(latchedShiftCapitalisesAll){
+  driverReset();
+  typeChord(CHORD_LSHIFT);
+  typeChord(CHORD_FUNC);
+  typeChord(CHORD_LATCH);
+  typeChord(CHORD_THE);
+  typeChord(CHORD_THE);
+  CHECK_TRAFFIC(word("THE") + word("THE"));
+}
+
+TEST(otherModifiersTypeAKeyAtATime){
+  driverReset();
+  typeChord(CHORD_FUNC);
+  typeChord(CHORD_CTRL);
+  typeChord(CHORD_LATCH);  // latched ctrl, back in the alpha layer
+  typeChord(CHORD_THE, 40, 200);
+  CHECK_TRAFFIC("AT+BLEKEYBOARDCODE=01-00-17\r\nAT+BLEKEYBOARDCODE=00-00\r\n"
+                "AT+BLEKEYBOARDCODE=01-00-0b\r\nAT+BLEKEYBOARDCODE=00-00\r\n"
+                "AT+BLEKEYBOARDCODE=01-00-08\r\nAT+BLEKEYBOARDCODE=00-00\r\n");
+}
+
+TEST(unknownWordDoesNothing){
+  driverReset();
+  typeWord(dictionaryWordCount, 0, 0);
+  CHECK_EQ(0, outputQueueDepth());
+}
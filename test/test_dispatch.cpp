@@ -0,0 +1,137 @@
+// test_dispatch.cpp
+// dispatchKey() by KeyCodes.h range: modifiers through modifier_bits,
+// media keys and fixed-modifier keys from KeyTables.h, and the codes
+// that change the mode keeping the modifiers for the next key.
+
+#define TEST_MAIN
+#include "TestMain.h"
+
+#include "ChordDriver.h"
+#include "Chorder.h"
+#include "KeyCodes.h"
+#include "OutputQueue.h"
+
+static std::string down(int mod, int key){
+  char command[40];
+  snprintf(command, sizeof(command), "AT+BLEKEYBOARDCODE=%02x-00-%02x\r\n", mod, key);
+  return command;
+}
+
+static std::string tap(int mod, int key){
+  return down(mod, key) + "AT+BLEKEYBOARDCODE=00-00\r\n";
+}
+
+static void dispatch(byte code){
+  dispatchKey(code);
+  outputFlush();
+}
+
+TEST(plainKeysGoOutWithTheModifiers){
+  driverReset();
+  dispatch(ENUMKEY_A);
+  dispatch(MOD_LSHIFT);
+  dispatch(ENUMKEY_A);
+  dispatch(ENUMKEY_A);  // the shift was used up
+  CHECK_TRAFFIC(tap(0, 0x04) + tap(2, 0x04) + tap(0, 0x04));
+}
+
+TEST(eachModifierTogglesItsBit){
+  const byte mods[] = { MOD_LCTRL, MOD_LSHIFT, MOD_LALT, MOD_LGUI,
+                        MOD_RCTRL, MOD_RSHIFT, MOD_RALT, MOD_RGUI };
+  for (int i = 0; i < 8; i++) {
+    driverReset();
+    dispatch(mods[i]);
+    CHECK_EQ(0u, hostTraffic().size());
+    dispatch(ENUMKEY_B);
+    dispatch(mods[i]);
+    dispatch(mods[i]);  // on and off again
+    dispatch(ENUMKEY_B);
+    CHECK_TRAFFIC(tap(1 << i, 0x05) + tap(0, 0x05));
+  }
+  driverReset();
+  dispatch(MOD_LCTRL);
+  dispatch(MOD_RALT);
+  dispatch(MULTI_CtlAlt);  // ctrl off, alt on
+  dispatch(ENUMKEY_B);
+  CHECK_TRAFFIC(tap(0x44, 0x05));
+}
+
+TEST(everyComboTapsItsKeys){
+  struct { byte code, mod, key; } expected[] = {
+    { MACRO_dollar,       2, 0x21 },
+    { MACRO_percent,      2, 0x22 },
+    { MACRO_ampersand,    2, 0x24 },
+    { MACRO_asterisk,     2, 0x25 },
+    { MACRO_question,     2, 0x38 },
+    { MACRO_plus,         2, 0x2E },
+    { MACRO_openparen,    2, 0x26 },
+    { MACRO_closeparen,   2, 0x27 },
+    { MACRO_opencurly,    2, 0x2F },
+    { MACRO_closecurly,   2, 0x30 },
+    { ANDROID_search,     4, 0x2C },
+    { ANDROID_home,       4, 0x29 },
+    { ANDROID_menu,    0x10, 0x29 },
+    { ANDROID_back,       0, 0x29 },
+    { ANDROID_dpadcenter, 0, 0x5D },
+  };
+  const size_t count = sizeof(expected) / sizeof(expected[0]);
+  CHECK_EQ((size_t)(DIV_Macro - DIV_Combo), count);
+  for (size_t i = 0; i < count; i++) {
+    driverReset();
+    CHECK_EQ(expected[i].code, DIV_Combo + i);
+    dispatch(MOD_LCTRL);  // fixed modifiers, the current ones don't count
+    dispatch(expected[i].code);
+    dispatch(ENUMKEY_A);  // and they are used up
+    if (hostTraffic() != tap(expected[i].mod, expected[i].key) + tap(0, 0x04)) {
+      printf("  combo %u\n", (unsigned)i);
+      CHECK_TRAFFIC(tap(expected[i].mod, expected[i].key) + tap(0, 0x04));
+    }
+  }
+}
+
+TEST(mediaKeysSendTheirControl){
+  const char *expected[] = {
+    "PLAYPAUSE", "MEDIANEXT", "MEDIAPREVIOUS", "MEDIASTOP", "VOLUME+,500", "VOLUME-,500"
+  };
+  for (int i = 0; i < 6; i++) {
+    driverReset();
+    dispatch(MEDIA_playpause + i);
+    CHECK_TRAFFIC(std::string("AT+BleHidControlKey=") + expected[i] + "\r\n");
+  }
+}
+
+TEST(modeKeysKeepTheModifiers){
+  driverReset();
+  dispatch(MOD_LSHIFT);
+  dispatch(MODE_NUM);
+  dispatch(MODE_NUM);
+  dispatch(ENUMKEY_C);
+  CHECK_TRAFFIC(tap(2, 0x06));
+}
+
+TEST(latchKeepsTheModifiersAfterAKey){
+  driverReset();
+  dispatch(MOD_LCTRL);
+  dispatch(LATCH);
+  dispatch(ENUMKEY_C);
+  dispatch(ENUMKEY_C);
+  dispatch(LATCH);
+  dispatch(ENUMKEY_C);
+  CHECK_TRAFFIC(tap(1, 0x06) + tap(1, 0x06) + tap(0, 0x06));
+}
+
+TEST(rangeEdgesAreSentAsRawKeys){
+  // the range markers and codes past the dictionary aren't bound to
+  // anything, they go out as they are
+  const byte raw[] = { ENUMKEY__, DIV_Mods, DIV_Modes, RAW_LGUI, 0xFF };
+  for (size_t i = 0; i < sizeof(raw); i++) {
+    driverReset();
+    dispatch(raw[i]);
+    CHECK_TRAFFIC(tap(0, raw[i]));
+  }
+  // past the last macro or word is still in their range, and does nothing
+  driverReset();
+  dispatch(DIV_Last);
+  dispatch(DIV_WordLast);
+  CHECK_EQ(0u, hostTraffic().size());
+}
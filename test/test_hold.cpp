@@ -0,0 +1,127 @@
+// test_hold.cpp
+// Chords sent on hold (holdDwellMs set) against chords sent on release,
+// single chords and then whole typing sessions for error rate and latency.
+
+#define TEST_MAIN
+#include "TestMain.h"
+
+#include "ChordDriver.h"
+#include "Chorder.h"
+#include "TypingSession.h"
+
+#include <algorithm>
+
+const byte CHORD_A       = 0x2E;  // -C- IMR-
+const byte CHORD_I       = 0x08;  // --- I---
+const byte CHORD_NUMLOCK = 0x3F;  // -CN IMRP, no bigger chord is bound
+
+const unsigned int Dwell = 25;
+
+static std::string tap(const char *key){
+  return std::string("AT+BLEKEYBOARDCODE=00-00-") + key + "\r\n"
+         "AT+BLEKEYBOARDCODE=00-00\r\n";
+}
+
+static void holdMode(unsigned int dwell){
+  driverReset();
+  holdDwellMs = dwell;
+}
+
+TEST(chordGoesOutWhileHeld){
+  holdMode(Dwell);
+  hostSetSwitches(CHORD_A);
+  driveFor((Dwell - 2) * 1000);
+  CHECK_TRAFFIC("");
+  driveFor(4000);
+  CHECK_TRAFFIC(tap("04"));
+  // lifting only ends the chord
+  hostSetSwitches(0);
+  driveFor(40000);
+  CHECK_TRAFFIC(tap("04"));
+  holdDwellMs = 0;
+}
+
+TEST(anotherFingerStartsTheDwellOver){
+  holdMode(Dwell);
+  hostSetSwitches(CHORD_I);
+  driveFor((Dwell - 5) * 1000);
+  hostSetSwitches(CHORD_A);
+  driveFor((Dwell - 2) * 1000);
+  CHECK_TRAFFIC("");
+  driveFor(4000);
+  CHECK_TRAFFIC(tap("04"));
+  holdDwellMs = 0;
+}
+
+TEST(chordWithNothingBiggerGoesAtOnce){
+  holdMode(Dwell);
+  hostSetSwitches(CHORD_NUMLOCK);
+  driveFor(1000);
+  CHECK_TRAFFIC(tap("53"));
+  holdDwellMs = 0;
+}
+
+TEST(fingersAddedAfterSendingAreIgnored){
+  holdMode(Dwell);
+  hostSetSwitches(CHORD_I);
+  driveFor(40000);
+  hostSetSwitches(CHORD_A);
+  driveFor(100000);
+  hostSetSwitches(0);
+  driveFor(40000);
+  CHECK_TRAFFIC(tap("0c"));
+  // and the next chord goes as usual
+  hostSetSwitches(CHORD_A);
+  driveFor(40000);
+  CHECK_TRAFFIC(tap("0c") + tap("04"));
+  holdDwellMs = 0;
+}
+
+TEST(releaseRearmsForRollingChords){
+  holdMode(Dwell);
+  hostSetSwitches(CHORD_A);
+  driveFor(40000);
+  // lift the ring finger and keep the rest: a new chord can start
+  hostSetSwitches(CHORD_A & ~0x02);
+  driveFor(10000);
+  hostSetSwitches((CHORD_A & ~0x02) | 0x01);  // -C- IM-P  MACRO_4, "in"
+  driveFor(100000);
+  CHECK_TRAFFIC(tap("04") + tap("0c") + tap("11"));
+  holdDwellMs = 0;
+}
+
+static double median(std::vector<double> v){
+  std::sort(v.begin(), v.end());
+  return v.empty() ? 0 : v[v.size() / 2];
+}
+
+static const char *sessionText =
+  "the quick brown fox jumps over the lazy dog while seven brave wizards "
+  "hex a jolly quartz sphinx and in the end there is another kind of "
+  "rhythm to chording than to typing on a row of keys ";
+
+static SessionResult session(const Typist &typist, unsigned int dwell){
+  driverReset();
+  sessionSeed(7);
+  holdDwellMs = dwell;
+  SessionResult result = playSession(sessionText, 400, typist);
+  holdDwellMs = 0;
+  return result;
+}
+
+TEST(sessionsTypeTheSameAndSooner){
+  const Typist *typists[] = { &steadyTypist, &fastTypist };
+  const char *names[] = { "steady", "fast" };
+  for (int t = 0; t < 2; t++) {
+    SessionResult release = session(*typists[t], 0);
+    SessionResult hold = session(*typists[t], Dwell);
+    printf("  %-6s typist, landing -> key p50: release %6.1f ms, %lu errors;"
+           " hold %6.1f ms, %lu errors\n", names[t],
+           median(release.landingToKey), release.errors,
+           median(hold.landingToKey), hold.errors);
+    CHECK_EQ(0ul, release.errors);
+    CHECK_EQ(0ul, hold.errors);
+    CHECK(median(hold.landingToKey) < median(release.landingToKey));
+    CHECK(median(hold.landingToKey) <= Dwell + 1);
+  }
+}
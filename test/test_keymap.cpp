@@ -0,0 +1,50 @@
+// test_keymap.cpp
+// Layer tables in ChordMappings.h and keymapLookup().
+
+#define TEST_MAIN
+#include "TestMain.h"
+
+#include "Keymap.h"
+#include "KeyCodes.h"
+#include "ChordMappings.h"
+
+TEST(denseLayersAreIndexedByChord){
+  CHECK_EQ(ENUMKEY__, keymapLookup(0, 0x00));
+  CHECK_EQ(ENUMKEY_W, keymapLookup(0, 0x01));
+  CHECK_EQ(ENUMKEY_A, keymapLookup(0, 0x2E));
+  CHECK_EQ(ENUMKEY_5, keymapLookup(1, 0x01));
+  CHECK_EQ(MACRO_000, keymapLookup(1, 0x0F));
+}
+
+TEST(sparseLayersAreSortedAndHoldNoEmptyEntries){
+  for (byte layer = 0; layer < keymapLayerCount; layer++) {
+    const keymap_layer_t &l = keymap_layers[layer];
+    CHECK(l.dense || l.sparse);
+    for (byte i = 0; i < l.sparseCount; i++) {
+      CHECK(l.sparse[i].chord < 128);
+      CHECK(l.sparse[i].key != ENUMKEY__);
+      if (i > 0) CHECK(l.sparse[i - 1].chord < l.sparse[i].chord);
+    }
+  }
+}
+
+TEST(sparseLookupFindsEveryEntryAndOnlyThose){
+  const keymap_layer_t &l = keymap_layers[2];
+  CHECK(l.sparse != 0);
+  byte next = 0;
+  for (int chord = 0; chord < 128; chord++) {
+    if (next < l.sparseCount && l.sparse[next].chord == chord) {
+      CHECK_EQ(l.sparse[next].key, keymapLookup(2, chord));
+      next++;
+    } else {
+      CHECK_EQ(ENUMKEY__, keymapLookup(2, chord));
+    }
+  }
+  CHECK_EQ(l.sparseCount, next);
+  CHECK_EQ(BAT_LVL, keymapLookup(2, 0x0E));
+  CHECK_EQ(MODE_RESET, keymapLookup(2, 0x70));
+}
+
+TEST(unknownLayerIsEmpty){
+  CHECK_EQ(ENUMKEY__, keymapLookup(keymapLayerCount, 0x01));
+}
@@ -0,0 +1,193 @@
+// test_keymap_compiler.cpp
+// The chord chart compiler (KeymapCompiler.h): chart syntax, the checks
+// that stop a bad chart, and the header it makes.
+
+#define TEST_MAIN
+#include "TestMain.h"
+
+#include "KeymapCompiler.h"
+
+static const char keyCodes[] =
+  "enum keycodes {\n"
+  "  ENUMKEY__,   // 0x00\n"
+  "  ENUMKEY_A, ENUMKEY_B,\n"
+  "  MODE_NUM, MODE_FUNC, MODE_NUMLCK, MOD_LCTRL, LATCH,\n"
+  "  MODE_POINTER, MODE_RESET, POINTER_up,\n"
+  "/* a comment, NOT_A_CODE, */\n"
+  "  DIV_Word = 0xB0,\n"
+  "  WORD_the = DIV_Word,\n"
+  "};\n"
+  "const int RAW_LGUI = 0xE3;\n";
+
+// the errors for a chart, none when it is fine
+static std::vector<std::string> compile(const char *text, KeymapChart &chart){
+  std::vector<std::string> errors;
+  if (parseChart("chart", text, chart, errors) && checkCodes(chart, keyCodes, errors))
+    checkChart(chart, errors);
+  for (size_t i = 0; i < errors.size(); i++) printf("    %s\n", errors[i].c_str());
+  return errors;
+}
+
+static std::vector<std::string> compile(const char *text){
+  KeymapChart chart;
+  return compile(text, chart);
+}
+
+static bool hasError(const std::vector<std::string> &errors, const std::string &part){
+  for (size_t i = 0; i < errors.size(); i++)
+    if (errors[i].find(part) != std::string::npos) return true;
+  return false;
+}
+
+static const char twoLayers[] =
+  "# alpha and numbers\n"
+  "layer ALPHA alpha auto\n"
+  "--- ---P  ENUMKEY_A   first\n"
+  "--N ----  MODE_NUM\n"
+  "layer NUMSYM numsym sparse number mode\n"
+  "--- I---  ENUMKEY_B\n"
+  "--N ----  MODE_NUM\n";
+
+TEST(patternsAreFcnImrp){
+  CHECK_EQ(0x00, parseChordPattern("--- ----"));
+  CHECK_EQ(0x7F, parseChordPattern("FCN IMRP"));
+  CHECK_EQ(0x1A, parseChordPattern("--N I-R-"));
+  CHECK_EQ(0x40, parseChordPattern("F------"));  // the space is optional
+  CHECK_EQ(-1, parseChordPattern("--X ----"));
+  CHECK_EQ(-1, parseChordPattern("--- ---"));
+  CHECK_EQ(-1, parseChordPattern("-C- I--P-"));
+  CHECK_EQ(-1, parseChordPattern("C-- ----"));  // letters have their place
+  CHECK_EQ("-CN I--P", chordPattern(0x39));
+}
+
+TEST(goodChartParses){
+  KeymapChart chart;
+  CHECK(compile(twoLayers, chart).empty());
+  CHECK_EQ(2u, chart.layers.size());
+  CHECK_EQ("alpha", chart.layers[0].array);
+  CHECK_EQ("number mode", chart.layers[1].title);
+  CHECK_EQ(0x01, chart.layers[0].entries[0].chord);
+  CHECK_EQ("first", chart.layers[0].entries[0].note);
+  CHECK(!chart.layers[0].dense);  // auto with 2 chords
+}
+
+TEST(autoGoesDenseAt64Chords){
+  std::string text = "layer ALPHA alpha auto\n";
+  for (int chord = 1; chord <= 64; chord++) text += chordPattern(chord) + "  ENUMKEY_A\n";
+  KeymapChart chart;
+  CHECK(compile(text.c_str(), chart).empty());
+  CHECK(chart.layers[0].dense);
+}
+
+TEST(badLinesSayWhere){
+  std::vector<std::string> errors = compile("layer ALPHA alpha\n");
+  CHECK(hasError(errors, "chart:1: expected: layer"));
+  errors = compile("--- ---P  ENUMKEY_A\n");
+  CHECK(hasError(errors, "chart:1: chord before the first layer"));
+  errors = compile("layer ALPHA alpha dense\n--- -X-P  ENUMKEY_A\n");
+  CHECK(hasError(errors, "chart:2: '--- -X-P' is not a chord"));
+  errors = compile("layer ALPHA alpha dense\n--- ---P\n");
+  CHECK(hasError(errors, "chart:2: expected"));
+  CHECK(hasError(compile("# nothing\n"), "no layers"));
+}
+
+TEST(unknownCodesAreCaught){
+  std::vector<std::string> errors = compile("layer ALPHA alpha dense\n--- ---P  ENUMKEY_Q\n"
+                                            "--- --R-  NOT_A_CODE\n--- --RP  RAW_LGUI\n"
+                                            "--- -M--  WORD_the\n");
+  CHECK_EQ(2u, errors.size());
+  CHECK(hasError(errors, "chart:2: ENUMKEY_Q is not in KeyCodes.h"));
+  CHECK(hasError(errors, "chart:3: NOT_A_CODE"));
+}
+
+TEST(codesHaveTheirEnumValues){
+  std::map<std::string, int> values = keyCodeValues(keyCodes);
+  CHECK_EQ(0, values["ENUMKEY__"]);
+  CHECK_EQ(2, values["ENUMKEY_B"]);
+  CHECK_EQ(10, values["POINTER_up"]);
+  CHECK_EQ(0xB0, values["DIV_Word"]);
+  CHECK_EQ(0xB0, values["WORD_the"]);
+  CHECK_EQ(0xE3, values["RAW_LGUI"]);
+  CHECK(!values.count("NOT_A_CODE"));
+}
+
+TEST(duplicateChordsAreCaught){
+  std::vector<std::string> errors = compile("layer ALPHA alpha dense\n--- ---P  ENUMKEY_A\n"
+                                            "--- ---P  ENUMKEY_B\n");
+  CHECK(hasError(errors, "chart:3: --- ---P is in ALPHA twice, first at line 2"));
+  // the same chord in two layers is fine
+  CHECK(compile(twoLayers).size() == 0);
+}
+
+TEST(chordsNobodyCanPressAreCaught){
+  std::vector<std::string> errors = compile("layer ALPHA alpha dense\n--- ----  ENUMKEY_A\n"
+                                            "--- ---P  ENUMKEY__\n");
+  CHECK(hasError(errors, "chart:2: --- ---- can't be pressed"));
+  CHECK(hasError(errors, "chart:3: ENUMKEY__"));
+  errors = compile("layer ALPHA alpha dense\n--- ---P  ENUMKEY_A\n"
+                   "layer ALPHA alpha2 dense\n");
+  CHECK(hasError(errors, "chart:3: layer ALPHA is already"));
+}
+
+TEST(unreachableLayersAreCaught){
+  // nothing in ALPHA switches to FUNCTION
+  std::vector<std::string> errors = compile("layer ALPHA alpha dense\n--- ---P  ENUMKEY_A\n"
+                                            "layer FUNCTION func sparse\n--- ---P  ENUMKEY_B\n");
+  CHECK(hasError(errors, "chart:3: layer FUNCTION can't be reached from ALPHA"));
+  // a switch to a layer the chart doesn't have
+  errors = compile("layer ALPHA alpha dense\n--N ---P  MODE_FUNC\n");
+  CHECK(hasError(errors, "chart:2: MODE_FUNC switches to FUNCTION, which has no layer"));
+}
+
+TEST(layerLoopsAreCaught){
+  // FUNCTION only has a modifier and a switch to NUMSYM, NUMSYM a latch and
+  // a switch back to FUNCTION: once in, every chord keeps you there
+  std::vector<std::string> errors = compile(
+    "layer ALPHA alpha dense\n--N ---P  MODE_FUNC\n"
+    "layer NUMSYM numsym sparse\n--N ---P  MODE_FUNC\n--- ---P  LATCH\n"
+    "layer FUNCTION func sparse\n--N ----  MODE_NUM\n--- ---P  MOD_LCTRL\n");
+  CHECK(hasError(errors, "chart:3: layer NUMSYM only switches among layers that never get back to ALPHA"));
+  CHECK(hasError(errors, "chart:6: layer FUNCTION only switches"));
+  CHECK_EQ(2u, errors.size());
+  // MODE_NUMLCK can also go to ALPHA
+  CHECK(compile("layer ALPHA alpha dense\n--N ---P  MODE_FUNC\n"
+                "layer NUMSYM numsym sparse\n--N ---P  MODE_FUNC\n"
+                "layer FUNCTION func sparse\n--N ----  MODE_NUMLCK\n").empty());
+  // any key that sends gets you out
+  CHECK(compile("layer ALPHA alpha dense\n--N ---P  MODE_FUNC\n"
+                "layer NUMSYM numsym sparse\n--N ---P  MODE_FUNC\n--- ---P  ENUMKEY_A\n"
+                "layer FUNCTION func sparse\n--N ----  MODE_NUMLCK\n").empty());
+}
+
+TEST(pointerStaysLockedUntilLeft){
+  // what is sent in POINTER stays there, so it needs a way out
+  std::vector<std::string> errors = compile(
+    "layer ALPHA alpha dense\n--N ---P  MODE_POINTER\n"
+    "layer POINTER pointer sparse\n--- ---P  POINTER_up\n--- --R-  ENUMKEY_A\n");
+  CHECK(hasError(errors, "chart:3: layer POINTER only switches"));
+  CHECK(compile("layer ALPHA alpha dense\n--N ---P  MODE_POINTER\n"
+                "layer POINTER pointer sparse\n--- ---P  POINTER_up\n--N ----  MODE_POINTER\n").empty());
+  CHECK(compile("layer ALPHA alpha dense\n--N ---P  MODE_POINTER\n"
+                "layer POINTER pointer sparse\n--- ---P  POINTER_up\n--N ----  MODE_RESET\n").empty());
+}
+
+TEST(headerHasTheTablesAndAsserts){
+  KeymapChart chart;
+  CHECK(compile(twoLayers, chart).empty());
+  chart.layers[0].dense = true;
+  std::string header = emitMappings(chart);
+  CHECK(header.find("const keymap_t alpha[] PROGMEM = {\n"
+                    "  ENUMKEY__,                        // --- ----  0x00   no keys pressed\n"
+                    "  ENUMKEY_A,                        // --- ---P  0x01   first\n") != std::string::npos);
+  CHECK(header.find("  ENUMKEY__                         // FCN IMRP  0x7F\n};\n"
+                    "static_assert(sizeof(alpha) == 128") != std::string::npos);
+  CHECK(header.find(" * number mode                        *\n"
+                    " * sparse, only the chords in use     *\n") != std::string::npos);
+  CHECK(header.find("constexpr keymap_entry_t numsym[] PROGMEM = {\n"
+                    "  { 0x08, ENUMKEY_B },              // --- I---  0x08\n"
+                    "\n"
+                    "  { 0x10, MODE_NUM }                // --N ----  0x10\n};\n") != std::string::npos);
+  CHECK(header.find("keymapSparseOk(numsym,") != std::string::npos);
+  CHECK(header.find("  { alpha, 0, 0 },                            // ALPHA\n") != std::string::npos);
+  CHECK(header.find("== 2,\n") != std::string::npos);
+}
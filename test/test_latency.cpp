@@ -0,0 +1,146 @@
+// test_latency.cpp
+// Per stage latency histograms (Latency.h): the buckets, and each stage
+// timed where it happens in the core.
+
+#define TEST_MAIN
+#include "TestMain.h"
+
+#include "AckPacing.h"
+#include "ChordDriver.h"
+#include "Chorder.h"
+#include "Debounce.h"
+#include "KeyCodes.h"
+#include "Latency.h"
+#include "Macro.h"
+#include "OutputQueue.h"
+
+#include <algorithm>
+
+const byte CHORD_A      = 0x2E;  // -C- IMR-
+const byte CHORD_FUNC   = 0x11;  // --N ---P
+const byte CHORD_REPORT = 0x0D;  // --- IM-P  LATENCY_REPORT in function layer
+
+static int bucketHolding(byte stage){
+  for (byte b = 0; b < LatencyBuckets; b++)
+    if (latencyHistograms[stage].count[b]) return b;
+  return -1;
+}
+
+TEST(bucketsDoubleFromEightMicros){
+  driverReset();
+  const unsigned long micros[] = { 0, 7, 8, 15, 16, 1000, 131071, 131072, 4000000000ul };
+  const byte bucket[] = { 0, 0, 1, 1, 2, 7, 14, 15, 15 };
+  for (byte i = 0; i < sizeof(micros) / sizeof(micros[0]); i++) {
+    latencyInit();
+    latencyRecord(LAT_TOTAL, micros[i]);
+    CHECK_EQ(bucket[i], bucketHolding(LAT_TOTAL));
+  }
+}
+
+TEST(percentilesAreBucketEdges){
+  driverReset();
+  for (int i = 0; i < 9; i++) latencyRecord(LAT_QUEUE, 100);  // < 128
+  latencyRecord(LAT_QUEUE, 200000);                         // open bucket
+  CHECK_EQ(10ul, latencyCount(LAT_QUEUE));
+  CHECK_EQ(128ul, latencyPercentile(LAT_QUEUE, 50));
+  CHECK_EQ(128ul, latencyPercentile(LAT_QUEUE, 90));
+  CHECK_EQ(200000ul, latencyPercentile(LAT_QUEUE, 100));
+  CHECK_EQ(0ul, latencyPercentile(LAT_ACK, 50));
+  for (int i = 0; i < 70000; i++) latencyRecord(LAT_ACK, 0);
+  CHECK_EQ(0xFFFF, latencyHistograms[LAT_ACK].count[0]);
+}
+
+TEST(aChordIsTimedStageByStage){
+  driverReset();
+  typeChord(CHORD_A, 40, 40);
+  CHECK_EQ(2ul, latencyCount(LAT_DEBOUNCE));  // down and up, eager
+  CHECK_EQ(0ul, latencyHistograms[LAT_DEBOUNCE].maxMicros);
+  CHECK_EQ(1ul, latencyCount(LAT_CHORD));
+  CHECK_EQ(40000ul, latencyHistograms[LAT_CHORD].maxMicros);
+  CHECK_EQ(1ul, latencyCount(LAT_DISPATCH));
+  CHECK_EQ(2ul, latencyCount(LAT_QUEUE));
+  CHECK_EQ(1ul, latencyCount(LAT_FORMAT));
+  CHECK_EQ(2ul, latencyCount(LAT_WRITE));
+  CHECK_EQ(1ul, latencyCount(LAT_TOTAL));
+  CHECK_EQ(0ul, latencyCount(LAT_ACK));
+}
+
+TEST(debounceWaitIsTimedWithoutEagerEdges){
+  driverReset();
+  eagerSwitches = 0;
+  typeChord(CHORD_A, 40, 40);
+  CHECK_EQ((unsigned long)debounceDelay * 1000, latencyHistograms[LAT_DEBOUNCE].maxMicros);
+  // the lift was debounced too, the chord's total starts at the lift
+  CHECK_EQ((unsigned long)debounceDelay * 1000, latencyHistograms[LAT_TOTAL].maxMicros);
+  eagerSwitches = 0x7F;
+}
+
+TEST(bouncesThatComeToNothingAreNotCounted){
+  driverReset();
+  eagerSwitches = 0;
+  hostSetSwitches(0x01);
+  driveFor(2000);
+  hostSetSwitches(0);
+  driveFor(50000);
+  CHECK_EQ(0ul, latencyCount(LAT_DEBOUNCE));
+  typeChord(CHORD_A, 40, 40);
+  CHECK_EQ((unsigned long)debounceDelay * 1000, latencyHistograms[LAT_DEBOUNCE].maxMicros);
+  eagerSwitches = 0x7F;
+}
+
+TEST(macroKeysWaitInTheQueue){
+  driverReset();
+  runMacro(MACRO_TEST - DIV_Macro, 0, 0);
+  outputFlush();
+  CHECK_EQ(16ul, latencyCount(LAT_QUEUE));
+  CHECK_EQ(7ul * InterstitialDelay * 1000, latencyHistograms[LAT_QUEUE].maxMicros);
+}
+
+TEST(answersAreTimedWithAckPacing){
+  driverReset();
+  ackPacing = true;
+  hostSetAckDelay(3000);
+  typeChord(CHORD_A, 40, 40);
+  CHECK_EQ(2ul, latencyCount(LAT_ACK));
+  CHECK_EQ(3000ul, latencyHistograms[LAT_ACK].maxMicros);
+  ackPacing = false;
+}
+
+TEST(reportChordLogsAndTypesTheLatencies){
+  driverReset();
+  typeChord(CHORD_A);
+  typeChord(CHORD_FUNC);
+  hostClearTraffic();
+  typeChord(CHORD_REPORT);
+  const std::string &log = hostLog();
+  CHECK_EQ(0u, log.find("latency us: "));
+  // the report chord itself is in it
+  CHECK(log.find("\nchord n 3 p50 40000 p90 40000 max 40000 : 0 0 0 0 0 0 0 0 0 0 0 0 0 3 0 0\n")
+        != std::string::npos);
+  CHECK_EQ(9, (int)std::count(log.begin(), log.end(), '\n'));
+  CHECK_EQ(0u, hostTraffic().find("AT+BleKeyboard=lat us p50/p90 deb 0/0 cho 40000/40000 dis 0/0"));
+}
+
+TEST(summaryFitsItsBuffer){
+  driverReset();
+  for (byte s = 0; s < LatencyStages; s++) latencyRecord(s, 4000000000ul);
+  char summary[LatencySummarySize + 8];
+  memset(summary, 'x', sizeof(summary));
+  latencySummary(summary);
+  CHECK_EQ(LatencySummarySize - 1, (int)strlen(summary));
+  CHECK_EQ('x', summary[LatencySummarySize]);
+}
+
+TEST(reportLinesAtTheirLongestAreWhole){
+  driverReset();
+  for (byte s = 0; s < LatencyStages; s++) {
+    for (byte b = 0; b < LatencyBuckets; b++) latencyHistograms[s].count[b] = 0xFFFF;
+    latencyHistograms[s].maxMicros = 4000000000ul;
+  }
+  hostClearTraffic();
+  latencyReport();
+  std::string buckets;
+  for (byte b = 0; b < LatencyBuckets; b++) buckets += " 65535";
+  CHECK(hostLog().find("\ndebounce n 1048560 p50 1024 p90 131072 max 9999999 :" + buckets + "\n")
+        != std::string::npos);
+}
@@ -0,0 +1,165 @@
+// test_layout_optimizer.cpp
+// The layout optimizer (LayoutOptimizer.h): reading the board's usage
+// dump, the moves it proposes and the chart it writes with them made.
+
+#define TEST_MAIN
+#include "TestMain.h"
+
+#include "LayoutOptimizer.h"
+
+static KeymapChart chartOf(const char *text){
+  KeymapChart chart;
+  std::vector<std::string> errors;
+  if (parseChart("chart", text, chart, errors)) checkChart(chart, errors);
+  for (size_t i = 0; i < errors.size(); i++) printf("    %s\n", errors[i].c_str());
+  return chart;
+}
+
+static UsageCounts none(){
+  UsageCounts counts;
+  memset(&counts, 0, sizeof(counts));
+  return counts;
+}
+
+static bool hasMove(const LayoutPlan &plan, const std::string &code, int toLayer, int toChord){
+  for (size_t m = 0; m < plan.moves.size(); m++) {
+    const LayoutMove &move = plan.moves[m];
+    if (move.code == code) return move.toLayer == toLayer && move.toChord == toChord;
+  }
+  return false;
+}
+
+static const char chart[] =
+  "layer ALPHA alpha auto\n"
+  "--- ---P  ENUMKEY_A   first\n"
+  "--- -MRP  ENUMKEY_B   three fingers\n"
+  "--- IMRP  ENUMKEY_D\n"
+  "--N ----  MODE_NUM\n"
+  "layer NUMSYM numsym sparse\n"
+  "--- I---  ENUMKEY_C\n"
+  "--N ----  MODE_NUM\n";
+
+TEST(readsTheLastDumpInALog){
+  const char log[] =
+    "Typing over Bluefruit\n"
+    "usage halved 0 macros 0 words 0 function 0\n"
+    "mode num 0 numlck 0 func 0 numshift 0\n"
+    "end\n"
+    "boot to first key 812 ms\n"
+    "usage halved 2 macros 9 words 1 function 3\n"
+    "mode num 4 numlck 5 func 6 numshift 7\n"
+    "0 00 00 05 00 00 00 00 00 00 00 00 00 00 00 00 00 00\r\n"
+    "1 70 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 ff\n"
+    "end\n";
+  UsageCounts counts;
+  std::vector<std::string> errors;
+  CHECK(parseUsageDump("log", log, counts, errors));
+  CHECK_EQ(2ul, counts.halvings);
+  CHECK_EQ(9ul, counts.macros);
+  CHECK_EQ(7ul, counts.modeKeys[3]);
+  CHECK_EQ(5ul, counts.chords[0][1]);
+  CHECK_EQ(255ul, counts.chords[1][0x7F]);
+  CHECK_EQ(0ul, counts.chords[1][0x70]);
+}
+
+TEST(aBrokenDumpIsAnError){
+  UsageCounts counts;
+  std::vector<std::string> errors;
+  CHECK(!parseUsageDump("log", "nothing here\n", counts, errors));
+  CHECK(!parseUsageDump("log", "usage halved 0 macros 0 words 0 function 0\n"
+                               "mode num 0 numlck 0 func 0 numshift 0\n"
+                               "0 00 01 02\n", counts, errors));
+  CHECK(!parseUsageDump("log", "usage halved 0 macros 0 words 0 function 0\n"
+                               "mode num 0 numlck 0 func 0 numshift 0\n", counts, errors));
+  CHECK_EQ((size_t)3, errors.size());
+  CHECK(errors[1].find("want 16 counts") != std::string::npos);
+}
+
+TEST(theMostUsedGetTheCheapestChords){
+  UsageCounts counts = none();
+  counts.chords[0][0x01] = 1;   // A, one finger
+  counts.chords[0][0x07] = 50;  // B, three
+  counts.chords[1][0x08] = 20;  // C, one and the detour
+  LayoutPlan plan = optimizeLayout(chartOf(chart), counts, 2);
+
+  // the free one finger chords in chord order, A keeps its own
+  CHECK_EQ((size_t)2, plan.moves.size());
+  CHECK(hasMove(plan, "ENUMKEY_B", 0, 0x02));
+  CHECK(hasMove(plan, "ENUMKEY_C", 0, 0x04));
+
+  CHECK_EQ(71ul, plan.before.chars);
+  CHECK_EQ(1ul + 150 + 40, plan.before.fingers);
+  CHECK_EQ(20ul, plan.before.switches);
+  CHECK_EQ(191ul + 40, plan.before.cost);
+  CHECK_EQ(71ul, plan.after.fingers);
+  CHECK_EQ(0ul, plan.after.switches);
+  CHECK_EQ(71ul, plan.after.cost);
+}
+
+TEST(aDetourCostsTheSwitchChordAndTheWeight){
+  UsageCounts counts = none();
+  counts.chords[1][0x08] = 20;  // C, one finger and MODE_NUM's one
+  KeymapChart c = chartOf(chart);
+  CHECK_EQ(40ul, optimizeLayout(c, counts, 0).before.cost);
+  CHECK_EQ(140ul, optimizeLayout(c, counts, 5).before.cost);
+  CHECK_EQ(20ul, optimizeLayout(c, counts, 5).after.cost);
+}
+
+TEST(nothingUsedNothingMoves){
+  LayoutPlan plan = optimizeLayout(chartOf(chart), none(), 2);
+  CHECK(plan.moves.empty());
+  CHECK_EQ(0ul, plan.before.chars);
+}
+
+TEST(anUnusedCodeOnlyMovesForOneThatIsUsed){
+  static const char full[] =
+    "layer ALPHA alpha auto\n"
+    "--- ---P  ENUMKEY_A\n"
+    "--- --R-  ENUMKEY_B\n"
+    "--- -M--  ENUMKEY_C\n"
+    "--- I---  ENUMKEY_D\n"
+    "-C- ----  ENUMKEY_E\n"
+    "F-- ----  ENUMKEY_F\n"
+    "--- -MRP  ENUMKEY_G\n"
+    "--- IMRP  ENUMKEY_H\n"
+    "--N ----  MODE_NUM\n"
+    "layer NUMSYM numsym sparse\n"
+    "--N ----  MODE_NUM\n";
+  UsageCounts counts = none();
+  counts.chords[0][0x07] = 3;  // G
+  LayoutPlan plan = optimizeLayout(chartOf(full), counts, 2);
+  // G takes the first one finger chord, A the cheapest free one; H
+  // (never used either) stays
+  CHECK_EQ((size_t)2, plan.moves.size());
+  CHECK(hasMove(plan, "ENUMKEY_G", 0, 0x01));
+  CHECK(hasMove(plan, "ENUMKEY_A", 0, 0x03));
+}
+
+TEST(equalUseKeepsItsPlace){
+  UsageCounts counts = none();
+  counts.chords[0][0x01] = 5;  // A
+  counts.chords[0][0x07] = 5;  // B
+  counts.chords[0][0x0F] = 5;  // D
+  LayoutPlan plan = optimizeLayout(chartOf(chart), counts, 2);
+  CHECK(!hasMove(plan, "ENUMKEY_A", 0, 0x02));
+  CHECK(hasMove(plan, "ENUMKEY_B", 0, 0x02));
+  CHECK(hasMove(plan, "ENUMKEY_D", 0, 0x04));
+}
+
+TEST(theNewChartHasTheMovesMade){
+  UsageCounts counts = none();
+  counts.chords[0][0x07] = 50;  // B
+  counts.chords[1][0x08] = 20;  // C
+  KeymapChart c = chartOf(chart);
+  std::string proposed = applyLayout(chart, c, optimizeLayout(c, counts, 2));
+  CHECK_EQ(std::string(
+    "layer ALPHA alpha auto\n"
+    "--- ---P  ENUMKEY_A   first\n"
+    "--- IMRP  ENUMKEY_D\n"
+    "--N ----  MODE_NUM\n"
+    "--- --R-  ENUMKEY_B  three fingers\n"
+    "--- -M--  ENUMKEY_C\n"
+    "layer NUMSYM numsym sparse\n"
+    "--N ----  MODE_NUM\n"), proposed);
+  CHECK(!chartOf(proposed.c_str()).layers.empty());
+}
@@ -0,0 +1,86 @@
+// test_macro.cpp
+// Every macro in MacroTable.h run through runMacro(), against the key
+// sequence the old hand-written sendKey() cases sent.
+
+#define TEST_MAIN
+#include "TestMain.h"
+
+#include "ChordDriver.h"
+#include "Chorder.h"
+#include "KeyCodes.h"
+#include "Macro.h"
+#include "OutputQueue.h"
+
+#include <stdlib.h>
+
+static std::string down(int mod, int key){
+  char command[40];
+  snprintf(command, sizeof(command), "AT+BLEKEYBOARDCODE=%02x-00-%02x\r\n", mod, key);
+  return command;
+}
+
+static std::string tap(int mod, int key){
+  return down(mod, key) + "AT+BLEKEYBOARDCODE=00-00\r\n";
+}
+
+// current modifiers shift, latched ctrl, so M_TAPC and M_TAPL show
+const byte Current = 0x03;
+const byte Latched = 0x01;
+
+struct Expected {
+  byte code;
+  std::string traffic;
+  unsigned long gaps;  // InterstitialDelay waits
+};
+
+TEST(everyMacroSendsItsKeys){
+  const Expected expected[] = {
+    { MACRO_000,          tap(0, 0x27) + tap(0, 0x27) + tap(0, 0x27), 0 },
+    { MACRO_00,           tap(0, 0x27) + tap(0, 0x27), 0 },
+    { MACRO_quotes,       tap(2, 0x34) + tap(2, 0x34) + tap(0, 0x50), 2 },
+    { MACRO_parens,       tap(2, 0x26) + tap(2, 0x27) + tap(0, 0x50), 2 },
+    { MACRO_1,            tap(Current, 0x08) + tap(Latched, 0x15), 1 },
+    { MACRO_2,            tap(Current, 0x17) + tap(Latched, 0x0B), 1 },
+    { MACRO_3,            tap(Current, 0x04) + tap(Latched, 0x11), 1 },
+    { MACRO_4,            tap(Current, 0x0C) + tap(Latched, 0x11), 1 },
+    { MACRO_TEST,         tap(Current, 0x04) + tap(Current, 0x05) + tap(Current, 0x06) +
+                          tap(Current, 0x07) + tap(Current, 0x08) + tap(Current, 0x09) +
+                          tap(Current, 0x0A) + tap(Current, 0x0B), 7 },
+    { MACRO_SHIFTDN,      down(2, 0x00), 0 },
+  };
+  const size_t count = sizeof(expected) / sizeof(expected[0]);
+  CHECK_EQ((size_t)macroCount, count);
+
+  for (size_t i = 0; i < count; i++) {
+    driverReset();
+    CHECK_EQ(expected[i].code, DIV_Macro + i);
+    runMacro(expected[i].code - DIV_Macro, Current, Latched);
+    unsigned long start = hostMicros();
+    outputFlush();
+    if (hostTraffic() != expected[i].traffic) {
+      printf("  macro %u\n", (unsigned)i);
+      CHECK_TRAFFIC(expected[i].traffic);
+    }
+    CHECK_EQ(expected[i].gaps * InterstitialDelay * 1000ul, hostMicros() - start);
+  }
+}
+
+TEST(unknownMacroDoesNothing){
+  driverReset();
+  runMacro(macroCount, 0, 0);
+  runMacro(0xFF, 0, 0);
+  CHECK_EQ(0, outputQueueDepth());
+}
+
+TEST(macroCodesInAKeymapRunTheMacro){
+  driverReset();
+  typeChord(0x10);  // --N ----  MODE_NUM
+  typeChord(0x0F);  // --- IMRP  MACRO_000
+  CHECK_TRAFFIC(tap(0, 0x27) + tap(0, 0x27) + tap(0, 0x27));
+}
+
+TEST(rawCodesAboveTheMacrosAreSentAsKeys){
+  driverReset();
+  typeChord(0x10 | 0x08);  // --N I---  RAW_LGUI
+  CHECK_TRAFFIC(tap(0, 0xE3));
+}
@@ -0,0 +1,102 @@
+// test_output_queue.cpp
+// Macros go out through the output queue while the scan keeps running.
+
+#define TEST_MAIN
+#include "TestMain.h"
+
+#include "ChordDriver.h"
+#include "Chorder.h"
+#include "OutputQueue.h"
+
+#include <algorithm>
+
+const byte CHORD_A     = 0x2E;  // -C- IMR-
+const byte CHORD_FUNC  = 0x11;  // --N ---P
+const byte CHORD_TEST  = 0x06;  // --- -MR-  MACRO_TEST in function layer
+const byte CHORD_RESET = 0x70;  // FCN ----
+
+static std::string keys(const char *codes){
+  std::string out;
+  for (const char *c = codes; *c; c += 2) {
+    out += std::string("AT+BLEKEYBOARDCODE=00-00-") + c[0] + c[1] + "\r\n";
+    out += "AT+BLEKEYBOARDCODE=00-00\r\n";
+  }
+  return out;
+}
+
+TEST(loopNeverWaitsForAMacro){
+  driverReset();
+  typeChord(CHORD_FUNC);
+  hostSetSwitches(CHORD_TEST);
+  driveFor(40000);
+  hostSetSwitches(0);
+  unsigned long longest = 0;
+  for (int i = 0; i < 5000; i++) {
+    unsigned long before = hostMicros();
+    chorderLoop();
+    longest = std::max(longest, hostMicros() - before);
+    hostAdvanceMicros(scanTickMicros);
+  }
+  CHECK_EQ(0ul, longest);
+  CHECK_TRAFFIC(keys("0405060708090a0b"));
+}
+
+TEST(macroKeysAreSpacedByInterstitialDelay){
+  driverReset();
+  typeChord(CHORD_FUNC);
+  hostSetSwitches(CHORD_TEST);
+  driveFor(40000);
+  hostSetSwitches(0);
+  driveFor(20000);  // released and debounced, first key out
+  CHECK_EQ(2ul, hostCommandCount());
+  CHECK_EQ(20, outputQueueDepth());  // down, up and wait have gone
+  driveFor(InterstitialDelay * 1000);
+  CHECK_EQ(4ul, hostCommandCount());
+  driveFor(6 * InterstitialDelay * 1000);
+  CHECK_EQ(16ul, hostCommandCount());
+  CHECK_EQ(0, outputQueueDepth());
+  CHECK_EQ(23, outputStats.maxDepth);
+  CHECK_EQ(0u, outputStats.stalls);
+  CHECK_EQ(16ul, outputStats.sent);  // the waits between don't count
+}
+
+TEST(chordTypedDuringAMacroIsKeptAndSentAfterIt){
+  driverReset();
+  typeChord(CHORD_FUNC);
+  typeChord(CHORD_TEST, 40, 20);
+  typeChord(CHORD_A, 40, 20);  // while the macro is still going out
+  driveFor(400000);
+  CHECK_TRAFFIC(keys("0405060708090a0b04"));
+}
+
+TEST(fullQueueStallsInsteadOfDropping){
+  driverReset();
+  for (int i = 0; i < 20; i++) {
+    sendRawKey(0, 0x04 + i);
+    queueWait(10);
+  }
+  CHECK(outputStats.stalls > 0);
+  CHECK(outputStats.stalledMs > 0);
+  CHECK_EQ(OutputQueueSize, outputStats.maxDepth);
+  driveFor(400000);
+  CHECK_TRAFFIC(keys("0405060708090a0b0c0d0e0f1011121314151617"));
+}
+
+TEST(resetDropsTheRestOfAMacro){
+  driverReset();
+  typeChord(CHORD_FUNC);
+  typeChord(CHORD_TEST, 40, 15);
+  typeChord(CHORD_RESET, 20, 20);  // sent before the second macro key
+  driveFor(400000);
+  CHECK_TRAFFIC(keys("04") + "AT+BLEKEYBOARDCODE=00-00\r\n");
+}
+
+TEST(stringWaitsForQueuedKeys){
+  driverReset();
+  sendRawKey(0, 0x04);
+  queueWait(50);
+  sendRawKey(0, 0x05);
+  sendString("x");
+  CHECK_TRAFFIC(keys("0405") + "AT+BleKeyboard=x\r\nAT+BLEKEYBOARDCODE=00-00\r\n");
+  CHECK_EQ(1u, outputStats.stalls);
+}
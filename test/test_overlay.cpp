@@ -0,0 +1,288 @@
+// test_overlay.cpp
+// The keymap overlay (KeymapOverlay.h): entries in EEPROM win over the
+// chart, RECORD_BINDING changes them from the keyboard, a bad or half
+// written image leaves the chart alone, what a load and a lookup cost
+// in EEPROM reads, and the images tools/overlay_image makes.
+
+#define TEST_MAIN
+#include "TestMain.h"
+
+#include "ChordDriver.h"
+#include "Chorder.h"
+#include "KeyCodes.h"
+#include "Keymap.h"
+#include "KeymapOverlay.h"
+#include "OverlayImage.h"
+
+const byte CHORD_W      = 0x01;  // --- ---P  ENUMKEY_W in ALPHA
+const byte CHORD_Y      = 0x02;  // --- --R-  ENUMKEY_Y in ALPHA
+const byte CHORD_A      = 0x2E;  // -C- IMR-  ENUMKEY_A in ALPHA
+const byte CHORD_NUM    = 0x10;  // --N ----  MODE_NUM in ALPHA
+const byte CHORD_FUNC   = 0x11;  // --N ---P  MODE_FUNC in ALPHA
+const byte CHORD_RESET  = 0x70;  // FCN ----  MODE_RESET in ALPHA
+const byte CHORD_RECORD = 0x0B;  // --- I-RP  RECORD_BINDING in FUNCTION
+const byte CHORD_MACRO  = 0x41;  // F-- ---P  in the overlays below
+
+// an AVR EEPROM read with its call, generously; the host clock doesn't
+// run while code does, so the load is costed by its reads
+const unsigned long EepromReadMicros = 2;
+
+static KeymapChart chart(){
+  KeymapChart c;
+  std::vector<std::string> errors;
+  parseChart("chart", "layer ALPHA a auto\nlayer NUMSYM b auto\n"
+                      "layer FUNCTION c auto\nlayer POINTER d auto\n", c, errors);
+  return c;
+}
+
+static std::map<std::string, int> codes(){
+  std::map<std::string, int> c;
+  c["ENUMKEY_Q"] = ENUMKEY_Q;
+  c["OVERLAY_MACRO_0"] = OVERLAY_MACRO_0;
+  c["OVERLAY_MACRO_1"] = OVERLAY_MACRO_1;
+  return c;
+}
+
+static OverlayBytes build(const std::string &text, std::vector<std::string> &errors){
+  OverlayBytes image;
+  buildOverlay("overlay", text, chart(), codes(), image, errors);
+  return image;
+}
+
+// a fresh board with 'text' in its EEPROM
+static void install(const std::string &text){
+  driverReset();
+  std::vector<std::string> errors;
+  CHECK_EQ((int)OVERLAY_OK, loadOverlay(build(text, errors)));
+  CHECK(errors.empty());
+  hostClearTraffic();
+}
+
+static void record(byte target, byte code){
+  typeChord(CHORD_FUNC);
+  typeChord(CHORD_RECORD);
+  typeChord(target);
+  typeChord(code);
+}
+
+static std::string tap(const char *code){
+  return std::string("AT+BLEKEYBOARDCODE=") + code + "\r\nAT+BLEKEYBOARDCODE=00-00\r\n";
+}
+
+static bool hasError(const std::vector<std::string> &errors, const std::string &text){
+  for (size_t i = 0; i < errors.size(); i++)
+    if (errors[i] == text) return true;
+  return false;
+}
+
+TEST(anEntryWinsOverTheChart){
+  install("layer ALPHA\n--- ---P  ENUMKEY_Q\n");
+  CHECK_EQ(ENUMKEY_Q, keymapLookup(0, CHORD_W));
+  CHECK_EQ(ENUMKEY_W, keymapChartLookup(0, CHORD_W));
+  CHECK_EQ(ENUMKEY_A, keymapLookup(0, CHORD_A));
+  CHECK_EQ(keymapChartLookup(1, CHORD_W), keymapLookup(1, CHORD_W));
+  typeChord(CHORD_W);
+  CHECK_TRAFFIC(tap("00-00-14"));
+}
+
+TEST(withNoOverlayALookupReadsNothing){
+  driverReset();
+  CHECK_EQ((int)OVERLAY_NONE, overlayStats.status);
+  unsigned long reads = hostEepromReads();
+  CHECK_EQ(ENUMKEY_W, keymapLookup(0, CHORD_W));
+  CHECK_EQ(reads, hostEepromReads());
+}
+
+TEST(aFullOverlayLoadsAndLooksUpCheaply){
+  std::string text;
+  const char *layers[] = { "ALPHA", "NUMSYM", "FUNCTION", "POINTER" };
+  for (int e = 0; e < OverlayMaxEntries; e++) {
+    if (e % 12 == 0) text += std::string("layer ") + layers[e / 12] + "\n";
+    text += chordPattern(1 + e * 5 % 127) + "  ENUMKEY_Q\n";
+  }
+  for (int m = 0; m < OverlayMacros; m++) {
+    text += "macro " + std::to_string(m);
+    for (int t = 0; t < OverlayMacroTaps; t++) text += " 00-14";
+    text += "\n";
+  }
+  install(text);
+  CHECK_EQ(OverlayMaxEntries, overlayStats.entries);
+
+  unsigned long reads = hostEepromReads();
+  overlayInit();
+  reads = hostEepromReads() - reads;
+  CHECK(reads * EepromReadMicros < 3000);  // under 3 ms added to the boot
+
+  // each entry found, and misses, in a few probes
+  unsigned long most = 0, total = 0;
+  for (int chord = 1; chord < 128; chord++) {
+    for (byte layer = 0; layer < OverlayLayers; layer++) {
+      unsigned long before = hostEepromReads();
+      keymapLookup(layer, chord);
+      unsigned long n = hostEepromReads() - before;
+      total += n;
+      if (n > most) most = n;
+    }
+  }
+  CHECK(most <= 2 * 6 + 1);
+  CHECK(total < 127 * OverlayLayers * 3);  // under 3 reads a lookup on average
+}
+
+TEST(recordingBindsAChordAndItStaysBound){
+  driverReset();
+  record(CHORD_W, CHORD_A);
+  CHECK_EQ(0u, hostTraffic().size());  // neither chord typed
+  CHECK(hostLog().find("overlay 00 01 04\n") != std::string::npos);
+  typeChord(CHORD_W);
+  CHECK_TRAFFIC(tap("00-00-04"));
+  // back in ALPHA after it
+  hostClearTraffic();
+  typeChord(CHORD_Y);
+  CHECK_TRAFFIC(tap("00-00-1c"));
+  // and over a power cycle
+  chorderInit();
+  hostClearTraffic();
+  typeChord(CHORD_W);
+  CHECK_TRAFFIC(tap("00-00-04"));
+}
+
+TEST(theModeKeysPickTheLayerToRecordIn){
+  driverReset();
+  typeChord(CHORD_FUNC);
+  typeChord(CHORD_RECORD);
+  typeChord(CHORD_NUM);
+  typeChord(CHORD_W);
+  typeChord(CHORD_A);
+  CHECK_EQ(ENUMKEY_A, keymapLookup(1, CHORD_W));
+  CHECK_EQ(ENUMKEY_W, keymapLookup(0, CHORD_W));
+}
+
+TEST(recordBindingAgainPutsTheChartBack){
+  driverReset();
+  record(CHORD_W, CHORD_A);
+  record(CHORD_Y, CHORD_A);
+  CHECK_EQ(2, overlayStats.entries);
+  typeChord(CHORD_FUNC);
+  typeChord(CHORD_RECORD);
+  typeChord(CHORD_W);
+  typeChord(CHORD_FUNC);
+  typeChord(CHORD_RECORD);
+  CHECK_EQ(1, overlayStats.entries);
+  CHECK_EQ(ENUMKEY_W, keymapLookup(0, CHORD_W));
+  CHECK_EQ(ENUMKEY_A, keymapLookup(0, CHORD_Y));
+  // binding it to what the chart has drops it too
+  CHECK(overlayBind(0, CHORD_Y, ENUMKEY_Y, keymapChartLookup(0, CHORD_Y)));
+  CHECK_EQ(0, overlayStats.entries);
+}
+
+TEST(resetGivesUpARecording){
+  driverReset();
+  typeChord(CHORD_FUNC);
+  typeChord(CHORD_RECORD);
+  typeChord(CHORD_W);
+  typeChord(CHORD_RESET);
+  typeChord(CHORD_A);
+  CHECK_TRAFFIC("AT+BLEKEYBOARDCODE=00-00\r\n" + tap("00-00-04"));  // reset()'s key up
+  CHECK_EQ(ENUMKEY_W, keymapLookup(0, CHORD_W));
+  // and so does RECORD_BINDING before a chord is picked
+  typeChord(CHORD_FUNC);
+  typeChord(CHORD_RECORD);
+  typeChord(CHORD_FUNC);
+  typeChord(CHORD_RECORD);
+  hostClearTraffic();
+  typeChord(CHORD_W);
+  CHECK_TRAFFIC(tap("00-00-1a"));
+}
+
+TEST(aBadImageLeavesTheChartAndRecordingStartsOver){
+  install("layer ALPHA\n--- ---P  ENUMKEY_Q\n");
+  halEepromWrite(OverlayEepromStart + OverlayHeaderSize + 2, ENUMKEY_A);
+  overlayInit();
+  CHECK_EQ((int)OVERLAY_BAD, overlayStats.status);
+  CHECK_EQ(ENUMKEY_W, keymapLookup(0, CHORD_W));
+  record(CHORD_Y, CHORD_A);
+  CHECK_EQ((int)OVERLAY_OK, overlayStats.status);
+  CHECK_EQ(1, overlayStats.entries);
+  CHECK_EQ(ENUMKEY_A, keymapLookup(0, CHORD_Y));
+  CHECK_EQ(ENUMKEY_W, keymapLookup(0, CHORD_W));
+}
+
+TEST(aPowerCutWhileRecordingNeverMixesImages){
+  for (unsigned long writes = 0; writes < 8; writes++) {
+    install("layer ALPHA\n--- --R-  ENUMKEY_Q\n");
+    hostEepromPowerFail(writes);
+    record(CHORD_W, CHORD_A);
+    hostEepromPowerFail(~0ul);
+    chorderInit();
+    if (overlayStats.status == OVERLAY_OK) {
+      CHECK_EQ(ENUMKEY_Q, keymapLookup(0, CHORD_Y));
+      CHECK(keymapLookup(0, CHORD_W) == ENUMKEY_W || keymapLookup(0, CHORD_W) == ENUMKEY_A);
+    } else {
+      CHECK_EQ((int)OVERLAY_BAD, overlayStats.status);
+      CHECK_EQ(ENUMKEY_Y, keymapLookup(0, CHORD_Y));
+      CHECK_EQ(ENUMKEY_W, keymapLookup(0, CHORD_W));
+    }
+  }
+}
+
+TEST(aFullOverlaySaysSo){
+  driverReset();
+  for (int chord = 1; chord <= OverlayMaxEntries; chord++)
+    CHECK(overlayBind(3, chord, ENUMKEY_Q, keymapChartLookup(3, chord)));
+  CHECK(!overlayBind(3, 0x7F, ENUMKEY_Q, keymapChartLookup(3, 0x7F)));
+  // a change to one already there still goes
+  CHECK(overlayBind(3, 1, ENUMKEY_A, keymapChartLookup(3, 1)));
+  record(CHORD_W, CHORD_A);
+  CHECK(hostLog().find("overlay full\n") != std::string::npos);
+  CHECK_EQ(ENUMKEY_W, keymapLookup(0, CHORD_W));
+}
+
+TEST(anOverlayMacroTypesItsTaps){
+  install("layer ALPHA\nF-- ---P  OVERLAY_MACRO_0\n--- ---P  OVERLAY_MACRO_1\n"
+          "macro 0  03-17 00-28\n");
+  typeChord(CHORD_MACRO);
+  driveFor(200000);
+  CHECK_TRAFFIC(tap("03-00-17") + tap("00-00-28"));
+  // a slot with nothing in it does nothing
+  hostClearTraffic();
+  typeChord(CHORD_W);
+  driveFor(200000);
+  CHECK_EQ(0u, hostTraffic().size());
+}
+
+TEST(imagesGoThroughIntelHex){
+  std::vector<std::string> errors;
+  OverlayBytes image = build("layer NUMSYM\n--- ---P  0x2E\nmacro 1  02-04\n", errors);
+  CHECK(errors.empty());
+  std::string hex = overlayHex(image);
+  CHECK_EQ(0u, hex.find(":0D022800"));  // 13 bytes at OverlayEepromStart, 0x228
+  OverlayBytes back;
+  CHECK(parseOverlayHex("hex", hex, back, errors));
+  CHECK(back == image);
+
+  hex[12] = hex[12] == '0' ? '1' : '0';
+  CHECK(!parseOverlayHex("hex", hex, back, errors));
+  CHECK(hasError(errors, "hex:1: not an Intel hex record"));
+  errors.clear();
+  CHECK(!parseOverlayHex("hex", ":0100000000FF\n:00000001FF\n", back, errors));
+  CHECK(hasError(errors, "hex:1: data outside the overlay"));
+}
+
+TEST(overlayTextMistakesAreReported){
+  std::vector<std::string> errors;
+  build("--- ---P  ENUMKEY_Q\n"
+        "layer ALPHA\n"
+        "--- ---P  ENUMKEY_NOPE\n"
+        "--- --R-  ENUMKEY_Q\n"
+        "--- --R-  ENUMKEY_Q\n"
+        "macro 3  00-04\n"
+        "macro 0  0004\n"
+        "layer SIDEWAYS\n", errors);
+  CHECK(hasError(errors, "overlay:1: a chord before any layer line"));
+  CHECK(hasError(errors, "overlay:3: ENUMKEY_NOPE is not in KeyCodes.h"));
+  CHECK(hasError(errors, "overlay:5: --- --R- is already on line 4"));
+  CHECK(hasError(errors, "overlay:6: a macro slot is 0 to 2"));
+  CHECK(hasError(errors, "overlay:7: a tap is MM-KK in hex, not 0004"));
+  CHECK(hasError(errors, "overlay:8: no layer SIDEWAYS in the chart"));
+  CHECK_EQ(6u, errors.size());
+}
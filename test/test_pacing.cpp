@@ -0,0 +1,161 @@
+// test_pacing.cpp
+// Output paced by the module's OK/ERROR answers (AckPacing.h): the next
+// report goes when the last is answered, ERRORs are resent, and with no
+// answer it goes on after ackTimeoutMs.
+
+#define TEST_MAIN
+#include "TestMain.h"
+
+#include "AckPacing.h"
+#include "ChordDriver.h"
+#include "Chorder.h"
+#include "KeyCodes.h"
+#include "Macro.h"
+#include "OutputQueue.h"
+
+const byte CHORD_A = 0x2E;  // -C- IMR-
+
+static const std::string Up = "AT+BLEKEYBOARDCODE=00-00\r\n";
+
+static std::string down(int mod, const char *key){
+  char command[40];
+  snprintf(command, sizeof(command), "AT+BLEKEYBOARDCODE=%02x-00-%s\r\n", mod, key);
+  return command;
+}
+
+static void pacing(unsigned long ackMicros){
+  driverReset();
+  ackPacing = true;
+  hostSetAckDelay(ackMicros);
+}
+
+TEST(macroGoesOutAtTheAnswerPace){
+  pacing(3000);
+  runMacro(MACRO_TEST - DIV_Macro, 0, 0);
+  unsigned long start = hostMicros();
+  outputFlush();
+  unsigned long took = hostMicros() - start;
+  std::string expected;
+  const char *keys[] = { "04", "05", "06", "07", "08", "09", "0a", "0b" };
+  for (int i = 0; i < 8; i++) expected += down(0, keys[i]) + Up;
+  CHECK_TRAFFIC(expected);
+  // 15 answers waited for, against 7 gaps of InterstitialDelay
+  CHECK(took >= 15 * 3000ul);
+  CHECK(took <= 15 * 4000ul);
+  CHECK(took < 7 * InterstitialDelay * 1000ul);
+  CHECK_EQ(15ul, ackStats.acks);
+  CHECK_EQ(0ul, ackStats.timeouts);
+  CHECK_EQ(3000ul, ackStats.maxAckMicros);
+  ackService();
+  CHECK_EQ(15ul, ackStats.acks);  // the last is still on its way
+  hostAdvanceMicros(3000);
+  ackService();
+  CHECK_EQ(16ul, ackStats.acks);
+  CHECK_EQ(16 * 3000ul, ackStats.ackMicros);
+}
+
+TEST(nextReportWaitsForTheAnswer){
+  pacing(10000);
+  sendRawKey(0, 0x04);
+  outputService();
+  CHECK_EQ(1ul, hostCommandCount());
+  hostAdvanceMicros(9000);
+  outputService();
+  CHECK_EQ(1ul, hostCommandCount());
+  hostAdvanceMicros(1000);
+  outputService();
+  CHECK_EQ(2ul, hostCommandCount());
+}
+
+TEST(chordsTypeTheSameWithPacing){
+  pacing(2000);
+  typeChord(CHORD_A);
+  CHECK_TRAFFIC(down(0, "04") + Up);
+  CHECK_EQ(2ul, ackStats.acks);
+  CHECK_EQ(2ul, ackStats.sent);
+}
+
+TEST(errorOnAKeyReportSendsItAgain){
+  pacing(1000);
+  hostFailNext(1);
+  sendRawKey(0, 0x04);
+  outputFlush();
+  hostAdvanceMicros(1000);
+  ackService();
+  CHECK_TRAFFIC(down(0, "04") + down(0, "04") + Up);
+  CHECK_EQ(1ul, ackStats.errors);
+  CHECK_EQ(1ul, ackStats.retries);
+  CHECK_EQ(2ul, ackStats.acks);
+}
+
+TEST(resendsStopAfterAckRetries){
+  pacing(1000);
+  hostFailNext(10);
+  sendRawKey(0, 0x04);
+  outputFlush();
+  std::string expected;
+  for (int i = 0; i <= AckRetries; i++) expected += down(0, "04");
+  CHECK_TRAFFIC(expected + Up);
+  CHECK_EQ((unsigned long)AckRetries, ackStats.retries);
+}
+
+TEST(otherCommandsAreNotResent){
+  pacing(1000);
+  hostFailNext(1);
+  queueControlKey("MEDIANEXT");
+  outputFlush();
+  hostAdvanceMicros(2000);
+  ackService();
+  CHECK_TRAFFIC("AT+BleHidControlKey=MEDIANEXT\r\n");
+  CHECK_EQ(1ul, ackStats.errors);
+  CHECK_EQ(0ul, ackStats.retries);
+}
+
+TEST(noAnswerGoesOnAfterTheTimeout){
+  pacing(HostNoAck);
+  sendRawKey(0, 0x04);
+  sendRawKey(0, 0x05);
+  unsigned long start = hostMicros();
+  outputFlush();
+  CHECK_EQ(3 * ackTimeoutMs * 1000ul, hostMicros() - start);
+  CHECK_EQ(3ul, ackStats.timeouts);
+  CHECK_TRAFFIC(down(0, "04") + Up + down(0, "05") + Up);
+}
+
+TEST(answersAfterTheTimeoutCountAsLate){
+  pacing((ackTimeoutMs + 20) * 1000ul);
+  sendRawKey(0, 0x04);
+  outputFlush();
+  CHECK_EQ(1ul, ackStats.timeouts);
+  hostAdvanceMicros(20000);
+  ackService();
+  CHECK_EQ(1ul, ackStats.late);  // the key down's, after the key up went
+  hostAdvanceMicros(50000);
+  ackService();
+  CHECK_EQ(2ul, ackStats.acks);
+  CHECK_EQ(1ul, ackStats.late);
+  CHECK_EQ(70000ul, ackStats.ackMicros);  // only the key up's is timed
+}
+
+TEST(withoutPacingAnswersAreIgnored){
+  driverReset();
+  ackPacing = false;
+  hostSetAckDelay(1000);
+  runMacro(MACRO_1 - DIV_Macro, 0, 0);
+  unsigned long start = hostMicros();
+  outputFlush();
+  CHECK_EQ(InterstitialDelay * 1000ul, hostMicros() - start);
+  ackService();
+  CHECK_EQ(0ul, ackStats.acks);
+  CHECK_EQ(4ul, ackStats.sent);
+}
+
+TEST(sleepsOnceEverythingIsAnswered){
+  pacing(2000);
+  idleSleepMs = 100;
+  typeChord(CHORD_A);
+  driveFor(200000);
+  CHECK_EQ(2ul, ackStats.acks);
+  CHECK(sleepStats.sleeps > 0);
+  idleSleepMs = 5000;
+}
@@ -0,0 +1,216 @@
+// test_pointer.cpp
+// The POINTER layer (Pointer.h): held chords move and scroll with the
+// acceleration curve, clicks and drags go through the output queue
+// without stopping the scan, and motion coalesces into fewer, bigger
+// AT+BleHidMouseMove commands when the module answers slowly.
+
+#define TEST_MAIN
+#include "TestMain.h"
+
+#include "AckPacing.h"
+#include "ChordDriver.h"
+#include "Chorder.h"
+#include "MockBackend.h"
+#include "OutputBackend.h"
+#include "Pointer.h"
+
+const byte CHORD_MODE_FUNC = 0x11;  // --N ---P in ALPHA
+const byte CHORD_POINTER   = 0x10;  // --N ---- in FUNCTION
+const byte CHORD_A         = 0x2E;  // -C- IMR- in ALPHA
+
+// in POINTER
+const byte CHORD_RIGHT    = 0x01;  // --- ---P
+const byte CHORD_DOWN     = 0x02;  // --- --R-
+const byte CHORD_UP       = 0x04;  // --- -M--
+const byte CHORD_UPLEFT   = 0x0C;  // --- IM--
+const byte CHORD_LCLICK   = 0x10;  // --N ----
+const byte CHORD_RCLICK   = 0x20;  // -C- ----
+const byte CHORD_SCROLLUP = 0x24;  // -C- -M--
+const byte CHORD_DRAG     = 0x40;  // F-- ----
+const byte CHORD_LEAVE    = 0x60;  // FC- ----
+
+struct Motion {
+  int moves;
+  long x, y, wheel;
+  int firstX, lastX;  // of the moves along x
+};
+
+// the AT+BleHidMouseMove commands in the traffic, added up
+static Motion motion(){
+  Motion m = Motion();
+  const std::string &t = hostTraffic();
+  const char prefix[] = "AT+BleHidMouseMove=";
+  for (size_t at = t.find(prefix); at != std::string::npos; at = t.find(prefix, at + 1)) {
+    int x = 0, y = 0, wheel = 0;
+    sscanf(t.c_str() + at + strlen(prefix), "%d,%d,%d", &x, &y, &wheel);
+    if (x && !m.firstX) m.firstX = x;
+    if (x) m.lastX = x;
+    m.moves++;
+    m.x += x;
+    m.y += y;
+    m.wheel += wheel;
+  }
+  return m;
+}
+
+static void pointerMode(){
+  driverReset();
+  ackPacing = false;
+  holdDwellMs = 0;
+  rolloverChords = false;
+  pointerStartSpeed = 100;
+  pointerTopSpeed = 1200;
+  pointerAccelMs = 1000;
+  pointerIntervalMs = 15;
+  typeChord(CHORD_MODE_FUNC);
+  typeChord(CHORD_POINTER);
+  hostClearTraffic();
+}
+
+static void hold(byte chord, unsigned long ms){
+  hostSetSwitches(chord);
+  driveFor(ms * 1000);
+  hostSetSwitches(0);
+  driveFor(60000);
+}
+
+TEST(aHeldMoveGoesUntilItIsLifted){
+  pointerMode();
+  hold(CHORD_RIGHT, 1000);
+  Motion m = motion();
+  // 100 + 1100 t^2 counts/s over the second, less the debounce
+  CHECK(m.x > 420 && m.x <= 467);
+  CHECK_EQ(0l, m.y);
+  CHECK_EQ(0l, m.wheel);
+  // no more than one a pointerIntervalMs
+  CHECK(m.moves <= 1000 / 15 + 1);
+  CHECK_EQ((unsigned long)m.moves, pointerStats.moves);
+  // and nothing once lifted
+  driveFor(500000);
+  CHECK_EQ(m.moves, motion().moves);
+  CHECK(!pointerBusy());
+}
+
+TEST(theLongerItIsHeldTheFasterItGoes){
+  pointerMode();
+  hold(CHORD_RIGHT, 1500);
+  Motion m = motion();
+  CHECK(m.firstX <= 2);
+  CHECK_EQ(18, pointerStats.maxStep);  // 1200 counts/s, 15 ms apart
+  CHECK(m.lastX <= 18);
+}
+
+TEST(theDirectionsComeFromTheChord){
+  pointerMode();
+  hold(CHORD_UPLEFT, 500);
+  Motion m = motion();
+  CHECK(m.x < 0);
+  CHECK(m.x == m.y || m.x == m.y + 1 || m.x == m.y - 1);
+
+  hostClearTraffic();
+  hold(CHORD_DOWN, 500);
+  m = motion();
+  CHECK_EQ(0l, m.x);
+  CHECK(m.y > 0);
+
+  hostClearTraffic();
+  hold(CHORD_UP, 500);
+  CHECK(motion().y < 0);
+}
+
+TEST(aScrollIsTheWheelAndSlower){
+  pointerMode();
+  hold(CHORD_SCROLLUP, 1000);
+  Motion m = motion();
+  CHECK_EQ(0l, m.x);
+  CHECK_EQ(0l, m.y);
+  CHECK(m.wheel > 0);
+  CHECK(m.wheel <= 467 / PointerScrollRatio + 1);
+  CHECK(hostTraffic().find("AT+BleHidMouseMove=0,0,1\r\n") != std::string::npos);
+}
+
+TEST(aSlowLinkGetsFewerBiggerMoves){
+  pointerMode();
+  hold(CHORD_RIGHT, 1200);
+  Motion fast = motion();
+
+  pointerMode();
+  ackPacing = true;
+  hostSetAckDelay(40000);
+  hold(CHORD_RIGHT, 1200);
+  driveFor(200000);
+  Motion slow = motion();
+  CHECK(slow.moves * 2 < fast.moves);  // 40 ms answers against 15 ms apart
+  CHECK(pointerStats.maxStep > 18);
+  // the same distance, give or take the counts the last move left behind
+  CHECK(slow.x >= fast.x - 2 && slow.x <= fast.x + 2);
+  CHECK_EQ(0ul, ackStats.timeouts);
+}
+
+TEST(aClickDoesNotStopTheScan){
+  pointerMode();
+  unsigned long start = hostMicros();
+  typeChord(CHORD_LCLICK, 40, 40);
+  CHECK(hostMicros() - start < 100000);
+  CHECK_TRAFFIC("AT+BleHidMouseButton=L\r\nAT+BleHidMouseButton=0\r\n");
+  // still in POINTER
+  typeChord(CHORD_RCLICK);
+  CHECK_TRAFFIC("AT+BleHidMouseButton=L\r\nAT+BleHidMouseButton=0\r\n"
+                "AT+BleHidMouseButton=R\r\nAT+BleHidMouseButton=0\r\n");
+}
+
+TEST(aDragHoldsTheButtonWhileItMoves){
+  pointerMode();
+  typeChord(CHORD_DRAG);
+  hold(CHORD_RIGHT, 300);
+  typeChord(CHORD_RCLICK);
+  typeChord(CHORD_DRAG);
+  const std::string &t = hostTraffic();
+  size_t down = t.find("AT+BleHidMouseButton=L\r\n");
+  size_t move = t.find("AT+BleHidMouseMove=");
+  size_t right = t.find("AT+BleHidMouseButton=LR\r\nAT+BleHidMouseButton=L\r\n");
+  size_t up = t.rfind("AT+BleHidMouseButton=0\r\n");
+  CHECK(down == 0);
+  CHECK(down < move && move < right && right < up);
+  CHECK(up != std::string::npos);
+}
+
+TEST(resetLetsGoOfADrag){
+  pointerMode();
+  typeChord(CHORD_DRAG);
+  reset();
+  driveFor(10000);
+  CHECK_TRAFFIC("AT+BleHidMouseButton=L\r\nAT+BLEKEYBOARDCODE=00-00\r\n"
+                "AT+BleHidMouseButton=0\r\n");
+}
+
+TEST(leavingGoesBackToTyping){
+  pointerMode();
+  typeChord(CHORD_DRAG);
+  typeChord(CHORD_LEAVE);
+  hostClearTraffic();
+  typeChord(CHORD_A);
+  CHECK_TRAFFIC("AT+BLEKEYBOARDCODE=00-00-04\r\nAT+BLEKEYBOARDCODE=00-00\r\n");
+  // and the chord that moved doesn't
+  hold(CHORD_RIGHT, 300);
+  CHECK_EQ(0, motion().moves);
+}
+
+TEST(leavingLetsGoOfADrag){
+  pointerMode();
+  typeChord(CHORD_DRAG);
+  typeChord(CHORD_LEAVE);
+  CHECK_TRAFFIC("AT+BleHidMouseButton=L\r\nAT+BleHidMouseButton=0\r\n");
+}
+
+TEST(aBackendWithNoMouseSendsNothingAndCanSleep){
+  pointerMode();
+  mockReset();
+  outputSelect(&mockBackend);
+  hold(CHORD_RIGHT, 500);
+  typeChord(CHORD_LCLICK);
+  CHECK(mockReports().empty());
+  CHECK_EQ(0ul, pointerStats.moves);
+  CHECK(!pointerBusy());
+  outputSelect(&bleBackend);
+}
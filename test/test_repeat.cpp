@@ -0,0 +1,216 @@
+// test_repeat.cpp
+// Hold to repeat (repeatHoldMs): a held chord for a repeating key sends
+// key down and leaves the key up to its release, anything else is a tap,
+// and whatever the fingers do no key is left down.
+
+#define TEST_MAIN
+#include "TestMain.h"
+
+#include "ChordDriver.h"
+#include "Chorder.h"
+#include "OutputQueue.h"
+
+const byte CHORD_A      = 0x2E;  // -C- IMR-
+const byte CHORD_BSPC   = 0x44;  // F-- -M--
+const byte CHORD_RARR   = 0x42;  // F-- --R-
+const byte CHORD_LSHIFT = 0x40;  // F-- ----
+
+const unsigned int Repeat = 250;
+
+static const char keyUp[] = "AT+BLEKEYBOARDCODE=00-00\r\n";
+
+static std::string down(const char *code){
+  return std::string("AT+BLEKEYBOARDCODE=") + code + "\r\n";
+}
+
+static void repeatMode(unsigned int holdMs, byte layers = 0){
+  driverReset();
+  holdDwellMs = 0;
+  rolloverChords = false;
+  repeatHoldMs = holdMs;
+  repeatLayers = layers;
+}
+
+// the last keyboard report sent, "" if none
+static std::string lastKeyboardReport(){
+  const std::string &t = hostTraffic();
+  size_t at = t.rfind("AT+BLEKEYBOARDCODE=");
+  return at == std::string::npos ? "" : t.substr(at, t.find('\n', at) + 1 - at);
+}
+
+TEST(aHeldKeyGoesDownAndUpOnRelease){
+  repeatMode(Repeat);
+  hostSetSwitches(CHORD_BSPC);
+  driveFor((Repeat - 5) * 1000);
+  CHECK_TRAFFIC("");
+  driveFor(20000);
+  CHECK_TRAFFIC(down("00-00-2a"));
+  // the host repeats it, nothing more from here
+  driveFor(2000000);
+  CHECK_TRAFFIC(down("00-00-2a"));
+  hostSetSwitches(0);
+  driveFor(40000);
+  CHECK_TRAFFIC(down("00-00-2a") + keyUp);
+}
+
+TEST(aShortPressIsATap){
+  repeatMode(Repeat);
+  typeChord(CHORD_BSPC, 100);
+  CHECK_TRAFFIC(down("00-00-2a") + keyUp);
+}
+
+TEST(otherKeysAreATapHoweverLongTheyAreHeld){
+  repeatMode(Repeat);
+  typeChord(CHORD_A, 1000, 0);
+  CHECK_TRAFFIC("");
+  driveFor(40000);
+  CHECK_TRAFFIC(down("00-00-04") + keyUp);
+}
+
+TEST(aRepeatLayerRepeatsEveryPlainKey){
+  repeatMode(Repeat, 1 << 0);  // ALPHA
+  hostSetSwitches(CHORD_A);
+  driveFor((Repeat + 20) * 1000);
+  CHECK_TRAFFIC(down("00-00-04"));
+  hostSetSwitches(0);
+  driveFor(40000);
+  CHECK_TRAFFIC(down("00-00-04") + keyUp);
+}
+
+TEST(zeroSendsEveryChordAsATap){
+  repeatMode(0);
+  typeChord(CHORD_BSPC, 1000, 0);
+  CHECK_TRAFFIC("");
+  driveFor(40000);
+  CHECK_TRAFFIC(down("00-00-2a") + keyUp);
+}
+
+TEST(modifiersGoDownWithTheHeldKey){
+  repeatMode(Repeat);
+  typeChord(CHORD_LSHIFT);
+  hostSetSwitches(CHORD_RARR);
+  driveFor((Repeat + 20) * 1000);
+  CHECK_TRAFFIC(down("02-00-4f"));
+  hostSetSwitches(0);
+  driveFor(40000);
+  CHECK_TRAFFIC(down("02-00-4f") + keyUp);
+  // and are spent like a tap's
+  typeChord(CHORD_BSPC);
+  CHECK_EQ(down("00-00-2a") + keyUp,
+           hostTraffic().substr(hostTraffic().size() - down("00-00-2a").size() - strlen(keyUp)));
+}
+
+TEST(anotherFingerLetsTheKeyGo){
+  repeatMode(Repeat);
+  hostSetSwitches(CHORD_BSPC);
+  driveFor((Repeat + 20) * 1000);
+  hostSetSwitches(CHORD_BSPC | 0x01);
+  driveFor(40000);
+  CHECK_TRAFFIC(down("00-00-2a") + keyUp);
+  // lifting it all sends nothing more
+  hostSetSwitches(0);
+  driveFor(40000);
+  CHECK_TRAFFIC(down("00-00-2a") + keyUp);
+}
+
+TEST(withRolloverTheNextChordCanStartWhileHeld){
+  repeatMode(Repeat);
+  rolloverChords = true;
+  hostSetSwitches(CHORD_BSPC);
+  driveFor((Repeat + 20) * 1000);
+  hostSetSwitches(CHORD_BSPC | 0x08);  // --- I---, ENUMKEY_I on its own
+  driveFor(40000);
+  CHECK_TRAFFIC(down("00-00-2a") + keyUp);
+  hostSetSwitches(CHORD_BSPC);
+  driveFor(40000);
+  CHECK_TRAFFIC(down("00-00-2a") + keyUp + down("00-00-0c") + keyUp);
+  hostSetSwitches(0);
+  driveFor(40000);
+  rolloverChords = false;
+}
+
+TEST(resetLetsGoOfAHeldKey){
+  repeatMode(Repeat);
+  hostSetSwitches(CHORD_BSPC);
+  driveFor((Repeat + 20) * 1000);
+  reset();
+  CHECK_TRAFFIC(down("00-00-2a") + keyUp);
+  // and the release doesn't send a second one
+  hostSetSwitches(0);
+  driveFor(40000);
+  CHECK_TRAFFIC(down("00-00-2a") + keyUp);
+}
+
+// presses, holds and releases of random chords, held from a blink to
+// past the repeat, with and without rollover and a hold dwell: every
+// time all the fingers are up, so is every key (macro_shiftdn can leave
+// shift down, that is what it is for)
+TEST(noKeyIsLeftDownWhateverTheFingersDo){
+  unsigned long seed = 12345;
+  auto next = [&](unsigned long n){
+    seed = seed * 1103515245ul + 12345ul;
+    return (seed >> 16) % n;
+  };
+  for (int round = 0; round < 8; round++) {
+    repeatMode(Repeat, round & 4 ? 1 << 0 : 0);
+    rolloverChords = round & 1;
+    holdDwellMs = round & 2 ? 25 : 0;
+    for (int step = 0; step < 300; step++) {
+      // a few chords with fingers coming and going, then all up
+      for (int change = next(4); change >= 0; change--) {
+        hostSetSwitches(next(2) ? CHORD_BSPC | (next(128) & 0x0B) : next(128));
+        driveFor(next(2) ? next(30) * 1000 : (Repeat + next(300)) * 1000);
+      }
+      hostSetSwitches(0);
+      driveFor(60000);
+      outputFlush();
+      std::string last = lastKeyboardReport();
+      bool isKeyDown = last.size() > strlen(keyUp) && last.compare(25, 2, "00") != 0;
+      if (isKeyDown) {
+        printf("  round %d step %d left %s", round, step, last.c_str());
+        CHECK(!isKeyDown);
+        break;
+      }
+    }
+  }
+  rolloverChords = false;
+  holdDwellMs = 0;
+}
+
+// the same one finger at a time: switches land and lift in random
+// orders, some faster than the debounce, so presses and releases of
+// different chords interleave; off (the default) and on
+TEST(noKeyIsLeftDownWhenFingersLandAndLiftOneAtATime){
+  unsigned long seed = 2024;
+  auto next = [&](unsigned long n){
+    seed = seed * 1103515245ul + 12345ul;
+    return (seed >> 16) % n;
+  };
+  for (int round = 0; round < 8; round++) {
+    repeatMode(round & 4 ? Repeat : 0);
+    rolloverChords = round & 1;
+    holdDwellMs = round & 2 ? 25 : 0;
+    for (int step = 0; step < 300; step++) {
+      byte switches = 0;
+      for (int change = 1 + next(10); change > 0 || switches; change--) {
+        byte bit = 1 << next(7);
+        if (change <= 0) while (!(switches & bit)) bit = 1 << next(7);  // lift what's down
+        switches ^= bit;
+        hostSetSwitches(switches);
+        unsigned long gapMs = next(3) ? next(debounceDelay * 2) : next(Repeat * 2);
+        driveFor(gapMs * 1000 + next(1000));
+      }
+      driveFor(60000);
+      outputFlush();
+      std::string last = lastKeyboardReport();
+      bool isKeyDown = last.size() > strlen(keyUp) && last.compare(25, 2, "00") != 0;
+      if (isKeyDown) {
+        printf("  round %d step %d left %s", round, step, last.c_str());
+        CHECK(!isKeyDown);
+        break;
+      }
+    }
+  }
+  rolloverChords = false;
+  holdDwellMs = 0;
+}
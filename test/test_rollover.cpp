@@ -0,0 +1,143 @@
+// test_rollover.cpp
+// Rollover chording: the next chord pressed while fingers of the last one
+// are still down.  Single overlaps, then overlapped typing sessions for
+// accuracy and chords per second against lifting every finger.
+
+#define TEST_MAIN
+#include "TestMain.h"
+
+#include "ChordDriver.h"
+#include "Chorder.h"
+#include "TypingSession.h"
+
+const byte CHORD_A = 0x2E;  // -C- IMR-
+const byte RING    = 0x02;
+const byte PINKY   = 0x01;
+const byte THUMB   = 0x20;  // Center Thumb
+
+static std::string tap(const char *key){
+  return std::string("AT+BLEKEYBOARDCODE=00-00-") + key + "\r\n"
+         "AT+BLEKEYBOARDCODE=00-00\r\n";
+}
+
+static void rollover(bool on){
+  driverReset();
+  rolloverChords = on;
+  rolloverHeldSwitches = 0;
+}
+
+// 'a', then the pinky lands while the index, middle and thumb are still
+// down from it
+static void overlapPinky(){
+  hostSetSwitches(CHORD_A);
+  driveFor(40000);
+  hostSetSwitches(CHORD_A & ~RING);
+  driveFor(5000);
+  hostSetSwitches((CHORD_A & ~RING) | PINKY);
+  driveFor(5000);
+}
+
+TEST(nextChordCountsOnlyNewFingers){
+  rollover(true);
+  overlapPinky();
+  hostSetSwitches(PINKY);
+  driveFor(20000);
+  hostSetSwitches(0);
+  driveFor(40000);
+  CHECK_TRAFFIC(tap("04") + tap("1a"));  // a w
+  rolloverChords = false;
+}
+
+TEST(withoutRolloverHeldFingersJoinTheChord){
+  rollover(false);
+  overlapPinky();
+  hostSetSwitches(0);
+  driveFor(100000);
+  CHECK_TRAFFIC(tap("04") + tap("0c") + tap("11"));  // a, -C- IM-P "in"
+}
+
+TEST(liftingLeftoverFingersSendsNothing){
+  rollover(true);
+  overlapPinky();
+  hostSetSwitches(PINKY);  // the rest of 'a' lifts, pinky still down
+  driveFor(40000);
+  CHECK_TRAFFIC(tap("04"));
+  hostSetSwitches(0);
+  driveFor(40000);
+  CHECK_TRAFFIC(tap("04") + tap("1a"));
+  rolloverChords = false;
+}
+
+TEST(heldSwitchesStayInTheChord){
+  rollover(true);
+  rolloverHeldSwitches = THUMB;
+  hostSetSwitches(CHORD_A);
+  driveFor(40000);
+  hostSetSwitches(THUMB);       // fingers up, thumb stays
+  driveFor(20000);
+  hostSetSwitches(CHORD_A);     // fingers down again
+  driveFor(40000);
+  hostSetSwitches(0);
+  driveFor(40000);
+  CHECK_TRAFFIC(tap("04") + tap("04"));
+
+  // not held, the second chord is just the fingers, -- IMR- 'e'
+  rolloverHeldSwitches = 0;
+  hostClearTraffic();
+  hostSetSwitches(CHORD_A);
+  driveFor(40000);
+  hostSetSwitches(THUMB);
+  driveFor(20000);
+  hostSetSwitches(CHORD_A);
+  driveFor(40000);
+  hostSetSwitches(0);
+  driveFor(40000);
+  CHECK_TRAFFIC(tap("04") + tap("08"));
+  rolloverChords = false;
+}
+
+static const char *sessionText =
+  "the quick brown fox jumps over the lazy dog while seven brave wizards "
+  "hex a jolly quartz sphinx and in the end there is another kind of "
+  "rhythm to chording than to typing on a row of keys ";
+
+struct Run {
+  unsigned long errors;
+  double chordsPerSecond;
+};
+
+static Run session(const Typist &typist, bool on, unsigned int dwell = 0){
+  rollover(on);
+  holdDwellMs = dwell;
+  sessionSeed(11);
+  const unsigned long chords = 400;
+  SessionResult result = playSession(sessionText, chords, typist);
+  rolloverChords = false;
+  holdDwellMs = 0;
+  Run run = { result.errors, chords / (result.micros / 1e6) };
+  return run;
+}
+
+TEST(overlappedSessionsStream){
+  Run lifting = session(fastTypist, false);
+  Run oldRolling = session(rollingTypist, false);
+  Run rolling = session(rollingTypist, true);
+  Run rollingHold = session(rollingTypist, true, 25);
+  const Run *runs[] = { &lifting, &oldRolling, &rolling, &rollingHold };
+  const char *names[] = { "lifting every finger", "overlapped, no rollover",
+                          "overlapped, rollover", "overlapped, rollover on hold" };
+  for (int i = 0; i < 4; i++) {
+    printf("  %-28s %5.1f chords/s, %3lu errors\n", names[i],
+           runs[i]->chordsPerSecond, runs[i]->errors);
+  }
+  CHECK_EQ(0ul, lifting.errors);
+  CHECK(oldRolling.errors > 0);
+  CHECK_EQ(0ul, rolling.errors);
+  CHECK_EQ(0ul, rollingHold.errors);
+  CHECK(rolling.chordsPerSecond > lifting.chordsPerSecond);
+}
+
+TEST(rolloverTypesNonOverlappedSessionsTheSame){
+  Run run = session(fastTypist, true);
+  CHECK_EQ(0ul, run.errors);
+}
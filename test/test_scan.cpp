@@ -0,0 +1,52 @@
+// test_scan.cpp
+// The 32u4 port read gives the same keyState the digitalRead() scan did,
+// and a pass with nothing to do stops after the read.
+
+#define TEST_MAIN
+#include "TestMain.h"
+
+#include "ChordDriver.h"
+#include "Chorder.h"
+#include "SwitchPorts.h"
+
+TEST(openSwitchesReadAsNothing){
+  CHECK_EQ(0, switchesFromPorts(0xFF, 0xFF));
+  // the other pins on the ports don't show up, whatever they read
+  CHECK_EQ(0, switchesFromPorts(0x80, 0xF3));
+}
+
+TEST(eachPortBitIsOneSwitch){
+  struct { byte pind, pinf, keyState; } pins[] = {
+    { 0x7F, 0xFF, 0x01 },  // Pinky         PD7
+    { 0xFF, 0xFE, 0x02 },  // Ring          PF0
+    { 0xFF, 0xFD, 0x04 },  // Middle        PF1
+    { 0xFF, 0xEF, 0x08 },  // Index         PF4
+    { 0xFF, 0xDF, 0x10 },  // Near Thumb    PF5
+    { 0xFF, 0xBF, 0x20 },  // Center Thumb  PF6
+    { 0xFF, 0x7F, 0x40 },  // Far Thumb     PF7
+  };
+  for (size_t i = 0; i < sizeof(pins) / sizeof(pins[0]); i++) {
+    CHECK_EQ(pins[i].keyState, switchesFromPorts(pins[i].pind, pins[i].pinf));
+  }
+  CHECK_EQ(0x7F, switchesFromPorts(0x7F, 0x0C));
+}
+
+TEST(quietPassesStopAfterTheRead){
+  driverReset();
+  driveFor(100000);
+  CHECK_EQ(1000ul, scanStats.scans);
+  CHECK_EQ(1000ul, scanStats.idleScans);
+  CHECK_EQ(0ul, scanStats.changes);
+
+  typeChord(0x2E);  // -C- IMR-  'a'
+  CHECK_TRAFFIC("AT+BLEKEYBOARDCODE=00-00-04\r\nAT+BLEKEYBOARDCODE=00-00\r\n");
+  CHECK_EQ(2ul, scanStats.changes);
+  CHECK(scanStats.idleScans > 1000ul);
+  CHECK(scanStats.idleScans < scanStats.scans);
+}
+
+TEST(oneScanInScanCostEveryIsTimed){
+  driverReset();
+  driveFor(100000);
+  CHECK_EQ((1000ul + ScanCostEvery - 1) / ScanCostEvery, scanStats.costSamples);
+}
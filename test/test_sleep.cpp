@@ -0,0 +1,72 @@
+// test_sleep.cpp
+// Idle sleep: when the chorder goes to sleep, that it wakes for the next
+// chord without losing it, and the sleep counters.
+
+#define TEST_MAIN
+#include "TestMain.h"
+
+#include "ChordDriver.h"
+#include "Chorder.h"
+
+const byte CHORD_A = 0x2E;  // -C- IMR-
+
+TEST(sleepsAfterTheIdleTime){
+  driverReset();
+  driveFor(idleSleepMs * 1000 - 10000);
+  CHECK_EQ(0ul, sleepStats.sleeps);
+  driveFor(110000);
+  CHECK_EQ(1ul, sleepStats.sleeps);
+  CHECK_EQ(idleSleepMs, sleepStats.awakeMs);
+  CHECK(sleepStats.asleepMs >= 100);
+}
+
+TEST(firstChordAfterSleepIsTyped){
+  driverReset();
+  driveFor(idleSleepMs * 1000 + 1000000);
+  typeChord(CHORD_A);
+  CHECK_TRAFFIC("AT+BLEKEYBOARDCODE=00-00-04\r\n"
+                "AT+BLEKEYBOARDCODE=00-00\r\n");
+  CHECK_EQ(1ul, sleepStats.wakes);
+  // woke when the fingers landed, the key goes on the lift
+  CHECK(sleepStats.maxWakeToKeyMs >= 40);
+  CHECK(sleepStats.maxWakeToKeyMs < 45);
+
+  // and the next idle time puts it back to sleep
+  driveFor(idleSleepMs * 1000 + 100000);
+  CHECK_EQ(2ul, sleepStats.sleeps);
+}
+
+TEST(staysAwakeWhileAChordIsHeld){
+  driverReset();
+  hostSetSwitches(CHORD_A);
+  driveFor(idleSleepMs * 1000 + 100000);
+  CHECK_EQ(0ul, sleepStats.sleeps);
+  hostSetSwitches(0);
+  driveFor(40000);
+  CHECK_EQ(2ul, hostCommandCount());
+}
+
+TEST(staysAwakeWhileOutputIsQueued){
+  driverReset();
+  typeChord(0x11);  // --N ---P  function layer
+  hostSetSwitches(0x06);  // --- -MR-  MACRO_TEST, 7 gaps of InterstitialDelay
+  driveFor(40000);
+  hostSetSwitches(0);
+  unsigned long saved = idleSleepMs;
+  idleSleepMs = 100;
+  driveFor(400000);
+  CHECK_EQ(0ul, sleepStats.sleeps);
+  CHECK_EQ(16ul, hostCommandCount());
+  driveFor(200000);
+  CHECK_EQ(1ul, sleepStats.sleeps);
+  idleSleepMs = saved;
+}
+
+TEST(zeroNeverSleeps){
+  driverReset();
+  unsigned long saved = idleSleepMs;
+  idleSleepMs = 0;
+  driveFor(saved * 2000);
+  CHECK_EQ(0ul, sleepStats.sleeps);
+  idleSleepMs = saved;
+}
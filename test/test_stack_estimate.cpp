@@ -0,0 +1,145 @@
+// test_stack_estimate.cpp
+// The stack depth estimate (StackEstimate.h) on .su lines and avr-objdump
+// listings shaped like the real ones.
+
+#define TEST_MAIN
+#include "TestMain.h"
+
+#include "StackEstimate.h"
+
+static const char stackUsage[] =
+  "main.cpp:43:5:int main()\t4\tstatic\n"
+  "FeatherChorder.ino:330:6:void loop()\t0\tstatic\n"
+  "Chorder.cpp:480:6:void chorderLoop()\t6\tstatic\n"
+  "Chorder.cpp:430:6:void processReading()\t2\tstatic\n"
+  "Chorder.cpp:121:6:void sendKey(byte)\t3\tstatic\n"
+  "Chorder.cpp:250:6:void sendRawKeyDn(char, char)\t30\tstatic\n"
+  "Chorder.cpp:280:6:void sendString(const char*)\t66\tstatic\n"
+  "AckPacing.cpp:60:6:void atSendKey(const char*)\t8\tstatic\n"
+  "FeatherChorder.ino:150:6:void halPrintln(const char*)\t2\tstatic\n"
+  "FeatherChorder.ino:160:6:void __vector_23()\t12\tstatic\n";
+
+static const char listing[] =
+  "\n"
+  "firmware.elf:     file format elf32-avr\n"
+  "\n"
+  "Disassembly of section .text:\n"
+  "\n"
+  "00000100 <main>:\n"
+  "     100:\t0e 94 00 02 \tcall\t0x400\t; 0x400 <loop>\n"
+  "     104:\tfd cf       \trjmp\t.-6      \t; 0x100 <main>\n"
+  "\n"
+  "00000400 <loop>:\n"
+  "     400:\t0c 94 00 05 \tjmp\t0x500\t; 0x500 <chorderLoop()>\n"
+  "\n"
+  "00000500 <chorderLoop()>:\n"
+  "     500:\t0e 94 00 06 \tcall\t0x600\t; 0x600 <processReading()>\n"
+  "     504:\t01 c0       \trjmp\t.+2      \t; 0x508 <chorderLoop()+0x8>\n"
+  "     506:\t0e 94 00 08 \tcall\t0x800\t; 0x800 <sendString(char const*)>\n"
+  "     508:\t08 95       \tret\n"
+  "\n"
+  "00000600 <processReading()>:\n"
+  "     600:\t0e 94 00 07 \tcall\t0x700\t; 0x700 <sendKey(unsigned char)>\n"
+  "     604:\t08 95       \tret\n"
+  "\n"
+  "00000700 <sendKey(unsigned char)>:\n"
+  "     700:\t0e 94 80 07 \tcall\t0x780\t; 0x780 <sendRawKeyDn(char, char)>\n"
+  "     704:\t09 95       \ticall\n"
+  "     706:\t08 95       \tret\n"
+  "\n"
+  "00000780 <sendRawKeyDn(char, char)>:\n"
+  "     780:\t0e 94 00 09 \tcall\t0x900\t; 0x900 <atSendKey(char const*)>\n"
+  "     784:\t08 95       \tret\n"
+  "\n"
+  "00000800 <sendString(char const*)>:\n"
+  "     800:\t0e 94 00 0a \tcall\t0xa00\t; 0xa00 <halPrintln(char const*)>\n"
+  "     804:\t0e 94 10 0b \tcall\t0xb10\t; 0xb10 <__udivmodsi4>\n"
+  "     808:\t08 95       \tret\n"
+  "\n"
+  "00000900 <atSendKey(char const*)>:\n"
+  "     900:\t0e 94 00 0a \tcall\t0xa00\t; 0xa00 <halPrintln(char const*)>\n"
+  "     904:\t08 95       \tret\n"
+  "\n"
+  "00000a00 <halPrintln(char const*)>:\n"
+  "     a00:\t08 95       \tret\n"
+  "\n"
+  "00000b00 <__vector_23>:\n"
+  "     b00:\t0e 94 00 0a \tcall\t0xa00\t; 0xa00 <halPrintln(char const*)>\n"
+  "     b04:\t18 95       \treti\n"
+  "\n"
+  "00000b10 <__udivmodsi4>:\n"
+  "     b10:\t08 95       \tret\n";
+
+TEST(namesDropTypesAndParameters){
+  CHECK_EQ("sendKey", functionName("void sendKey(byte)"));
+  CHECK_EQ("sendKey", functionName("sendKey(unsigned char)"));
+  CHECK_EQ("halPrintln", functionName("const char* halPrintln(const char*)"));
+  CHECK_EQ("main", functionName("main"));
+  CHECK_EQ("Adafruit_BLE::sendCommandCheckOK", functionName("bool Adafruit_BLE::sendCommandCheckOK(const char*)"));
+  CHECK_EQ("Print::write", functionName("virtual size_t Print::write(const uint8_t*, size_t)"));
+  CHECK_EQ("f<int, char>", functionName("void f<int, char>(int)"));
+  CHECK_EQ("Foo::operator()", functionName("int Foo::operator()(int)"));
+}
+
+TEST(stackUsageGivesFrames){
+  CallGraph graph;
+  parseStackUsage(stackUsage, graph);
+  parseStackUsage("x.cpp:1:6:void sendKey(int)\t9\tdynamic,bounded\nnot a line\n", graph);
+  CHECK_EQ(10u, graph.size());
+  CHECK_EQ(30u, graph["sendRawKeyDn"].frame);
+  CHECK_EQ(9u, graph["sendKey"].frame);   // overloads share the biggest
+  CHECK(graph["sendKey"].isDynamic);
+  CHECK(!graph["loop"].isDynamic);
+  CHECK(graph["loop"].hasFrame);
+}
+
+TEST(disassemblyGivesCallsNotBranches){
+  CallGraph graph;
+  parseDisassembly(listing, graph);
+  CHECK_EQ(1u, graph["main"].callees.size());  // the rjmp to itself is a loop
+  CHECK(graph["loop"].callees.count("chorderLoop"));  // a tail call
+  CHECK_EQ(2u, graph["chorderLoop"].callees.size());  // not its own +0x8
+  CHECK(graph["sendKey"].callsIndirect);
+  CHECK(!graph["sendRawKeyDn"].callsIndirect);
+  CHECK(graph["__vector_23"].callees.count("halPrintln"));
+}
+
+TEST(deepestChainWithReturnAddressesAndAnInterrupt){
+  CallGraph graph;
+  parseStackUsage(stackUsage, graph);
+  parseDisassembly(listing, graph);
+  StackDepth depth;
+  CHECK(estimateStack(graph, "main", depth));
+  // main 4, loop 0, chorderLoop 6, sendString 66, halPrintln 2, and five
+  // return addresses; the sendKey chain is 4+0+6+2+3+30+8+2 + 14 = 69
+  CHECK_EQ(4u + 0 + 6 + 66 + 2 + 4 * ReturnAddressBytes, depth.bytes);
+  CHECK_EQ(5u, depth.path.size());
+  CHECK_EQ("main", depth.path[0]);
+  CHECK_EQ("sendString", depth.path[3]);
+  CHECK_EQ("halPrintln", depth.path[4]);
+  CHECK_EQ("__vector_23", depth.interrupt);
+  CHECK_EQ(ReturnAddressBytes + 12 + ReturnAddressBytes + 2, depth.interruptBytes);
+  CHECK_EQ(depth.bytes + depth.interruptBytes, depth.total());
+  CHECK_EQ(1u, depth.indirect.size());
+  CHECK_EQ(1u, depth.unknown.size());
+  CHECK_EQ("__udivmodsi4", depth.unknown[0]);
+  CHECK(depth.recursive.empty());
+  CHECK(!estimateStack(graph, "setup", depth));
+}
+
+TEST(recursionIsReported){
+  CallGraph graph;
+  graph["main"].hasFrame = true;
+  graph["main"].callees.insert("a");
+  graph["a"].hasFrame = true;
+  graph["a"].frame = 10;
+  graph["a"].callees.insert("b");
+  graph["b"].hasFrame = true;
+  graph["b"].frame = 20;
+  graph["b"].callees.insert("a");
+  StackDepth depth;
+  CHECK(estimateStack(graph, "main", depth));
+  CHECK_EQ(1u, depth.recursive.size());
+  CHECK_EQ("a", depth.recursive[0]);
+  CHECK_EQ(10u + 20 + 2 * ReturnAddressBytes, depth.bytes);
+}
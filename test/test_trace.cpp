@@ -0,0 +1,133 @@
+// test_trace.cpp
+// The chord trace ring (Trace.h), its dump on the TRACE_DUMP chord, and
+// replaying a dump through the core again (TraceReplay.h).
+
+#define TEST_MAIN
+#include "TestMain.h"
+
+#include "ChordDriver.h"
+#include "Chorder.h"
+#include "KeyCodes.h"
+#include "TraceReplay.h"
+#include "TypingSession.h"
+
+const byte CHORD_A    = 0x2E;  // -C- IMR-
+const byte CHORD_FUNC = 0x11;  // --N ---P
+const byte CHORD_DUMP = 0x0F;  // --- IMRP  TRACE_DUMP in function layer
+
+static std::string line(const TraceEntry &e){
+  char text[TraceLineSize];
+  CHECK(traceLine(text, e) < TraceLineSize);
+  return text;
+}
+
+// the dump as the board's serial port shows it
+static std::string dumpAfter(const char *text, unsigned long chords){
+  driverReset();
+  sessionSeed(7);
+  playSession(text, chords, steadyTypist);
+  typeChord(CHORD_FUNC);
+  typeChord(CHORD_DUMP);
+  return hostLog();
+}
+
+TEST(chordRecordsRawStableChordAndReports){
+  driverReset();
+  typeChord(CHORD_A);
+  CHECK_EQ(7, traceCount());
+  CHECK_EQ("0 r 2e", line(traceEntry(0)));
+  CHECK_EQ("0 s 2e", line(traceEntry(1)));
+  CHECK_EQ("40 r 00", line(traceEntry(2)));
+  CHECK_EQ("40 s 00", line(traceEntry(3)));
+  CHECK_EQ("40 c 2e 04", line(traceEntry(4)));
+  CHECK_EQ("40 d 00 04", line(traceEntry(5)));
+  CHECK_EQ("40 u", line(traceEntry(6)));
+}
+
+TEST(ringKeepsTheLastTraceSize){
+  driverReset();
+  for (int i = 0; i < TraceSize + 10; i++) traceRecord(TRACE_RAW, i);
+  CHECK_EQ(TraceSize, traceCount());
+  CHECK_EQ((unsigned long)TraceSize + 10, traceSeq());
+  CHECK_EQ(10, traceEntry(0).a);
+  CHECK_EQ(TraceSize + 9, traceEntry(TraceSize - 1).a);
+}
+
+TEST(timesKeepSixteenBits){
+  driverReset();
+  hostAdvanceMicros(70000000ul);  // 70 s
+  traceRecord(TRACE_TEXT);
+  CHECK_EQ("4464 t", line(traceEntry(0)));
+}
+
+TEST(dumpChordWritesTheTraceToTheLog){
+  std::string log = dumpAfter("ab", 2);
+  CHECK_EQ(0u, log.find("trace 48 debounce 10 eager 7f hold 0 rollover 0 held 00 repeat 0 layers 00\n"));
+  CHECK(log.size() > 4 && log.compare(log.size() - 4, 4, "end\n") == 0);
+  CHECK(log.find(" c 11 ") != std::string::npos);   // into the function layer
+  CHECK(log.find(" c 0f ") != std::string::npos);   // and the dump chord itself
+  CHECK_EQ(std::string::npos, log.find(" c 0f ", log.find(" c 0f ") + 1));
+}
+
+TEST(parseSkipsTheSerialLogAroundATrace){
+  TraceLog trace;
+  std::string error;
+  CHECK(parseTrace("Adafruit Bluefruit HID Chorder\r\n"
+                   "trace 3 debounce 5 eager 0f hold 25 rollover 1 held 20\r\n"
+                   "65530 r 2e\r\n"
+                   "4 s 2e\r\n"
+                   "9 c 2e 04\r\n"
+                   "end\r\n", trace, &error));
+  CHECK_EQ(5, trace.debounceMs);
+  CHECK_EQ(0x0F, trace.eager);
+  CHECK_EQ(25u, trace.holdMs);
+  CHECK(trace.rollover);
+  CHECK_EQ(0x20, trace.held);
+  CHECK_EQ(3u, trace.events.size());
+  CHECK_EQ(65530ul, trace.events[0].ms);
+  CHECK_EQ(65540ul, trace.events[1].ms);  // past the 16 bit wrap
+  CHECK_EQ(TRACE_CHORD, trace.events[2].kind);
+  CHECK_EQ(0x04, trace.events[2].b);
+  CHECK_EQ(0u, trace.repeatMs);  // from before hold to repeat
+
+  CHECK(parseTrace("trace 0 debounce 5 eager 0f hold 0 rollover 0 held 00 repeat 300 layers 04\n"
+                   "end\n", trace, &error));
+  CHECK_EQ(300u, trace.repeatMs);
+  CHECK_EQ(0x04, trace.repeatLayers);
+
+  CHECK(!parseTrace("trace 1 debounce 5 eager 7f hold 0 rollover 0 held 00\n1 x\nend\n", trace, &error));
+  CHECK(!parseTrace("trace 1 debounce 5 eager 7f hold 0 rollover 0 held 00\n1 r 00\n", trace, &error));
+  CHECK_EQ("trace has no end line", error);
+  CHECK(!parseTrace("nothing here\n", trace, &error));
+}
+
+TEST(replayOfADumpSendsTheSame){
+  TraceLog trace;
+  CHECK(parseTrace(dumpAfter("the quick", 9), trace, 0));
+  ReplayResult r = replayTrace(trace);
+  CHECK(r.raw > 0);
+  CHECK(r.recorded.size() >= 4);
+  CHECK(r.firstDiff == std::string::npos);
+  CHECK_EQ(r.recorded.size(), r.replayed.size());
+  CHECK(r.shiftMs > -1 && r.shiftMs < 1);
+}
+
+TEST(replayShowsWhereOtherSettingsPart){
+  TraceLog trace;
+  CHECK(parseTrace(dumpAfter("the quick", 9), trace, 0));
+  trace.holdMs = 25;  // chords go out on hold, before their lift
+  ReplayResult r = replayTrace(trace);
+  CHECK(r.firstDiff == std::string::npos);
+  CHECK(r.shiftMs < -5);
+  // a key the board sent that the replay doesn't
+  for (size_t i = trace.events.size(); i--; ) {
+    if (trace.events[i].kind == TRACE_DOWN) {
+      trace.events[i].b ^= 1;
+      break;
+    }
+  }
+  trace.holdMs = 0;
+  r = replayTrace(trace);
+  CHECK(r.firstDiff != std::string::npos);
+  CHECK_EQ(TRACE_DOWN, r.recorded[r.firstDiff].kind);
+}
@@ -0,0 +1,206 @@
+// test_usage.cpp
+// Chord usage counts (Usage.h): what sendKey() counts, halving when a
+// counter fills, the flush to EEPROM and loading it back at power-up,
+// and the dump tools/layout_optimizer reads.
+
+#define TEST_MAIN
+#include "TestMain.h"
+
+#include "ChordDriver.h"
+#include "Chorder.h"
+#include "KeyCodes.h"
+#include "Usage.h"
+
+const byte CHORD_A     = 0x2E;  // -C- IMR-  ENUMKEY_A
+const byte CHORD_NUM   = 0x10;  // --N ----  MODE_NUM
+const byte CHORD_FUNC  = 0x11;  // --N ---P  MODE_FUNC
+const byte CHORD_000   = 0x0F;  // --- IMRP  MACRO_000 in NUMSYM
+const byte CHORD_THE   = 0x58;  // F-N I---  WORD_the
+const byte CHORD_USAGE = 0x0A;  // --- I-R-  USAGE_DUMP in FUNCTION
+
+static void usageReset(unsigned long flushMs = 0){
+  usageFlushMs = flushMs;
+  driverReset();
+}
+
+// power off and on: the core starts again, the EEPROM stays
+static void powerCycle(){
+  chorderInit();
+}
+
+TEST(countsEachChordInItsLayer){
+  usageReset();
+  typeChord(CHORD_A);
+  typeChord(CHORD_A);
+  typeChord(CHORD_NUM);
+  typeChord(CHORD_000);
+  typeChord(CHORD_THE);
+  CHECK_EQ(2, usageChordCount(0, CHORD_A));
+  CHECK_EQ(1, usageChordCount(0, CHORD_NUM));
+  CHECK_EQ(1, usageChordCount(1, CHORD_000));
+  CHECK_EQ(1, usageChordCount(0, CHORD_THE));
+  CHECK_EQ(1, usageStats.modeKeys[USAGE_NUM]);
+  CHECK_EQ(1, usageStats.macros);
+  CHECK_EQ(1, usageStats.words);
+  CHECK_EQ(0, usageStats.function);
+}
+
+TEST(functionLayerChordsAreCountedTogether){
+  usageReset();
+  typeChord(CHORD_FUNC);
+  typeChord(0x01);  // --- ---P  ENUMKEY_F5
+  CHECK_EQ(1, usageStats.modeKeys[USAGE_FUNC]);
+  CHECK_EQ(1, usageStats.function);
+  CHECK_EQ(0, usageChordCount(1, 0x01));
+}
+
+TEST(packedCountsLeaveTheirNeighboursAlone){
+  usageReset();
+  for (byte l = 0; l < UsageLayers; l++)
+    for (byte c = 0; c < 128; c++) usageSetChordCount(l, c, (c * 5 + l) & UsageChordMax);
+  usageSetChordCount(0, 42, UsageChordMax);
+  usageSetChordCount(1, 127, 0);
+  for (byte l = 0; l < UsageLayers; l++) {
+    for (byte c = 0; c < 128; c++) {
+      byte expected = (c * 5 + l) & UsageChordMax;
+      if (l == 0 && c == 42) expected = UsageChordMax;
+      if (l == 1 && c == 127) expected = 0;
+      CHECK_EQ(expected, usageChordCount(l, c));
+    }
+  }
+}
+
+TEST(aFullCounterHalvesThemAll){
+  usageReset();
+  usageSetChordCount(0, 5, UsageChordMax);
+  usageSetChordCount(1, 3, 11);
+  usageStats.macros = 7;
+  usageStats.modeKeys[USAGE_NUMSHIFT] = 300;
+  usageCount(0, 5, ENUMKEY_A);
+  CHECK_EQ(32, usageChordCount(0, 5));
+  CHECK_EQ(5, usageChordCount(1, 3));
+  CHECK_EQ(3, usageStats.macros);
+  CHECK_EQ(150, usageStats.modeKeys[USAGE_NUMSHIFT]);
+  CHECK_EQ(1, usageStats.halvings);
+
+  usageStats.words = 0xFFFF;
+  usageCount(0, CHORD_THE, WORD_the);
+  CHECK_EQ(0x8000, usageStats.words);
+  CHECK_EQ(2, usageStats.halvings);
+}
+
+TEST(nothingIsWrittenUntilAFlushIsDue){
+  usageReset(1000);
+  typeChord(CHORD_A);
+  driveFor(500000);
+  CHECK_EQ(0ul, hostEepromWriteTotal());
+  driveFor(1000000);
+  CHECK(hostEepromWriteTotal() > 0);
+  CHECK(!usageFlushing());
+
+  unsigned long written = hostEepromWriteTotal();
+  driveFor(3000000);  // nothing new to write
+  CHECK_EQ(written, hostEepromWriteTotal());
+}
+
+TEST(aFlushWritesACellAPass){
+  usageReset(1000);
+  typeChord(CHORD_A);
+  hostAdvanceMicros(1000000);
+  usageService();
+  CHECK(usageFlushing());
+  CHECK_EQ(1ul, hostEepromWriteTotal());
+  usageService();
+  CHECK_EQ(2ul, hostEepromWriteTotal());
+}
+
+TEST(countsComeBackAfterAPowerCycle){
+  usageReset(1000);
+  typeChord(CHORD_A);
+  typeChord(CHORD_NUM);
+  typeChord(CHORD_000);
+  driveFor(2000000);
+  powerCycle();
+  CHECK_EQ(1, usageChordCount(0, CHORD_A));
+  CHECK_EQ(1, usageChordCount(1, CHORD_000));
+  CHECK_EQ(1, usageStats.modeKeys[USAGE_NUM]);
+  CHECK_EQ(1, usageStats.macros);
+
+  // and keep counting from there
+  typeChord(CHORD_A);
+  usageFlush();
+  powerCycle();
+  CHECK_EQ(2, usageChordCount(0, CHORD_A));
+}
+
+TEST(flushesTakeTheSlotsInTurn){
+  usageReset();
+  for (int i = 0; i < 6; i++) {
+    typeChord(CHORD_A);
+    usageFlush();
+  }
+  // each slot's count of CHORD_A went 1, 3, 5 and 2, 4, 6, all in the
+  // byte its low bits are in
+  unsigned int cell = UsageEepromStart + 4 + CHORD_A * 6 / 8;
+  CHECK_EQ(3ul, hostEepromWrites(cell));
+  CHECK_EQ(3ul, hostEepromWrites(cell + UsageSlotSize));
+  powerCycle();
+  CHECK_EQ(6, usageChordCount(0, CHORD_A));
+  CHECK(UsageEepromEnd <= HalEepromSize);
+}
+
+TEST(aPowerCutMidFlushLoadsTheSlotBefore){
+  usageReset();
+  typeChord(CHORD_A);
+  usageFlush();
+  typeChord(CHORD_A);
+  typeChord(CHORD_A);
+  typeChord(CHORD_NUM);
+  hostEepromPowerFail(2);  // the body but not the header
+  usageFlush();
+  hostEepromPowerFail(~0ul);
+  powerCycle();
+  CHECK_EQ(1, usageChordCount(0, CHORD_A));
+  CHECK_EQ(0, usageChordCount(0, CHORD_NUM));
+}
+
+TEST(anErasedEepromStartsAtZero){
+  usageReset();
+  powerCycle();
+  CHECK_EQ(0, usageChordCount(0, CHORD_A));
+  CHECK_EQ(0, usageStats.halvings);
+}
+
+TEST(masterResetFlushesBeforeThePowerGoes){
+  usageReset();
+  typeChord(CHORD_A);
+  dispatchKey(MODE_MRESET);
+  CHECK(hostPoweredOff());
+  powerCycle();
+  CHECK_EQ(1, usageChordCount(0, CHORD_A));
+}
+
+TEST(dumpListsTheRowsInUse){
+  usageReset();
+  usageSetChordCount(0, 0x2E, 0x12);
+  usageSetChordCount(1, 0x0F, UsageChordMax);
+  usageStats.modeKeys[USAGE_NUM] = 4;
+  usageStats.modeKeys[USAGE_NUMSHIFT] = 2;
+  usageStats.macros = 9;
+  usageStats.words = 1;
+  usageStats.halvings = 3;
+  usageDump();
+  CHECK_EQ(std::string(
+    "usage halved 3 macros 9 words 1 function 0\n"
+    "mode num 4 numlck 0 func 0 numshift 2\n"
+    "0 20 00 00 00 00 00 00 00 00 00 00 00 00 00 00 12 00\n"
+    "1 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 3f\n"
+    "end\n"), hostLog());
+}
+
+TEST(usageDumpChordWritesIt){
+  usageReset();
+  typeChord(CHORD_FUNC);
+  typeChord(CHORD_USAGE);
+  CHECK(hostLog().find("usage halved 0 macros 0 words 0 function 1\n") == 0);
+}
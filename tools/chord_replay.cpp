@@ -0,0 +1,100 @@
+// chord_replay.cpp
+// Replays a trace dumped from the board with the TRACE_DUMP chord (see
+// Trace.h) through the chorder core on the host and diffs the chords and
+// reports against what the board sent.  Settings default to the ones in
+// the trace; change them to see what another debounceDelay, eager set,
+// hold dwell, rollover or hold to repeat would have done with the same
+// fingers.
+//
+//   chord_replay trace.txt [--debounce MS] [--eager HEX] [--hold MS]
+//                [--rollover 0|1] [--held HEX] [--repeat MS] [--scan-us US]
+//                [--show]
+//
+// Exits 0 when the replay sends the same, 1 when it differs.
+
+#include "TraceReplay.h"
+
+#include <fstream>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void usage(const char *name){
+  fprintf(stderr, "usage: %s trace.txt [--debounce MS] [--eager HEX] [--hold MS]\n"
+                  "       [--rollover 0|1] [--held HEX] [--repeat MS] [--scan-us US] [--show]\n", name);
+}
+
+static void list(const char *name, const std::vector<TraceEvent> &events, size_t from, size_t to){
+  printf("  %s:", name);
+  for (size_t i = from; i < to && i < events.size(); i++)
+    printf(" [%s]", describeEvent(events[i]).c_str());
+  printf("\n");
+}
+
+int main(int argc, char **argv){
+  const char *path = 0;
+  bool show = false;
+  long debounceMs = -1, eager = -1, hold = -1, rollover = -1, held = -1, repeat = -1;
+  unsigned long scanUs = 100;
+  for (int i = 1; i < argc; i++) {
+    bool more = i + 1 < argc;
+    if (!strcmp(argv[i], "--debounce") && more) debounceMs = atol(argv[++i]);
+    else if (!strcmp(argv[i], "--eager") && more) eager = strtol(argv[++i], 0, 16);
+    else if (!strcmp(argv[i], "--hold") && more) hold = atol(argv[++i]);
+    else if (!strcmp(argv[i], "--rollover") && more) rollover = atol(argv[++i]);
+    else if (!strcmp(argv[i], "--held") && more) held = strtol(argv[++i], 0, 16);
+    else if (!strcmp(argv[i], "--repeat") && more) repeat = atol(argv[++i]);
+    else if (!strcmp(argv[i], "--scan-us") && more) scanUs = atol(argv[++i]);
+    else if (!strcmp(argv[i], "--show")) show = true;
+    else if (argv[i][0] != '-' && !path) path = argv[i];
+    else {
+      usage(argv[0]);
+      return 2;
+    }
+  }
+  if (!path) {
+    usage(argv[0]);
+    return 2;
+  }
+
+  std::ifstream in(path);
+  if (!in) {
+    fprintf(stderr, "%s: can't read %s\n", argv[0], path);
+    return 2;
+  }
+  std::stringstream text;
+  text << in.rdbuf();
+  TraceLog trace;
+  std::string error;
+  if (!parseTrace(text.str(), trace, &error)) {
+    fprintf(stderr, "%s: %s: %s\n", argv[0], path, error.c_str());
+    return 2;
+  }
+  if (debounceMs >= 0) trace.debounceMs = debounceMs;
+  if (eager >= 0) trace.eager = eager;
+  if (hold >= 0) trace.holdMs = hold;
+  if (rollover >= 0) trace.rollover = rollover;
+  if (held >= 0) trace.held = held;
+  if (repeat >= 0) trace.repeatMs = repeat;
+
+  ReplayResult r = replayTrace(trace, scanUs);
+  printf("chord_replay: %s, %lu events, debounce %ld ms eager %02x hold %u ms rollover %d held %02x"
+         " repeat %u ms\n", path, (unsigned long)trace.events.size(), trace.debounceMs, trace.eager,
+         trace.holdMs, trace.rollover, trace.held, trace.repeatMs);
+  printf("  %lu raw changes replayed, %lu chords and reports recorded, %lu replayed\n",
+         (unsigned long)r.raw, (unsigned long)r.recorded.size(), (unsigned long)r.replayed.size());
+  if (show) {
+    list("recorded", r.recorded, 0, r.recorded.size());
+    list("replayed", r.replayed, 0, r.replayed.size());
+  }
+  if (r.firstDiff == std::string::npos) {
+    printf("  same, key downs %+.1f ms from the recorded times\n", r.shiftMs);
+    return 0;
+  }
+  size_t from = r.firstDiff > 2 ? r.firstDiff - 2 : 0;
+  printf("  differs from event %lu:\n", (unsigned long)r.firstDiff);
+  list("recorded", r.recorded, from, r.firstDiff + 3);
+  list("replayed", r.replayed, from, r.firstDiff + 3);
+  return 1;
+}
@@ -0,0 +1,96 @@
+// keymap_compiler.cpp
+// Builds FeatherChorder/ChordMappings.h from the chord chart, see
+// KeymapCompiler.h for the chart syntax and what is checked.
+//
+//   keymap_compiler ChordChart.txt [-o ChordMappings.h] [--check ChordMappings.h]
+//                   [--codes KeyCodes.h]
+//
+// With no -o the header goes to stdout.  --check writes nothing and fails
+// when the header isn't what the chart makes, so a hand edit is caught.
+// KeyCodes.h defaults to the one next to the chart.
+// Exits 0 when fine, 1 with the chart errors or a stale header.
+
+#include "KeymapCompiler.h"
+
+#include <fstream>
+#include <sstream>
+#include <stdio.h>
+#include <string.h>
+
+static void usage(const char *name){
+  fprintf(stderr, "usage: %s ChordChart.txt [-o ChordMappings.h] [--check ChordMappings.h]\n"
+                  "       [--codes KeyCodes.h]\n", name);
+}
+
+static bool readFile(const std::string &path, std::string &text){
+  std::ifstream in(path.c_str(), std::ios::binary);
+  if (!in) return false;
+  std::ostringstream all;
+  all << in.rdbuf();
+  text = all.str();
+  return true;
+}
+
+int main(int argc, char **argv){
+  std::string chartPath, outPath, checkPath, codesPath;
+  for (int i = 1; i < argc; i++) {
+    bool more = i + 1 < argc;
+    if (!strcmp(argv[i], "-o") && more) outPath = argv[++i];
+    else if (!strcmp(argv[i], "--check") && more) checkPath = argv[++i];
+    else if (!strcmp(argv[i], "--codes") && more) codesPath = argv[++i];
+    else if (argv[i][0] != '-' && chartPath.empty()) chartPath = argv[i];
+    else {
+      usage(argv[0]);
+      return 2;
+    }
+  }
+  if (chartPath.empty()) {
+    usage(argv[0]);
+    return 2;
+  }
+  if (codesPath.empty()) {
+    size_t slash = chartPath.find_last_of('/');
+    codesPath = (slash == std::string::npos ? "" : chartPath.substr(0, slash + 1)) + "KeyCodes.h";
+  }
+
+  std::string text, codes;
+  if (!readFile(chartPath, text)) {
+    fprintf(stderr, "%s: can't read %s\n", argv[0], chartPath.c_str());
+    return 2;
+  }
+  if (!readFile(codesPath, codes)) {
+    fprintf(stderr, "%s: can't read %s\n", argv[0], codesPath.c_str());
+    return 2;
+  }
+
+  KeymapChart chart;
+  std::vector<std::string> errors;
+  if (parseChart(chartPath, text, chart, errors) && checkCodes(chart, codes, errors))
+    checkChart(chart, errors);
+  for (size_t i = 0; i < errors.size(); i++)
+    fprintf(stderr, "%s\n", errors[i].c_str());
+  if (!errors.empty()) return 1;
+
+  std::string header = emitMappings(chart);
+  if (!checkPath.empty()) {
+    std::string current;
+    if (!readFile(checkPath, current) || current != header) {
+      fprintf(stderr, "%s is not what %s makes, regenerate it (cmake --build build --target keymap)\n",
+              checkPath.c_str(), chartPath.c_str());
+      return 1;
+    }
+    printf("%s matches %s\n", checkPath.c_str(), chartPath.c_str());
+    return 0;
+  }
+  if (outPath.empty()) {
+    fputs(header.c_str(), stdout);
+    return 0;
+  }
+  std::ofstream out(outPath.c_str(), std::ios::binary);
+  out << header;
+  if (!out) {
+    fprintf(stderr, "%s: can't write %s\n", argv[0], outPath.c_str());
+    return 2;
+  }
+  return 0;
+}
@@ -0,0 +1,123 @@
+// layout_optimizer.cpp
+// Reads a usage dump (USAGE_DUMP, see Usage.h) and the chord chart the
+// board ran when it was counted, and proposes moves that make typing
+// cheaper, see LayoutOptimizer.h for the cost.
+//
+//   layout_optimizer ChordChart.txt usage.log [-o NewChart.txt]
+//                    [--switch-weight N] [--codes KeyCodes.h]
+//
+// usage.log can be a whole serial log, the last dump in it is used.  The
+// report (cost per char before and after, then each move) goes to
+// stdout; -o writes the chart with the moves made, checked the same way
+// keymap_compiler checks it.  --switch-weight is what a detour through
+// NUMSYM costs on top of the chord that gets there, in fingers (2).
+// Exits 0 when fine, 1 with chart or dump errors.
+
+#include "KeymapCompiler.h"
+#include "LayoutOptimizer.h"
+
+#include <fstream>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void usage(const char *name){
+  fprintf(stderr, "usage: %s ChordChart.txt usage.log [-o NewChart.txt] [--switch-weight N]\n"
+                  "       [--codes KeyCodes.h]\n", name);
+}
+
+static bool readFile(const std::string &path, std::string &text){
+  std::ifstream in(path.c_str(), std::ios::binary);
+  if (!in) return false;
+  std::ostringstream all;
+  all << in.rdbuf();
+  text = all.str();
+  return true;
+}
+
+static void printCost(const char *label, const LayoutCost &c){
+  double chars = c.chars ? c.chars : 1;
+  printf("%-7s %.3f fingers/char  %.3f switches/char  cost %.3f/char\n", label,
+         c.fingers / chars, c.switches / chars, c.cost / chars);
+}
+
+static bool check(const std::string &name, const std::string &text, const std::string &codes,
+                  KeymapChart &chart){
+  std::vector<std::string> errors;
+  if (parseChart(name, text, chart, errors) && checkCodes(chart, codes, errors))
+    checkChart(chart, errors);
+  for (size_t i = 0; i < errors.size(); i++)
+    fprintf(stderr, "%s\n", errors[i].c_str());
+  return errors.empty();
+}
+
+int main(int argc, char **argv){
+  std::string chartPath, usagePath, outPath, codesPath;
+  int switchWeight = 2;
+  for (int i = 1; i < argc; i++) {
+    bool more = i + 1 < argc;
+    if (!strcmp(argv[i], "-o") && more) outPath = argv[++i];
+    else if (!strcmp(argv[i], "--switch-weight") && more) switchWeight = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--codes") && more) codesPath = argv[++i];
+    else if (argv[i][0] != '-' && chartPath.empty()) chartPath = argv[i];
+    else if (argv[i][0] != '-' && usagePath.empty()) usagePath = argv[i];
+    else {
+      usage(argv[0]);
+      return 2;
+    }
+  }
+  if (chartPath.empty() || usagePath.empty() || switchWeight < 0) {
+    usage(argv[0]);
+    return 2;
+  }
+  if (codesPath.empty()) {
+    size_t slash = chartPath.find_last_of('/');
+    codesPath = (slash == std::string::npos ? "" : chartPath.substr(0, slash + 1)) + "KeyCodes.h";
+  }
+
+  std::string text, log, codes;
+  const std::string *paths[] = { &chartPath, &usagePath, &codesPath };
+  std::string *contents[] = { &text, &log, &codes };
+  for (int f = 0; f < 3; f++) {
+    if (!readFile(*paths[f], *contents[f])) {
+      fprintf(stderr, "%s: can't read %s\n", argv[0], paths[f]->c_str());
+      return 2;
+    }
+  }
+
+  KeymapChart chart;
+  if (!check(chartPath, text, codes, chart)) return 1;
+  UsageCounts counts;
+  std::vector<std::string> errors;
+  if (!parseUsageDump(usagePath, log, counts, errors)) {
+    fprintf(stderr, "%s\n", errors[0].c_str());
+    return 1;
+  }
+
+  LayoutPlan plan = optimizeLayout(chart, counts, switchWeight);
+  printf("%lu chords typed, halved %lu times on the board\n", plan.before.chars, counts.halvings);
+  printf("mode keys: num %lu numlck %lu func %lu numshift %lu\n", counts.modeKeys[0],
+         counts.modeKeys[1], counts.modeKeys[2], counts.modeKeys[3]);
+  printCost("before", plan.before);
+  printCost("after", plan.after);
+  printf("%u moves\n", (unsigned)plan.moves.size());
+  for (size_t m = 0; m < plan.moves.size(); m++) {
+    const LayoutMove &move = plan.moves[m];
+    printf("  %-20s %6lu  %-8s %s  ->  %-8s %s\n", move.code.c_str(), move.count,
+           chart.layers[move.fromLayer].mode.c_str(), chordPattern(move.fromChord).c_str(),
+           chart.layers[move.toLayer].mode.c_str(), chordPattern(move.toChord).c_str());
+  }
+  if (outPath.empty()) return 0;
+
+  std::string proposed = applyLayout(text, chart, plan);
+  KeymapChart proposedChart;
+  if (!check(outPath, proposed, codes, proposedChart)) return 1;
+  std::ofstream out(outPath.c_str(), std::ios::binary);
+  out << proposed;
+  if (!out) {
+    fprintf(stderr, "%s: can't write %s\n", argv[0], outPath.c_str());
+    return 2;
+  }
+  return 0;
+}
@@ -0,0 +1,108 @@
+#!/bin/sh
+# memory_budget.sh
+# Memory budget gate for the FeatherChorder firmware: compiles the sketch
+# for the Feather 32u4 with -fstack-usage, reports the biggest symbols in
+# flash, .data and .bss, estimates the worst-case stack (tools/stack_depth)
+# and fails when a budget is exceeded.  Offline, with arduino-cli and the
+# AVR toolchain; from the host build it is
+#
+#   cmake --build build --target memory_budget
+#
+# or by hand
+#
+#   tools/memory_budget.sh path/to/stack_depth
+#
+# Budgets, in bytes, from the environment:
+#   FLASH_BUDGET        .text + .data               (28672, 32 KB less the bootloader)
+#   STATIC_RAM_BUDGET   .data + .bss                (1792)
+#   STACK_BUDGET        deepest chain + interrupt   (512)
+#   MIN_FREE_RAM        left for the heap of 2560   (256)
+#   TOP                 symbols listed per section  (12)
+
+set -e
+
+FQBN=${FQBN:-adafruit:avr:feather32u4}
+HERE=$(cd "$(dirname "$0")/.." && pwd)
+STACK_DEPTH=${1:-$HERE/build/stack_depth}
+FLASH_BUDGET=${FLASH_BUDGET:-28672}
+STATIC_RAM_BUDGET=${STATIC_RAM_BUDGET:-1792}
+STACK_BUDGET=${STACK_BUDGET:-512}
+MIN_FREE_RAM=${MIN_FREE_RAM:-256}
+TOP=${TOP:-12}
+RAM_SIZE=2560
+
+if [ ! -x "$STACK_DEPTH" ]; then
+  echo "memory_budget: no $STACK_DEPTH, build the host tools first" >&2
+  exit 2
+fi
+# no figures without the AVR build, so stop on the first missing tool
+for tool in arduino-cli avr-size avr-nm avr-objdump; do
+  if ! command -v $tool >/dev/null 2>&1; then
+    echo "memory_budget: $tool not found, this needs arduino-cli and the AVR toolchain" >&2
+    exit 2
+  fi
+done
+
+OUT=${OUT:-$HERE/_avr_budget}
+mkdir -p "$OUT"
+arduino-cli compile --fqbn "$FQBN" --build-path "$OUT/build" --output-dir "$OUT" \
+  --build-property "compiler.cpp.extra_flags=-fstack-usage" \
+  --build-property "compiler.c.extra_flags=-fstack-usage" \
+  "$HERE/FeatherChorder" >/dev/null
+ELF=$OUT/FeatherChorder.ino.elf
+avr-objdump -d -C "$ELF" > "$OUT/FeatherChorder.lst"
+
+section(){
+  avr-size -A "$ELF" | awk -v s="$1" '$1 == s { print $2 }'
+}
+TEXT=$(section .text)
+DATA=$(section .data)
+BSS=$(section .bss)
+DATA=${DATA:-0}
+BSS=${BSS:-0}
+
+top(){
+  # $1 title, $2 nm type letters
+  echo "== $1"
+  avr-nm -S -C --size-sort -r -t d "$ELF" | awk -v types="$2" -v n="$TOP" '
+    NF >= 4 && index(types, $3) { name = $4; for (i = 5; i <= NF; i++) name = name " " $i;
+      printf "  %6d  %s\n", $2, name; if (++k == n) exit }'
+}
+
+echo "== sections"
+printf "  .text %6d  .data %5d  .bss %5d\n" "$TEXT" "$DATA" "$BSS"
+top "flash (.text)" "TtRrWwVv"
+top ".data (flash and SRAM)" "Dd"
+top ".bss (SRAM)" "Bb"
+
+echo "== stack"
+STACK_STATUS=0
+REPORT=$("$STACK_DEPTH" --objdump "$OUT/FeatherChorder.lst" --budget "$STACK_BUDGET" \
+         $(find "$OUT/build" -name '*.su')) || STACK_STATUS=$?
+echo "$REPORT" | sed 's/^/  /'
+STACK=$(echo "$REPORT" | awk '/^worst case/ { print $3 }')
+if [ -z "$STACK" ]; then
+  echo "memory_budget: no stack estimate" >&2
+  exit 2
+fi
+
+FLASH=$((TEXT + DATA))
+STATIC=$((DATA + BSS))
+FREE=$((RAM_SIZE - STATIC - STACK))
+FAIL=0
+check(){
+  # $1 what, $2 used, $3 budget, $4 'max' or 'min'
+  if { [ "$4" = max ] && [ "$2" -gt "$3" ]; } || { [ "$4" = min ] && [ "$2" -lt "$3" ]; }; then
+    printf "  %-12s %6d  FAIL (%s %d)\n" "$1" "$2" "$4" "$3"
+    FAIL=1
+  else
+    printf "  %-12s %6d  ok   (%s %d)\n" "$1" "$2" "$4" "$3"
+  fi
+}
+echo "== budget"
+check flash "$FLASH" "$FLASH_BUDGET" max
+check "static RAM" "$STATIC" "$STATIC_RAM_BUDGET" max
+check stack "$STACK" "$STACK_BUDGET" max
+check "free RAM" "$FREE" "$MIN_FREE_RAM" min
+[ "$STACK_STATUS" -eq 0 ] || FAIL=1
+exit $FAIL
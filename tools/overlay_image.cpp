@@ -0,0 +1,115 @@
+// overlay_image.cpp
+// Makes an EEPROM image of the keymap overlay (KeymapOverlay.h) from a
+// text file, see OverlayImage.h for its syntax, or checks one.
+//
+//   overlay_image ChordChart.txt overlay.txt [-o overlay.hex] [--codes KeyCodes.h]
+//   overlay_image --check overlay.hex
+//
+// The image is loaded the way the board loads it at boot, and what it
+// holds goes to stdout; -o writes it in Intel hex, for
+//   avrdude ... -U eeprom:w:overlay.hex:i
+// Exits 0 when fine, 1 with overlay or image errors.
+
+#include "HostHal.h"
+#include "KeymapOverlay.h"
+#include "OverlayImage.h"
+
+#include <fstream>
+#include <sstream>
+#include <stdio.h>
+#include <string.h>
+
+static void usage(const char *name){
+  fprintf(stderr, "usage: %s ChordChart.txt overlay.txt [-o overlay.hex] [--codes KeyCodes.h]\n"
+                  "       %s --check overlay.hex\n", name, name);
+}
+
+static bool readFile(const std::string &path, std::string &text){
+  std::ifstream in(path.c_str(), std::ios::binary);
+  if (!in) return false;
+  std::ostringstream all;
+  all << in.rdbuf();
+  text = all.str();
+  return true;
+}
+
+static bool report(const std::vector<std::string> &errors){
+  for (size_t i = 0; i < errors.size(); i++)
+    fprintf(stderr, "%s\n", errors[i].c_str());
+  return errors.empty();
+}
+
+// loads 'image' as the board would, false when it wouldn't take it
+static bool load(const char *name, const OverlayBytes &image){
+  static const char *const statuses[] = { "erased", "ok", "bad" };
+  int status = loadOverlay(image);
+  printf("%s: %s, %u chords, %u macros, %u bytes at EEPROM 0x%03X\n", name, statuses[status],
+         overlayStats.entries, overlayStats.macros, (unsigned)image.size(), OverlayEepromStart);
+  return status == OVERLAY_OK;
+}
+
+int main(int argc, char **argv){
+  std::string chartPath, overlayPath, outPath, codesPath, checkPath;
+  for (int i = 1; i < argc; i++) {
+    bool more = i + 1 < argc;
+    if (!strcmp(argv[i], "-o") && more) outPath = argv[++i];
+    else if (!strcmp(argv[i], "--codes") && more) codesPath = argv[++i];
+    else if (!strcmp(argv[i], "--check") && more) checkPath = argv[++i];
+    else if (argv[i][0] != '-' && chartPath.empty()) chartPath = argv[i];
+    else if (argv[i][0] != '-' && overlayPath.empty()) overlayPath = argv[i];
+    else {
+      usage(argv[0]);
+      return 2;
+    }
+  }
+  hostReset();
+  std::vector<std::string> errors;
+  OverlayBytes image;
+
+  if (!checkPath.empty()) {
+    std::string hex;
+    if (!chartPath.empty()) {
+      usage(argv[0]);
+      return 2;
+    }
+    if (!readFile(checkPath, hex)) {
+      fprintf(stderr, "%s: can't read %s\n", argv[0], checkPath.c_str());
+      return 2;
+    }
+    if (!parseOverlayHex(checkPath, hex, image, errors)) return report(errors), 1;
+    return load(checkPath.c_str(), image) ? 0 : 1;
+  }
+
+  if (chartPath.empty() || overlayPath.empty()) {
+    usage(argv[0]);
+    return 2;
+  }
+  if (codesPath.empty()) {
+    size_t slash = chartPath.find_last_of('/');
+    codesPath = (slash == std::string::npos ? "" : chartPath.substr(0, slash + 1)) + "KeyCodes.h";
+  }
+  std::string chartText, overlayText, codes;
+  const std::string *paths[] = { &chartPath, &overlayPath, &codesPath };
+  std::string *contents[] = { &chartText, &overlayText, &codes };
+  for (int f = 0; f < 3; f++) {
+    if (!readFile(*paths[f], *contents[f])) {
+      fprintf(stderr, "%s: can't read %s\n", argv[0], paths[f]->c_str());
+      return 2;
+    }
+  }
+
+  KeymapChart chart;
+  if (!parseChart(chartPath, chartText, chart, errors)) return report(errors), 1;
+  if (!buildOverlay(overlayPath, overlayText, chart, keyCodeValues(codes), image, errors))
+    return report(errors), 1;
+  if (!load(overlayPath.c_str(), image)) return 1;
+  if (outPath.empty()) return 0;
+
+  std::ofstream out(outPath.c_str(), std::ios::binary);
+  out << overlayHex(image);
+  if (!out) {
+    fprintf(stderr, "%s: can't write %s\n", argv[0], outPath.c_str());
+    return 2;
+  }
+  return 0;
+}
@@ -0,0 +1,53 @@
+#!/bin/sh
+# size_report.sh
+# Flash/SRAM report for the FeatherChorder firmware.
+#
+#   tools/size_report.sh [firmware.elf]
+#
+# Without an ELF the sketch is compiled for the Feather 32u4 with
+# arduino-cli (FQBN overridable with $FQBN).  Prints the section totals
+# (.text is flash, .data is flash and SRAM, .bss is SRAM) and the size
+# and section of the keymap tables, which should all be in .text
+# (PROGMEM) and none in .data.
+
+set -e
+
+FQBN=${FQBN:-adafruit:avr:feather32u4}
+HERE=$(cd "$(dirname "$0")/.." && pwd)
+
+# say which tool is missing rather than leave a bare "not found"
+need(){
+  command -v "$1" >/dev/null 2>&1 && return
+  echo "size_report: $1 not found, this needs the AVR toolchain (and arduino-cli without an ELF)" >&2
+  exit 2
+}
+
+ELF=$1
+need avr-size
+need avr-nm
+if [ -z "$ELF" ]; then
+  need arduino-cli
+  OUT=${OUT:-$HERE/_avr_build}
+  arduino-cli compile --fqbn "$FQBN" --output-dir "$OUT" "$HERE/FeatherChorder" >/dev/null
+  ELF=$OUT/FeatherChorder.ino.elf
+fi
+
+echo "== sections ($ELF)"
+avr-size -A "$ELF" | awk '$1 == ".text" || $1 == ".data" || $1 == ".bss" { printf "  %-6s %6d\n", $1, $2 }'
+avr-size -C --mcu=atmega32u4 "$ELF" | grep -E "Program|Data"
+
+echo "== keymap tables"
+avr-nm -S -C --size-sort "$ELF" | grep ' [A-Za-z] keymap_' | while read addr size type name; do
+  case $type in
+    [dD]) sect=".data (SRAM!)" ;;
+    [bB]) sect=".bss" ;;
+    *)    sect=".text (flash)" ;;
+  esac
+  printf "  %-28s %5d  %s\n" "$name" "0x$size" "$sect"
+done
+
+echo "== key dispatch"
+avr-nm -S -C --size-sort "$ELF" | grep -E ' (sendKey|dispatchKey|dispatchCommand|runMacro)\(| (modifier_bits|media_controls|key_combos|macro_table)$' |
+  while read addr size type name; do
+    printf "  %-28s %5d\n" "$name" "0x$size"
+  done
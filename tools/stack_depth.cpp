@@ -0,0 +1,103 @@
+// stack_depth.cpp
+// Worst-case stack depth of the firmware from avr-gcc's -fstack-usage
+// files and its disassembly, see StackEstimate.h.  Run by
+// tools/memory_budget.sh.
+//
+//   stack_depth --objdump firmware.lst [--root main] [--budget BYTES] file.su...
+//
+// Prints the deepest call chain with each frame, the interrupt on top of
+// it and what couldn't be followed.  Exits 1 when the total is over
+// --budget or the chain recurses, 2 on bad arguments.
+
+#include "StackEstimate.h"
+
+#include <fstream>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void usage(const char *name){
+  fprintf(stderr, "usage: %s --objdump firmware.lst [--root main] [--budget BYTES] file.su...\n", name);
+}
+
+static bool readFile(const char *path, std::string &text){
+  std::ifstream in(path);
+  if (!in) return false;
+  std::ostringstream all;
+  all << in.rdbuf();
+  text = all.str();
+  return true;
+}
+
+static void list(const char *what, const std::vector<std::string> &names){
+  if (names.empty()) return;
+  printf("  %s:", what);
+  for (size_t i = 0; i < names.size(); i++) printf(" %s", names[i].c_str());
+  printf("\n");
+}
+
+int main(int argc, char **argv){
+  const char *objdump = 0;
+  std::string root = "main";
+  long budget = -1;
+  std::vector<const char *> usage_files;
+  for (int i = 1; i < argc; i++) {
+    bool more = i + 1 < argc;
+    if (!strcmp(argv[i], "--objdump") && more) objdump = argv[++i];
+    else if (!strcmp(argv[i], "--root") && more) root = argv[++i];
+    else if (!strcmp(argv[i], "--budget") && more) budget = atol(argv[++i]);
+    else if (argv[i][0] != '-') usage_files.push_back(argv[i]);
+    else {
+      usage(argv[0]);
+      return 2;
+    }
+  }
+  if (!objdump || usage_files.empty()) {
+    usage(argv[0]);
+    return 2;
+  }
+
+  CallGraph graph;
+  std::string text;
+  for (size_t i = 0; i < usage_files.size(); i++) {
+    if (!readFile(usage_files[i], text)) {
+      fprintf(stderr, "%s: can't read %s\n", argv[0], usage_files[i]);
+      return 2;
+    }
+    parseStackUsage(text, graph);
+  }
+  if (!readFile(objdump, text)) {
+    fprintf(stderr, "%s: can't read %s\n", argv[0], objdump);
+    return 2;
+  }
+  parseDisassembly(text, graph);
+
+  StackDepth depth;
+  if (!estimateStack(graph, root, depth)) {
+    fprintf(stderr, "%s: no %s in %s\n", argv[0], root.c_str(), objdump);
+    return 2;
+  }
+
+  printf("stack from %s: %u bytes\n", root.c_str(), depth.bytes);
+  unsigned sum = 0;
+  for (size_t i = 0; i < depth.path.size(); i++) {
+    const StackFunction &f = graph[depth.path[i]];
+    if (i) sum += ReturnAddressBytes;
+    sum += f.frame;
+    printf("  %5u  %4u%s  %s\n", sum, f.frame, f.hasFrame ? " " : "?", depth.path[i].c_str());
+  }
+  if (!depth.interrupt.empty())
+    printf("interrupt on top: %s, %u bytes\n", depth.interrupt.c_str(), depth.interruptBytes);
+  printf("worst case %u bytes", depth.total());
+  if (budget >= 0) printf(", budget %ld", budget);
+  printf("\n");
+
+  list("recursive, not bounded", depth.recursive);
+  list("calls through a pointer, not followed", depth.indirect);
+  list("dynamic frames", depth.dynamic);
+  list("no frame size (asm or libgcc), counted as 0", depth.unknown);
+
+  if (!depth.recursive.empty()) return 1;
+  return budget >= 0 && depth.total() > (unsigned long)budget ? 1 : 0;
+}